@@ -0,0 +1,133 @@
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <string.h>
+
+#include "arena.h"
+
+static const char *TAG = "COMMANDS:ARENA";
+
+// the memory of a block starts right after its header
+#define arena_block_data(block)                                                \
+  ((uint8_t *)(block) + arena_align(sizeof(arena_block_t)))
+
+static arena_block_t *arena_block_init(uint32_t caps, size_t capacity) {
+  const size_t size = arena_align(sizeof(arena_block_t)) + capacity;
+  arena_block_t *block = (arena_block_t *)heap_caps_malloc(size, caps);
+  if (block == NULL && caps != MALLOC_CAP_DEFAULT) {
+    // PSRAM can be full or missing, so any memory will do
+    block = (arena_block_t *)heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+  }
+  if (block == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate an arena block of %u bytes", size);
+    return NULL;
+  }
+
+  block->next = NULL;
+  block->length = 0;
+  block->capacity = capacity;
+  return block;
+}
+
+// allocates the first block of an arena, which the arena itself is kept in.
+// `caps` picks where the blocks go, such as `MALLOC_CAP_SPIRAM`.
+esp_err_t arena_init(arena_handle_t *arena_handle, uint32_t caps) {
+  arena_block_t *block = arena_block_init(caps, ARENA_BLOCK_SIZE);
+  if (block == NULL) {
+    *arena_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  arena_handle_t arena = (arena_handle_t)arena_block_data(block);
+  block->length = arena_align(sizeof(arena_t));
+  arena->blocks = block;
+  arena->cleanups = NULL;
+  arena->caps = caps;
+
+  *arena_handle = arena;
+  return ESP_OK;
+}
+
+// hands out `size` bytes, which are not cleared. Returns `NULL` if a new
+// block was needed and couldn't be allocated.
+void *arena_alloc(arena_handle_t arena, size_t size) {
+  size = arena_align(size);
+  arena_block_t *block = arena->blocks;
+
+  if (block->length + size > block->capacity) {
+    if (size > ARENA_BLOCK_SIZE / 4) {
+      // it goes behind the current block, so what's left of that isn't lost
+      arena_block_t *own = arena_block_init(arena->caps, size);
+      if (own == NULL) {
+        return NULL;
+      }
+      own->length = size;
+      own->next = block->next;
+      block->next = own;
+      return arena_block_data(own);
+    }
+
+    block = arena_block_init(arena->caps, ARENA_BLOCK_SIZE);
+    if (block == NULL) {
+      return NULL;
+    }
+    block->next = arena->blocks;
+    arena->blocks = block;
+  }
+
+  void *memory = arena_block_data(block) + block->length;
+  block->length += size;
+  return memory;
+}
+
+void *arena_calloc(arena_handle_t arena, size_t count, size_t size) {
+  void *memory = arena_alloc(arena, count * size);
+  if (memory != NULL) {
+    memset(memory, 0, count * size);
+  }
+  return memory;
+}
+
+char *arena_strdup(arena_handle_t arena, const char *value) {
+  const size_t length = strlen(value) + 1;
+  char *copy = (char *)arena_alloc(arena, length);
+  if (copy != NULL) {
+    memcpy(copy, value, length);
+  }
+  return copy;
+}
+
+// has `arena_end` call `cleanup` with `arg`, for anything allocated outside of
+// the arena that lives as long as it. Cleanups are called newest first.
+esp_err_t arena_defer(arena_handle_t arena, arena_cleanup_t cleanup,
+                      void *arg) {
+  arena_cleanup_node_t *node =
+      (arena_cleanup_node_t *)arena_alloc(arena, sizeof(arena_cleanup_node_t));
+  if (node == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+
+  node->cleanup = cleanup;
+  node->arg = arg;
+  node->next = arena->cleanups;
+  arena->cleanups = node;
+  return ESP_OK;
+}
+
+void arena_end(arena_handle_t arena) {
+  if (arena == NULL) {
+    return;
+  }
+
+  for (arena_cleanup_node_t *node = arena->cleanups; node != NULL;
+       node = node->next) {
+    node->cleanup(node->arg);
+  }
+
+  // the arena is inside one of the blocks, so it can't be used after this
+  arena_block_t *block = arena->blocks;
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+}
@@ -0,0 +1,155 @@
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "assets.h"
+
+static const char *TAG = "COMMANDS:ASSETS";
+
+// FNV-1a, which the server works out the same way
+#define ASSET_HASH_OFFSET 0xcbf29ce484222325ULL
+#define ASSET_HASH_PRIME 0x100000001b3ULL
+
+#define asset_bucket(hash) (&buckets[(hash) % ASSET_BUCKET_COUNT])
+
+static asset_handle_t buckets[ASSET_BUCKET_COUNT];
+
+uint64_t asset_hash(const uint8_t *data, uint32_t length) {
+  uint64_t hash = ASSET_HASH_OFFSET;
+  for (uint32_t i = 0; i < length; i++) {
+    hash ^= data[i];
+    hash *= ASSET_HASH_PRIME;
+  }
+  return hash;
+}
+
+// Allocates an asset of `length` bytes to be filled in, with one reference.
+// It isn't found by anything until it's passed to `asset_share`.
+esp_err_t asset_init(asset_handle_t *asset_handle, uint32_t length,
+                     uint32_t caps) {
+  const size_t size = sizeof(asset_t) + length;
+  asset_handle_t asset = (asset_handle_t)heap_caps_malloc(size, caps);
+  if (asset == NULL && caps != MALLOC_CAP_DEFAULT) {
+    // PSRAM can be full or missing, so any memory will do
+    asset = (asset_handle_t)heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+  }
+  if (asset == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate an asset of %" PRIu32 " bytes", length);
+    *asset_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  asset->next = NULL;
+  asset->hash = 0;
+  asset->length = length;
+  asset->refs = 1;
+  asset->is_shared = false;
+  *asset_handle = asset;
+  return ESP_OK;
+}
+
+// the cached asset with the same bytes as `data`, if there is one
+static asset_handle_t asset_lookup(uint64_t hash, const uint8_t *data,
+                                   uint32_t length) {
+  for (asset_handle_t asset = *asset_bucket(hash); asset != NULL;
+       asset = asset->next) {
+    if (asset->hash == hash && asset->length == length &&
+        memcmp(asset->data, data, length) == 0) {
+      return asset;
+    }
+  }
+  return NULL;
+}
+
+// Adds an asset that has been filled in to the cache. If the cache already has
+// the same bytes, the new asset is freed and the cached one is referenced and
+// returned instead.
+asset_handle_t asset_share(asset_handle_t asset) {
+  const uint64_t hash = asset_hash(asset->data, asset->length);
+  asset_handle_t cached = asset_lookup(hash, asset->data, asset->length);
+  if (cached != NULL) {
+    free(asset);
+    cached->refs++;
+    return cached;
+  }
+
+  asset->hash = hash;
+  asset->is_shared = true;
+  asset->next = *asset_bucket(hash);
+  *asset_bucket(hash) = asset;
+  return asset;
+}
+
+// references the cached asset with the same bytes as `data`, or adds a copy
+esp_err_t asset_copy(asset_handle_t *asset_handle, const uint8_t *data,
+                     uint32_t length, uint32_t caps) {
+  asset_handle_t asset = asset_lookup(asset_hash(data, length), data, length);
+  if (asset != NULL) {
+    asset->refs++;
+    *asset_handle = asset;
+    return ESP_OK;
+  }
+
+  esp_err_t ret = asset_init(&asset, length, caps);
+  if (ret != ESP_OK) {
+    *asset_handle = NULL;
+    return ret;
+  }
+  memcpy(asset->data, data, length);
+  *asset_handle = asset_share(asset);
+  return ESP_OK;
+}
+
+// references the cached asset with `hash`. Returns `NULL` if there isn't one.
+asset_handle_t asset_find(uint64_t hash) {
+  for (asset_handle_t asset = *asset_bucket(hash); asset != NULL;
+       asset = asset->next) {
+    if (asset->hash == hash) {
+      asset->refs++;
+      return asset;
+    }
+  }
+  return NULL;
+}
+
+// drops a reference, freeing the asset with the last one. It takes a `void *`
+// so that it can be passed to `arena_defer`.
+void asset_release(void *arg) {
+  asset_handle_t asset = (asset_handle_t)arg;
+  if (asset == NULL || --asset->refs > 0) {
+    return;
+  }
+
+  if (asset->is_shared) {
+    asset_handle_t *link = asset_bucket(asset->hash);
+    while (*link != asset) {
+      link = &(*link)->next;
+    }
+    *link = asset->next;
+  }
+  free(asset);
+}
+
+// Writes the hashes of up to `ASSET_HEADER_COUNT` cached assets into `buffer`,
+// separated by commas, for the server to refer to instead of sending them.
+// Returns how many were written.
+size_t asset_hashes(char *buffer, size_t size) {
+  size_t count = 0;
+  size_t length = 0;
+  buffer[0] = '\0';
+  for (uint8_t i = 0; i < ASSET_BUCKET_COUNT; i++) {
+    for (asset_handle_t asset = buckets[i]; asset != NULL;
+         asset = asset->next) {
+      if (count == ASSET_HEADER_COUNT ||
+          length + ASSET_HASH_LENGTH + 2 > size) {
+        return count;
+      }
+      length += snprintf(buffer + length, size - length, "%s%016" PRIx64,
+                         count > 0 ? "," : "", asset->hash);
+      count++;
+    }
+  }
+  return count;
+}
@@ -1,16 +1,29 @@
 #include "cJSON.h"
 #include "esp_check.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include <stdlib.h>
 #include <string.h>
 
+#include "gfx/color.h"
 #include "gfx/display_buffer.h"
 #include "time_util.h"
 
+#include "assets.h"
 #include "commands.h"
+#include "qoi.h"
 
 static const char *TAG = "COMMANDS";
 
+// where the arenas of command lists are allocated. Keeping them in PSRAM
+// leaves internal RAM to the network stack and the frame buffers.
+#ifdef CONFIG_COMMANDS_IN_SPIRAM
+#define COMMAND_LIST_CAPS MALLOC_CAP_SPIRAM
+#else
+#define COMMAND_LIST_CAPS MALLOC_CAP_DEFAULT
+#endif
+
 #define invalid_shape_warn(type)                                               \
   ESP_LOGW(TAG, "command_t of type '%s' does not have a valid shape", type)
 
@@ -22,12 +35,14 @@ void parse_command_array(command_list_handle_t command_list_handle,
 
 // --------
 // Below are the functions related to initiating and cleaning up the structures
-// for commands. Ideally, all memory allocation and deallocation should occur
-// within these functions
+// for commands. Everything a command list holds is carved out of its arena, so
+// nothing is freed until the whole list is.
 // --------
 
-esp_err_t command_state_init(command_state_t **state_handle) {
-  command_state_t *state = (command_state_t *)malloc(sizeof(command_state_t));
+esp_err_t command_state_init(arena_handle_t arena,
+                             command_state_t **state_handle) {
+  command_state_t *state =
+      (command_state_t *)arena_alloc(arena, sizeof(command_state_t));
   if (state == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for command state");
     *state_handle = NULL;
@@ -38,8 +53,15 @@ esp_err_t command_state_init(command_state_t **state_handle) {
   state->color_green = 255;
   state->color_blue = 255;
   state->font_size = FONT_SIZE_MD;
+  state->text_scale = 1;
   state->pos_x = 0;
   state->pos_y = 0;
+  state->fill = NULL;
+  state->hue_rotate = 0;
+  state->rotated_red = 255;
+  state->rotated_green = 255;
+  state->rotated_blue = 255;
+  state->rotated_fill = NULL;
   state->flags = 0;
 
   *state_handle = state;
@@ -47,211 +69,277 @@ esp_err_t command_state_init(command_state_t **state_handle) {
   return ESP_OK;
 }
 
-void command_state_end(command_state_t *state) {
-  // state could possibly be null. But we only are calling _free_ so NBD
-  free(state);
+// How much room a command of `type` takes along with its value, which is kept
+// right after it so that both are read together. It's 0 for unknown types.
+size_t command_record_size(command_type_enum_t type) {
+  size_t valueSize;
+  switch (type) {
+  case COMMAND_TYPE_STRING:
+    valueSize = sizeof(command_value_string_t);
+    break;
+  case COMMAND_TYPE_LINE:
+    valueSize = sizeof(command_value_line_t);
+    break;
+  case COMMAND_TYPE_BITMAP:
+    valueSize = sizeof(command_value_bitmap_t);
+    break;
+  case COMMAND_TYPE_SETSTATE:
+    valueSize = sizeof(command_value_set_state_t);
+    break;
+  case COMMAND_TYPE_LINEFEED:
+    valueSize = sizeof(command_value_line_feed_t);
+    break;
+  case COMMAND_TYPE_ANIMATION:
+    valueSize = sizeof(command_value_animation_t);
+    break;
+  case COMMAND_TYPE_TIME:
+    valueSize = sizeof(command_value_time_t);
+    break;
+  case COMMAND_TYPE_DATE:
+    valueSize = sizeof(command_value_date_t);
+    break;
+  case COMMAND_TYPE_GRAPH:
+    valueSize = sizeof(command_value_graph_t);
+    break;
+  case COMMAND_TYPE_INDEXED_BITMAP:
+    valueSize = sizeof(command_value_indexed_bitmap_t);
+    break;
+  case COMMAND_TYPE_PALETTE:
+    valueSize = sizeof(command_value_palette_t);
+    break;
+  case COMMAND_TYPE_LAYER:
+    valueSize = sizeof(command_value_layer_t);
+    break;
+  case COMMAND_TYPE_RECT:
+    valueSize = sizeof(command_value_rect_t);
+    break;
+  case COMMAND_TYPE_EFFECT:
+    valueSize = sizeof(command_value_effect_t);
+    break;
+  default:
+    return 0;
+  }
+
+  return arena_align(sizeof(command_t)) + valueSize;
 }
 
-esp_err_t command_init(command_handle_t *command_handle,
-                       command_type_enum_t type) {
-  command_handle_t command = (command_t *)malloc(sizeof(command_t));
-  if (command == NULL) {
-    ESP_LOGE(TAG, "Failed to allocate memory for command");
-    *command_handle = NULL;
-    return ESP_ERR_NO_MEM;
-  }
+// sets up a command in the room from `command_record_size`
+void command_record_init(command_handle_t command, command_type_enum_t type) {
+  void *value = (uint8_t *)command + arena_align(sizeof(command_t));
 
   command->type = type;
+  command->start_x = 0;
+  command->start_y = 0;
+  display_buffer_rect_clear(&command->bounds);
+  command->end_x = 0;
+  command->end_y = 0;
+  command->is_cached = false;
+  command->tweens = NULL;
+  command->tween_count = 0;
 
   switch (command->type) {
   case COMMAND_TYPE_STRING:
-    command->value.string =
-        (command_value_string_t *)malloc(sizeof(command_value_string_t));
-    if (command->value.string == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command string");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.string = (command_value_string_t *)value;
     command->value.string->state = NULL;
     command->value.string->value = NULL;
     break;
   case COMMAND_TYPE_LINE:
-    command->value.line =
-        (command_value_line_t *)malloc(sizeof(command_value_line_t));
-    if (command->value.line == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command line");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.line = (command_value_line_t *)value;
     command->value.line->state = NULL;
     break;
   case COMMAND_TYPE_BITMAP:
-    command->value.bitmap =
-        (command_value_bitmap_t *)malloc(sizeof(command_value_bitmap_t));
-    if (command->value.bitmap == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command bitmap");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.bitmap = (command_value_bitmap_t *)value;
     command->value.bitmap->state = NULL;
+    command->value.bitmap->width = 0;
+    command->value.bitmap->height = 0;
     command->value.bitmap->data_red = NULL;
     command->value.bitmap->data_green = NULL;
     command->value.bitmap->data_blue = NULL;
+    command->value.bitmap->transform.scale_x = DISPLAY_BUFFER_SCALE_ONE;
+    command->value.bitmap->transform.scale_y = DISPLAY_BUFFER_SCALE_ONE;
+    command->value.bitmap->transform.rotation = DISPLAY_BUFFER_ROTATION_0;
     break;
   case COMMAND_TYPE_SETSTATE:
-    command->value.set_state =
-        (command_value_set_state_t *)malloc(sizeof(command_value_set_state_t));
-    if (command->value.set_state == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command set state");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.set_state = (command_value_set_state_t *)value;
     command->value.set_state->state = NULL;
     break;
   case COMMAND_TYPE_LINEFEED:
-    command->value.line_feed =
-        (command_value_line_feed_t *)malloc(sizeof(command_value_line_feed_t));
-    if (command->value.line_feed == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command line feed");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.line_feed = (command_value_line_feed_t *)value;
     break;
   case COMMAND_TYPE_ANIMATION:
-    command->value.animation =
-        (command_value_animation_t *)malloc(sizeof(command_value_animation_t));
-    if (command->value.animation == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command animation");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.animation = (command_value_animation_t *)value;
     command->value.animation->frame_count = 0;
     command->value.animation->last_show_frame = 0;
     command->value.animation->frames = NULL;
+    command->value.animation->canvas = NULL;
+    command->value.animation->durations = NULL;
+    command->value.animation->delay = 0;
+    command->value.animation->next_frame_us = 0;
+    command->value.animation->is_moved = false;
     break;
   case COMMAND_TYPE_TIME:
-    command->value.time =
-        (command_value_time_t *)malloc(sizeof(command_value_time_t));
-    if (command->value.time == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command time");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.time = (command_value_time_t *)value;
     command->value.time->state = NULL;
     break;
   case COMMAND_TYPE_DATE:
-    command->value.date =
-        (command_value_date_t *)malloc(sizeof(command_value_date_t));
-    if (command->value.date == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command date");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.date = (command_value_date_t *)value;
     command->value.date->state = NULL;
     break;
   case COMMAND_TYPE_GRAPH:
-    command->value.graph =
-        (command_value_graph_t *)malloc(sizeof(command_value_graph_t));
-    if (command->value.graph == NULL) {
-      free(command);
-      ESP_LOGE(TAG, "Failed to allocate memory for command graph");
-      *command_handle = NULL;
-      return ESP_ERR_NO_MEM;
-    }
+    command->value.graph = (command_value_graph_t *)value;
     command->value.graph->state = NULL;
-    command->value.graph->height = 0;
-    command->value.graph->width = 0;
+    command->value.graph->graph = (display_buffer_graph_t){
+        .style = DISPLAY_BUFFER_GRAPH_BAR,
+        .autoscale = true,
+    };
     command->value.graph->values = NULL;
-    command->value.graph->bg_color_red = 0;
-    command->value.graph->bg_color_green = 0;
-    command->value.graph->bg_color_blue = 0;
+    command->value.graph->value_count = 0;
+    command->value.graph->series = NULL;
+    break;
+  case COMMAND_TYPE_INDEXED_BITMAP:
+    command->value.indexed_bitmap = (command_value_indexed_bitmap_t *)value;
+    command->value.indexed_bitmap->state = NULL;
+    command->value.indexed_bitmap->height = 0;
+    command->value.indexed_bitmap->width = 0;
+    command->value.indexed_bitmap->bits_per_pixel = 0;
+    command->value.indexed_bitmap->data = NULL;
+    command->value.indexed_bitmap->palette = NULL;
+    command->value.indexed_bitmap->rotated_palette = NULL;
+    command->value.indexed_bitmap->transform.scale_x = DISPLAY_BUFFER_SCALE_ONE;
+    command->value.indexed_bitmap->transform.scale_y = DISPLAY_BUFFER_SCALE_ONE;
+    command->value.indexed_bitmap->transform.rotation =
+        DISPLAY_BUFFER_ROTATION_0;
+    break;
+  case COMMAND_TYPE_PALETTE:
+    command->value.palette = (command_value_palette_t *)value;
+    command->value.palette->palette = NULL;
+    break;
+  case COMMAND_TYPE_LAYER:
+    command->value.layer = (command_value_layer_t *)value;
+    command->value.layer->layer = COMPOSITOR_LAYER_CONTENT;
+    command->value.layer->opacity = COMPOSITOR_OPACITY_OPAQUE;
+    command->value.layer->blend = COMPOSITOR_BLEND_NORMAL;
+    break;
+  case COMMAND_TYPE_RECT:
+    command->value.rect = (command_value_rect_t *)value;
+    command->value.rect->state = NULL;
+    command->value.rect->width = 0;
+    command->value.rect->height = 0;
+    break;
+  case COMMAND_TYPE_EFFECT:
+    command->value.effect = (command_value_effect_t *)value;
+    command->value.effect->state = NULL;
+    command->value.effect->effect = NULL;
     break;
   default:
-    free(command);
+    break;
+  }
+}
+
+esp_err_t command_init(arena_handle_t arena, command_handle_t *command_handle,
+                       command_type_enum_t type) {
+  *command_handle = NULL;
+  size_t size = command_record_size(type);
+  if (size == 0) {
     ESP_LOGE(TAG, "command_t has an invalid type");
     return ESP_ERR_INVALID_ARG;
   }
 
+  command_handle_t command = (command_t *)arena_alloc(arena, size);
+  if (command == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for command");
+    return ESP_ERR_NO_MEM;
+  }
+  command_record_init(command, type);
   *command_handle = command;
 
   return ESP_OK;
 }
 
-void command_end(command_handle_t command) {
-  switch (command->type) {
-  case COMMAND_TYPE_STRING:
-    command_state_end(command->value.string->state);
-    free(command->value.string->value);
-    free(command->value.string);
-    break;
-  case COMMAND_TYPE_LINE:
-    command_state_end(command->value.line->state);
-    free(command->value.line);
-    break;
-  case COMMAND_TYPE_BITMAP:
-    command_state_end(command->value.bitmap->state);
-    free(command->value.bitmap->data_red);
-    free(command->value.bitmap->data_green);
-    free(command->value.bitmap->data_blue);
-    free(command->value.bitmap);
-    break;
-  case COMMAND_TYPE_SETSTATE:
-    command_state_end(command->value.set_state->state);
-    free(command->value.set_state);
-    break;
-  case COMMAND_TYPE_LINEFEED:
-    free(command->value.line_feed);
-    break;
-  case COMMAND_TYPE_ANIMATION:
-    for (uint16_t i = 0; i < command->value.animation->frame_count; i++) {
-      command_list_end(command->value.animation->frames[i]);
-      command->value.animation->frames[i] = NULL;
+// carves a palette of `length` colors out of an arena. All colors start as
+// black, as with `palette_init`.
+esp_err_t command_palette_init(arena_handle_t arena,
+                               palette_handle_t *palette_handle,
+                               uint16_t length) {
+  *palette_handle = NULL;
+  if (length == 0 || length > PALETTE_LENGTH_MAX) {
+    ESP_LOGE(TAG, "Invalid palette length %u", length);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  palette_handle_t palette =
+      (palette_handle_t)arena_alloc(arena, sizeof(palette_t));
+  uint8_t *colors = (uint8_t *)arena_calloc(arena, 3 * length, sizeof(uint8_t));
+  if (palette == NULL || colors == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for palette");
+    return ESP_ERR_NO_MEM;
+  }
+
+  palette->length = length;
+  palette->red = colors;
+  palette->green = colors + length;
+  palette->blue = colors + 2 * length;
+  *palette_handle = palette;
+
+  return ESP_OK;
+}
+
+// Makes room for the colors of a command after its state's `hue_rotate`, and
+// works them out. This is called once the command and its tweens are parsed.
+esp_err_t command_hue_rotate_init(arena_handle_t arena,
+                                  command_handle_t command) {
+  command_state_t *state = command_get_state(command);
+  if (state == NULL || !command_state_has_hue_rotate(state)) {
+    return ESP_OK;
+  }
+
+  if (state->fill != NULL && state->rotated_fill == NULL) {
+    state->rotated_fill = (display_buffer_fill_t *)arena_alloc(
+        arena, sizeof(display_buffer_fill_t));
+    if (state->rotated_fill == NULL) {
+      ESP_LOGE(TAG, "Failed to allocate memory for rotated fill");
+      return ESP_ERR_NO_MEM;
     }
-    free(command->value.animation->frames);
-    free(command->value.animation);
-    break;
-  case COMMAND_TYPE_TIME:
-    command_state_end(command->value.time->state);
-    free(command->value.time);
-    break;
-  case COMMAND_TYPE_DATE:
-    command_state_end(command->value.date->state);
-    free(command->value.date);
-    break;
-  case COMMAND_TYPE_GRAPH:
-    command_state_end(command->value.graph->state);
-    free(command->value.graph->values);
-    free(command->value.graph);
-    break;
   }
 
-  free(command);
+  if (command->type == COMMAND_TYPE_INDEXED_BITMAP &&
+      command->value.indexed_bitmap->palette != NULL &&
+      command->value.indexed_bitmap->rotated_palette == NULL) {
+    esp_err_t ret = command_palette_init(
+        arena, &command->value.indexed_bitmap->rotated_palette,
+        command->value.indexed_bitmap->palette->length);
+    if (ret != ESP_OK) {
+      return ret;
+    }
+  }
+
+  command_apply_hue_rotate(command);
+
+  return ESP_OK;
 }
 
+// Adds a command of `type` to the end of a list. The node, the command and its
+// value are one record in the list's arena, and as the arena hands out memory
+// in order, walking the list reads forward through it.
 esp_err_t command_list_node_init(command_list_handle_t command_list,
                                  command_type_enum_t type,
                                  command_handle_t *command_handle) {
-  esp_err_t cmdRet = command_init(command_handle, type);
-  if (cmdRet != ESP_OK) {
-    return cmdRet;
+  *command_handle = NULL;
+  size_t size = command_record_size(type);
+  if (size == 0) {
+    ESP_LOGE(TAG, "command_t has an invalid type");
+    return ESP_ERR_INVALID_ARG;
   }
 
-  command_list_node_t *newNode =
-      (command_list_node_t *)malloc(sizeof(command_list_node_t));
+  size_t nodeSize = arena_align(sizeof(command_list_node_t));
+  command_list_node_t *newNode = (command_list_node_t *)arena_alloc(
+      command_list->arena, nodeSize + size);
   if (newNode == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for command list node");
-    command_end(*command_handle);
-    *command_handle = NULL;
     return ESP_ERR_NO_MEM;
   }
+  *command_handle = (command_t *)((uint8_t *)newNode + nodeSize);
+  command_record_init(*command_handle, type);
   newNode->command = *command_handle;
   newNode->next = NULL;
 
@@ -267,43 +355,296 @@ esp_err_t command_list_node_init(command_list_handle_t command_list,
   return ESP_OK;
 }
 
-void command_list_node_end(command_list_node_t *commandListNode) {
-  command_end(commandListNode->command);
-  commandListNode->next = NULL;
-  free(commandListNode);
-}
-
-esp_err_t command_list_init(command_list_handle_t *command_list_handle) {
+// carves an empty command list out of `arena`
+esp_err_t command_list_alloc(arena_handle_t arena,
+                             command_list_handle_t *command_list_handle) {
   command_list_handle_t command_list =
-      (command_list_t *)malloc(sizeof(command_list_t));
+      (command_list_t *)arena_alloc(arena, sizeof(command_list_t));
   if (command_list == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for command list");
     *command_list_handle = NULL;
     return ESP_ERR_NO_MEM;
   }
 
+  command_list->arena = arena;
   command_list->head = NULL;
   command_list->tail = NULL;
   command_list->config.animation_delay = COMMAND_CONFIG_ANIMATION_DELAY_DEFAULT;
+  command_list->config.transition = COMPOSITOR_TRANSITION_NONE;
+  command_list->config.transition_direction = COMPOSITOR_DIRECTION_LEFT;
+  command_list->config.transition_duration =
+      COMMAND_CONFIG_TRANSITION_DURATION_DEFAULT;
+  command_list->blobs = NULL;
+  command_list->blobs_length = 0;
 
   *command_list_handle = command_list;
 
   return ESP_OK;
 }
 
+// inits a command list in an arena of its own
+esp_err_t command_list_init(command_list_handle_t *command_list_handle) {
+  arena_handle_t arena;
+  if (arena_init(&arena, COMMAND_LIST_CAPS) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to allocate memory for command list");
+    *command_list_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  esp_err_t ret = command_list_alloc(arena, command_list_handle);
+  if (ret != ESP_OK) {
+    arena_end(arena);
+  }
+  return ret;
+}
+
+// inits the command list of an animation frame. Frames are kept in the arena
+// of the list they're in, and share its blobs.
+esp_err_t command_list_frame_init(command_list_handle_t command_list,
+                                  command_list_handle_t *frame_handle) {
+  esp_err_t ret = command_list_alloc(command_list->arena, frame_handle);
+  if (ret == ESP_OK) {
+    (*frame_handle)->blobs = command_list->blobs;
+    (*frame_handle)->blobs_length = command_list->blobs_length;
+  }
+  return ret;
+}
+
+// frees a command list and everything in it at once, by ending its arena. Only
+// lists from `command_list_init` are ended, as frames go with their list.
 void command_list_end(command_list_handle_t command_list) {
-  command_list_node_t *current;
-  while (command_list->head != NULL) {
-    // save current head
-    current = command_list->head;
-    // move head to next item
-    command_list->head = command_list->head->next;
-    // delete current item
-    command_list_node_end(current);
+  arena_end(command_list->arena);
+}
+
+// effects keep their own memory between ticks, which is freed with the arena
+void command_effect_cleanup(void *effect) {
+  effect_end((effect_handle_t)effect);
+}
+
+// the canvas of an animation that is drawn a frame at a time, freed with the
+// arena
+void command_canvas_cleanup(void *canvas) {
+  display_buffer_end((display_buffer_handle_t)canvas);
+}
+
+// Returns a bitmask of the layers (`1 << COMPOSITOR_LAYER_*`) that have
+// commands which draw something different each tick, such as the time or an
+// animation. Every other layer only has to be drawn once per command list.
+uint8_t command_list_dynamic_layers(command_list_handle_t command_list) {
+  uint8_t dynamicLayers = 0;
+  compositor_layer_id_t layer = COMPOSITOR_LAYER_CONTENT;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_LAYER) {
+      layer = loopNode->command->value.layer->layer;
+    } else if (command_is_dynamic(loopNode->command)) {
+      dynamicLayers |= 1 << layer;
+    }
+    loopNode = loopNode->next;
   }
-  command_list->tail = NULL;
 
-  free(command_list);
+  return dynamicLayers;
+}
+
+// Marks the commands of `layers` that come before the first dynamic command in
+// their layer. They draw the same thing every tick, so they can be drawn once
+// into a cache and copied from it after that. Returns the layers that have any
+// marked commands which draw.
+uint8_t command_list_mark_cached(command_list_handle_t command_list,
+                                 uint8_t layers) {
+  uint8_t cachedLayers = 0;
+  // layers that have had a dynamic command, or are not cached at all
+  uint8_t doneLayers = ~layers;
+  compositor_layer_id_t layer = COMPOSITOR_LAYER_CONTENT;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    command_handle_t command = loopNode->command;
+    if (command->type == COMMAND_TYPE_LAYER) {
+      layer = command->value.layer->layer;
+    } else if (command_is_dynamic(command)) {
+      doneLayers |= 1 << layer;
+    }
+
+    command->is_cached = command->type != COMMAND_TYPE_LAYER &&
+                         !(doneLayers & (1 << layer));
+    if (command->is_cached && command_only_draws(command)) {
+      cachedLayers |= 1 << layer;
+    }
+    loopNode = loopNode->next;
+  }
+
+  return cachedLayers;
+}
+
+// returns where a command keeps the state it applies before drawing, or `NULL`
+// if it can't have one
+command_state_t **command_state_field(command_handle_t command) {
+  switch (command->type) {
+  case COMMAND_TYPE_STRING:
+    return &command->value.string->state;
+  case COMMAND_TYPE_LINE:
+    return &command->value.line->state;
+  case COMMAND_TYPE_BITMAP:
+    return &command->value.bitmap->state;
+  case COMMAND_TYPE_SETSTATE:
+    return &command->value.set_state->state;
+  case COMMAND_TYPE_TIME:
+    return &command->value.time->state;
+  case COMMAND_TYPE_DATE:
+    return &command->value.date->state;
+  case COMMAND_TYPE_GRAPH:
+    return &command->value.graph->state;
+  case COMMAND_TYPE_INDEXED_BITMAP:
+    return &command->value.indexed_bitmap->state;
+  case COMMAND_TYPE_RECT:
+    return &command->value.rect->state;
+  case COMMAND_TYPE_EFFECT:
+    return &command->value.effect->state;
+  default:
+    return NULL;
+  }
+}
+
+// returns the state a command applies before drawing, or `NULL` if it has none
+command_state_t *command_get_state(command_handle_t command) {
+  command_state_t **stateField = command_state_field(command);
+  return stateField != NULL ? *stateField : NULL;
+}
+
+// eases a tween's progress between two keyframes, from `0` up to
+// `COMMAND_TWEEN_PROGRESS_ONE`
+uint32_t tween_ease(command_tween_easing_t easing, uint32_t progress) {
+  uint32_t square;
+  uint32_t inverse;
+  switch (easing) {
+  case TWEEN_EASING_IN:
+    return (progress * progress) >> 16;
+  case TWEEN_EASING_OUT:
+    inverse = COMMAND_TWEEN_PROGRESS_ONE - 1 - progress;
+    return COMMAND_TWEEN_PROGRESS_ONE - 1 - ((inverse * inverse) >> 16);
+  case TWEEN_EASING_IN_OUT:
+    // smoothstep, 3p^2 - 2p^3
+    square = (progress * progress) >> 16;
+    return 3 * square - 2 * ((square * progress) >> 16);
+  default:
+    return progress;
+  }
+}
+
+// works out the values of a tween `elapsed_ms` after the command list was
+// first shown
+void tween_values(const command_tween_t *tween, uint32_t elapsed_ms,
+                  uint8_t *values) {
+  const command_tween_keyframe_t *keyframes = tween->keyframes;
+  uint32_t end = keyframes[tween->keyframe_count - 1].time;
+  uint32_t time = elapsed_ms;
+  if (end > 0 && tween->loop == TWEEN_LOOP_REPEAT) {
+    time = elapsed_ms % end;
+  } else if (end > 0 && tween->loop == TWEEN_LOOP_ALTERNATE) {
+    // keyframe times fit in an `int`, so this can't overflow
+    time = elapsed_ms % (2 * end);
+    if (time > end) {
+      time = 2 * end - time;
+    }
+  }
+
+  // before the first keyframe and after the last, the values are held
+  uint8_t next = 0;
+  while (next < tween->keyframe_count && keyframes[next].time <= time) {
+    next++;
+  }
+  if (next == 0 || next == tween->keyframe_count) {
+    memcpy(values, keyframes[next == 0 ? 0 : next - 1].values, 3);
+    return;
+  }
+
+  const command_tween_keyframe_t *from = &keyframes[next - 1];
+  const command_tween_keyframe_t *to = &keyframes[next];
+  uint32_t progress = (uint32_t)(((uint64_t)(time - from->time) << 16) /
+                                 (to->time - from->time));
+  int32_t eased = tween_ease(tween->easing, progress);
+  for (uint8_t i = 0; i < 3; i++) {
+    values[i] = from->values[i] +
+                (((to->values[i] - from->values[i]) * eased + 0x8000) >> 16);
+  }
+}
+
+// Moves each of a command's tweens to where it is `elapsed_ms` after the
+// command list was first shown. This is done once per tick, before anything is
+// drawn, since a command may be applied more than once per tick.
+void command_apply_tweens(command_handle_t command, uint32_t elapsed_ms) {
+  command_state_t *state = command_get_state(command);
+  uint8_t values[3];
+  for (uint8_t i = 0; i < command->tween_count; i++) {
+    tween_values(&command->tweens[i], elapsed_ms, values);
+    switch (command->tweens[i].property) {
+    case TWEEN_PROPERTY_POSITION:
+      state->pos_x = values[0];
+      state->pos_y = values[1];
+      break;
+    case TWEEN_PROPERTY_COLOR:
+      state->color_red = values[0];
+      state->color_green = values[1];
+      state->color_blue = values[2];
+      break;
+    case TWEEN_PROPERTY_SIZE:
+      if (command->type == COMMAND_TYPE_RECT) {
+        command->value.rect->width = values[0];
+        command->value.rect->height = values[1];
+      } else {
+        command->value.graph->graph.width = values[0];
+        command->value.graph->graph.height = values[1];
+      }
+      break;
+    case TWEEN_PROPERTY_VALUE:
+      command->value.graph->values[command->value.graph->value_count - 1] =
+          values[0];
+      break;
+    case TWEEN_PROPERTY_HUE_ROTATE:
+      state->hue_rotate = values[0];
+      break;
+    }
+  }
+
+  command_apply_hue_rotate(command);
+}
+
+// Works out the colors of a command after its state's `hue_rotate`. This is
+// done once when the command is parsed and again whenever its tweens move,
+// rather than for every pixel that is drawn.
+void command_apply_hue_rotate(command_handle_t command) {
+  command_state_t *state = command_get_state(command);
+  if (state == NULL || !command_state_has_hue_rotate(state)) {
+    return;
+  }
+
+  state->rotated_red = state->color_red;
+  state->rotated_green = state->color_green;
+  state->rotated_blue = state->color_blue;
+  color_rotate_hue(&state->rotated_red, &state->rotated_green,
+                   &state->rotated_blue, state->hue_rotate);
+
+  if (state->rotated_fill != NULL) {
+    *state->rotated_fill = *state->fill;
+    for (uint8_t i = 0; i < state->rotated_fill->stop_count; i++) {
+      display_buffer_fill_stop_t *stop = &state->rotated_fill->stops[i];
+      color_rotate_hue(&stop->red, &stop->green, &stop->blue,
+                       state->hue_rotate);
+    }
+  }
+
+  if (command->type == COMMAND_TYPE_INDEXED_BITMAP &&
+      command->value.indexed_bitmap->rotated_palette != NULL) {
+    palette_handle_t palette = command->value.indexed_bitmap->palette;
+    palette_handle_t rotated = command->value.indexed_bitmap->rotated_palette;
+    for (uint16_t i = 0; i < palette->length; i++) {
+      rotated->red[i] = palette->red[i];
+      rotated->green[i] = palette->green[i];
+      rotated->blue[i] = palette->blue[i];
+      color_rotate_hue(&rotated->red[i], &rotated->green[i],
+                       &rotated->blue[i], state->hue_rotate);
+    }
+  }
 }
 
 // --------
@@ -311,9 +652,151 @@ void command_list_end(command_list_handle_t command_list) {
 // list, using the above lifecycle functions.
 // --------
 
+// Parses a color given as `{red, green, blue}`, `{hue, saturation, value}` or
+// `{hue, saturation, lightness}`, each from `0` to `255`, into RGB. Other
+// colors are turned into RGB here, so nothing else has to know about them.
+esp_err_t parse_color(const cJSON *colorJson, uint8_t *red, uint8_t *green,
+                      uint8_t *blue) {
+  char *rgbNames[] = {"red", "green", "blue"};
+  char *hsvNames[] = {"hue", "saturation", "value"};
+  char *hslNames[] = {"hue", "saturation", "lightness"};
+  char **names = rgbNames;
+  if (cJSON_GetObjectItemCaseSensitive(colorJson, "hue") != NULL) {
+    names = cJSON_GetObjectItemCaseSensitive(colorJson, "lightness") != NULL
+                ? hslNames
+                : hsvNames;
+  }
+
+  uint8_t channels[3];
+  for (uint8_t i = 0; i < 3; i++) {
+    const cJSON *channel =
+        cJSON_GetObjectItemCaseSensitive(colorJson, names[i]);
+    if (!cJSON_IsNumber(channel)) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    channels[i] = (uint8_t)channel->valueint;
+  }
+
+  if (names == hsvNames) {
+    color_from_hsv(channels[0], channels[1], channels[2], red, green, blue);
+  } else if (names == hslNames) {
+    color_from_hsl(channels[0], channels[1], channels[2], red, green, blue);
+  } else {
+    *red = channels[0];
+    *green = channels[1];
+    *blue = channels[2];
+  }
+
+  return ESP_OK;
+}
+
+// Parses an array of gradient stops, each a color with a `position`, into
+// `stops`, which must have room for `DISPLAY_BUFFER_FILL_STOPS_MAX`. Stops
+// without a `position` are spread evenly, and the stops must be in order.
+esp_err_t parse_stops(const cJSON *stopsJson, char *type, char *prop,
+                      display_buffer_fill_stop_t *stops, uint8_t *stop_count) {
+  if (!cJSON_IsArray(stopsJson) || cJSON_GetArraySize(stopsJson) < 2 ||
+      cJSON_GetArraySize(stopsJson) > DISPLAY_BUFFER_FILL_STOPS_MAX) {
+    invalid_prop_warn(type, prop);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  *stop_count = cJSON_GetArraySize(stopsJson);
+  const cJSON *stop = NULL;
+  uint8_t stopIndex = 0;
+  cJSON_ArrayForEach(stop, stopsJson) {
+    const cJSON *position = cJSON_GetObjectItemCaseSensitive(stop, "position");
+    display_buffer_fill_stop_t *fillStop = &stops[stopIndex];
+    if (parse_color(stop, &fillStop->red, &fillStop->green, &fillStop->blue) !=
+        ESP_OK) {
+      invalid_prop_warn(type, prop);
+      return ESP_ERR_INVALID_ARG;
+    }
+
+    fillStop->position = (stopIndex * 255) / (*stop_count - 1);
+    if (cJSON_IsNumber(position) && position->valueint >= 0 &&
+        position->valueint <= 255) {
+      fillStop->position = (uint8_t)position->valueint;
+    }
+    // the gradient kernels rely on the stops being in order
+    if (stopIndex > 0 && fillStop->position < stops[stopIndex - 1].position) {
+      invalid_prop_warn(type, prop);
+      return ESP_ERR_INVALID_ARG;
+    }
+    stopIndex++;
+  }
+
+  return ESP_OK;
+}
+
+// Parses a `fill` into a new fill, which is left as `NULL` if it is not valid.
+// Patterns alternate between the first two stops.
+esp_err_t parse_fill(arena_handle_t arena, const cJSON *fillJson, char *type,
+                     display_buffer_fill_t **fill_handle) {
+  *fill_handle = NULL;
+
+  const cJSON *fillType = cJSON_GetObjectItemCaseSensitive(fillJson, "type");
+  if (!cJSON_IsString(fillType) || fillType->valuestring == NULL) {
+    invalid_prop_warn(type, "fill");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  display_buffer_fill_t *fill = (display_buffer_fill_t *)arena_alloc(
+      arena, sizeof(display_buffer_fill_t));
+  if (fill == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for fill");
+    return ESP_ERR_NO_MEM;
+  }
+
+  if (strcmp(fillType->valuestring, "gradient") == 0) {
+    fill->type = DISPLAY_BUFFER_FILL_GRADIENT;
+  } else if (strcmp(fillType->valuestring, "checker") == 0) {
+    fill->type = DISPLAY_BUFFER_FILL_CHECKER;
+  } else if (strcmp(fillType->valuestring, "stripes") == 0) {
+    fill->type = DISPLAY_BUFFER_FILL_STRIPES;
+  } else {
+    invalid_prop_warn(type, "fill.type");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  fill->direction = DISPLAY_BUFFER_FILL_HORIZONTAL;
+  const cJSON *direction =
+      cJSON_GetObjectItemCaseSensitive(fillJson, "direction");
+  if (cJSON_IsString(direction) && direction->valuestring != NULL) {
+    if (strcmp(direction->valuestring, "horizontal") == 0) {
+      fill->direction = DISPLAY_BUFFER_FILL_HORIZONTAL;
+    } else if (strcmp(direction->valuestring, "vertical") == 0) {
+      fill->direction = DISPLAY_BUFFER_FILL_VERTICAL;
+    } else if (strcmp(direction->valuestring, "diagonal") == 0) {
+      fill->direction = DISPLAY_BUFFER_FILL_DIAGONAL;
+    } else {
+      invalid_prop_warn(type, "fill.direction");
+    }
+  }
+
+  fill->pattern_size = 1;
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(fillJson, "size");
+  if (cJSON_IsNumber(size)) {
+    if (size->valueint >= 1 && size->valueint <= UINT8_MAX) {
+      fill->pattern_size = (uint8_t)size->valueint;
+    } else {
+      invalid_prop_warn(type, "fill.size");
+    }
+  }
+
+  if (parse_stops(cJSON_GetObjectItemCaseSensitive(fillJson, "stops"), type,
+                  "fill.stops", fill->stops, &fill->stop_count) != ESP_OK) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  *fill_handle = fill;
+
+  return ESP_OK;
+}
+
 // This is responsible for pulling off shared state data and adding it.
-void parse_and_add_state(const cJSON *commandJson, char *type,
-                         command_state_t **state) {
+void parse_and_add_state(arena_handle_t arena, const cJSON *commandJson,
+                         char *type, command_state_t **state) {
   bool didInitState = *state != NULL;
 
   const cJSON *font_size =
@@ -321,7 +804,7 @@ void parse_and_add_state(const cJSON *commandJson, char *type,
   if (cJSON_IsString(font_size) && font_size->valuestring != NULL) {
     if (!didInitState) {
       didInitState = true;
-      if (command_state_init(state) != ESP_OK) {
+      if (command_state_init(arena, state) != ESP_OK) {
         ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
                  type);
         return;
@@ -337,29 +820,51 @@ void parse_and_add_state(const cJSON *commandJson, char *type,
     } else if (strcmp(font_size->valuestring, "md") == 0) {
       (*state)->font_size = FONT_SIZE_MD;
       command_state_set_flag_font(*state);
+    } else if (strcmp(font_size->valuestring, "prop") == 0) {
+      (*state)->font_size = FONT_SIZE_PROP;
+      command_state_set_flag_font(*state);
     } else {
       invalid_prop_warn(type, "fontSize");
     }
   }
 
+  const cJSON *text_scale =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "textScale");
+  if (cJSON_IsNumber(text_scale)) {
+    if (text_scale->valueint >= 1 &&
+        text_scale->valueint <= DISPLAY_BUFFER_TEXT_SCALE_MAX) {
+      if (!didInitState) {
+        didInitState = true;
+        if (command_state_init(arena, state) != ESP_OK) {
+          ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
+                   type);
+          return;
+        }
+      }
+
+      (*state)->text_scale = (uint8_t)text_scale->valueint;
+      command_state_set_flag_text_scale(*state);
+    } else {
+      invalid_prop_warn(type, "textScale");
+    }
+  }
+
   const cJSON *color = cJSON_GetObjectItemCaseSensitive(commandJson, "color");
   if (cJSON_IsObject(color) && !cJSON_IsNull(color)) {
-    const cJSON *red = cJSON_GetObjectItemCaseSensitive(color, "red");
-    const cJSON *green = cJSON_GetObjectItemCaseSensitive(color, "green");
-    const cJSON *blue = cJSON_GetObjectItemCaseSensitive(color, "blue");
-    if (cJSON_IsNumber(red) && cJSON_IsNumber(green) && cJSON_IsNumber(blue)) {
+    uint8_t red, green, blue;
+    if (parse_color(color, &red, &green, &blue) == ESP_OK) {
       if (!didInitState) {
         didInitState = true;
-        if (command_state_init(state) != ESP_OK) {
+        if (command_state_init(arena, state) != ESP_OK) {
           ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
                    type);
           return;
         }
       }
 
-      (*state)->color_red = (uint8_t)red->valueint;
-      (*state)->color_green = (uint8_t)green->valueint;
-      (*state)->color_blue = (uint8_t)blue->valueint;
+      (*state)->color_red = red;
+      (*state)->color_green = green;
+      (*state)->color_blue = blue;
       command_state_set_flag_color(*state);
     } else {
       invalid_prop_warn(type, "color");
@@ -376,7 +881,7 @@ void parse_and_add_state(const cJSON *commandJson, char *type,
     } else {
       if (!didInitState) {
         didInitState = true;
-        if (command_state_init(state) != ESP_OK) {
+        if (command_state_init(arena, state) != ESP_OK) {
           ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
                    type);
           return;
@@ -388,17 +893,160 @@ void parse_and_add_state(const cJSON *commandJson, char *type,
       command_state_set_flag_position(*state);
     }
   }
-}
 
-void parse_and_add_config(const cJSON *json,
-                          command_list_handle_t command_list) {
-  const cJSON *config = cJSON_GetObjectItemCaseSensitive(json, "config");
+  const cJSON *fillJson = cJSON_GetObjectItemCaseSensitive(commandJson, "fill");
+  if (cJSON_IsObject(fillJson)) {
+    display_buffer_fill_t *fill;
+    if (parse_fill(arena, fillJson, type, &fill) == ESP_OK) {
+      if (!didInitState) {
+        didInitState = true;
+        if (command_state_init(arena, state) != ESP_OK) {
+          ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
+                   type);
+          return;
+        }
+      }
 
-  if (!cJSON_IsObject(config) || cJSON_IsNull(config)) {
-    return;
+      (*state)->fill = fill;
+      command_state_set_flag_fill(*state);
+    }
   }
 
-  const cJSON *animation_delay =
+  const cJSON *hue_rotate =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "hueRotate");
+  if (cJSON_IsNumber(hue_rotate)) {
+    if (hue_rotate->valueint >= 0 && hue_rotate->valueint <= UINT8_MAX) {
+      if (!didInitState) {
+        didInitState = true;
+        if (command_state_init(arena, state) != ESP_OK) {
+          ESP_LOGW(TAG, "Failed to init command state for command type '%s'",
+                   type);
+          return;
+        }
+      }
+
+      (*state)->hue_rotate = (uint8_t)hue_rotate->valueint;
+      command_state_set_flag_hue_rotate(*state);
+    } else {
+      invalid_prop_warn(type, "hueRotate");
+    }
+  }
+}
+
+// converts a JSON scale factor into fixed-point, clamping to the valid range
+uint16_t parse_scale_value(const cJSON *scale, char *type) {
+  const double fixed = scale->valuedouble * DISPLAY_BUFFER_SCALE_ONE;
+  if (fixed < DISPLAY_BUFFER_SCALE_MIN) {
+    invalid_prop_warn(type, "scale");
+    return DISPLAY_BUFFER_SCALE_MIN;
+  }
+  if (fixed > DISPLAY_BUFFER_SCALE_MAX) {
+    invalid_prop_warn(type, "scale");
+    return DISPLAY_BUFFER_SCALE_MAX;
+  }
+  return (uint16_t)(fixed + 0.5);
+}
+
+// pulls the optional `scale` and `rotation` off of a bitmap command. `scale`
+// is either a single number or an `{x, y}` object. `rotation` is clockwise
+// degrees, in steps of 90.
+void parse_and_add_transform(const cJSON *commandJson, char *type,
+                             display_buffer_transform_t *transform) {
+  const cJSON *scale = cJSON_GetObjectItemCaseSensitive(commandJson, "scale");
+  if (cJSON_IsNumber(scale)) {
+    transform->scale_x = parse_scale_value(scale, type);
+    transform->scale_y = transform->scale_x;
+  } else if (cJSON_IsObject(scale)) {
+    const cJSON *scaleX = cJSON_GetObjectItemCaseSensitive(scale, "x");
+    const cJSON *scaleY = cJSON_GetObjectItemCaseSensitive(scale, "y");
+    if (cJSON_IsNumber(scaleX) && cJSON_IsNumber(scaleY)) {
+      transform->scale_x = parse_scale_value(scaleX, type);
+      transform->scale_y = parse_scale_value(scaleY, type);
+    } else {
+      invalid_prop_warn(type, "scale");
+    }
+  }
+
+  const cJSON *rotation =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "rotation");
+  if (cJSON_IsNumber(rotation)) {
+    switch (rotation->valueint) {
+    case 0:
+      transform->rotation = DISPLAY_BUFFER_ROTATION_0;
+      break;
+    case 90:
+      transform->rotation = DISPLAY_BUFFER_ROTATION_90;
+      break;
+    case 180:
+      transform->rotation = DISPLAY_BUFFER_ROTATION_180;
+      break;
+    case 270:
+      transform->rotation = DISPLAY_BUFFER_ROTATION_270;
+      break;
+    default:
+      invalid_prop_warn(type, "rotation");
+      break;
+    }
+  }
+}
+
+// parses the optional `{type, direction, duration}` transition of a command
+// list. Without a valid one, the display changes straight away.
+void parse_and_add_transition(const cJSON *config,
+                              command_list_handle_t command_list) {
+  const cJSON *transition =
+      cJSON_GetObjectItemCaseSensitive(config, "transition");
+  if (transition == NULL) {
+    return;
+  }
+
+  const cJSON *type = cJSON_GetObjectItemCaseSensitive(transition, "type");
+  const cJSON *direction =
+      cJSON_GetObjectItemCaseSensitive(transition, "direction");
+  const cJSON *duration =
+      cJSON_GetObjectItemCaseSensitive(transition, "duration");
+  if (!cJSON_IsString(type) || type->valuestring == NULL) {
+    ESP_LOGW(TAG, "transition is invalid. Not using one.");
+    return;
+  }
+
+  if (strcmp(type->valuestring, "crossfade") == 0) {
+    command_list->config.transition = COMPOSITOR_TRANSITION_CROSSFADE;
+  } else if (strcmp(type->valuestring, "wipe") == 0) {
+    command_list->config.transition = COMPOSITOR_TRANSITION_WIPE;
+  } else if (strcmp(type->valuestring, "slide") == 0) {
+    command_list->config.transition = COMPOSITOR_TRANSITION_SLIDE;
+  } else {
+    ESP_LOGW(TAG, "transition.type is invalid. Not using one.");
+    return;
+  }
+
+  if (cJSON_IsString(direction) && direction->valuestring != NULL) {
+    if (strcmp(direction->valuestring, "right") == 0) {
+      command_list->config.transition_direction = COMPOSITOR_DIRECTION_RIGHT;
+    } else if (strcmp(direction->valuestring, "up") == 0) {
+      command_list->config.transition_direction = COMPOSITOR_DIRECTION_UP;
+    } else if (strcmp(direction->valuestring, "down") == 0) {
+      command_list->config.transition_direction = COMPOSITOR_DIRECTION_DOWN;
+    }
+  }
+
+  if (cJSON_IsNumber(duration)) {
+    if (duration->valueint >= 1 && duration->valueint <= UINT16_MAX) {
+      command_list->config.transition_duration = duration->valueint;
+    } else {
+      ESP_LOGW(TAG, "transition.duration is invalid. Using default value.");
+    }
+  }
+}
+
+void parse_and_add_config(const cJSON *config,
+                          command_list_handle_t command_list) {
+  if (!cJSON_IsObject(config) || cJSON_IsNull(config)) {
+    return;
+  }
+
+  const cJSON *animation_delay =
       cJSON_GetObjectItemCaseSensitive(config, "animationDelay");
 
   if (cJSON_IsNumber(animation_delay)) {
@@ -420,6 +1068,8 @@ void parse_and_add_config(const cJSON *json,
     command_list->config.animation_delay =
         COMMAND_CONFIG_ANIMATION_DELAY_DEFAULT;
   }
+
+  parse_and_add_transition(config, command_list);
 }
 
 void parse_and_append_string(command_list_handle_t command_list,
@@ -437,16 +1087,14 @@ void parse_and_append_string(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "string", &command->value.string->state);
+  parse_and_add_state(command_list->arena, commandJson, "string",
+                      &command->value.string->state);
 
   command->value.string->value =
-      (char *)malloc((strlen(value->valuestring) + 1) * sizeof(char));
+      arena_strdup(command_list->arena, value->valuestring);
   if (command->value.string->value == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for string command value");
-    return;
   }
-
-  strcpy(command->value.string->value, value->valuestring);
 }
 
 void parse_and_append_line(command_list_handle_t command_list,
@@ -471,12 +1119,166 @@ void parse_and_append_line(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "line", &command->value.line->state);
+  parse_and_add_state(command_list->arena, commandJson, "line",
+                      &command->value.line->state);
 
   command->value.line->to_x = to_x->valueint;
   command->value.line->to_y = to_y->valueint;
 }
 
+// Finds a `{blob, length}` offset into the blobs of a binary response. Returns
+// `NULL` if the commands aren't from one, or if it doesn't fit inside them.
+uint8_t *parse_blob(command_list_handle_t command_list, const cJSON *blobJson,
+                    uint32_t *length) {
+  const cJSON *offset = cJSON_GetObjectItemCaseSensitive(blobJson, "blob");
+  const cJSON *blobLength =
+      cJSON_GetObjectItemCaseSensitive(blobJson, "length");
+  if (command_list->blobs == NULL || !cJSON_IsNumber(offset) ||
+      !cJSON_IsNumber(blobLength) || offset->valueint < 0 ||
+      blobLength->valueint < 0 ||
+      (uint32_t)offset->valueint + (uint32_t)blobLength->valueint >
+          command_list->blobs_length) {
+    return NULL;
+  }
+
+  *length = blobLength->valueint;
+  return command_list->blobs + offset->valueint;
+}
+
+// Has a command list hold a reference to `asset` until it's ended. Returns the
+// asset's bytes, or `NULL` if the reference couldn't be kept.
+uint8_t *command_list_hold_asset(command_list_handle_t command_list,
+                                 asset_handle_t asset) {
+  if (arena_defer(command_list->arena, asset_release, asset) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to hold an asset");
+    asset_release(asset);
+    return NULL;
+  }
+  return asset->data;
+}
+
+// Finds bitmap data that isn't an array, which is either `{asset}`, the hash
+// of an asset the device already has, or `{blob, length}` in the blobs of a
+// binary response. Blobs are copied into the asset cache, unless it already
+// has the same bytes. The first `length` bytes are used. Returns `NULL` if
+// there isn't an asset or a blob that long.
+uint8_t *parse_asset(command_list_handle_t command_list, const cJSON *dataJson,
+                     uint32_t length) {
+  asset_handle_t asset = NULL;
+  const cJSON *hash = cJSON_GetObjectItemCaseSensitive(dataJson, "asset");
+  if (cJSON_IsString(hash)) {
+    char *end;
+    const uint64_t value = strtoull(hash->valuestring, &end, 16);
+    if (strlen(hash->valuestring) == ASSET_HASH_LENGTH && *end == '\0') {
+      asset = asset_find(value);
+    }
+  } else {
+    uint32_t blobLength;
+    uint8_t *blobData = parse_blob(command_list, dataJson, &blobLength);
+    if (blobData != NULL && blobLength >= length) {
+      asset_copy(&asset, blobData, length, COMMAND_LIST_CAPS);
+    }
+  }
+
+  if (asset == NULL) {
+    return NULL;
+  }
+  if (asset->length < length) {
+    asset_release(asset);
+    return NULL;
+  }
+  return command_list_hold_asset(command_list, asset);
+}
+
+// Parses the red, green and blue arrays of a bitmap into an asset, which is
+// shared with any other bitmap that has the same pixels. Channels shorter than
+// `channel_length` are padded with black. Returns the asset's bytes.
+uint8_t *parse_bitmap_channels(command_list_handle_t command_list,
+                               const cJSON *data_red, const cJSON *data_green,
+                               const cJSON *data_blue,
+                               uint32_t channel_length) {
+  asset_handle_t asset;
+  if (asset_init(&asset, 3 * channel_length, COMMAND_LIST_CAPS) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to allocate memory for bitmap channels");
+    return NULL;
+  }
+  memset(asset->data, 0, asset->length);
+  uint8_t *red = asset->data;
+  uint8_t *green = red + channel_length;
+  uint8_t *blue = green + channel_length;
+
+  // we cannot access the array directly, so we have to loop and put the values
+  // into a buffer that we can use with the display buffer. The channels are
+  // walked together, since finding each value by its index would walk the
+  // array from the start every time.
+  const cJSON *pixelValueRed = data_red->child;
+  const cJSON *pixelValueGreen = data_green->child;
+  const cJSON *pixelValueBlue = data_blue->child;
+  uint32_t bufIndex = 0;
+  while (pixelValueRed != NULL && pixelValueGreen != NULL &&
+         pixelValueBlue != NULL && bufIndex < channel_length) {
+    if (cJSON_IsNumber(pixelValueRed) && cJSON_IsNumber(pixelValueGreen) &&
+        cJSON_IsNumber(pixelValueBlue)) {
+      red[bufIndex] = (uint8_t)pixelValueRed->valueint;
+      green[bufIndex] = (uint8_t)pixelValueGreen->valueint;
+      blue[bufIndex] = (uint8_t)pixelValueBlue->valueint;
+    } else {
+      invalid_prop_warn("bitmap", "pixel value");
+    }
+    pixelValueRed = pixelValueRed->next;
+    pixelValueGreen = pixelValueGreen->next;
+    pixelValueBlue = pixelValueBlue->next;
+    bufIndex++;
+  }
+
+  return command_list_hold_asset(command_list, asset_share(asset));
+}
+
+// Decodes bitmap data that is `{encoding: "qoi"}` with either the image as
+// `base64` or `{blob, length}` in the blobs of a binary response. It's decoded
+// straight into an asset, which is shared with any other bitmap that has the
+// same pixels, so the compressed image is never copied. The size has to be
+// checked first, since the image is decoded at the size it's kept at. Returns
+// the asset's bytes, or `NULL` if it couldn't be decoded.
+uint8_t *parse_encoded_bitmap(command_list_handle_t command_list,
+                              const cJSON *dataJson, uint8_t width,
+                              uint8_t height) {
+  const cJSON *encoding =
+      cJSON_GetObjectItemCaseSensitive(dataJson, "encoding");
+  const cJSON *base64 = cJSON_GetObjectItemCaseSensitive(dataJson, "base64");
+  if (!cJSON_IsString(encoding) || strcmp(encoding->valuestring, "qoi") != 0) {
+    invalid_prop_warn("bitmap", "encoding");
+    return NULL;
+  }
+
+  qoi_source_t source;
+  if (cJSON_IsString(base64)) {
+    qoi_source_init_base64(&source, base64->valuestring);
+  } else {
+    uint32_t blobLength;
+    uint8_t *blobData = parse_blob(command_list, dataJson, &blobLength);
+    if (blobData == NULL) {
+      return NULL;
+    }
+    qoi_source_init(&source, blobData, blobLength);
+  }
+
+  const uint32_t channelLength = (uint32_t)width * height;
+  asset_handle_t asset;
+  if (asset_init(&asset, 3 * channelLength, COMMAND_LIST_CAPS) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to allocate memory for bitmap channels");
+    return NULL;
+  }
+  if (qoi_decode(&source, width, height, asset->data,
+                 asset->data + channelLength,
+                 asset->data + 2 * channelLength) != ESP_OK) {
+    asset_release(asset);
+    return NULL;
+  }
+
+  return command_list_hold_asset(command_list, asset_share(asset));
+}
+
 void parse_and_append_bitmap(command_list_handle_t command_list,
                              const cJSON *commandJson) {
   const cJSON *dataObj = cJSON_GetObjectItemCaseSensitive(commandJson, "data");
@@ -487,18 +1289,27 @@ void parse_and_append_bitmap(command_list_handle_t command_list,
     return;
   }
 
+  const cJSON *blob = cJSON_GetObjectItemCaseSensitive(dataObj, "blob");
+  const cJSON *asset = cJSON_GetObjectItemCaseSensitive(dataObj, "asset");
+  const cJSON *encoding =
+      cJSON_GetObjectItemCaseSensitive(dataObj, "encoding");
   const cJSON *data_red = cJSON_GetObjectItemCaseSensitive(dataObj, "red");
   const cJSON *data_green = cJSON_GetObjectItemCaseSensitive(dataObj, "green");
   const cJSON *data_blue = cJSON_GetObjectItemCaseSensitive(dataObj, "blue");
-  if (!cJSON_IsArray(data_red) || !cJSON_IsArray(data_green) ||
-      !cJSON_IsArray(data_blue)) {
+  const bool isArrays = cJSON_IsArray(data_red) &&
+                        cJSON_IsArray(data_green) && cJSON_IsArray(data_blue);
+  if (!isArrays && blob == NULL && asset == NULL && encoding == NULL) {
     invalid_prop_warn("bitmap", "data");
     return;
   }
 
+  // the width and height are kept as bytes, and the channels are split by
+  // them, so anything larger would garble the bitmap
   const cJSON *sizeW = cJSON_GetObjectItemCaseSensitive(size, "width");
   const cJSON *sizeH = cJSON_GetObjectItemCaseSensitive(size, "height");
-  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH)) {
+  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH) ||
+      sizeW->valueint < 1 || sizeW->valueint > UINT8_MAX ||
+      sizeH->valueint < 1 || sizeH->valueint > UINT8_MAX) {
     invalid_prop_warn("bitmap", "size");
     return;
   }
@@ -510,52 +1321,101 @@ void parse_and_append_bitmap(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "bitmap", &command->value.bitmap->state);
+  parse_and_add_state(command_list->arena, commandJson, "bitmap",
+                      &command->value.bitmap->state);
+  parse_and_add_transform(commandJson, "bitmap",
+                          &command->value.bitmap->transform);
+
+  // the red, green and blue channels follow each other, in an asset or a blob
+  const uint8_t width = sizeW->valueint;
+  const uint8_t height = sizeH->valueint;
+  const uint32_t channelLength = (uint32_t)width * height;
+  uint8_t *data;
+  if (isArrays) {
+    data = parse_bitmap_channels(command_list, data_red, data_green, data_blue,
+                                 channelLength);
+  } else if (encoding != NULL) {
+    data = parse_encoded_bitmap(command_list, dataObj, width, height);
+    if (data == NULL) {
+      invalid_prop_warn("bitmap", "data");
+    }
+  } else {
+    data = parse_asset(command_list, dataObj, 3 * channelLength);
+    if (data == NULL) {
+      invalid_prop_warn("bitmap", "data");
+    }
+  }
+  if (data == NULL) {
+    return;
+  }
 
-  command->value.bitmap->width = sizeW->valueint;
-  command->value.bitmap->height = sizeH->valueint;
-  command->value.bitmap->data_red =
-      (uint8_t *)malloc(cJSON_GetArraySize(data_red) * sizeof(uint8_t));
-  command->value.bitmap->data_green =
-      (uint8_t *)malloc(cJSON_GetArraySize(data_green) * sizeof(uint8_t));
-  command->value.bitmap->data_blue =
-      (uint8_t *)malloc(cJSON_GetArraySize(data_blue) * sizeof(uint8_t));
+  // only set these once the data is valid, so a zero sized bitmap is drawn if
+  // anything above failed
+  command->value.bitmap->data_red = data;
+  command->value.bitmap->data_green = data + channelLength;
+  command->value.bitmap->data_blue = data + 2 * channelLength;
+  command->value.bitmap->width = width;
+  command->value.bitmap->height = height;
+}
 
-  if (command->value.bitmap->data_red == NULL ||
-      command->value.bitmap->data_green == NULL ||
-      command->value.bitmap->data_blue == NULL) {
-    ESP_LOGE(TAG, "Failed to allocate memory for bitmap channels");
-    free(command->value.bitmap->data_red);
-    free(command->value.bitmap->data_green);
-    free(command->value.bitmap->data_blue);
-    return;
+// Parses the `size` of an animation whose frames only hold what changed since
+// the one before, which is the size of the canvas they're drawn into
+esp_err_t parse_canvas_size(const cJSON *size, uint8_t *width,
+                            uint8_t *height) {
+  const cJSON *sizeW = cJSON_GetObjectItemCaseSensitive(size, "width");
+  const cJSON *sizeH = cJSON_GetObjectItemCaseSensitive(size, "height");
+  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH) ||
+      sizeW->valueint < 1 || sizeW->valueint > UINT8_MAX ||
+      sizeH->valueint < 1 || sizeH->valueint > UINT8_MAX) {
+    return ESP_ERR_INVALID_ARG;
   }
 
-  // we cannot access the array directly, so we have to loop and put the values
-  // into a buffer that we can use with the display buffer
-  const cJSON *pixelValueRed = NULL;
-  const cJSON *pixelValueGreen = NULL;
-  const cJSON *pixelValueBlue = NULL;
-  uint16_t bufIndex = 0;
-  cJSON_ArrayForEach(pixelValueRed, data_red) {
-    pixelValueGreen = cJSON_GetArrayItem(data_green, bufIndex);
-    pixelValueBlue = cJSON_GetArrayItem(data_blue, bufIndex);
-    if (cJSON_IsNumber(pixelValueRed) && cJSON_IsNumber(pixelValueGreen) &&
-        cJSON_IsNumber(pixelValueBlue)) {
-      command->value.bitmap->data_red[bufIndex] =
-          (uint8_t)pixelValueRed->valueint;
-      command->value.bitmap->data_green[bufIndex] =
-          (uint8_t)pixelValueGreen->valueint;
-      command->value.bitmap->data_blue[bufIndex] =
-          (uint8_t)pixelValueBlue->valueint;
-    } else {
-      invalid_prop_warn("bitmap", "pixel value");
-      command->value.bitmap->data_red[bufIndex] = 0;
-      command->value.bitmap->data_green[bufIndex] = 0;
-      command->value.bitmap->data_blue[bufIndex] = 0;
+  *width = sizeW->valueint;
+  *height = sizeH->valueint;
+  return ESP_OK;
+}
+
+// the same limits as the animation delay, for an animation's own durations
+uint16_t clamp_frame_duration(int duration) {
+  if (duration < 5) {
+    return 5;
+  }
+  if (duration > 65535) {
+    return 65535;
+  }
+  return (uint16_t)duration;
+}
+
+// Parses how long each frame of an animation is shown for. Frames past the end
+// of `durationsArr` are left as `0`, which shows them for the animation's
+// `delay`.
+esp_err_t parse_animation_durations(command_list_handle_t command_list,
+                                    const cJSON *durationsArr,
+                                    uint16_t frame_count,
+                                    uint16_t **durations) {
+  if (!cJSON_IsArray(durationsArr)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  *durations = (uint16_t *)arena_alloc(command_list->arena,
+                                       sizeof(uint16_t) * frame_count);
+  if (*durations == NULL) {
+    return ESP_ERR_NO_MEM;
+  }
+  memset(*durations, 0, sizeof(uint16_t) * frame_count);
+
+  uint16_t frame = 0;
+  const cJSON *duration = NULL;
+  cJSON_ArrayForEach(duration, durationsArr) {
+    if (!cJSON_IsNumber(duration)) {
+      return ESP_ERR_INVALID_ARG;
     }
-    bufIndex++;
+    if (frame >= frame_count) {
+      break;
+    }
+    (*durations)[frame] = clamp_frame_duration(duration->valueint);
+    frame++;
   }
+  return ESP_OK;
 }
 
 void parse_and_append_animation(command_list_handle_t command_list,
@@ -567,6 +1427,31 @@ void parse_and_append_animation(command_list_handle_t command_list,
     return;
   }
 
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(commandJson, "size");
+  uint8_t canvasWidth = 0;
+  uint8_t canvasHeight = 0;
+  if (size != NULL && !cJSON_IsNull(size) &&
+      parse_canvas_size(size, &canvasWidth, &canvasHeight) != ESP_OK) {
+    invalid_prop_warn("animation", "size");
+    return;
+  }
+
+  const cJSON *durationsArr =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "durations");
+  uint16_t *durations = NULL;
+  if (durationsArr != NULL && !cJSON_IsNull(durationsArr) &&
+      parse_animation_durations(command_list, durationsArr,
+                                cJSON_GetArraySize(framesArr),
+                                &durations) != ESP_OK) {
+    invalid_prop_warn("animation", "durations");
+    return;
+  }
+  const cJSON *delay = cJSON_GetObjectItemCaseSensitive(commandJson, "delay");
+  if (delay != NULL && !cJSON_IsNull(delay) && !cJSON_IsNumber(delay)) {
+    invalid_prop_warn("animation", "delay");
+    return;
+  }
+
   command_handle_t command;
   if (command_list_node_init(command_list, COMMAND_TYPE_ANIMATION, &command) !=
       ESP_OK) {
@@ -575,22 +1460,44 @@ void parse_and_append_animation(command_list_handle_t command_list,
   }
 
   command->value.animation->frame_count = cJSON_GetArraySize(framesArr);
+  command->value.animation->durations = durations;
+  if (cJSON_IsNumber(delay)) {
+    command->value.animation->delay = clamp_frame_duration(delay->valueint);
+  }
   // init the as the "last frame", so that we always start in the first
   command->value.animation->last_show_frame =
       command->value.animation->frame_count - 1;
-  command->value.animation->frames = (void *)malloc(
-      sizeof(command_list_handle_t) * command->value.animation->frame_count);
+  command->value.animation->frames = (void *)arena_calloc(
+      command_list->arena, command->value.animation->frame_count,
+      sizeof(command_list_handle_t));
   if (command->value.animation->frames == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for animation frames");
+    command->value.animation->frame_count = 0;
     return;
   }
 
+  // without a canvas, the frames are still drawn, but each over whatever else
+  // is in the layer instead of over the frame before
+  if (canvasWidth > 0) {
+    display_buffer_handle_t canvas;
+    if (display_buffer_init(&canvas, canvasWidth, canvasHeight) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to create animation canvas");
+    } else if (arena_defer(command_list->arena, command_canvas_cleanup,
+                           canvas) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to keep animation canvas");
+      display_buffer_end(canvas);
+    } else {
+      command->value.animation->canvas = canvas;
+    }
+  }
+
   // the frame we're iterating
   uint16_t frameI = 0;
   const cJSON *frameCommandsArr = NULL;
   // now loop all frames and extract their values
   cJSON_ArrayForEach(frameCommandsArr, framesArr) {
-    if (command_list_init(&command->value.animation->frames[frameI]) !=
+    if (command_list_frame_init(command_list,
+                                &command->value.animation->frames[frameI]) !=
         ESP_OK) {
       ESP_LOGW(TAG, "Failed to init command list for animation frame %u",
                frameI);
@@ -600,6 +1507,9 @@ void parse_and_append_animation(command_list_handle_t command_list,
                         frameCommandsArr, true);
     frameI++;
   }
+  // frames that failed are left out, so every frame up to the count is set
+  command->value.animation->frame_count = frameI;
+  command->value.animation->last_show_frame = frameI - 1;
 }
 
 void parse_and_append_time(command_list_handle_t command_list,
@@ -611,7 +1521,8 @@ void parse_and_append_time(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "time", &command->value.time->state);
+  parse_and_add_state(command_list->arena, commandJson, "time",
+                      &command->value.time->state);
 }
 
 void parse_and_append_date(command_list_handle_t command_list,
@@ -623,7 +1534,8 @@ void parse_and_append_date(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "date", &command->value.date->state);
+  parse_and_add_state(command_list->arena, commandJson, "date",
+                      &command->value.date->state);
 }
 
 void parse_and_append_line_feed(command_list_handle_t command_list,
@@ -645,15 +1557,88 @@ void parse_and_append_set_state(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "setState",
+  parse_and_add_state(command_list->arena, commandJson, "setState",
                       &command->value.set_state->state);
 }
 
+// parses the `series` of a graph command, with `samples` to append to one of
+// the device's series
+esp_err_t parse_graph_series(arena_handle_t arena, const cJSON *seriesJson,
+                             uint8_t width,
+                             command_value_graph_series_t **series_handle) {
+  *series_handle = NULL;
+
+  const cJSON *id = cJSON_GetObjectItemCaseSensitive(seriesJson, "id");
+  const cJSON *samples =
+      cJSON_GetObjectItemCaseSensitive(seriesJson, "samples");
+  if (!cJSON_IsNumber(id) || id->valueint < 0 ||
+      id->valueint >= COMMAND_GRAPH_SERIES_COUNT || !cJSON_IsArray(samples)) {
+    invalid_prop_warn("graph", "series");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  command_value_graph_series_t *series =
+      (command_value_graph_series_t *)arena_alloc(
+          arena, sizeof(command_value_graph_series_t));
+  if (series == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for graph series");
+    return ESP_ERR_NO_MEM;
+  }
+
+  series->id = (uint8_t)id->valueint;
+  // by default there is one sample per column
+  series->capacity = width;
+  const cJSON *capacity =
+      cJSON_GetObjectItemCaseSensitive(seriesJson, "capacity");
+  if (cJSON_IsNumber(capacity)) {
+    if (capacity->valueint > 0 && capacity->valueint <= SERIES_CAPACITY_MAX) {
+      series->capacity = (uint16_t)capacity->valueint;
+    } else {
+      invalid_prop_warn("graph", "series.capacity");
+    }
+  }
+
+  const cJSON *start = cJSON_GetObjectItemCaseSensitive(seriesJson, "start");
+  series->has_start = cJSON_IsNumber(start) && start->valuedouble >= 0;
+  series->start = series->has_start ? (uint32_t)start->valuedouble : 0;
+
+  series->sample_count = cJSON_GetArraySize(samples);
+  series->samples = (int16_t *)arena_alloc(
+      arena, series->sample_count * sizeof(int16_t));
+  if (series->sample_count > 0 && series->samples == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for graph series samples");
+    return ESP_ERR_NO_MEM;
+  }
+
+  const cJSON *sample = NULL;
+  uint16_t sampleIndex = 0;
+  cJSON_ArrayForEach(sample, samples) {
+    if (cJSON_IsNumber(sample)) {
+      // out of range samples are clamped
+      series->samples[sampleIndex] =
+          sample->valueint > INT16_MAX   ? INT16_MAX
+          : sample->valueint < INT16_MIN ? INT16_MIN
+                                         : (int16_t)sample->valueint;
+    } else {
+      invalid_prop_warn("graph", "series.samples");
+      series->samples[sampleIndex] = 0;
+    }
+    sampleIndex++;
+  }
+
+  *series_handle = series;
+
+  return ESP_OK;
+}
+
 void parse_and_append_graph(command_list_handle_t command_list,
                             const cJSON *commandJson) {
   const cJSON *size = cJSON_GetObjectItemCaseSensitive(commandJson, "size");
   const cJSON *values = cJSON_GetObjectItemCaseSensitive(commandJson, "values");
-  if (!cJSON_IsObject(size) || !cJSON_IsArray(values)) {
+  const cJSON *series = cJSON_GetObjectItemCaseSensitive(commandJson, "series");
+  if (!cJSON_IsObject(size) ||
+      (!cJSON_IsArray(values) && !cJSON_IsObject(values) &&
+       !cJSON_IsObject(series))) {
     invalid_shape_warn("graph");
     return;
   }
@@ -672,29 +1657,77 @@ void parse_and_append_graph(command_list_handle_t command_list,
     return;
   }
 
-  parse_and_add_state(commandJson, "graph", &command->value.graph->state);
+  command_value_graph_t *graphValue = command->value.graph;
+  parse_and_add_state(command_list->arena, commandJson, "graph",
+                      &graphValue->state);
 
   const cJSON *bgColor =
       cJSON_GetObjectItemCaseSensitive(commandJson, "backgroundColor");
-  if (cJSON_IsObject(bgColor) && !cJSON_IsNull(bgColor)) {
-    const cJSON *red = cJSON_GetObjectItemCaseSensitive(bgColor, "red");
-    const cJSON *green = cJSON_GetObjectItemCaseSensitive(bgColor, "green");
-    const cJSON *blue = cJSON_GetObjectItemCaseSensitive(bgColor, "blue");
-    if (cJSON_IsNumber(red) && cJSON_IsNumber(green) && cJSON_IsNumber(blue)) {
-      command->value.graph->bg_color_red = (uint8_t)red->valueint;
-      command->value.graph->bg_color_green = (uint8_t)green->valueint;
-      command->value.graph->bg_color_blue = (uint8_t)blue->valueint;
+  if (cJSON_IsObject(bgColor) && !cJSON_IsNull(bgColor) &&
+      parse_color(bgColor, &graphValue->graph.bg_color_red,
+                  &graphValue->graph.bg_color_green,
+                  &graphValue->graph.bg_color_blue) != ESP_OK) {
+    invalid_prop_warn("graph", "backgroundColor");
+  }
+
+  graphValue->graph.width = sizeW->valueint;
+  graphValue->graph.height = sizeH->valueint;
+
+  const cJSON *style = cJSON_GetObjectItemCaseSensitive(commandJson, "style");
+  if (cJSON_IsString(style) && style->valuestring != NULL) {
+    if (strcmp(style->valuestring, "bar") == 0) {
+      graphValue->graph.style = DISPLAY_BUFFER_GRAPH_BAR;
+    } else if (strcmp(style->valuestring, "line") == 0) {
+      graphValue->graph.style = DISPLAY_BUFFER_GRAPH_LINE;
+    } else if (strcmp(style->valuestring, "area") == 0) {
+      graphValue->graph.style = DISPLAY_BUFFER_GRAPH_AREA;
     } else {
-      invalid_prop_warn("graph", "backgroundColor");
+      invalid_prop_warn("graph", "style");
     }
   }
 
-  command->value.graph->width = sizeW->valueint;
-  command->value.graph->height = sizeH->valueint;
-  command->value.graph->values =
-      (uint8_t *)malloc(cJSON_GetArraySize(values) * sizeof(uint8_t));
-  if (command->value.graph->values == NULL) {
+  // without a scale, series graphs fit whatever samples they show
+  const cJSON *scale = cJSON_GetObjectItemCaseSensitive(commandJson, "scale");
+  if (cJSON_IsObject(scale)) {
+    const cJSON *min = cJSON_GetObjectItemCaseSensitive(scale, "min");
+    const cJSON *max = cJSON_GetObjectItemCaseSensitive(scale, "max");
+    if (cJSON_IsNumber(min) && cJSON_IsNumber(max) &&
+        min->valueint < max->valueint && min->valueint >= INT16_MIN &&
+        max->valueint <= INT16_MAX) {
+      graphValue->graph.autoscale = false;
+      graphValue->graph.scale_min = (int16_t)min->valueint;
+      graphValue->graph.scale_max = (int16_t)max->valueint;
+    } else {
+      invalid_prop_warn("graph", "scale");
+    }
+  }
+
+  if (cJSON_IsObject(series)) {
+    parse_graph_series(command_list->arena, series, graphValue->graph.width,
+                       &graphValue->series);
+    return;
+  }
+
+  if (cJSON_IsObject(values)) {
+    uint32_t blobLength;
+    uint8_t *blobData = parse_blob(command_list, values, &blobLength);
+    if (blobData == NULL || blobLength > UINT16_MAX) {
+      invalid_prop_warn("graph", "values");
+      return;
+    }
+
+    graphValue->values = blobData;
+    graphValue->value_count = blobLength;
+    return;
+  }
+
+  graphValue->value_count = cJSON_GetArraySize(values);
+  graphValue->values =
+      (uint8_t *)arena_alloc(command_list->arena,
+                             graphValue->value_count * sizeof(uint8_t));
+  if (graphValue->value_count > 0 && graphValue->values == NULL) {
     ESP_LOGE(TAG, "Failed to allocate memory for graph values");
+    graphValue->value_count = 0;
     return;
   }
 
@@ -702,64 +1735,634 @@ void parse_and_append_graph(command_list_handle_t command_list,
   uint16_t valIndex = 0;
   cJSON_ArrayForEach(value, values) {
     if (cJSON_IsNumber(value)) {
-      command->value.graph->values[valIndex] = (uint8_t)value->valueint;
+      graphValue->values[valIndex] = (uint8_t)value->valueint;
     } else {
       invalid_prop_warn("graph", "value");
-      command->value.graph->values[valIndex] = 0;
+      graphValue->values[valIndex] = 0;
     }
     valIndex++;
   }
 }
 
-void parse_command_array(command_list_handle_t command_list_handle,
-                         const cJSON *commandArray, bool is_in_animation) {
-  uint16_t commandIndex = 0;
-  const cJSON *commandJson = NULL;
+void parse_and_append_rect(command_list_handle_t command_list,
+                           const cJSON *commandJson) {
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(commandJson, "size");
+  if (!cJSON_IsObject(size)) {
+    invalid_shape_warn("rect");
+    return;
+  }
+
+  const cJSON *sizeW = cJSON_GetObjectItemCaseSensitive(size, "width");
+  const cJSON *sizeH = cJSON_GetObjectItemCaseSensitive(size, "height");
+  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH)) {
+    invalid_prop_warn("rect", "size");
+    return;
+  }
+
+  command_handle_t command;
+  if (command_list_node_init(command_list, COMMAND_TYPE_RECT, &command) !=
+      ESP_OK) {
+    ESP_LOGW(TAG, "Failed to init command of type 'rect'");
+    return;
+  }
+
+  parse_and_add_state(command_list->arena, commandJson, "rect",
+                      &command->value.rect->state);
+  command->value.rect->width = sizeW->valueint;
+  command->value.rect->height = sizeH->valueint;
+}
+
+// parses one of an effect's optional byte-sized numbers, such as `speed`
+void parse_effect_byte(const cJSON *commandJson, char *prop, uint8_t *value) {
+  const cJSON *number = cJSON_GetObjectItemCaseSensitive(commandJson, prop);
+  if (!cJSON_IsNumber(number)) {
+    return;
+  }
+  if (number->valueint >= 1 && number->valueint <= UINT8_MAX) {
+    *value = (uint8_t)number->valueint;
+  } else {
+    invalid_prop_warn("effect", prop);
+  }
+}
+
+void parse_and_append_effect(command_list_handle_t command_list,
+                             const cJSON *commandJson) {
+  const cJSON *name = cJSON_GetObjectItemCaseSensitive(commandJson, "effect");
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(commandJson, "size");
+  if (!cJSON_IsString(name) || name->valuestring == NULL ||
+      !cJSON_IsObject(size)) {
+    invalid_shape_warn("effect");
+    return;
+  }
+
+  effect_type_t effectType;
+  if (strcmp(name->valuestring, "plasma") == 0) {
+    effectType = EFFECT_PLASMA;
+  } else if (strcmp(name->valuestring, "fire") == 0) {
+    effectType = EFFECT_FIRE;
+  } else if (strcmp(name->valuestring, "starfield") == 0) {
+    effectType = EFFECT_STARFIELD;
+  } else if (strcmp(name->valuestring, "noise") == 0) {
+    effectType = EFFECT_NOISE;
+  } else {
+    invalid_prop_warn("effect", "effect");
+    return;
+  }
+
+  const cJSON *sizeW = cJSON_GetObjectItemCaseSensitive(size, "width");
+  const cJSON *sizeH = cJSON_GetObjectItemCaseSensitive(size, "height");
+  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH) ||
+      sizeW->valueint < 1 || sizeW->valueint > UINT8_MAX ||
+      sizeH->valueint < 1 || sizeH->valueint > UINT8_MAX) {
+    invalid_prop_warn("effect", "size");
+    return;
+  }
+
+  command_handle_t command;
+  if (command_list_node_init(command_list, COMMAND_TYPE_EFFECT, &command) !=
+      ESP_OK) {
+    ESP_LOGW(TAG, "Failed to init command of type 'effect'");
+    return;
+  }
+
+  command_value_effect_t *effectValue = command->value.effect;
+  parse_and_add_state(command_list->arena, commandJson, "effect",
+                      &effectValue->state);
+
+  if (effect_init(&effectValue->effect, effectType, sizeW->valueint,
+                  sizeH->valueint) != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to create effect");
+    return;
+  }
+
+  if (arena_defer(command_list->arena, command_effect_cleanup,
+                  effectValue->effect) != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to keep effect");
+    effect_end(effectValue->effect);
+    effectValue->effect = NULL;
+    return;
+  }
+
+  effect_handle_t effect = effectValue->effect;
+  parse_effect_byte(commandJson, "speed", &effect->speed);
+  parse_effect_byte(commandJson, "scale", &effect->scale);
+
+  const cJSON *seed = cJSON_GetObjectItemCaseSensitive(commandJson, "seed");
+  if (cJSON_IsNumber(seed)) {
+    effect->seed = (uint32_t)seed->valuedouble;
+  }
+
+  // the effect keeps its own colors when these aren't valid
+  const cJSON *colors = cJSON_GetObjectItemCaseSensitive(commandJson, "colors");
+  display_buffer_fill_stop_t stops[DISPLAY_BUFFER_FILL_STOPS_MAX];
+  uint8_t stopCount;
+  if (colors != NULL &&
+      parse_stops(colors, "effect", "colors", stops, &stopCount) == ESP_OK) {
+    effect_set_ramp(effect, stops, stopCount);
+  }
+
+  effect_reset(effect);
+}
+
+// parses an array of colors into a new palette.
+// `palette_handle` is left as `NULL` if the array is not valid.
+esp_err_t parse_palette(arena_handle_t arena, const cJSON *colors, char *type,
+                        palette_handle_t *palette_handle) {
+  *palette_handle = NULL;
+
+  if (!cJSON_IsArray(colors) || cJSON_GetArraySize(colors) == 0 ||
+      cJSON_GetArraySize(colors) > PALETTE_LENGTH_MAX) {
+    invalid_prop_warn(type, "palette");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t ret =
+      command_palette_init(arena, palette_handle, cJSON_GetArraySize(colors));
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  const cJSON *color = NULL;
+  uint16_t colorIndex = 0;
+  cJSON_ArrayForEach(color, colors) {
+    if (parse_color(color, &(*palette_handle)->red[colorIndex],
+                    &(*palette_handle)->green[colorIndex],
+                    &(*palette_handle)->blue[colorIndex]) != ESP_OK) {
+      // palettes start as black, so just leave it
+      invalid_prop_warn(type, "palette color");
+    }
+    colorIndex++;
+  }
+
+  return ESP_OK;
+}
+
+void parse_and_append_palette(command_list_handle_t command_list,
+                              const cJSON *commandJson) {
+  const cJSON *colors = cJSON_GetObjectItemCaseSensitive(commandJson, "colors");
+  if (!cJSON_IsArray(colors)) {
+    invalid_shape_warn("palette");
+    return;
+  }
+
+  palette_handle_t palette;
+  if (parse_palette(command_list->arena, colors, "palette", &palette) !=
+      ESP_OK) {
+    return;
+  }
+
+  command_handle_t command;
+  if (command_list_node_init(command_list, COMMAND_TYPE_PALETTE, &command) !=
+      ESP_OK) {
+    ESP_LOGW(TAG, "Failed to init command of type 'palette'");
+    return;
+  }
+
+  command->value.palette->palette = palette;
+}
+
+void parse_and_append_layer(command_list_handle_t command_list,
+                            const cJSON *commandJson) {
+  const cJSON *layer = cJSON_GetObjectItemCaseSensitive(commandJson, "layer");
+  if (!cJSON_IsString(layer) || layer->valuestring == NULL) {
+    invalid_shape_warn("layer");
+    return;
+  }
+
+  compositor_layer_id_t layerId;
+  if (strcmp(layer->valuestring, "background") == 0) {
+    layerId = COMPOSITOR_LAYER_BACKGROUND;
+  } else if (strcmp(layer->valuestring, "content") == 0) {
+    layerId = COMPOSITOR_LAYER_CONTENT;
+  } else if (strcmp(layer->valuestring, "overlay") == 0) {
+    layerId = COMPOSITOR_LAYER_OVERLAY;
+  } else {
+    invalid_prop_warn("layer", "layer");
+    return;
+  }
+
+  command_handle_t command;
+  if (command_list_node_init(command_list, COMMAND_TYPE_LAYER, &command) !=
+      ESP_OK) {
+    ESP_LOGW(TAG, "Failed to init command of type 'layer'");
+    return;
+  }
+
+  command->value.layer->layer = layerId;
+
+  const cJSON *opacity =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "opacity");
+  if (cJSON_IsNumber(opacity)) {
+    if (opacity->valueint >= 0 && opacity->valueint <= 255) {
+      command->value.layer->opacity = (uint8_t)opacity->valueint;
+    } else {
+      invalid_prop_warn("layer", "opacity");
+    }
+  }
+
+  const cJSON *blend = cJSON_GetObjectItemCaseSensitive(commandJson, "blend");
+  if (cJSON_IsString(blend) && blend->valuestring != NULL) {
+    if (strcmp(blend->valuestring, "normal") == 0) {
+      command->value.layer->blend = COMPOSITOR_BLEND_NORMAL;
+    } else if (strcmp(blend->valuestring, "add") == 0) {
+      command->value.layer->blend = COMPOSITOR_BLEND_ADD;
+    } else {
+      invalid_prop_warn("layer", "blend");
+    }
+  }
+}
+
+void parse_and_append_indexed_bitmap(command_list_handle_t command_list,
+                                     const cJSON *commandJson) {
+  const cJSON *data = cJSON_GetObjectItemCaseSensitive(commandJson, "data");
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(commandJson, "size");
+  const cJSON *bpp =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "bitsPerPixel");
+  if ((!cJSON_IsArray(data) && !cJSON_IsObject(data)) ||
+      !cJSON_IsObject(size) || !cJSON_IsNumber(bpp)) {
+    invalid_shape_warn("indexed-bitmap");
+    return;
+  }
+
+  if (!palette_is_valid_bpp(bpp->valueint)) {
+    invalid_prop_warn("indexed-bitmap", "bitsPerPixel");
+    return;
+  }
+
+  const cJSON *sizeW = cJSON_GetObjectItemCaseSensitive(size, "width");
+  const cJSON *sizeH = cJSON_GetObjectItemCaseSensitive(size, "height");
+  // the width and height are kept as bytes, and the data's length is worked
+  // out from them, so anything larger would be drawn past the data
+  if (!cJSON_IsNumber(sizeW) || !cJSON_IsNumber(sizeH) ||
+      sizeW->valueint < 1 || sizeW->valueint > UINT8_MAX ||
+      sizeH->valueint < 1 || sizeH->valueint > UINT8_MAX) {
+    invalid_prop_warn("indexed-bitmap", "size");
+    return;
+  }
+
+  const uint16_t dataLength =
+      palette_data_length(sizeW->valueint, sizeH->valueint, bpp->valueint);
+  if (cJSON_IsArray(data) && cJSON_GetArraySize(data) < dataLength) {
+    invalid_prop_warn("indexed-bitmap", "data");
+    return;
+  }
+
+  command_handle_t command;
+  if (command_list_node_init(command_list, COMMAND_TYPE_INDEXED_BITMAP,
+                             &command) != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to init command of type 'indexed-bitmap'");
+    return;
+  }
+
+  parse_and_add_state(command_list->arena, commandJson, "indexed-bitmap",
+                      &command->value.indexed_bitmap->state);
+  parse_and_add_transform(commandJson, "indexed-bitmap",
+                          &command->value.indexed_bitmap->transform);
+
+  const cJSON *colors =
+      cJSON_GetObjectItemCaseSensitive(commandJson, "palette");
+  if (colors != NULL && !cJSON_IsNull(colors)) {
+    parse_palette(command_list->arena, colors, "indexed-bitmap",
+                  &command->value.indexed_bitmap->palette);
+  }
+
+  if (cJSON_IsObject(data)) {
+    command->value.indexed_bitmap->data =
+        parse_asset(command_list, data, dataLength);
+    if (command->value.indexed_bitmap->data == NULL) {
+      invalid_prop_warn("indexed-bitmap", "data");
+      return;
+    }
+  } else {
+    asset_handle_t asset;
+    if (asset_init(&asset, dataLength, COMMAND_LIST_CAPS) != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to allocate memory for indexed bitmap data");
+      return;
+    }
+
+    const cJSON *packedValue = NULL;
+    uint16_t dataIndex = 0;
+    cJSON_ArrayForEach(packedValue, data) {
+      if (dataIndex >= dataLength) {
+        break;
+      }
+      if (cJSON_IsNumber(packedValue)) {
+        asset->data[dataIndex] = (uint8_t)packedValue->valueint;
+      } else {
+        invalid_prop_warn("indexed-bitmap", "data value");
+        asset->data[dataIndex] = 0;
+      }
+      dataIndex++;
+    }
+
+    // identical icons, such as in each frame of an animation, are kept once
+    command->value.indexed_bitmap->data =
+        command_list_hold_asset(command_list, asset_share(asset));
+    if (command->value.indexed_bitmap->data == NULL) {
+      return;
+    }
+  }
+
+  // only set these once the data is valid, so a zero sized bitmap is drawn if
+  // anything above failed
+  command->value.indexed_bitmap->width = sizeW->valueint;
+  command->value.indexed_bitmap->height = sizeH->valueint;
+  command->value.indexed_bitmap->bits_per_pixel = bpp->valueint;
+}
+
+// parses the values of one keyframe of a tween. Values that a property doesn't
+// use are left as `0`.
+esp_err_t parse_tween_values(const cJSON *valueJson,
+                             command_tween_property_t property,
+                             uint8_t *values) {
+  values[0] = 0;
+  values[1] = 0;
+  values[2] = 0;
+  if (property == TWEEN_PROPERTY_VALUE ||
+      property == TWEEN_PROPERTY_HUE_ROTATE) {
+    if (!cJSON_IsNumber(valueJson) || valueJson->valueint < 0 ||
+        valueJson->valueint > UINT8_MAX) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    values[0] = valueJson->valueint;
+    return ESP_OK;
+  }
+
+  if (!cJSON_IsObject(valueJson)) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  // colors are tweened as RGB, whichever way the keyframes give them
+  if (property == TWEEN_PROPERTY_COLOR) {
+    return parse_color(valueJson, &values[0], &values[1], &values[2]);
+  }
+
+  char *positionNames[] = {"x", "y"};
+  char *sizeNames[] = {"width", "height"};
+  char **names =
+      property == TWEEN_PROPERTY_POSITION ? positionNames : sizeNames;
+  for (uint8_t i = 0; i < 2; i++) {
+    const cJSON *number = cJSON_GetObjectItemCaseSensitive(valueJson, names[i]);
+    if (!cJSON_IsNumber(number) || number->valueint < 0 ||
+        number->valueint > UINT8_MAX) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    values[i] = number->valueint;
+  }
+
+  return ESP_OK;
+}
+
+// Parses a `{property, easing, loop, keyframes}` tween for `command`, where
+// each keyframe is a `{time, value}`. Tweens of the position, color or hue
+// rotation give the command a state if it doesn't have one yet.
+esp_err_t parse_tween(arena_handle_t arena, const cJSON *tweenJson,
+                      command_handle_t command, command_tween_t *tween) {
+  const cJSON *property =
+      cJSON_GetObjectItemCaseSensitive(tweenJson, "property");
+  const cJSON *easing = cJSON_GetObjectItemCaseSensitive(tweenJson, "easing");
+  const cJSON *loop = cJSON_GetObjectItemCaseSensitive(tweenJson, "loop");
+  const cJSON *keyframes =
+      cJSON_GetObjectItemCaseSensitive(tweenJson, "keyframes");
+  int keyframeCount = cJSON_GetArraySize(keyframes);
+  if (!cJSON_IsString(property) || property->valuestring == NULL ||
+      !cJSON_IsArray(keyframes) || keyframeCount < 1 ||
+      keyframeCount > COMMAND_TWEEN_KEYFRAMES_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  bool isValuesGraph = command->type == COMMAND_TYPE_GRAPH &&
+                       command->value.graph->series == NULL &&
+                       command->value.graph->value_count > 0;
+  command_state_t **stateField = command_state_field(command);
+  if (strcmp(property->valuestring, "position") == 0 && stateField != NULL) {
+    tween->property = TWEEN_PROPERTY_POSITION;
+  } else if (strcmp(property->valuestring, "color") == 0 &&
+             stateField != NULL) {
+    tween->property = TWEEN_PROPERTY_COLOR;
+  } else if (strcmp(property->valuestring, "size") == 0 &&
+             (command->type == COMMAND_TYPE_RECT ||
+              command->type == COMMAND_TYPE_GRAPH)) {
+    tween->property = TWEEN_PROPERTY_SIZE;
+  } else if (strcmp(property->valuestring, "value") == 0 && isValuesGraph) {
+    tween->property = TWEEN_PROPERTY_VALUE;
+  } else if (strcmp(property->valuestring, "hue-rotate") == 0 &&
+             stateField != NULL) {
+    tween->property = TWEEN_PROPERTY_HUE_ROTATE;
+  } else {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  tween->easing = TWEEN_EASING_LINEAR;
+  if (cJSON_IsString(easing) && easing->valuestring != NULL) {
+    if (strcmp(easing->valuestring, "ease-in") == 0) {
+      tween->easing = TWEEN_EASING_IN;
+    } else if (strcmp(easing->valuestring, "ease-out") == 0) {
+      tween->easing = TWEEN_EASING_OUT;
+    } else if (strcmp(easing->valuestring, "ease-in-out") == 0) {
+      tween->easing = TWEEN_EASING_IN_OUT;
+    }
+  }
+
+  tween->loop = TWEEN_LOOP_NONE;
+  if (cJSON_IsString(loop) && loop->valuestring != NULL) {
+    if (strcmp(loop->valuestring, "repeat") == 0) {
+      tween->loop = TWEEN_LOOP_REPEAT;
+    } else if (strcmp(loop->valuestring, "alternate") == 0) {
+      tween->loop = TWEEN_LOOP_ALTERNATE;
+    }
+  }
+
+  tween->keyframes = (command_tween_keyframe_t *)arena_alloc(
+      arena, sizeof(command_tween_keyframe_t) * keyframeCount);
+  if (tween->keyframes == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for tween keyframes");
+    return ESP_ERR_NO_MEM;
+  }
+
+  tween->keyframe_count = 0;
+  const cJSON *keyframeJson = NULL;
+  cJSON_ArrayForEach(keyframeJson, keyframes) {
+    const cJSON *time = cJSON_GetObjectItemCaseSensitive(keyframeJson, "time");
+    const cJSON *value =
+        cJSON_GetObjectItemCaseSensitive(keyframeJson, "value");
+    command_tween_keyframe_t *keyframe =
+        &tween->keyframes[tween->keyframe_count];
+    // times are kept to an `int`, so a tween that alternates can't overflow
+    if (!cJSON_IsNumber(time) || time->valueint < 0 ||
+        (tween->keyframe_count > 0 &&
+         (uint32_t)time->valueint <
+             tween->keyframes[tween->keyframe_count - 1].time) ||
+        parse_tween_values(value, tween->property, keyframe->values) !=
+            ESP_OK) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    keyframe->time = time->valueint;
+    tween->keyframe_count++;
+  }
+
+  if (tween->property == TWEEN_PROPERTY_POSITION ||
+      tween->property == TWEEN_PROPERTY_COLOR ||
+      tween->property == TWEEN_PROPERTY_HUE_ROTATE) {
+    if (*stateField == NULL &&
+        command_state_init(arena, stateField) != ESP_OK) {
+      return ESP_ERR_NO_MEM;
+    }
+    if (tween->property == TWEEN_PROPERTY_POSITION) {
+      command_state_set_flag_position(*stateField);
+    } else if (tween->property == TWEEN_PROPERTY_COLOR) {
+      command_state_set_flag_color(*stateField);
+    } else {
+      command_state_set_flag_hue_rotate(*stateField);
+    }
+  }
+
+  return ESP_OK;
+}
+
+// Parses the optional `tweens` of a command that was just appended. Tweens
+// that aren't valid for the command are skipped.
+void parse_and_add_tweens(arena_handle_t arena, const cJSON *commandJson,
+                          char *type, command_handle_t command) {
+  const cJSON *tweens = cJSON_GetObjectItemCaseSensitive(commandJson, "tweens");
+  if (tweens == NULL) {
+    return;
+  }
+
+  int tweenCount = cJSON_GetArraySize(tweens);
+  if (!cJSON_IsArray(tweens) || tweenCount < 1 || tweenCount > UINT8_MAX) {
+    invalid_prop_warn(type, "tweens");
+    return;
+  }
+
+  command->tweens = (command_tween_t *)arena_alloc(
+      arena, sizeof(command_tween_t) * tweenCount);
+  if (command->tweens == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for tweens");
+    return;
+  }
+
+  const cJSON *tweenJson = NULL;
+  cJSON_ArrayForEach(tweenJson, tweens) {
+    if (parse_tween(arena, tweenJson, command,
+                    &command->tweens[command->tween_count]) == ESP_OK) {
+      command->tween_count++;
+    } else {
+      invalid_prop_warn(type, "tweens");
+    }
+  }
+}
+
+// Parses one command of a command array and appends it to the list
+void parse_command(command_list_handle_t command_list_handle,
+                   const cJSON *commandJson, uint16_t commandIndex,
+                   bool is_in_animation) {
   const cJSON *commandType = NULL;
 
-  cJSON_ArrayForEach(commandJson, commandArray) {
-    if (cJSON_IsObject(commandJson)) {
-      commandType = cJSON_GetObjectItemCaseSensitive(commandJson, "type");
-      if (cJSON_IsString(commandType) && commandType->valuestring != NULL) {
-        if (strcmp(commandType->valuestring, "string") == 0) {
-          parse_and_append_string(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "line") == 0) {
-          parse_and_append_line(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "bitmap") == 0) {
-          parse_and_append_bitmap(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "line-feed") == 0) {
-          parse_and_append_line_feed(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "set-state") == 0) {
-          parse_and_append_set_state(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "animation") == 0) {
-          if (is_in_animation == true) {
-            ESP_LOGW(TAG, "Nested animations are not supported (command %u)",
-                     commandIndex);
-          } else {
-            parse_and_append_animation(command_list_handle, commandJson);
-          }
-        } else if (strcmp(commandType->valuestring, "time") == 0) {
-          parse_and_append_time(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "date") == 0) {
-          parse_and_append_date(command_list_handle, commandJson);
-        } else if (strcmp(commandType->valuestring, "graph") == 0) {
-          parse_and_append_graph(command_list_handle, commandJson);
+  // any command can have tweens, so they're added to whatever was appended
+  command_list_node_t *tail = command_list_handle->tail;
+  if (cJSON_IsObject(commandJson)) {
+    commandType = cJSON_GetObjectItemCaseSensitive(commandJson, "type");
+    if (cJSON_IsString(commandType) && commandType->valuestring != NULL) {
+      if (strcmp(commandType->valuestring, "string") == 0) {
+        parse_and_append_string(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "line") == 0) {
+        parse_and_append_line(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "bitmap") == 0) {
+        parse_and_append_bitmap(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "line-feed") == 0) {
+        parse_and_append_line_feed(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "set-state") == 0) {
+        parse_and_append_set_state(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "animation") == 0) {
+        if (is_in_animation == true) {
+          ESP_LOGW(TAG, "Nested animations are not supported (command %u)",
+                   commandIndex);
         } else {
-          ESP_LOGW(TAG, "Command %u does not have a valid 'type'",
+          parse_and_append_animation(command_list_handle, commandJson);
+        }
+      } else if (strcmp(commandType->valuestring, "time") == 0) {
+        parse_and_append_time(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "date") == 0) {
+        parse_and_append_date(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "graph") == 0) {
+        parse_and_append_graph(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "indexed-bitmap") == 0) {
+        parse_and_append_indexed_bitmap(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "rect") == 0) {
+        parse_and_append_rect(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "effect") == 0) {
+        parse_and_append_effect(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "palette") == 0) {
+        parse_and_append_palette(command_list_handle, commandJson);
+      } else if (strcmp(commandType->valuestring, "layer") == 0) {
+        if (is_in_animation == true) {
+          ESP_LOGW(TAG, "Animations cannot change layers (command %u)",
                    commandIndex);
+        } else {
+          parse_and_append_layer(command_list_handle, commandJson);
         }
       } else {
-        ESP_LOGW(TAG, "Command %u does not have a 'string' 'type'",
-                 commandIndex);
+        ESP_LOGW(TAG, "Command %u does not have a valid 'type'", commandIndex);
       }
     } else {
-      ESP_LOGW(TAG, "Command %u is not an object", commandIndex);
+      ESP_LOGW(TAG, "Command %u does not have a 'string' 'type'", commandIndex);
     }
+  } else {
+    ESP_LOGW(TAG, "Command %u is not an object", commandIndex);
+  }
+
+  if (command_list_handle->tail != tail) {
+    parse_and_add_tweens(command_list_handle->arena, commandJson,
+                         commandType->valuestring,
+                         command_list_handle->tail->command);
+    if (command_hue_rotate_init(command_list_handle->arena,
+                                command_list_handle->tail->command) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to rotate the hue of command %u", commandIndex);
+    }
+  }
+}
+
+void parse_command_array(command_list_handle_t command_list_handle,
+                         const cJSON *commandArray, bool is_in_animation) {
+  uint16_t commandIndex = 0;
+  const cJSON *commandJson = NULL;
 
+  cJSON_ArrayForEach(commandJson, commandArray) {
+    parse_command(command_list_handle, commandJson, commandIndex,
+                  is_in_animation);
     commandIndex++;
   }
 }
 
+// Parses the JSON of a response into a new command list. `blobs` are the blobs
+// of a binary response that its commands can point into, or `NULL`.
+esp_err_t parse_response(command_list_handle_t *command_list_handle,
+                         const cJSON *json, uint8_t *blobs,
+                         uint32_t blobs_length) {
+  ESP_RETURN_ON_FALSE(cJSON_IsObject(json) && !cJSON_IsNull(json),
+                      ESP_ERR_INVALID_RESPONSE, TAG,
+                      "JSON response is not an object");
+
+  const cJSON *commandArray =
+      cJSON_GetObjectItemCaseSensitive(json, "commands");
+
+  ESP_RETURN_ON_FALSE(cJSON_IsArray(commandArray), ESP_ERR_INVALID_RESPONSE,
+                      TAG, "response.commands is not an array");
+
+  ESP_RETURN_ON_FALSE(command_list_init(command_list_handle) == ESP_OK,
+                      ESP_ERR_NO_MEM, TAG, "Failed to init command list");
+
+  (*command_list_handle)->blobs = blobs;
+  (*command_list_handle)->blobs_length = blobs_length;
+
+  parse_and_add_config(cJSON_GetObjectItemCaseSensitive(json, "config"),
+                       *command_list_handle);
+
+  parse_command_array(*command_list_handle, commandArray, false);
+
+  return ESP_OK;
+}
+
 esp_err_t command_list_parse(command_list_handle_t *command_list_handle,
                              char *data, size_t length) {
   esp_err_t ret = ESP_OK;
@@ -769,26 +2372,289 @@ esp_err_t command_list_parse(command_list_handle_t *command_list_handle,
                     command_list_parse_cleanup, TAG,
                     "Invalid JSON response or content length");
 
-  ESP_GOTO_ON_FALSE(cJSON_IsObject(json) && !cJSON_IsNull(json),
-                    ESP_ERR_INVALID_RESPONSE, command_list_parse_cleanup, TAG,
-                    "JSON response is not an object");
+  ret = parse_response(command_list_handle, json, NULL, 0);
 
-  const cJSON *commandArray =
-      cJSON_GetObjectItemCaseSensitive(json, "commands");
+command_list_parse_cleanup:
+  cJSON_Delete(json);
+  return ret;
+}
 
-  ESP_GOTO_ON_FALSE(cJSON_IsArray(commandArray), ESP_ERR_INVALID_RESPONSE,
-                    command_list_parse_cleanup, TAG,
-                    "response.commands is not an array");
+// Decodes a binary response, as described by `COMMAND_WIRE_MAGIC`. Only the
+// JSON section goes through cJSON, and bitmaps and graph values point straight
+// into the blobs after it. On success the command list takes the response, so
+// `*data_handle` is set to `NULL`.
+esp_err_t command_list_decode(command_list_handle_t *command_list_handle,
+                              char **data_handle, size_t length) {
+  esp_err_t ret = ESP_OK;
+  cJSON *json = NULL;
+  uint8_t *data = (uint8_t *)*data_handle;
 
-  ESP_GOTO_ON_FALSE(command_list_init(command_list_handle) == ESP_OK,
-                    ESP_ERR_NO_MEM, command_list_parse_cleanup, TAG,
-                    "Failed to init command list");
+  ESP_GOTO_ON_FALSE(command_wire_is_binary(data, length),
+                    ESP_ERR_INVALID_RESPONSE, command_list_decode_cleanup, TAG,
+                    "Binary response is too short or has no header");
 
-  parse_and_add_config(json, *command_list_handle);
+  ESP_GOTO_ON_FALSE(data[3] == COMMAND_WIRE_VERSION, ESP_ERR_NOT_SUPPORTED,
+                    command_list_decode_cleanup, TAG,
+                    "Binary response version %u is not supported", data[3]);
 
-  parse_command_array(*command_list_handle, commandArray, false);
+  const uint32_t jsonLength =
+      data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+  ESP_GOTO_ON_FALSE(jsonLength <= length - COMMAND_WIRE_HEADER_LENGTH,
+                    ESP_ERR_INVALID_RESPONSE, command_list_decode_cleanup, TAG,
+                    "Binary response is shorter than its JSON");
 
-command_list_parse_cleanup:
+  json = cJSON_ParseWithLength((char *)data + COMMAND_WIRE_HEADER_LENGTH,
+                               jsonLength);
+  ESP_GOTO_ON_FALSE(json != NULL, ESP_ERR_INVALID_RESPONSE,
+                    command_list_decode_cleanup, TAG,
+                    "Invalid JSON in binary response");
+
+  const uint32_t blobsOffset = COMMAND_WIRE_HEADER_LENGTH + jsonLength;
+  ret = parse_response(command_list_handle, json, data + blobsOffset,
+                       length - blobsOffset);
+  // bitmaps point into the response, so it is freed along with the list
+  if (ret == ESP_OK && arena_defer((*command_list_handle)->arena, free,
+                                   *data_handle) != ESP_OK) {
+    command_list_end(*command_list_handle);
+    *command_list_handle = NULL;
+    ret = ESP_ERR_NO_MEM;
+  }
+  if (ret == ESP_OK) {
+    *data_handle = NULL;
+  }
+
+command_list_decode_cleanup:
   cJSON_Delete(json);
   return ret;
 }
+
+// --------
+// Below are the functions related to parsing a response as it arrives. The
+// stream only works out where each value starts and ends, and leaves parsing
+// the values themselves to cJSON.
+// --------
+
+esp_err_t command_stream_init(command_stream_handle_t *stream_handle) {
+  command_stream_handle_t stream =
+      (command_stream_handle_t)calloc(1, sizeof(command_stream_t));
+  if (stream == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for command stream");
+    *stream_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  *stream_handle = stream;
+  return ESP_OK;
+}
+
+void command_stream_end(command_stream_handle_t stream) {
+  if (stream == NULL) {
+    return;
+  }
+
+  // only set if the stream wasn't finished
+  if (stream->command_list != NULL) {
+    command_list_end(stream->command_list);
+  }
+  free(stream->buffer);
+  free(stream);
+}
+
+// grows the buffer to fit `length` more bytes. It doubles, so that keeping a
+// value a byte at a time is cheap.
+esp_err_t stream_reserve(command_stream_handle_t stream, size_t length) {
+  if (stream->length + length <= stream->capacity) {
+    return ESP_OK;
+  }
+
+  size_t capacity = stream->capacity > 0 ? stream->capacity : 256;
+  while (capacity < stream->length + length) {
+    capacity *= 2;
+  }
+
+  char *buffer = (char *)realloc(stream->buffer, capacity);
+  ESP_RETURN_ON_FALSE(buffer != NULL, ESP_ERR_NO_MEM, TAG,
+                      "Failed to grow the command stream to %u bytes",
+                      capacity);
+
+  stream->buffer = buffer;
+  stream->capacity = capacity;
+  return ESP_OK;
+}
+
+esp_err_t stream_keep(command_stream_handle_t stream, char c) {
+  ESP_RETURN_ON_ERROR(stream_reserve(stream, 1), TAG,
+                      "Failed to keep a value of the response");
+  stream->buffer[stream->length++] = c;
+  return ESP_OK;
+}
+
+// parses the kept value, now that it's complete, and starts the next one
+esp_err_t stream_parse_value(command_stream_handle_t stream) {
+  cJSON *json = cJSON_ParseWithLength(stream->buffer, stream->length);
+  stream->length = 0;
+  stream->value_depth = 0;
+
+  ESP_RETURN_ON_FALSE(json != NULL, ESP_ERR_INVALID_RESPONSE, TAG,
+                      "Invalid JSON in response.%s", stream->key);
+
+  if (stream->is_in_commands) {
+    parse_command(stream->command_list, json, stream->command_index, false);
+  } else {
+    parse_and_add_config(json, stream->command_list);
+  }
+
+  cJSON_Delete(json);
+  return ESP_OK;
+}
+
+// reads one byte of a JSON response. Only the bytes of `config` and of each
+// command are kept, and everything else is skipped.
+esp_err_t stream_scan(command_stream_handle_t stream, char c) {
+  const bool isKept = stream->value_depth > 0;
+
+  if (stream->is_in_string) {
+    if (stream->is_escaped) {
+      stream->is_escaped = false;
+    } else if (c == '\\') {
+      stream->is_escaped = true;
+    } else if (c == '"') {
+      stream->is_in_string = false;
+      stream->is_in_key = false;
+    }
+
+    if (stream->is_in_key &&
+        stream->key_length < COMMAND_STREAM_KEY_LENGTH - 1) {
+      stream->key[stream->key_length++] = c;
+      stream->key[stream->key_length] = '\0';
+    }
+    return isKept ? stream_keep(stream, c) : ESP_OK;
+  }
+
+  if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+    return ESP_OK;
+  }
+
+  // anything but an object in `commands` is skipped, like a parsed response
+  if (stream->is_in_commands && stream->depth == 2 && c != ',' && c != ']') {
+    if (!stream->is_command_started && c != '{') {
+      ESP_LOGW(TAG, "Command %u is not an object", stream->command_index);
+    }
+    stream->is_command_started = true;
+  }
+
+  switch (c) {
+  case '"':
+    stream->is_in_string = true;
+    if (stream->depth == 1 && stream->is_expecting_key) {
+      stream->is_expecting_key = false;
+      stream->is_in_key = true;
+      stream->key_length = 0;
+      stream->key[0] = '\0';
+    }
+    break;
+  case '{':
+  case '[':
+    if (isKept) {
+      // nothing to tell apart inside a kept value
+    } else if (stream->depth == 0) {
+      stream->is_expecting_key = true;
+    } else if (stream->depth == 1 && c == '{' &&
+               strcmp(stream->key, "config") == 0) {
+      stream->value_depth = 1;
+    } else if (stream->depth == 1 && c == '[' &&
+               strcmp(stream->key, "commands") == 0) {
+      stream->is_in_commands = true;
+      stream->has_commands = true;
+    } else if (stream->depth == 2 && c == '{' && stream->is_in_commands) {
+      stream->value_depth = 2;
+    }
+    stream->depth++;
+    break;
+  case '}':
+  case ']':
+    ESP_RETURN_ON_FALSE(stream->depth > 0, ESP_ERR_INVALID_RESPONSE, TAG,
+                        "Invalid JSON response");
+    stream->depth--;
+    if (isKept && stream->depth == stream->value_depth) {
+      ESP_RETURN_ON_ERROR(stream_keep(stream, c), TAG,
+                          "Failed to keep a value of the response");
+      return stream_parse_value(stream);
+    }
+    if (stream->depth == 1) {
+      stream->is_in_commands = false;
+    }
+    break;
+  case ',':
+    if (stream->depth == 1) {
+      stream->is_expecting_key = true;
+    } else if (stream->depth == 2 && stream->is_in_commands) {
+      stream->command_index++;
+      stream->is_command_started = false;
+    }
+    break;
+  }
+
+  // whichever value is kept is read from where its first brace was
+  return stream->value_depth > 0 ? stream_keep(stream, c) : ESP_OK;
+}
+
+// Reads the next chunk of a response. Commands are parsed and appended as soon
+// as each one is complete, and their bytes are let go of.
+esp_err_t command_stream_feed(command_stream_handle_t stream, const char *data,
+                              size_t length) {
+  if (stream->error != ESP_OK || length == 0) {
+    return stream->error;
+  }
+
+  if (!stream->is_started) {
+    stream->is_started = true;
+    // JSON can't start with the magic, so the first byte tells them apart
+    stream->is_binary = data[0] == COMMAND_WIRE_MAGIC[0];
+    if (!stream->is_binary) {
+      stream->error = command_list_init(&stream->command_list);
+    }
+  }
+
+  if (stream->is_binary) {
+    stream->error = stream_reserve(stream, length);
+    if (stream->error == ESP_OK) {
+      memcpy(stream->buffer + stream->length, data, length);
+      stream->length += length;
+    }
+    return stream->error;
+  }
+
+  for (size_t i = 0; i < length && stream->error == ESP_OK; i++) {
+    stream->error = stream_scan(stream, data[i]);
+  }
+
+  return stream->error;
+}
+
+// Finishes a stream once the whole response has arrived. On success the
+// command list is handed over, and is no longer freed by `command_stream_end`.
+esp_err_t command_stream_finish(command_stream_handle_t stream,
+                                command_list_handle_t *command_list_handle) {
+  ESP_RETURN_ON_ERROR(stream->error, TAG, "Failed to read the response");
+
+  if (stream->is_binary) {
+    // the list keeps the buffer, so it shouldn't keep any room to spare
+    char *buffer = (char *)realloc(stream->buffer, stream->length);
+    if (buffer != NULL) {
+      stream->buffer = buffer;
+      stream->capacity = stream->length;
+    }
+    return command_list_decode(command_list_handle, &stream->buffer,
+                               stream->length);
+  }
+
+  ESP_RETURN_ON_FALSE(stream->has_commands && stream->depth == 0 &&
+                          !stream->is_in_string,
+                      ESP_ERR_INVALID_RESPONSE, TAG,
+                      "Invalid JSON response or content length");
+
+  *command_list_handle = stream->command_list;
+  stream->command_list = NULL;
+  return ESP_OK;
+}
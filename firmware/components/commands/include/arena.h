@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// the size of the blocks that allocations are carved from. Anything bigger
+// than a quarter of this gets a block of its own.
+#define ARENA_BLOCK_SIZE 4096
+// every allocation starts on a multiple of this
+#define ARENA_ALIGN 8
+
+#define arena_align(size)                                                      \
+  (((size_t)(size) + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1))
+
+// called by `arena_end` for memory that the arena doesn't own itself
+typedef void (*arena_cleanup_t)(void *arg);
+
+typedef struct arena_block_t {
+  struct arena_block_t *next;
+  // how much of the block has been handed out
+  size_t length;
+  size_t capacity;
+} arena_block_t;
+
+typedef struct arena_cleanup_node_t {
+  arena_cleanup_t cleanup;
+  void *arg;
+  struct arena_cleanup_node_t *next;
+} arena_cleanup_node_t;
+
+// A bump allocator. Allocations are never freed one at a time, and all of them
+// go at once with `arena_end`, which frees a handful of blocks no matter how
+// many allocations there were. The arena is kept in its own first block.
+typedef struct {
+  // the block being carved from comes first
+  arena_block_t *blocks;
+  arena_cleanup_node_t *cleanups;
+  // the `MALLOC_CAP_*` that blocks are allocated with
+  uint32_t caps;
+} arena_t;
+
+typedef arena_t *arena_handle_t;
+
+esp_err_t arena_init(arena_handle_t *arena_handle, uint32_t caps);
+void *arena_alloc(arena_handle_t arena, size_t size);
+void *arena_calloc(arena_handle_t arena, size_t count, size_t size);
+char *arena_strdup(arena_handle_t arena, const char *value);
+esp_err_t arena_defer(arena_handle_t arena, arena_cleanup_t cleanup,
+                      void *arg);
+void arena_end(arena_handle_t arena);
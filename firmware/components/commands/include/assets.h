@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// how many lists of assets with the same low bits of their hash there are
+#define ASSET_BUCKET_COUNT 64
+// the hex digits of a hash, which is how the server refers to an asset
+#define ASSET_HASH_LENGTH 16
+// the most assets that the server is told about, so the header stays small
+#define ASSET_HEADER_COUNT 32
+// the hashes of `ASSET_HEADER_COUNT` assets, with commas and a null terminator
+#define ASSET_HEADER_LENGTH (ASSET_HEADER_COUNT * (ASSET_HASH_LENGTH + 1))
+
+// Bitmap data kept once however many commands use it, found by the hash of its
+// bytes. Command lists hold a reference to each asset they use, so an asset
+// that the next list uses too survives the lists being swapped, and isn't
+// parsed or allocated again. Assets aren't locked, so they're only used from
+// the task that parses and ends command lists. Lists that another task
+// swaps out are handed back to that task to be ended.
+typedef struct asset_t {
+  // the next asset in the same bucket
+  struct asset_t *next;
+  uint64_t hash;
+  uint32_t length;
+  // the command lists using the asset. It's freed when the last one is ended.
+  uint32_t refs;
+  // whether it's in the cache, rather than being filled in
+  bool is_shared;
+  uint8_t data[];
+} asset_t;
+
+typedef asset_t *asset_handle_t;
+
+uint64_t asset_hash(const uint8_t *data, uint32_t length);
+esp_err_t asset_init(asset_handle_t *asset_handle, uint32_t length,
+                     uint32_t caps);
+asset_handle_t asset_share(asset_handle_t asset);
+esp_err_t asset_copy(asset_handle_t *asset_handle, const uint8_t *data,
+                     uint32_t length, uint32_t caps);
+asset_handle_t asset_find(uint64_t hash);
+void asset_release(void *asset);
+size_t asset_hashes(char *buffer, size_t size);
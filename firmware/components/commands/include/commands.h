@@ -1,23 +1,38 @@
 #pragma once
 
 #include <stdbool.h>
+#include <string.h>
 
 #include "esp_err.h"
 
+#include "arena.h"
+#include "gfx/compositor.h"
+#include "gfx/display_buffer.h"
+#include "gfx/effect.h"
 #include "gfx/font.h"
+#include "gfx/palette.h"
 
 // -------- Shared across all commands
 
 // 1000MS
 #define COMMAND_CONFIG_ANIMATION_DELAY_DEFAULT 1000
+// 500MS
+#define COMMAND_CONFIG_TRANSITION_DURATION_DEFAULT 500
 
 typedef struct {
   uint16_t animation_delay;
+  // how the display changes to this command list from the last one
+  compositor_transition_t transition;
+  compositor_direction_t transition_direction;
+  uint16_t transition_duration;
 } command_config_t;
 
 #define COMMAND_STATE_FLAGS_COLOR (1 << 0)
 #define COMMAND_STATE_FLAGS_POSITION (1 << 1)
 #define COMMAND_STATE_FLAGS_FONT (1 << 2)
+#define COMMAND_STATE_FLAGS_TEXT_SCALE (1 << 3)
+#define COMMAND_STATE_FLAGS_FILL (1 << 4)
+#define COMMAND_STATE_FLAGS_HUE_ROTATE (1 << 5)
 
 #define command_state_has_color(state)                                         \
   ((bool)((state)->flags & COMMAND_STATE_FLAGS_COLOR))
@@ -25,6 +40,12 @@ typedef struct {
   ((bool)((state)->flags & COMMAND_STATE_FLAGS_POSITION))
 #define command_state_has_font(state)                                          \
   ((bool)((state)->flags & COMMAND_STATE_FLAGS_FONT))
+#define command_state_has_text_scale(state)                                    \
+  ((bool)((state)->flags & COMMAND_STATE_FLAGS_TEXT_SCALE))
+#define command_state_has_fill(state)                                          \
+  ((bool)((state)->flags & COMMAND_STATE_FLAGS_FILL))
+#define command_state_has_hue_rotate(state)                                    \
+  ((bool)((state)->flags & COMMAND_STATE_FLAGS_HUE_ROTATE))
 
 #define command_state_set_flag_color(state)                                    \
   (state)->flags |= COMMAND_STATE_FLAGS_COLOR;
@@ -32,12 +53,24 @@ typedef struct {
   (state)->flags |= COMMAND_STATE_FLAGS_POSITION;
 #define command_state_set_flag_font(state)                                     \
   (state)->flags |= COMMAND_STATE_FLAGS_FONT;
+#define command_state_set_flag_text_scale(state)                               \
+  (state)->flags |= COMMAND_STATE_FLAGS_TEXT_SCALE;
+#define command_state_set_flag_fill(state)                                     \
+  (state)->flags |= COMMAND_STATE_FLAGS_FILL;
+#define command_state_set_flag_hue_rotate(state)                               \
+  (state)->flags |= COMMAND_STATE_FLAGS_HUE_ROTATE;
 #define command_state_clear_flag_color(state)                                  \
   (state)->flags &= ~COMMAND_STATE_FLAGS_COLOR;
 #define command_state_clear_flag_position(state)                               \
   (state)->flags &= ~COMMAND_STATE_FLAGS_POSITION;
 #define command_state_clear_flag_font(state)                                   \
   (state)->flags &= ~COMMAND_STATE_FLAGS_FONT;
+#define command_state_clear_flag_text_scale(state)                             \
+  (state)->flags &= ~COMMAND_STATE_FLAGS_TEXT_SCALE;
+#define command_state_clear_flag_fill(state)                                   \
+  (state)->flags &= ~COMMAND_STATE_FLAGS_FILL;
+#define command_state_clear_flag_hue_rotate(state)                             \
+  (state)->flags &= ~COMMAND_STATE_FLAGS_HUE_ROTATE;
 
 typedef struct {
   uint8_t flags;
@@ -47,6 +80,19 @@ typedef struct {
   uint8_t pos_x;
   uint8_t pos_y;
   font_size_t font_size;
+  uint8_t text_scale;
+  // a gradient or pattern used instead of the color. Setting a color without
+  // a fill goes back to solid colors.
+  display_buffer_fill_t *fill;
+  // turns the color, fill and an indexed bitmap's own palette around the color
+  // wheel, in steps of 1/256
+  uint8_t hue_rotate;
+  // the color and fill after `hue_rotate`. These are worked out whenever the
+  // rotation or color changes, rather than for every pixel.
+  uint8_t rotated_red;
+  uint8_t rotated_green;
+  uint8_t rotated_blue;
+  display_buffer_fill_t *rotated_fill;
 } command_state_t;
 
 #define COMMAND_TYPE_STRING 0
@@ -58,6 +104,11 @@ typedef struct {
 #define COMMAND_TYPE_TIME 6
 #define COMMAND_TYPE_DATE 7
 #define COMMAND_TYPE_GRAPH 8
+#define COMMAND_TYPE_INDEXED_BITMAP 9
+#define COMMAND_TYPE_PALETTE 10
+#define COMMAND_TYPE_LAYER 11
+#define COMMAND_TYPE_RECT 12
+#define COMMAND_TYPE_EFFECT 13
 
 typedef enum {
   type_string = COMMAND_TYPE_STRING,
@@ -69,6 +120,11 @@ typedef enum {
   type_time = COMMAND_TYPE_TIME,
   type_date = COMMAND_TYPE_DATE,
   type_graph = COMMAND_TYPE_GRAPH,
+  type_indexed_bitmap = COMMAND_TYPE_INDEXED_BITMAP,
+  type_palette = COMMAND_TYPE_PALETTE,
+  type_layer = COMMAND_TYPE_LAYER,
+  type_rect = COMMAND_TYPE_RECT,
+  type_effect = COMMAND_TYPE_EFFECT,
 } command_type_enum_t;
 
 // -------- Individual Commands
@@ -91,6 +147,7 @@ typedef struct {
   uint8_t *data_red;
   uint8_t *data_green;
   uint8_t *data_blue;
+  display_buffer_transform_t transform;
 } command_value_bitmap_t;
 
 typedef struct {
@@ -106,8 +163,32 @@ typedef struct {
   uint16_t last_show_frame;
   // have to use the full struct here due to the typedef not being defined yet
   struct command_list_t **frames;
+  // Only for animations with a `size`. Each frame is drawn over the last one
+  // in here as the animation moves to it, so a frame only has to hold what
+  // changed, and the canvas is drawn at the cursor. The first frame starts
+  // from an empty canvas.
+  display_buffer_handle_t canvas;
+  // How long each frame is shown for in milliseconds, where `0` is `delay`,
+  // or `NULL` if none have their own. Animations with durations or a delay
+  // keep their own time instead of moving on with each step, so each can
+  // move at its own rate.
+  uint16_t *durations;
+  // how long frames without a duration are shown for in milliseconds, or `0`
+  // for the animation delay
+  uint16_t delay;
+  // when the next frame of an animation with its own time is due, from
+  // `esp_timer_get_time`, or `0` until it's shown
+  int64_t next_frame_us;
+  // set when the animation moves to another frame, and cleared once it's
+  // measured, so an animation that's still on the same frame isn't redrawn
+  bool is_moved;
 } command_value_animation_t;
 
+// animations that move on by their own frame durations, instead of with each
+// step of the command list
+#define command_animation_is_timed(animation)                                  \
+  ((bool)((animation)->durations != NULL || (animation)->delay > 0))
+
 typedef struct {
   command_state_t *state;
 } command_value_time_t;
@@ -116,16 +197,133 @@ typedef struct {
   command_state_t *state;
 } command_value_date_t;
 
+// how many series the device keeps between command lists
+#define COMMAND_GRAPH_SERIES_COUNT 8
+
+// samples to append to one of the device's series. See `series_append`.
+typedef struct {
+  uint8_t id;
+  uint16_t capacity;
+  // the number of the first sample. Without one, every sample is appended.
+  bool has_start;
+  uint32_t start;
+  int16_t *samples;
+  uint16_t sample_count;
+} command_value_graph_series_t;
+
+// a graph of either `values`, which are already scaled to its height, or of a
+// series that is kept on the device
 typedef struct {
   command_state_t *state;
-  uint8_t height;
-  uint8_t width;
+  display_buffer_graph_t graph;
   uint8_t *values;
-  uint8_t bg_color_red;
-  uint8_t bg_color_green;
-  uint8_t bg_color_blue;
+  uint16_t value_count;
+  command_value_graph_series_t *series;
 } command_value_graph_t;
 
+typedef struct {
+  command_state_t *state;
+  uint8_t height;
+  uint8_t width;
+  uint8_t bits_per_pixel;
+  // packed palette indexes. See `palette_row_stride` for the layout
+  uint8_t *data;
+  // optional palette for just this bitmap. If `NULL`, the current palette from
+  // the last `palette` command is used.
+  palette_handle_t palette;
+  // the bitmap's own palette after its state's `hue_rotate`, if it has both
+  palette_handle_t rotated_palette;
+  display_buffer_transform_t transform;
+} command_value_indexed_bitmap_t;
+
+typedef struct {
+  palette_handle_t palette;
+} command_value_palette_t;
+
+// selects the layer that the following commands draw into. Each layer starts
+// with the default drawing state.
+typedef struct {
+  compositor_layer_id_t layer;
+  uint8_t opacity;
+  compositor_blend_t blend;
+} command_value_layer_t;
+
+// a rectangle at the cursor, drawn with the current fill or color
+typedef struct {
+  command_state_t *state;
+  uint8_t width;
+  uint8_t height;
+} command_value_rect_t;
+
+// a procedural effect at the cursor, stepped once per tick. The effect is
+// `NULL` if it could not be created.
+typedef struct {
+  command_state_t *state;
+  effect_handle_t effect;
+} command_value_effect_t;
+
+// -------- Tweens
+
+// the most keyframes one tween can have
+#define COMMAND_TWEEN_KEYFRAMES_MAX 16
+// a tween's progress between two keyframes, as a fraction of this
+#define COMMAND_TWEEN_PROGRESS_ONE 65536
+
+// what a tween changes. Each keyframe has up to three values for it.
+typedef enum {
+  // the cursor that the command moves to, as `x` and `y`
+  TWEEN_PROPERTY_POSITION = 0,
+  // the color that the command draws with, as `red`, `green` and `blue`
+  TWEEN_PROPERTY_COLOR = 1,
+  // the `width` and `height` of a rect or graph
+  TWEEN_PROPERTY_SIZE = 2,
+  // the newest value of a graph of values
+  TWEEN_PROPERTY_VALUE = 3,
+  // the state's `hue_rotate`, which cycles the colors without a keyframe for
+  // each of them
+  TWEEN_PROPERTY_HUE_ROTATE = 4,
+} command_tween_property_t;
+
+// how a tween moves from one keyframe to the next
+typedef enum {
+  TWEEN_EASING_LINEAR = 0,
+  // starts slowly and speeds up
+  TWEEN_EASING_IN = 1,
+  // starts quickly and slows down
+  TWEEN_EASING_OUT = 2,
+  // starts and ends slowly
+  TWEEN_EASING_IN_OUT = 3,
+} command_tween_easing_t;
+
+// what a tween does after its last keyframe
+typedef enum {
+  // stays at the last keyframe
+  TWEEN_LOOP_NONE = 0,
+  // starts again from the first keyframe
+  TWEEN_LOOP_REPEAT = 1,
+  // goes back through the keyframes, and then forwards again
+  TWEEN_LOOP_ALTERNATE = 2,
+} command_tween_loop_t;
+
+typedef struct {
+  // milliseconds since the command list was first shown. Keyframes are in
+  // order of their time.
+  uint32_t time;
+  uint8_t values[3];
+} command_tween_keyframe_t;
+
+// A property that moves between a few keyframes by how long the command list
+// has been shown, instead of by sending a frame for each step. It is worked
+// out with fixed-point maths each tick, so it moves smoothly at whatever rate
+// the display ticks.
+typedef struct {
+  command_tween_property_t property;
+  command_tween_easing_t easing;
+  command_tween_loop_t loop;
+  uint8_t keyframe_count;
+  command_tween_keyframe_t *keyframes;
+} command_tween_t;
+
 // -------- high-level usage structs/fns
 
 typedef union {
@@ -138,15 +336,53 @@ typedef union {
   command_value_time_t *time;
   command_value_date_t *date;
   command_value_graph_t *graph;
+  command_value_indexed_bitmap_t *indexed_bitmap;
+  command_value_palette_t *palette;
+  command_value_layer_t *layer;
+  command_value_rect_t *rect;
+  command_value_effect_t *effect;
 } command_values_union_t;
 
 typedef struct {
   command_type_enum_t type;
   command_values_union_t value;
+  // where the cursor was and what the command drew the last time it was
+  // applied, used to find what has to be redrawn when either changes
+  uint8_t start_x;
+  uint8_t start_y;
+  display_buffer_rect_t bounds;
+  // where the command left the cursor, so it can be skipped when nothing it
+  // draws is needed
+  uint8_t end_x;
+  uint8_t end_y;
+  // drawn once into its layer's cache, see `command_list_mark_cached`
+  bool is_cached;
+  // applied before each tick, see `command_apply_tweens`
+  command_tween_t *tweens;
+  uint8_t tween_count;
 } command_t;
 
+// commands that draw something different each tick
+#define command_is_dynamic(command)                                            \
+  ((bool)((command)->type == COMMAND_TYPE_ANIMATION ||                         \
+          (command)->type == COMMAND_TYPE_TIME ||                              \
+          (command)->type == COMMAND_TYPE_DATE ||                              \
+          (command)->type == COMMAND_TYPE_EFFECT ||                            \
+          (command)->tween_count > 0))
+
+// commands that only apply their state, draw, and move the cursor
+#define command_only_draws(command)                                            \
+  ((bool)((command)->type == COMMAND_TYPE_STRING ||                            \
+          (command)->type == COMMAND_TYPE_LINE ||                              \
+          (command)->type == COMMAND_TYPE_BITMAP ||                            \
+          (command)->type == COMMAND_TYPE_GRAPH ||                             \
+          (command)->type == COMMAND_TYPE_INDEXED_BITMAP ||                    \
+          (command)->type == COMMAND_TYPE_RECT ||                              \
+          (command)->type == COMMAND_TYPE_EFFECT))
+
 typedef command_t *command_handle_t;
 
+// followed by its command and the command's value, in one allocation
 typedef struct command_list_node_t {
   command_handle_t command;
   struct command_list_node_t *next;
@@ -156,15 +392,102 @@ typedef struct command_list_t {
   command_config_t config;
   command_list_node_t *head;
   command_list_node_t *tail;
+  // where everything in the list is allocated. Animation frames share the
+  // arena of the list they're in.
+  arena_handle_t arena;
+  // the blobs of the binary response these commands were decoded from, which
+  // graph values point straight into. Bitmaps are copied out into assets, see
+  // "assets.h". The arena frees the response along with the list.
+  uint8_t *blobs;
+  uint32_t blobs_length;
 } command_list_t;
 
 typedef command_list_t *command_list_handle_t;
 
-esp_err_t command_state_init(command_state_t **state_handle);
+// -------- Binary responses
+
+// A binary response is `COMMAND_WIRE_MAGIC` and a version byte, the length of
+// a JSON section as 4 little-endian bytes, the JSON, and then the blobs. The
+// JSON is the same as a plain response, except that bitmap data and graph
+// values can be `{blob, length}` offsets into the blobs instead of arrays.
+// In either kind of response, bitmap data can also be `{asset}`, the hash of
+// an asset the device listed in its `X-Assets` header, or a QOI image as
+// `{encoding: "qoi"}` with `base64` or a blob.
+#define COMMAND_WIRE_MAGIC "ILX"
+#define COMMAND_WIRE_VERSION 1
+#define COMMAND_WIRE_HEADER_LENGTH 8
+// what the device asks for, and the server answers with
+#define COMMAND_WIRE_CONTENT_TYPE "application/vnd.illumindex.commands"
+
+#define command_wire_is_binary(data, length)                                   \
+  ((length) >= COMMAND_WIRE_HEADER_LENGTH &&                                   \
+   memcmp((data), COMMAND_WIRE_MAGIC, strlen(COMMAND_WIRE_MAGIC)) == 0)
+
+// -------- Streamed responses
+
+// the longest top-level key of a response that is told apart from the others
+#define COMMAND_STREAM_KEY_LENGTH 16
+
+// Parses a JSON response as it arrives, one chunk at a time. Only the value
+// being read is kept, which is either `config` or one command, so the whole
+// response is never held at once. Binary responses are kept whole instead,
+// as their commands refer to the blobs at the end of them.
+typedef struct {
+  // where the commands are appended as each one is complete
+  command_list_handle_t command_list;
+  // the value being kept until it's complete, or the whole of a binary
+  // response. It keeps its capacity between values, so it only ever grows to
+  // the largest of them.
+  char *buffer;
+  size_t length;
+  size_t capacity;
+  // the top-level key whose value is being read
+  char key[COMMAND_STREAM_KEY_LENGTH];
+  uint8_t key_length;
+  // how many objects and arrays the next byte is in
+  uint16_t depth;
+  // the depth that the kept value starts at, or 0 if nothing is being kept
+  uint16_t value_depth;
+  uint16_t command_index;
+  bool is_started;
+  bool is_binary;
+  bool is_in_string;
+  bool is_escaped;
+  bool is_expecting_key;
+  bool is_in_key;
+  bool is_in_commands;
+  bool has_commands;
+  // whether the current element of `commands` has been seen yet
+  bool is_command_started;
+  // the first error, after which the rest of the response is ignored
+  esp_err_t error;
+} command_stream_t;
+
+typedef command_stream_t *command_stream_handle_t;
+
+esp_err_t command_stream_init(command_stream_handle_t *stream_handle);
+esp_err_t command_stream_feed(command_stream_handle_t stream, const char *data,
+                              size_t length);
+esp_err_t command_stream_finish(command_stream_handle_t stream,
+                                command_list_handle_t *command_list_handle);
+void command_stream_end(command_stream_handle_t stream);
+
+esp_err_t command_state_init(arena_handle_t arena,
+                             command_state_t **state_handle);
 esp_err_t command_list_init(command_list_handle_t *command_list_handle);
 esp_err_t command_list_node_init(command_list_handle_t command_list,
                                  command_type_enum_t type,
                                  command_handle_t *command_handle);
 void command_list_end(command_list_handle_t command_list);
 esp_err_t command_list_parse(command_list_handle_t *command_list_handle,
-                             char *data, size_t length);
\ No newline at end of file
+                             char *data, size_t length);
+esp_err_t command_list_decode(command_list_handle_t *command_list_handle,
+                              char **data_handle, size_t length);
+uint8_t command_list_dynamic_layers(command_list_handle_t command_list);
+uint8_t command_list_mark_cached(command_list_handle_t command_list,
+                                 uint8_t layers);
+command_state_t *command_get_state(command_handle_t command);
+esp_err_t command_hue_rotate_init(arena_handle_t arena,
+                                  command_handle_t command);
+void command_apply_tweens(command_handle_t command, uint32_t elapsed_ms);
+void command_apply_hue_rotate(command_handle_t command);
\ No newline at end of file
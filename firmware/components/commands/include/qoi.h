@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// "qoif", then the width, height, channels and colorspace
+#define QOI_HEADER_LENGTH 14
+// how many colors a QOI stream remembers to refer back to
+#define QOI_INDEX_COUNT 64
+
+// Where the bytes of a QOI image are read from, one at a time. Either the raw
+// bytes of a blob, or a base64 string from JSON that is decoded as it's read,
+// so neither is copied before being decoded.
+typedef struct {
+  const uint8_t *data;
+  // how many bytes or base64 characters there are
+  uint32_t length;
+  uint32_t offset;
+  bool is_base64;
+  // base64 bits that have been read but not used yet
+  uint32_t bits;
+  uint8_t bit_count;
+} qoi_source_t;
+
+void qoi_source_init(qoi_source_t *source, const uint8_t *data,
+                     uint32_t length);
+void qoi_source_init_base64(qoi_source_t *source, const char *base64);
+esp_err_t qoi_decode(qoi_source_t *source, uint32_t width, uint32_t height,
+                     uint8_t *red, uint8_t *green, uint8_t *blue);
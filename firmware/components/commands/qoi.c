@@ -0,0 +1,194 @@
+#include "esp_log.h"
+#include <inttypes.h>
+#include <string.h>
+
+#include "qoi.h"
+
+static const char *TAG = "COMMANDS:QOI";
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MASK_2 0xc0
+
+#define qoi_color_hash(px)                                                     \
+  (((px).r * 3 + (px).g * 5 + (px).b * 7 + (px).a * 11) % QOI_INDEX_COUNT)
+
+typedef struct {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+  uint8_t a;
+} qoi_pixel_t;
+
+// reads from the bytes of a blob
+void qoi_source_init(qoi_source_t *source, const uint8_t *data,
+                     uint32_t length) {
+  source->data = data;
+  source->length = length;
+  source->offset = 0;
+  source->is_base64 = false;
+  source->bits = 0;
+  source->bit_count = 0;
+}
+
+// reads from a null terminated base64 string
+void qoi_source_init_base64(qoi_source_t *source, const char *base64) {
+  qoi_source_init(source, (const uint8_t *)base64, strlen(base64));
+  source->is_base64 = true;
+}
+
+// the 6 bits of a base64 character, or -1 for padding and anything else
+static int8_t qoi_base64_value(uint8_t c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  if (c == '+') {
+    return 62;
+  }
+  if (c == '/') {
+    return 63;
+  }
+  return -1;
+}
+
+// reads the next byte into `value`. Returns false at the end of the source.
+static bool qoi_source_next(qoi_source_t *source, uint8_t *value) {
+  if (!source->is_base64) {
+    if (source->offset >= source->length) {
+      return false;
+    }
+    *value = source->data[source->offset++];
+    return true;
+  }
+
+  // every 4 characters are 3 bytes, so there are at most 2 to read for one
+  while (source->bit_count < 8) {
+    if (source->offset >= source->length) {
+      return false;
+    }
+    const int8_t bits = qoi_base64_value(source->data[source->offset++]);
+    if (bits < 0) {
+      continue;
+    }
+    source->bits = (source->bits << 6) | bits;
+    source->bit_count += 6;
+  }
+  source->bit_count -= 8;
+  *value = (uint8_t)(source->bits >> source->bit_count);
+  return true;
+}
+
+// reads a big endian number from the header
+static bool qoi_source_next_u32(qoi_source_t *source, uint32_t *value) {
+  uint8_t byte;
+  *value = 0;
+  for (uint8_t i = 0; i < 4; i++) {
+    if (!qoi_source_next(source, &byte)) {
+      return false;
+    }
+    *value = (*value << 8) | byte;
+  }
+  return true;
+}
+
+// Decodes a QOI image into separate red, green and blue channels of
+// `width * height` bytes each, as it's read from `source`. The image has to be
+// the size that it's drawn at. Pixels that are fully transparent are black,
+// which bitmaps draw as transparent.
+esp_err_t qoi_decode(qoi_source_t *source, uint32_t width, uint32_t height,
+                     uint8_t *red, uint8_t *green, uint8_t *blue) {
+  uint8_t magic[4];
+  for (uint8_t i = 0; i < 4; i++) {
+    if (!qoi_source_next(source, &magic[i])) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+  }
+  uint32_t imageWidth;
+  uint32_t imageHeight;
+  uint8_t channels;
+  uint8_t colorspace;
+  if (memcmp(magic, "qoif", 4) != 0 ||
+      !qoi_source_next_u32(source, &imageWidth) ||
+      !qoi_source_next_u32(source, &imageHeight) ||
+      !qoi_source_next(source, &channels) ||
+      !qoi_source_next(source, &colorspace)) {
+    ESP_LOGW(TAG, "Invalid QOI header");
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (imageWidth != width || imageHeight != height) {
+    ESP_LOGW(TAG,
+             "QOI image is %" PRIu32 "x%" PRIu32 " instead of %" PRIu32
+             "x%" PRIu32,
+             imageWidth, imageHeight, width, height);
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  qoi_pixel_t index[QOI_INDEX_COUNT];
+  memset(index, 0, sizeof(index));
+  qoi_pixel_t px = {.r = 0, .g = 0, .b = 0, .a = 255};
+  uint8_t run = 0;
+  uint8_t op;
+  uint8_t next = 0;
+  const uint32_t pixelCount = width * height;
+  for (uint32_t i = 0; i < pixelCount; i++) {
+    if (run > 0) {
+      run--;
+    } else {
+      if (!qoi_source_next(source, &op)) {
+        ESP_LOGW(TAG, "QOI image ended after %" PRIu32 " pixels", i);
+        return ESP_ERR_INVALID_SIZE;
+      }
+
+      bool isComplete = true;
+      if (op == QOI_OP_RGB) {
+        isComplete = qoi_source_next(source, &px.r) &&
+                     qoi_source_next(source, &px.g) &&
+                     qoi_source_next(source, &px.b);
+      } else if (op == QOI_OP_RGBA) {
+        isComplete = qoi_source_next(source, &px.r) &&
+                     qoi_source_next(source, &px.g) &&
+                     qoi_source_next(source, &px.b) &&
+                     qoi_source_next(source, &px.a);
+      } else if ((op & QOI_MASK_2) == QOI_OP_INDEX) {
+        px = index[op];
+      } else if ((op & QOI_MASK_2) == QOI_OP_DIFF) {
+        px.r += ((op >> 4) & 0x03) - 2;
+        px.g += ((op >> 2) & 0x03) - 2;
+        px.b += (op & 0x03) - 2;
+      } else if ((op & QOI_MASK_2) == QOI_OP_LUMA) {
+        isComplete = qoi_source_next(source, &next);
+        const int8_t greenDiff = (op & 0x3f) - 32;
+        px.r += greenDiff - 8 + ((next >> 4) & 0x0f);
+        px.g += greenDiff;
+        px.b += greenDiff - 8 + (next & 0x0f);
+      } else {
+        run = op & 0x3f;
+      }
+      if (!isComplete) {
+        ESP_LOGW(TAG, "QOI image ended after %" PRIu32 " pixels", i);
+        return ESP_ERR_INVALID_SIZE;
+      }
+      index[qoi_color_hash(px)] = px;
+    }
+
+    if (px.a == 0) {
+      red[i] = green[i] = blue[i] = 0;
+    } else {
+      red[i] = px.r;
+      green[i] = px.g;
+      blue[i] = px.b;
+    }
+  }
+
+  return ESP_OK;
+}
@@ -1,7 +1,10 @@
 #include "esp_check.h"
 #include "esp_err.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
+#include "assets.h"
 #include "color_utils.h"
 #include "helper_utils.h"
 #include "network/fetch.h"
@@ -23,61 +26,222 @@ void set_state(display_buffer_handle_t db, command_state_t *state) {
     return;
   }
 
-  if (command_state_has_color(state)) {
+  // a color on its own replaces the fill, but one sent with a fill doesn't
+  if (command_state_has_color(state) && command_state_has_hue_rotate(state)) {
+    display_buffer_set_color(db, state->rotated_red, state->rotated_green,
+                             state->rotated_blue);
+    db->fill = NULL;
+  } else if (command_state_has_color(state)) {
     display_buffer_set_color(db, state->color_red, state->color_green,
                              state->color_blue);
+    db->fill = NULL;
+  }
+
+  if (command_state_has_fill(state)) {
+    db->fill = state->rotated_fill != NULL ? state->rotated_fill : state->fill;
   }
 
   if (command_state_has_font(state)) {
     font_set_size(db->font, state->font_size);
   }
 
+  if (command_state_has_text_scale(state)) {
+    db->text_scale = state->text_scale;
+  }
+
   if (command_state_has_position(state)) {
     display_buffer_set_cursor(db, state->pos_x, state->pos_y);
   }
 }
 
-// loops over the command list and applies each command to the display buffer
-void apply_command_list(display_handle_t display,
+static const char *RENDER_TASK_NAME = "DISPLAY:RENDER_TASK";
+
+// where commands are drawn while applying a command list
+typedef struct {
+  render_frame_t *frame;
+  // either the compositor's layers, or a band's views of them
+  display_buffer_handle_t dbs[COMPOSITOR_LAYER_COUNT];
+  // the buffer of the layer picked by the last `layer` command
+  display_buffer_handle_t db;
+  compositor_layer_id_t layer;
+  render_mode_t mode;
+  render_mode_t modes[COMPOSITOR_LAYER_COUNT];
+  // Set while drawing a band. Nothing shared with the other bands is written,
+  // and commands measured outside of the clip are skipped.
+  bool is_band;
+  // layers whose cached commands are skipped, since their cache has been
+  // copied in instead
+  uint8_t cached_layers;
+  // set while drawing only the cached commands, into the caches
+  bool is_caching;
+} render_target_t;
+
+// adds what changed in an animation's canvas since it was last drawn to the
+// layer's damage, as the canvas is drawn at `start_x` and `start_y`
+static void add_canvas_damage(display_buffer_rect_set_t *damage,
+                              display_buffer_handle_t canvas,
+                              const display_buffer_rect_t *measured,
+                              uint8_t start_x, uint8_t start_y) {
+  display_buffer_rect_t rect;
+  for (uint8_t i = 0; i < canvas->dirty.count; i++) {
+    rect = canvas->dirty.rects[i];
+    rect.x0 += start_x;
+    rect.y0 += start_y;
+    rect.x1 += start_x;
+    rect.y1 += start_y;
+    display_buffer_rect_intersect(&rect, measured);
+    if (!display_buffer_rect_is_empty(&rect)) {
+      display_buffer_rect_set_add(damage, &rect);
+    }
+  }
+}
+
+// Whether a command may draw something different to when it was last
+// measured. An animation only does when it moved to another frame, or its
+// frame has something dynamic in it, so one region of the screen moving on
+// doesn't redraw the animations in the others.
+static bool command_is_changed(command_handle_t command) {
+  if (command->type != COMMAND_TYPE_ANIMATION || command->tween_count > 0) {
+    return command_is_dynamic(command);
+  }
+  command_value_animation_t *animation = command->value.animation;
+  return animation->is_moved ||
+         (animation->frame_count > 0 &&
+          command_list_dynamic_layers(
+              animation->frames[animation->last_show_frame]) != 0);
+}
+
+// stores where a command drew, and when measuring, adds where it drew before
+// and now to the layer's damage if anything changed. An animation with a
+// canvas that stays where it is only adds what changed in the canvas.
+static void record_command(render_target_t *target, command_handle_t command,
+                           uint8_t start_x, uint8_t start_y) {
+  const display_buffer_rect_t *measured = &target->db->measured;
+  display_buffer_rect_set_t *damage = &target->frame->damage[target->layer];
+  display_buffer_handle_t canvas = command->type == COMMAND_TYPE_ANIMATION
+                                       ? command->value.animation->canvas
+                                       : NULL;
+  const bool isMoved = command->start_x != start_x ||
+                       command->start_y != start_y ||
+                       !display_buffer_rect_equal(measured, &command->bounds);
+  if (target->mode == RENDER_MODE_MEASURE &&
+      (isMoved || (canvas == NULL && command_is_changed(command)))) {
+    display_buffer_rect_set_add(damage, &command->bounds);
+    display_buffer_rect_set_add(damage, measured);
+  } else if (target->mode == RENDER_MODE_MEASURE && canvas != NULL) {
+    add_canvas_damage(damage, canvas, measured, start_x, start_y);
+  }
+  if (canvas != NULL) {
+    display_buffer_rect_set_clear(&canvas->dirty);
+  }
+  if (command->type == COMMAND_TYPE_ANIMATION) {
+    command->value.animation->is_moved = false;
+  }
+  command->start_x = start_x;
+  command->start_y = start_y;
+  command->bounds = *measured;
+  command->end_x = target->db->cursor.x;
+  command->end_y = target->db->cursor.y;
+}
+
+// Whether a command's drawing can be skipped, only applying its state and
+// moving the cursor to where it was left. Either it is already in its layer's
+// cache, or in a band, nothing it drew when last measured is inside the clip.
+// The latter bins each command into the bands its bounding box touches.
+static bool command_can_skip(render_target_t *target,
+                             command_handle_t command) {
+  if (!command_only_draws(command)) {
+    return false;
+  }
+  if (command->is_cached && (target->cached_layers & (1 << target->layer))) {
+    return true;
+  }
+  if (!target->is_band) {
+    return false;
+  }
+
+  display_buffer_rect_t overlap = command->bounds;
+  display_buffer_rect_intersect(&overlap, &target->db->clip);
+  return display_buffer_rect_is_empty(&overlap);
+}
+
+// loops over the command list and applies each command to the current layer
+void apply_command_list(display_handle_t display, render_target_t *target,
                         command_list_handle_t command_list,
                         bool is_in_animation) {
+  uint8_t startX;
+  uint8_t startY;
   // since the command list node is a union, there's lots of logic here for each
   // of the cases
   command_list_node_t *loopNode = command_list->head;
   while (loopNode != NULL) {
-    switch (loopNode->command->type) {
+    // the command and its value are read through this once, as they follow
+    // the node in the same record
+    command_handle_t command = loopNode->command;
+
+    // commands for layers that are not being drawn this tick are skipped
+    if (target->mode == RENDER_MODE_SKIP &&
+        command->type != COMMAND_TYPE_LAYER) {
+      loopNode = loopNode->next;
+      continue;
+    }
+
+    // caches only hold the cached commands
+    if (target->is_caching && !command->is_cached &&
+        command->type != COMMAND_TYPE_LAYER) {
+      loopNode = loopNode->next;
+      continue;
+    }
+
+    // Every command was measured before the bands were drawn, so one that
+    // doesn't have to be drawn only has to leave the state as it would have
+    if (!is_in_animation && command_can_skip(target, command)) {
+      set_state(target->db, command_get_state(command));
+      display_buffer_set_cursor(target->db, command->end_x, command->end_y);
+      loopNode = loopNode->next;
+      continue;
+    }
+
+    // an animation's frame is measured as part of the animation
+    startX = target->db->cursor.x;
+    startY = target->db->cursor.y;
+    if (!is_in_animation) {
+      display_buffer_rect_clear(&target->db->measured);
+    }
+
+    switch (command->type) {
     case COMMAND_TYPE_STRING: {
-      set_state(display->display_buffer,
-                loopNode->command->value.string->state);
-      display_buffer_draw_string(display->display_buffer,
-                                 loopNode->command->value.string->value);
+      set_state(target->db, command->value.string->state);
+      display_buffer_draw_string(target->db, command->value.string->value);
       break;
     }
     case COMMAND_TYPE_LINE: {
-      set_state(display->display_buffer, loopNode->command->value.line->state);
-      display_buffer_draw_line(display->display_buffer,
-                               loopNode->command->value.line->to_x,
-                               loopNode->command->value.line->to_y);
+      set_state(target->db, command->value.line->state);
+      display_buffer_draw_line(target->db, command->value.line->to_x,
+                               command->value.line->to_y);
       break;
     }
     case COMMAND_TYPE_BITMAP: {
-      set_state(display->display_buffer,
-                loopNode->command->value.bitmap->state);
-      display_buffer_draw_bitmap(
-          display->display_buffer, loopNode->command->value.bitmap->width,
-          loopNode->command->value.bitmap->height,
-          loopNode->command->value.bitmap->data_red,
-          loopNode->command->value.bitmap->data_green,
-          loopNode->command->value.bitmap->data_blue, true);
+      command_value_bitmap_t *bitmapValue = command->value.bitmap;
+      set_state(target->db, bitmapValue->state);
+      display_buffer_bitmap_t bitmap = {
+          .width = bitmapValue->width,
+          .height = bitmapValue->height,
+          .bpp = 0,
+          .data_red = bitmapValue->data_red,
+          .data_green = bitmapValue->data_green,
+          .data_blue = bitmapValue->data_blue,
+      };
+      display_buffer_draw_bitmap_transformed(target->db, &bitmap,
+                                             &bitmapValue->transform, true);
       break;
     }
     case COMMAND_TYPE_SETSTATE: {
-      set_state(display->display_buffer,
-                loopNode->command->value.set_state->state);
+      set_state(target->db, command->value.set_state->state);
       break;
     }
     case COMMAND_TYPE_LINEFEED: {
-      display_buffer_line_feed(display->display_buffer);
+      display_buffer_line_feed(target->db);
       break;
     }
     case COMMAND_TYPE_ANIMATION: {
@@ -89,97 +253,875 @@ void apply_command_list(display_handle_t display,
         break;
       }
 
-      loopNode->command->value.animation->last_show_frame++;
-      if (loopNode->command->value.animation->last_show_frame >=
-          loopNode->command->value.animation->frame_count) {
-        loopNode->command->value.animation->last_show_frame = 0;
+      command_value_animation_t *animation = command->value.animation;
+      display_buffer_handle_t canvas = animation->canvas;
+      if (canvas != NULL) {
+        // the frame was drawn into the canvas when the animation moved to it
+        display_buffer_draw_bitmap(target->db, canvas->width, canvas->height,
+                                   canvas->buffer_red, canvas->buffer_green,
+                                   canvas->buffer_blue, false);
+      } else if (animation->frame_count > 0) {
+        apply_command_list(display, target,
+                           animation->frames[animation->last_show_frame],
+                           true);
       }
 
-      apply_command_list(
-          display,
-          loopNode->command->value.animation
-              ->frames[loopNode->command->value.animation->last_show_frame],
-          true);
-
       break;
     }
     case COMMAND_TYPE_TIME: {
-      set_state(display->display_buffer, loopNode->command->value.time->state);
+      set_state(target->db, command->value.time->state);
 
       char timeString[8];
-      time_util_info_t time_info;
-      time_util_get(&time_info);
+      time_util_info_t *time_info = &target->frame->time_info;
       // draw the time in HH:MM format
-      snprintf(timeString, sizeof(timeString), "%u:%02u", time_info.hour12,
-               time_info.minute);
-      display_buffer_draw_string(display->display_buffer, timeString);
+      snprintf(timeString, sizeof(timeString), "%u:%02u", time_info->hour12,
+               time_info->minute);
+      display_buffer_draw_string(target->db, timeString);
       // move one character for a "space"
-      display_buffer_next_char_wrap(display->display_buffer);
+      display_buffer_next_char_wrap(target->db);
       // if we're on a LG font size, we're unable to fit `XX:XX XX` without line
       // wrapping. We just need 1 pixel to fit, so we will try to take that from
       // the space between the time and AM/PM.
       // We will only do this if the existing string didn't cause a wrap.
-      if (display->display_buffer->font->size == FONT_SIZE_LG &&
-          time_info.hour12 > 9 && display->display_buffer->cursor.x > 0) {
-        display->display_buffer->cursor.x -= 1;
+      if (target->db->font->size == FONT_SIZE_LG && time_info->hour12 > 9 &&
+          target->db->cursor.x > 0) {
+        target->db->cursor.x -= 1;
       }
       // now draw AM/PM
-      snprintf(timeString, 3, "%s", time_info.isPM ? "PM" : "AM");
-      display_buffer_draw_string(display->display_buffer, timeString);
+      snprintf(timeString, 3, "%s", time_info->isPM ? "PM" : "AM");
+      display_buffer_draw_string(target->db, timeString);
 
       break;
     }
     case COMMAND_TYPE_DATE: {
-      set_state(display->display_buffer, loopNode->command->value.date->state);
+      set_state(target->db, command->value.date->state);
 
-      time_util_info_t time_info;
+      time_util_info_t *time_info = &target->frame->time_info;
       char timeString[13];
-      time_util_get(&time_info);
       snprintf(timeString, sizeof(timeString), "%s %u, %u",
-               month_name_strings[time_info.month - 1], time_info.dayOfMonth,
-               time_info.year);
+               month_name_strings[time_info->month - 1], time_info->dayOfMonth,
+               time_info->year);
 
-      display_buffer_draw_string(display->display_buffer, timeString);
+      display_buffer_draw_string(target->db, timeString);
       break;
     }
     case COMMAND_TYPE_GRAPH: {
-      set_state(display->display_buffer, loopNode->command->value.graph->state);
-      display_buffer_draw_graph(display->display_buffer,
-                                loopNode->command->value.graph->width,
-                                loopNode->command->value.graph->height,
-                                loopNode->command->value.graph->values,
-                                loopNode->command->value.graph->bg_color_red,
-                                loopNode->command->value.graph->bg_color_green,
-                                loopNode->command->value.graph->bg_color_blue);
+      command_value_graph_t *graphValue = command->value.graph;
+      set_state(target->db, graphValue->state);
+      if (graphValue->series == NULL) {
+        display_buffer_draw_graph(target->db, &graphValue->graph,
+                                  graphValue->values, graphValue->value_count);
+      } else if (display->series[graphValue->series->id] != NULL) {
+        display_buffer_draw_series(target->db, &graphValue->graph,
+                                   display->series[graphValue->series->id]);
+      }
+      break;
+    }
+    case COMMAND_TYPE_INDEXED_BITMAP: {
+      command_value_indexed_bitmap_t *indexedBitmap =
+          command->value.indexed_bitmap;
+      set_state(target->db, indexedBitmap->state);
+      // the bitmap's own palette, turned by its hue if it has one, comes
+      // before the current palette
+      palette_handle_t palette = indexedBitmap->rotated_palette;
+      if (palette == NULL) {
+        palette = indexedBitmap->palette != NULL ? indexedBitmap->palette
+                                                 : target->db->palette;
+      }
+      display_buffer_bitmap_t bitmap = {
+          .width = indexedBitmap->width,
+          .height = indexedBitmap->height,
+          .bpp = indexedBitmap->bits_per_pixel,
+          .data = indexedBitmap->data,
+          .palette = palette,
+      };
+      display_buffer_draw_bitmap_transformed(target->db, &bitmap,
+                                             &indexedBitmap->transform, true);
+      break;
+    }
+    case COMMAND_TYPE_RECT: {
+      command_value_rect_t *rectValue = command->value.rect;
+      set_state(target->db, rectValue->state);
+      display_buffer_draw_rect(target->db, rectValue->width, rectValue->height);
+      break;
+    }
+    case COMMAND_TYPE_EFFECT: {
+      command_value_effect_t *effectValue = command->value.effect;
+      set_state(target->db, effectValue->state);
+      if (effectValue->effect != NULL) {
+        effect_draw(effectValue->effect, target->db);
+      }
+      break;
+    }
+    case COMMAND_TYPE_PALETTE: {
+      target->db->palette = command->value.palette->palette;
+      break;
+    }
+    case COMMAND_TYPE_LAYER: {
+      command_value_layer_t *layer = command->value.layer;
+      if (!target->is_band) {
+        compositor_layer_set_blend(display->compositor, layer->layer,
+                                   layer->opacity, layer->blend);
+      }
+      target->layer = layer->layer;
+      target->mode = target->modes[layer->layer];
+      target->db = target->dbs[layer->layer];
+      display_buffer_reset_state(target->db);
       break;
     }
     default: {
-      ESP_LOGW(TAG, "Unknown command type %d", loopNode->command->type);
+      ESP_LOGW(TAG, "Unknown command type %d", command->type);
       break;
     }
     }
 
+    if (!is_in_animation && !target->is_band &&
+        command->type != COMMAND_TYPE_LAYER) {
+      record_command(target, command, startX, startY);
+    }
+
+    loopNode = loopNode->next;
+  }
+}
+
+// Draws the frame an animation with a canvas has moved to over the one before.
+// Going back to the first frame starts again from an empty canvas.
+static void draw_canvas_frame(display_handle_t display,
+                              command_value_animation_t *animation) {
+  display_buffer_handle_t canvas = animation->canvas;
+  render_target_t target = {
+      .frame = &display->frame,
+      .db = canvas,
+      .layer = COMPOSITOR_LAYER_CONTENT,
+      .mode = RENDER_MODE_DRAW,
+      .is_band = false,
+      .cached_layers = 0,
+      .is_caching = false,
+  };
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    target.dbs[layer] = canvas;
+    target.modes[layer] = RENDER_MODE_DRAW;
+  }
+
+  if (animation->last_show_frame == 0) {
+    display_buffer_clear_bounds(canvas);
+  }
+  display_buffer_reset_state(canvas);
+  apply_command_list(display, &target,
+                     animation->frames[animation->last_show_frame], true);
+}
+
+// moves an animation to its next frame, drawing it into its canvas
+static void advance_animation(display_handle_t display,
+                              command_value_animation_t *animation) {
+  animation->is_moved = true;
+  animation->last_show_frame++;
+  if (animation->last_show_frame >= animation->frame_count) {
+    animation->last_show_frame = 0;
+  }
+  if (animation->canvas != NULL && animation->frame_count > 0) {
+    draw_canvas_frame(display, animation);
+  }
+}
+
+// Moves every animation without its own time on by `steps` frames, which
+// is more than one when steps were missed. This is done before anything is
+// drawn, since a layer may be applied more than once per tick. Frames that are
+// skipped are still drawn into canvases, since each only holds what changed.
+static void advance_animations(display_handle_t display,
+                               command_list_handle_t command_list,
+                               uint16_t steps) {
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION &&
+        !command_animation_is_timed(loopNode->command->value.animation)) {
+      for (uint16_t step = 0; step < steps; step++) {
+        advance_animation(display, loopNode->command->value.animation);
+      }
+    }
     loopNode = loopNode->next;
   }
 }
 
+// how long the frame an animation is on is shown for, in microseconds
+static int64_t animation_frame_us(display_handle_t display,
+                                  command_value_animation_t *animation) {
+  uint16_t duration = 0;
+  if (animation->durations != NULL && animation->frame_count > 0) {
+    duration = animation->durations[animation->last_show_frame];
+  }
+  if (duration == 0) {
+    duration = animation->delay;
+  }
+  if (duration == 0) {
+    duration = display->commands->config.animation_delay;
+  }
+  return duration * 1000LL;
+}
+
+// Moves each animation with its own time on to the frame it should be on by
+// `now`. Each keeps its own deadline, which only moves on by the frames'
+// durations, so it doesn't drift however late the ticks are. Returns the
+// soonest of their next deadlines, or `INT64_MAX` if there are none.
+static int64_t advance_timed_animations(display_handle_t display,
+                                        command_list_handle_t command_list,
+                                        int64_t now) {
+  int64_t nextFrameUs = INT64_MAX;
+  command_value_animation_t *animation;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type != COMMAND_TYPE_ANIMATION ||
+        !command_animation_is_timed(loopNode->command->value.animation)) {
+      loopNode = loopNode->next;
+      continue;
+    }
+
+    animation = loopNode->command->value.animation;
+    // the first frame is due as soon as the animation is shown
+    if (animation->next_frame_us == 0) {
+      animation->next_frame_us = now;
+    }
+    uint16_t frames = 0;
+    while (now >= animation->next_frame_us) {
+      advance_animation(display, animation);
+      animation->next_frame_us += animation_frame_us(display, animation);
+      frames++;
+      if (frames == DISPLAY_MAX_SKIPPED_FRAMES &&
+          now >= animation->next_frame_us) {
+        animation->next_frame_us = now + animation_frame_us(display, animation);
+      }
+    }
+    if (frames > 1) {
+      display->jitter.skipped_frames += frames - 1;
+    }
+    nextFrameUs = MIN(nextFrameUs, animation->next_frame_us);
+    loopNode = loopNode->next;
+  }
+  return nextFrameUs;
+}
+
+// Steps every effect once per tick, before anything is drawn, including those
+// in animation frames that aren't being shown. Each step is timed, so the cost
+// of an effect can be checked on the device.
+static void step_effects(command_list_handle_t command_list) {
+  effect_handle_t effect;
+  int64_t start;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION) {
+      command_value_animation_t *animation = loopNode->command->value.animation;
+      for (uint16_t frame = 0; frame < animation->frame_count; frame++) {
+        step_effects(animation->frames[frame]);
+      }
+    } else if (loopNode->command->type == COMMAND_TYPE_EFFECT &&
+               loopNode->command->value.effect->effect != NULL) {
+      effect = loopNode->command->value.effect->effect;
+      start = esp_timer_get_time();
+      effect_step(effect);
+      effect->step_us = esp_timer_get_time() - start;
+      ESP_LOGV(TAG, "Effect %u step took %" PRIu32 "us", effect->type,
+               effect->step_us);
+    }
+    loopNode = loopNode->next;
+  }
+}
+
+// Moves every tween to where it is `elapsed_ms` after the command list was
+// first shown, including those in animation frames that aren't being shown.
+// Returns whether there were any.
+static bool apply_tweens(command_list_handle_t command_list,
+                         uint32_t elapsed_ms) {
+  bool hasTweens = false;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION) {
+      command_value_animation_t *animation = loopNode->command->value.animation;
+      for (uint16_t frame = 0; frame < animation->frame_count; frame++) {
+        hasTweens |= apply_tweens(animation->frames[frame], elapsed_ms);
+      }
+    } else if (loopNode->command->tween_count > 0) {
+      command_apply_tweens(loopNode->command, elapsed_ms);
+      hasTweens = true;
+    }
+    loopNode = loopNode->next;
+  }
+
+  return hasTweens;
+}
+
+// Appends the samples of each graph command to the device's series. This is
+// done once per command list, and series that are not used keep their samples
+// for the next one. A series is created again if its capacity changes.
+static void append_graph_series(display_handle_t display,
+                                command_list_handle_t command_list) {
+  command_value_graph_series_t *graphSeries;
+  series_handle_t *series;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION) {
+      command_value_animation_t *animation = loopNode->command->value.animation;
+      for (uint16_t frame = 0; frame < animation->frame_count; frame++) {
+        append_graph_series(display, animation->frames[frame]);
+      }
+    } else if (loopNode->command->type == COMMAND_TYPE_GRAPH &&
+               loopNode->command->value.graph->series != NULL) {
+      graphSeries = loopNode->command->value.graph->series;
+      series = &display->series[graphSeries->id];
+      if (*series != NULL && (*series)->capacity != graphSeries->capacity) {
+        series_end(*series);
+        *series = NULL;
+      }
+      if (*series == NULL &&
+          series_init(series, graphSeries->capacity) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to create graph series %u", graphSeries->id);
+      } else {
+        series_append(*series,
+                      graphSeries->has_start ? graphSeries->start
+                                             : (*series)->total,
+                      graphSeries->samples, graphSeries->sample_count);
+      }
+    }
+    loopNode = loopNode->next;
+  }
+}
+
+// applies the whole command list, starting in the content layer
+static void apply_commands(display_handle_t display, render_target_t *target) {
+  target->layer = COMPOSITOR_LAYER_CONTENT;
+  target->mode = target->modes[COMPOSITOR_LAYER_CONTENT];
+  target->db = target->dbs[COMPOSITOR_LAYER_CONTENT];
+  display_buffer_reset_state(target->db);
+  apply_command_list(display, target, target->frame->commands, false);
+}
+
+// copies the cache of a layer into a band's view of it, within the view's clip
+static void restore_cache(display_handle_t display, uint8_t band,
+                          compositor_layer_id_t layer) {
+  display_buffer_handle_t view = display->views[band][layer];
+  display_buffer_rect_t rect = display->cache_bounds[band][layer];
+  display_buffer_rect_intersect(&rect, &view->clip);
+  if (display_buffer_rect_is_empty(&rect)) {
+    return;
+  }
+
+  display_buffer_copy_rect(view, display->caches[layer], &rect);
+  display_buffer_rect_union(&view->bounds, &rect);
+  display_buffer_rect_set_add(&view->dirty, &rect);
+}
+
+// Draws one band of the frame, through the band's views of the layers. Layers
+// being drawn are drawn within the band, and measured layers are redrawn where
+// they changed, so the bands never touch each other's pixels.
+//
+// The static commands at the start of each cached layer are drawn on their own
+// once per command list, and the band of the layer they cover is kept in the
+// layer's cache. From then on, that band is copied back a row at a time
+// instead of drawing them again.
+static void render_band(display_handle_t display, uint8_t band) {
+  render_frame_t *frame = &display->frame;
+  const uint8_t height = display->compositor->height;
+  const display_buffer_rect_t bandRect = {
+      .x0 = 0,
+      .y0 = (height * band) / DISPLAY_RENDER_BANDS,
+      .x1 = display->compositor->width,
+      .y1 = (height * (band + 1)) / DISPLAY_RENDER_BANDS,
+  };
+  display_buffer_rect_t clip;
+  display_buffer_handle_t view;
+  render_target_t target = {
+      .frame = frame,
+      .is_band = true,
+      .cached_layers = 0,
+      .is_caching = true,
+  };
+
+  // the layers being cached were just cleared, so only draw the cached commands
+  // into them and keep the result
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    target.dbs[layer] = display->views[band][layer];
+    display_buffer_view_begin(target.dbs[layer], &bandRect);
+    target.modes[layer] = frame->caching_layers & (1 << layer)
+                              ? RENDER_MODE_DRAW
+                              : RENDER_MODE_SKIP;
+  }
+  if (frame->caching_layers != 0) {
+    apply_commands(display, &target);
+  }
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    if (frame->caching_layers & (1 << layer)) {
+      view = target.dbs[layer];
+      display_buffer_copy_rect(display->caches[layer], view, &view->bounds);
+      display->cache_bounds[band][layer] = view->bounds;
+    }
+  }
+
+  target.is_caching = false;
+  target.cached_layers = frame->cached_layers;
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    target.modes[layer] = frame->modes[layer] == RENDER_MODE_DRAW
+                              ? RENDER_MODE_DRAW
+                              : RENDER_MODE_SKIP;
+    if (target.modes[layer] == RENDER_MODE_DRAW &&
+        (frame->cached_layers & (1 << layer))) {
+      restore_cache(display, band, layer);
+    }
+  }
+  apply_commands(display, &target);
+
+  // redraw each measured layer where it changed, skipping every other layer
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    if (frame->modes[layer] != RENDER_MODE_MEASURE) {
+      continue;
+    }
+
+    view = target.dbs[layer];
+    for (uint8_t other = 0; other < COMPOSITOR_LAYER_COUNT; other++) {
+      target.modes[other] =
+          other == layer ? RENDER_MODE_DRAW : RENDER_MODE_SKIP;
+    }
+    for (uint8_t i = 0; i < frame->damage[layer].count; i++) {
+      clip = frame->damage[layer].rects[i];
+      display_buffer_rect_intersect(&clip, &bandRect);
+      if (display_buffer_rect_is_empty(&clip)) {
+        continue;
+      }
+      view->clip = clip;
+      display_buffer_clear_rect(view, &clip);
+      if (frame->cached_layers & (1 << layer)) {
+        restore_cache(display, band, layer);
+      }
+      apply_commands(display, &target);
+    }
+  }
+}
+
+// Marks the static commands at the start of every layer that is drawn again
+// after a new command list's first tick, and makes sure each of those layers
+// has a cache to keep them in. Returns the layers that will be cached.
+static uint8_t prepare_caches(display_handle_t display) {
+  uint8_t layers = command_list_mark_cached(
+      display->commands,
+      display->dynamic_layers | (1 << COMPOSITOR_LAYER_OVERLAY));
+
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    if (!(layers & (1 << layer)) || display->caches[layer] != NULL) {
+      continue;
+    }
+    if (display_buffer_init(&display->caches[layer], display->compositor->width,
+                            display->compositor->height) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to create the cache for layer %u", layer);
+      display->caches[layer] = NULL;
+      layers &= ~(1 << layer);
+    }
+  }
+
+  return layers;
+}
+
+// whether tweens or a transition are moving, which both tick faster than the
+// animation delay
+static bool is_ticking_fast(display_handle_t display) {
+  return display->has_tweens ||
+         display->compositor->transition_type != COMPOSITOR_TRANSITION_NONE;
+}
+
+// Whether a command list draws the same each time its animations are back on
+// the same frames, which it doesn't with effects. Sets `uses_time` if anything
+// in it shows the time or date.
+static bool command_list_is_repeatable(command_list_handle_t command_list,
+                                       bool *uses_time) {
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    command_handle_t command = loopNode->command;
+    if (command->type == COMMAND_TYPE_EFFECT) {
+      return false;
+    }
+    if (command->type == COMMAND_TYPE_TIME ||
+        command->type == COMMAND_TYPE_DATE) {
+      *uses_time = true;
+    }
+    if (command->type == COMMAND_TYPE_ANIMATION) {
+      command_value_animation_t *animation = command->value.animation;
+      for (uint16_t frame = 0; frame < animation->frame_count; frame++) {
+        if (!command_list_is_repeatable(animation->frames[frame], uses_time)) {
+          return false;
+        }
+      }
+    }
+    loopNode = loopNode->next;
+  }
+  return true;
+}
+
+// the steps until every animation in a command list is back on the same
+// frame, or `0` if the list can't be cached because it has no animations,
+// they take too long to line up again, or any keep their own time
+static uint16_t frame_cache_loop_length(command_list_handle_t command_list) {
+  uint32_t length = 0;
+  uint32_t a;
+  uint32_t b;
+  command_list_node_t *loopNode = command_list->head;
+  while (loopNode != NULL) {
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION &&
+        command_animation_is_timed(loopNode->command->value.animation)) {
+      return 0;
+    }
+    if (loopNode->command->type == COMMAND_TYPE_ANIMATION &&
+        loopNode->command->value.animation->frame_count > 0) {
+      const uint32_t frameCount =
+          loopNode->command->value.animation->frame_count;
+      if (length == 0) {
+        length = frameCount;
+      } else {
+        // the least common multiple, from the greatest common divisor
+        a = length;
+        b = frameCount;
+        while (b != 0) {
+          const uint32_t rest = a % b;
+          a = b;
+          b = rest;
+        }
+        length = length / a * frameCount;
+      }
+      if (length > DISPLAY_FRAME_CACHE_STEPS) {
+        return 0;
+      }
+    }
+    loopNode = loopNode->next;
+  }
+  return length;
+}
+
+// the feedback icons that the overlay is drawn with, as bits
+static uint8_t frame_cache_feedback(display_handle_t display) {
+  return (display->state->invalid_remote_state ? 1 : 0) |
+         (display->state->invalid_commands ? 2 : 0) |
+         (display->state->invalid_wifi_state ? 4 : 0);
+}
+
+// Forgets every step of the last command list, and works out whether the new
+// one can be cached. Its steps are allocated in PSRAM, since they're only
+// copied once per tick.
+static void frame_cache_reset(display_handle_t display) {
+  display_frame_cache_t *cache = &display->frame_cache;
+  free(cache->planes);
+  cache->planes = NULL;
+  cache->kept = 0;
+  cache->is_steady = false;
+  cache->uses_time = false;
+  cache->loop_length = 0;
+#ifdef CONFIG_DISPLAY_FRAME_CACHE
+  if (command_list_is_repeatable(display->commands, &cache->uses_time)) {
+    cache->loop_length = frame_cache_loop_length(display->commands);
+  }
+#endif
+  // the first step moves the animations onto the first step of the loop
+  cache->step = cache->loop_length > 0 ? cache->loop_length - 1 : 0;
+  if (cache->loop_length == 0) {
+    return;
+  }
+
+  cache->planes = (uint8_t *)heap_caps_malloc(
+      cache->loop_length * led_matrix_planes_length(display->matrix),
+      MALLOC_CAP_SPIRAM);
+  if (cache->planes == NULL) {
+    ESP_LOGW(TAG, "Failed to allocate the frame cache for %u steps",
+             cache->loop_length);
+    cache->loop_length = 0;
+  }
+}
+
+// Copies the step the animations just moved to from the frame cache, if it
+// was kept with the same minute and feedback icons, and the matrix is showing
+// the step before it. Returns whether it was.
+static bool show_cached_frame(display_handle_t display) {
+  display_frame_cache_t *cache = &display->frame_cache;
+  const uint8_t feedback = frame_cache_feedback(display);
+  if ((cache->uses_time &&
+       cache->minute != display->frame.time_info.minute) ||
+      cache->feedback != feedback) {
+    cache->kept = 0;
+    cache->minute = display->frame.time_info.minute;
+    cache->feedback = feedback;
+  }
+  if (!cache->is_steady || !(cache->kept & (1UL << cache->step))) {
+    return false;
+  }
+
+  const display_buffer_rect_t *changed = &cache->changed[cache->step];
+  const size_t planesLength = led_matrix_planes_length(display->matrix);
+  led_matrix_show_planes(display->matrix,
+                         cache->planes + cache->step * planesLength,
+                         changed->x0, changed->y0, changed->x1 - changed->x0,
+                         changed->y1 - changed->y0);
+  cache->is_stale = true;
+  return true;
+}
+
+// Keeps what the matrix shows as the current step, along with where it
+// changed since the step before, if that's what it showed
+static void keep_cached_frame(display_handle_t display,
+                              const display_buffer_rect_set_t *damage,
+                              bool is_redrawn) {
+  display_frame_cache_t *cache = &display->frame_cache;
+  display_buffer_rect_t *changed = &cache->changed[cache->step];
+  if (cache->is_steady && !is_redrawn) {
+    display_buffer_rect_clear(changed);
+    for (uint8_t i = 0; i < damage->count; i++) {
+      display_buffer_rect_union(changed, &damage->rects[i]);
+    }
+  } else {
+    display_buffer_rect_set_full(display->compositor->output, changed);
+  }
+
+  const size_t planesLength = led_matrix_planes_length(display->matrix);
+  led_matrix_save_planes(display->matrix,
+                         cache->planes + cache->step * planesLength);
+  cache->kept |= 1UL << cache->step;
+}
+
+// Shows the next step of the transition to a new command list. Every step
+// changes the whole frame, and the last one shows all of `output`, so the
+// matrix is up to date again once the transition is over.
+static esp_err_t show_transition(display_handle_t display, int64_t now) {
+  compositor_handle_t compositor = display->compositor;
+  display_buffer_handle_t shown = compositor->output;
+  int64_t elapsedMs = (now - display->transition_start_us) / 1000;
+  if (elapsedMs < display->transition_duration) {
+    shown = compositor_transition_step(
+        compositor, elapsedMs * COMPOSITOR_TRANSITION_DONE /
+                        display->transition_duration);
+  } else {
+    compositor_transition_end(compositor);
+  }
+
+  return led_matrix_show_rect(display->matrix, shown->buffer_red,
+                              shown->buffer_green, shown->buffer_blue, 0, 0,
+                              compositor->width, compositor->height);
+}
+
+// Swaps in the command list that the fetch task published, if there is one.
+// The old list is handed back to the fetch task to be ended, since ending it
+// releases its assets. A list is only swapped once the last one handed back
+// has been ended.
+static void take_pending_commands(display_handle_t display) {
+  command_list_handle_t newCommands = NULL;
+  xSemaphoreTake(display->commands_mutex, portMAX_DELAY);
+  if (display->retired_commands == NULL) {
+    newCommands = display->pending_commands;
+    display->pending_commands = NULL;
+  }
+  if (newCommands != NULL) {
+    display->retired_commands = display->commands;
+  }
+  xSemaphoreGive(display->commands_mutex);
+  if (newCommands == NULL) {
+    return;
+  }
+
+  display->commands = newCommands;
+  display->commands_generation++;
+}
+
+// Ends the command list that the animation task handed back, if there is
+// one. Called from the fetch task before it uses any assets.
+static void end_retired_commands(display_handle_t display) {
+  xSemaphoreTake(display->commands_mutex, portMAX_DELAY);
+  command_list_handle_t oldCommands = display->retired_commands;
+  display->retired_commands = NULL;
+  xSemaphoreGive(display->commands_mutex);
+  if (oldCommands != NULL) {
+    command_list_end(oldCommands);
+  }
+}
+
 // a helper function to make sure that any other data outside of the commands is
 // also added to the display buffer, and then show it on the LED matrix
+//
+// A new command list draws every layer from scratch. After that, layers without
+// anything dynamic are left as they are, and dynamic layers are first measured
+// to find which commands changed. Only the rectangles they cover are cleared
+// and drawn again, with everything outside of them culled by the clip, so a
+// clock only redraws its own glyphs each tick.
+//
+// Every layer that is drawn is measured first, on this task, so each command
+// knows where it draws. The frame is then drawn in horizontal bands, one on
+// each core, and each band skips the commands that are outside of it.
 esp_err_t build_and_show(display_handle_t display) {
-  // reset the state of the buffer
-  display_buffer_clear(display->display_buffer);
-  display_buffer_set_cursor(display->display_buffer, 0, 0);
-  // don't worry about color/font here. Those should be handled by the commands
+  compositor_handle_t compositor = display->compositor;
+  render_frame_t *frame = &display->frame;
+  display_buffer_rect_set_t damage;
+  display_buffer_handle_t db;
+  render_target_t target = {
+      .frame = frame,
+      .is_band = false,
+      .is_caching = false,
+  };
+  uint8_t drawLayers = 0;
+  uint8_t measureLayers = 0;
+  int64_t now = esp_timer_get_time();
+  int64_t stepUs;
+  display_frame_cache_t *cache = &display->frame_cache;
+  uint16_t steps = 0;
+  esp_err_t ret = ESP_OK;
+
+  take_pending_commands(display);
+  stepUs = display->commands->config.animation_delay * 1000LL;
+  frame->caching_layers = 0;
+  if (display->rendered_generation != display->commands_generation) {
+    display->rendered_generation = display->commands_generation;
+    display->shown_at_us = now;
+    display->next_step_us = now;
+    // the new list is drawn off-screen, and a running transition carries on
+    // to it if it doesn't have its own
+    command_config_t *config = &display->commands->config;
+    if (config->transition != COMPOSITOR_TRANSITION_NONE &&
+        compositor_transition_begin(compositor, config->transition,
+                                    config->transition_direction) == ESP_OK) {
+      display->transition_start_us = now;
+      display->transition_duration = config->transition_duration;
+    }
+    append_graph_series(display, display->commands);
+    frame_cache_reset(display);
+    display->dynamic_layers = command_list_dynamic_layers(display->commands);
+    display->cached_layers = prepare_caches(display);
+    frame->caching_layers = display->cached_layers;
+    drawLayers = (1 << COMPOSITOR_LAYER_COUNT) - 1;
+    for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+      compositor_layer_set_blend(compositor, layer, COMPOSITOR_OPACITY_OPAQUE,
+                                 COMPOSITOR_BLEND_NORMAL);
+    }
+  }
+  frame->commands = display->commands;
+  time_util_get(&frame->time_info);
+
+  display->has_tweens = apply_tweens(
+      display->commands, (uint32_t)((now - display->shown_at_us) / 1000));
+  // Animations and effects only move on once per animation delay, however
+  // often the display ticks. Steps that were missed are skipped, so
+  // animations stay in time, and effects only move on once.
+  if (now >= display->next_step_us) {
+    const int64_t dueSteps = 1 + (now - display->next_step_us) / stepUs;
+    display->next_step_us += dueSteps * stepUs;
+    display->jitter.skipped_frames += dueSteps - 1;
+    // any further behind, and the animations carry on from where they are
+    steps = MIN(dueSteps, DISPLAY_MAX_SKIPPED_FRAMES);
+    // effects are stepped first, so that those in a frame drawn into a
+    // canvas are drawn where they are now
+    step_effects(display->commands);
+    advance_animations(display, display->commands, steps);
+  }
+  display->next_tick_us =
+      MIN(display->next_step_us,
+          advance_timed_animations(display, display->commands, now));
+  if (is_ticking_fast(display)) {
+    display->next_tick_us =
+        MIN(display->next_tick_us, now + DISPLAY_FAST_TICK_MS * 1000LL);
+  }
+
+  // a step of a loop that was drawn before is copied instead. Canvases have
+  // still been drawn into above, so they're ready for when the loop isn't.
+  // The matrix only shows the step before this one if none were skipped.
+  if (steps > 0 && cache->loop_length > 0) {
+    cache->step = (cache->step + steps) % cache->loop_length;
+    cache->is_steady = cache->is_steady && steps == 1;
+  }
+  const bool isRepeatable =
+      steps > 0 && cache->loop_length > 0 && !is_ticking_fast(display);
+  if (isRepeatable && show_cached_frame(display)) {
+    cache->is_steady = true;
+    return ESP_OK;
+  }
+  const bool isRedrawn = cache->is_stale;
+  if (cache->is_stale) {
+    cache->is_stale = false;
+    drawLayers = (1 << COMPOSITOR_LAYER_COUNT) - 1;
+  }
+
+  // the overlay also holds the feedback icons, so it is always drawn
+  drawLayers |= 1 << COMPOSITOR_LAYER_OVERLAY;
+  measureLayers = display->dynamic_layers & ~drawLayers;
+  frame->cached_layers = display->cached_layers;
+  // caches that are being drawn can't be used until they are, and every
+  // command has to be measured once before its drawing is skipped
+  target.cached_layers = display->cached_layers & ~frame->caching_layers;
+
+  // measure with an empty clip. Layers that are drawn in full are measured
+  // too, but nothing is added to their damage.
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    db = compositor_get_layer(compositor, layer);
+    target.dbs[layer] = db;
+    display_buffer_rect_set_clear(&frame->damage[layer]);
+    if (drawLayers & (1 << layer)) {
+      frame->modes[layer] = RENDER_MODE_DRAW;
+      compositor_layer_begin(compositor, layer);
+    } else if (measureLayers & (1 << layer)) {
+      frame->modes[layer] = RENDER_MODE_MEASURE;
+    } else {
+      frame->modes[layer] = RENDER_MODE_SKIP;
+    }
+    target.modes[layer] = frame->modes[layer];
+    display_buffer_rect_clear(&db->clip);
+  }
+
+  apply_commands(display, &target);
 
-  apply_command_list(display, display->commands, false);
+  // the render task draws every band after the first
+  if (display->render_task_handle != NULL) {
+    frame->waiting_task = xTaskGetCurrentTaskHandle();
+    xTaskNotifyGive(display->render_task_handle);
+    render_band(display, 0);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  } else {
+    for (uint8_t band = 0; band < DISPLAY_RENDER_BANDS; band++) {
+      render_band(display, band);
+    }
+  }
+
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    db = compositor_get_layer(compositor, layer);
+    display_buffer_rect_set_full(db, &db->clip);
+    for (uint8_t band = 0; band < DISPLAY_RENDER_BANDS; band++) {
+      display_buffer_view_merge(db, display->views[band][layer]);
+    }
+  }
 
   display_buffer_add_feedback(
-      display->display_buffer, display->state->invalid_remote_state,
-      display->state->invalid_commands, display->state->invalid_wifi_state);
+      compositor_get_layer(compositor, COMPOSITOR_LAYER_OVERLAY),
+      display->state->invalid_remote_state, display->state->invalid_commands,
+      display->state->invalid_wifi_state);
+
+  // only the parts of the frame that changed are converted for the matrix
+  compositor_compose(compositor, &damage);
+  if (compositor->transition_type != COMPOSITOR_TRANSITION_NONE) {
+    cache->is_steady = false;
+    return show_transition(display, now);
+  }
+  // the matrix was showing cached steps, which the layers know nothing about
+  if (isRedrawn) {
+    display_buffer_rect_t full;
+    display_buffer_rect_set_full(compositor->output, &full);
+    display_buffer_rect_set_clear(&damage);
+    display_buffer_rect_set_add(&damage, &full);
+  }
+  for (uint8_t i = 0; i < damage.count && ret == ESP_OK; i++) {
+    ret = led_matrix_show_rect(
+        display->matrix, compositor->output->buffer_red,
+        compositor->output->buffer_green, compositor->output->buffer_blue,
+        damage.rects[i].x0, damage.rects[i].y0,
+        damage.rects[i].x1 - damage.rects[i].x0,
+        damage.rects[i].y1 - damage.rects[i].y0);
+  }
+  if (isRepeatable) {
+    keep_cached_frame(display, &damage, isRedrawn);
+  }
+  cache->is_steady = isRepeatable;
 
-  return led_matrix_show(display->matrix, display->display_buffer->buffer_red,
-                         display->display_buffer->buffer_green,
-                         display->display_buffer->buffer_blue);
+  return ret;
+}
+
+static esp_err_t feed_commands(const char *data, size_t length, void *arg) {
+  return command_stream_feed((command_stream_handle_t)arg, data, length);
 }
 
 // fetches the commands from the remote endpoint and updates the display's
@@ -188,12 +1130,33 @@ esp_err_t fetch_commands(display_handle_t display) {
   ESP_LOGD(FETCH_TASK_NAME, "FETCHING DATA");
   esp_err_t ret = ESP_OK;
   fetch_ctx_handle_t ctx;
+  command_stream_handle_t stream = NULL;
+  char *assets = NULL;
 
   ESP_GOTO_ON_ERROR(fetch_init(&ctx), fetch_commands_cleanup, FETCH_TASK_NAME,
                     "Error initiating the request context");
 
+  ESP_GOTO_ON_ERROR(command_stream_init(&stream), fetch_commands_cleanup,
+                    FETCH_TASK_NAME, "Error initiating the command stream");
+
   ctx->url = display->state->command_endpoint;
   ctx->method = HTTP_METHOD_GET;
+  // the binary format is much smaller for bitmaps, but servers that don't
+  // know it can still answer with JSON
+  ctx->accept = COMMAND_WIRE_CONTENT_TYPE ", application/json;q=0.5";
+  // bitmaps that the device already has can be referred to by their hash,
+  // instead of being sent again. The last list that was swapped out is ended
+  // first, so the hashes are of the assets that are kept.
+  end_retired_commands(display);
+  assets = (char *)malloc(ASSET_HEADER_LENGTH);
+  if (assets != NULL) {
+    asset_hashes(assets, ASSET_HEADER_LENGTH);
+    ctx->assets = assets;
+  }
+  // commands are parsed as the response arrives, instead of the whole body
+  // being kept and then parsed into a tree
+  ctx->on_data = feed_commands;
+  ctx->on_data_arg = stream;
   // if there's an existing ETag, add it to the request
   if (display->last_etag != NULL) {
     if (fetch_etag_init(&ctx->etag) == ESP_OK) {
@@ -228,18 +1191,24 @@ esp_err_t fetch_commands(display_handle_t display) {
   }
 
   command_list_handle_t newCommands;
-  ESP_GOTO_ON_ERROR(command_list_parse(&newCommands, ctx->response->data,
-                                       ctx->response->length),
+  ESP_GOTO_ON_ERROR(command_stream_finish(stream, &newCommands),
                     fetch_commands_cleanup, FETCH_TASK_NAME,
-                    "Invalid JSON response or content length");
-
-  // hot-swap commands and cleanup the old one
-  command_list_handle_t oldCommands = display->commands;
-  display->commands = newCommands;
-  command_list_end(oldCommands);
+                    "Invalid response");
+
+  // published for the animation task to swap in between frames. A list that
+  // was published but never shown is replaced.
+  xSemaphoreTake(display->commands_mutex, portMAX_DELAY);
+  command_list_handle_t oldCommands = display->pending_commands;
+  display->pending_commands = newCommands;
+  xSemaphoreGive(display->commands_mutex);
+  if (oldCommands != NULL) {
+    command_list_end(oldCommands);
+  }
 
 fetch_commands_cleanup:
+  command_stream_end(stream);
   fetch_end(ctx);
+  free(assets);
   if (ret != ESP_OK) {
     fetch_etag_end(&display->last_etag);
   }
@@ -303,9 +1272,50 @@ void fetch_task(void *pvParameters) {
   }
 }
 
+// wakes the animation task when its next tick is due
+static void tick_timer_callback(void *arg) {
+  display_handle_t display = (display_handle_t)arg;
+  xSemaphoreGive(display->tick_semaphore);
+}
+
+// Waits until the next tick is due, and keeps track of how late it woke up,
+// which is logged every `DISPLAY_JITTER_REPORT_MS`. Without the timer, it
+// falls back to waiting on the FreeRTOS tick.
+static void wait_for_tick(display_handle_t display) {
+  display_jitter_t *jitter = &display->jitter;
+  int64_t wait = display->next_tick_us - esp_timer_get_time();
+  if (wait > 0) {
+    if (display->tick_timer != NULL &&
+        esp_timer_start_once(display->tick_timer, wait) == ESP_OK) {
+      xSemaphoreTake(display->tick_semaphore, portMAX_DELAY);
+    } else {
+      vTaskDelay(MAX(1, wait / 1000 / portTICK_PERIOD_MS));
+    }
+  }
+
+  const int64_t now = esp_timer_get_time();
+  const int64_t lateUs = now - display->next_tick_us;
+  jitter->ticks++;
+  jitter->total_us += lateUs;
+  jitter->max_us = MAX(jitter->max_us, lateUs);
+  if (now - jitter->reported_at_us >= DISPLAY_JITTER_REPORT_MS * 1000LL) {
+    ESP_LOGD(TAG,
+             "Ticks were %" PRId64 "us late on average and %" PRId64
+             "us at most, with %" PRIu32 " frames skipped",
+             jitter->total_us / jitter->ticks, jitter->max_us,
+             jitter->skipped_frames);
+    jitter->ticks = 0;
+    jitter->total_us = 0;
+    jitter->max_us = 0;
+    jitter->skipped_frames = 0;
+    jitter->reported_at_us = now;
+  }
+}
+
 // responsible for periodically updating the display.
-// if there's an animation, it will update based on the animation delay.
-// if not, it will use the default value.
+// Each tick is due at the soonest of the next step of the animations and
+// effects, the next frame of each animation with its own time, and the
+// fast tick while tweens or a transition are moving. See `next_tick_us`.
 //
 // periodically updating the display is required even if there's not an
 // animation to make sure that the date and time commands are updated.
@@ -314,8 +1324,31 @@ void animation_task(void *pvParameters) {
 
   while (true) {
     build_and_show(display);
-    // max animation speed is limited by the freertos tick...
-    vTaskDelay(display->commands->config.animation_delay / portTICK_PERIOD_MS);
+    wait_for_tick(display);
+  }
+}
+
+// draws the bands after the first whenever the animation task starts a frame,
+// on the core that isn't busy with WiFi and fetching
+void render_task(void *pvParameters) {
+  display_handle_t display = (display_handle_t)pvParameters;
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    for (uint8_t band = 1; band < DISPLAY_RENDER_BANDS; band++) {
+      render_band(display, band);
+    }
+    xTaskNotifyGive(display->frame.waiting_task);
+  }
+}
+
+// cleans up every band's views. Views that were never created are `NULL`.
+static void display_views_end(display_handle_t display) {
+  for (uint8_t band = 0; band < DISPLAY_RENDER_BANDS; band++) {
+    for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+      display_buffer_view_end(display->views[band][layer]);
+      display->views[band][layer] = NULL;
+    }
   }
 }
 
@@ -333,6 +1366,52 @@ esp_err_t display_init(display_handle_t *display_handle,
 
   // reset ETag
   display->last_etag = NULL;
+  // the start screen below counts as the first command list
+  display->commands_generation = 1;
+  display->pending_commands = NULL;
+  display->retired_commands = NULL;
+  display->commands_mutex = xSemaphoreCreateMutex();
+  if (display->commands_mutex == NULL) {
+    ESP_LOGE(TAG, "Failed to create the commands mutex");
+    free(display);
+    *display_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+  display->rendered_generation = 0;
+  display->dynamic_layers = 0;
+  display->shown_at_us = 0;
+  display->next_step_us = 0;
+  display->next_tick_us = 0;
+  display->tick_timer = NULL;
+  display->tick_semaphore = NULL;
+  display->jitter.ticks = 0;
+  display->jitter.total_us = 0;
+  display->jitter.max_us = 0;
+  display->jitter.skipped_frames = 0;
+  display->jitter.reported_at_us = 0;
+  display->has_tweens = false;
+  display->transition_start_us = 0;
+  display->transition_duration = 0;
+  for (uint8_t i = 0; i < COMMAND_GRAPH_SERIES_COUNT; i++) {
+    display->series[i] = NULL;
+  }
+  // until the render task is started, every band is drawn by the caller
+  display->render_task_handle = NULL;
+  display->cached_layers = 0;
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    display->caches[layer] = NULL;
+  }
+  display->frame_cache.planes = NULL;
+  display->frame_cache.loop_length = 0;
+  display->frame_cache.is_steady = false;
+  display->frame_cache.is_stale = false;
+  display->frame_cache.minute = 0;
+  display->frame_cache.feedback = 0;
+  for (uint8_t band = 0; band < DISPLAY_RENDER_BANDS; band++) {
+    for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+      display->views[band][layer] = NULL;
+    }
+  }
 
   // setup matrix
   setup_res = led_matrix_init(&display->matrix, led_matrix_config);
@@ -349,11 +1428,30 @@ esp_err_t display_init(display_handle_t *display_handle,
     return setup_res;
   }
 
-  // setup db
-  setup_res =
-      display_buffer_init(&display->display_buffer, led_matrix_config->width,
-                          led_matrix_config->height);
+  // setup the layers and the final frame
+  setup_res = compositor_init(&display->compositor, led_matrix_config->width,
+                              led_matrix_config->height);
+  if (setup_res != ESP_OK) {
+    led_matrix_stop(display->matrix);
+    led_matrix_end(display->matrix);
+    free(display);
+    *display_handle = NULL;
+    return setup_res;
+  }
+
+  // setup the views each band draws through
+  for (uint8_t band = 0; band < DISPLAY_RENDER_BANDS && setup_res == ESP_OK;
+       band++) {
+    for (uint8_t layer = 0;
+         layer < COMPOSITOR_LAYER_COUNT && setup_res == ESP_OK; layer++) {
+      setup_res = display_buffer_view_init(
+          &display->views[band][layer],
+          compositor_get_layer(display->compositor, layer));
+    }
+  }
   if (setup_res != ESP_OK) {
+    display_views_end(display);
+    compositor_end(display->compositor);
     led_matrix_stop(display->matrix);
     led_matrix_end(display->matrix);
     free(display);
@@ -364,7 +1462,8 @@ esp_err_t display_init(display_handle_t *display_handle,
   // setup state
   setup_res = state_init(&display->state);
   if (setup_res != ESP_OK) {
-    display_buffer_end(display->display_buffer);
+    display_views_end(display);
+    compositor_end(display->compositor);
     led_matrix_stop(display->matrix);
     led_matrix_end(display->matrix);
     free(display);
@@ -376,7 +1475,8 @@ esp_err_t display_init(display_handle_t *display_handle,
   setup_res = command_list_init(&display->commands);
   if (setup_res != ESP_OK) {
     state_end(display->state);
-    display_buffer_end(display->display_buffer);
+    display_views_end(display);
+    compositor_end(display->compositor);
     led_matrix_stop(display->matrix);
     led_matrix_end(display->matrix);
     free(display);
@@ -393,7 +1493,8 @@ esp_err_t display_init(display_handle_t *display_handle,
     return setup_res;
   }
 
-  setup_res = command_state_init(&startCommand->value.string->state);
+  setup_res = command_state_init(display->commands->arena,
+                                 &startCommand->value.string->state);
   if (setup_res != ESP_OK) {
     display_end(display);
     *display_handle = NULL;
@@ -408,20 +1509,20 @@ esp_err_t display_init(display_handle_t *display_handle,
 
   startCommand->value.string->state->pos_x = 0;
   startCommand->value.string->state->pos_y =
-      (display->display_buffer->height / 2) - 8;
+      (display->compositor->height / 2) - 8;
   command_state_set_flag_position(startCommand->value.string->state);
 
   startCommand->value.string->state->font_size = FONT_SIZE_LG;
   command_state_set_flag_font(startCommand->value.string->state);
 
-  startCommand->value.string->value = malloc(sizeof(char) * 9);
+  startCommand->value.string->value =
+      arena_strdup(display->commands->arena, "Starting");
   if (startCommand->value.string->value == NULL) {
     ESP_LOGE(TAG, "Failed to allocate start command string value");
     display_end(display);
     *display_handle = NULL;
     return ESP_ERR_NO_MEM;
   }
-  strcpy(startCommand->value.string->value, "Starting");
 
   build_and_show(display);
 
@@ -434,9 +1535,23 @@ esp_err_t display_init(display_handle_t *display_handle,
 void display_end(display_handle_t display) {
   led_matrix_stop(display->matrix);
   led_matrix_end(display->matrix);
-  display_buffer_end(display->display_buffer);
+  display_views_end(display);
+  compositor_end(display->compositor);
   state_end(display->state);
   command_list_end(display->commands);
+  for (uint8_t i = 0; i < COMMAND_GRAPH_SERIES_COUNT; i++) {
+    series_end(display->series[i]);
+  }
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    if (display->caches[layer] != NULL) {
+      display_buffer_end(display->caches[layer]);
+    }
+  }
+  free(display->frame_cache.planes);
+  if (display->tick_timer != NULL) {
+    esp_timer_stop(display->tick_timer);
+    esp_timer_delete(display->tick_timer);
+  }
 
   TaskHandle_t taskHandle;
   taskHandle = xTaskGetHandle(FETCH_TASK_NAME);
@@ -449,6 +1564,23 @@ void display_end(display_handle_t display) {
     vTaskDelete(display->animation_task_handle);
   }
 
+  taskHandle = xTaskGetHandle(RENDER_TASK_NAME);
+  if (taskHandle != NULL && taskHandle == display->render_task_handle) {
+    vTaskDelete(display->render_task_handle);
+  }
+
+  if (display->tick_semaphore != NULL) {
+    vSemaphoreDelete(display->tick_semaphore);
+  }
+  // only once the tasks are gone, so nothing can publish another list
+  if (display->pending_commands != NULL) {
+    command_list_end(display->pending_commands);
+  }
+  if (display->retired_commands != NULL) {
+    command_list_end(display->retired_commands);
+  }
+  vSemaphoreDelete(display->commands_mutex);
+
   free(display->last_etag);
   free(display);
 }
@@ -456,6 +1588,31 @@ void display_end(display_handle_t display) {
 // starts the display's fetch and animation tasks
 esp_err_t display_start(display_handle_t display) {
   BaseType_t taskCreate;
+  // created first, so the animation task's first frame is already split. If it
+  // can't be created, every band is drawn by the animation task instead.
+  taskCreate = xTaskCreatePinnedToCore(render_task, RENDER_TASK_NAME, 4096,
+                                       display, tskIDLE_PRIORITY + 2,
+                                       &display->render_task_handle, 1);
+  if (taskCreate != pdPASS) {
+    ESP_LOGW(TAG, "Failed to create task '%s'", RENDER_TASK_NAME);
+    display->render_task_handle = NULL;
+  }
+
+  // times each tick of the animation task. Without it, ticks fall back to
+  // the FreeRTOS tick.
+  const esp_timer_create_args_t timerArgs = {
+      .callback = tick_timer_callback,
+      .arg = display,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "display_tick",
+  };
+  display->tick_semaphore = xSemaphoreCreateBinary();
+  if (display->tick_semaphore == NULL ||
+      esp_timer_create(&timerArgs, &display->tick_timer) != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to create the tick timer");
+    display->tick_timer = NULL;
+  }
+
   taskCreate = xTaskCreatePinnedToCore(animation_task, ANIMATION_TASK_NAME,
                                        4096, display, tskIDLE_PRIORITY + 2,
                                        &display->animation_task_handle, 0);
@@ -1,24 +1,168 @@
 #pragma once
 
 #include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include <freertos/task.h>
 
 #include "esp_err.h"
+#include "esp_timer.h"
 #include <stdbool.h>
 
 #include "commands.h"
+#include "gfx/compositor.h"
 #include "gfx/display_buffer.h"
 #include "led_matrix.h"
 #include "state.h"
+#include "time_util.h"
+
+// Each frame is split into this many horizontal bands. The first is drawn by
+// the animation task and the rest by the render task, on the other core.
+#define DISPLAY_RENDER_BANDS 2
+
+// how often the display ticks while tweens or a transition are moving, which
+// is about 60 fps. Animations and effects still move on once per animation
+// delay.
+#define DISPLAY_FAST_TICK_MS 16
+
+// the most frames an animation skips in one tick when the display falls
+// behind. Any further behind, and it carries on from now instead.
+#define DISPLAY_MAX_SKIPPED_FRAMES 8
+
+// how often the animation task logs how late it woke up for each tick
+#define DISPLAY_JITTER_REPORT_MS 10000
+
+// how a layer's commands are applied this tick
+typedef enum {
+  // the layer has not changed, so its commands are skipped
+  RENDER_MODE_SKIP = 0,
+  // the commands are drawn
+  RENDER_MODE_DRAW = 1,
+  // the commands are applied with an empty clip, to find what changed
+  RENDER_MODE_MEASURE = 2,
+} render_mode_t;
+
+// what the bands of the current frame draw. Filled in before the bands start,
+// and only read while they draw.
+typedef struct {
+  command_list_handle_t commands;
+  render_mode_t modes[COMPOSITOR_LAYER_COUNT];
+  // what each measured layer has to redraw
+  display_buffer_rect_set_t damage[COMPOSITOR_LAYER_COUNT];
+  // layers whose static commands are copied from their cache, and the layers
+  // whose caches are drawn this frame
+  uint8_t cached_layers;
+  uint8_t caching_layers;
+  // read once per tick, so every band draws the same time
+  time_util_info_t time_info;
+  // notified by the render task when its bands are done
+  TaskHandle_t waiting_task;
+} render_frame_t;
+
+// the most steps of a loop of animations that the frame cache keeps. Each one
+// is a copy of the matrix's bitplanes, which is 32 KB for a 64x64 matrix.
+#define DISPLAY_FRAME_CACHE_STEPS 32
+
+// What the matrix shows after each step of a command list's animations. Steps
+// are kept in PSRAM as the first loop is drawn, and in later loops they're
+// copied back to the matrix instead of being drawn again. Only lists whose
+// animations all loop within `DISPLAY_FRAME_CACHE_STEPS` steps, and which
+// have no effects or animations with their own time, are cached.
+typedef struct {
+  // `loop_length` copies of the matrix's planes
+  uint8_t *planes;
+  // what each step changed from the one before it, which is all that's copied
+  display_buffer_rect_t changed[DISPLAY_FRAME_CACHE_STEPS];
+  // a bit for each step that has been kept
+  uint32_t kept;
+  // the steps until every animation is back on the same frame, or `0` if the
+  // command list isn't cached
+  uint16_t loop_length;
+  // the step the animations are on
+  uint16_t step;
+  // set when the list shows the time or date, so steps are only kept for the
+  // minute they were drawn in
+  bool uses_time;
+  int minute;
+  // the feedback icons the steps were drawn with
+  uint8_t feedback;
+  // set when the last tick was a step that could be kept, so the matrix shows
+  // the step before this one
+  bool is_steady;
+  // set when steps were copied instead of drawn, so the layers are behind the
+  // matrix and have to be drawn again in full
+  bool is_stale;
+} display_frame_cache_t;
+
+// How late the animation task woke up for each tick, since it was last
+// logged. Ticks are timed to the microsecond, so this is what's left from
+// other tasks and interrupts.
+typedef struct {
+  uint32_t ticks;
+  int64_t total_us;
+  int64_t max_us;
+  // frames that animations skipped because they were behind
+  uint32_t skipped_frames;
+  int64_t reported_at_us;
+} display_jitter_t;
 
 typedef struct {
   led_matrix_handle_t matrix;
-  display_buffer_handle_t display_buffer;
+  compositor_handle_t compositor;
   state_handle_t state;
   TaskHandle_t fetch_task_handle;
   TaskHandle_t animation_task_handle;
+  TaskHandle_t render_task_handle;
   char *last_etag;
   command_list_handle_t commands;
+  // The list the fetch task parsed, which the animation task swaps in before
+  // its next frame, so a list is never freed while a band is drawing it. The
+  // list it replaces is handed back as `retired_commands`, and ended by the
+  // fetch task, which is the only one that uses assets. Both are guarded by
+  // `commands_mutex`.
+  command_list_handle_t pending_commands;
+  command_list_handle_t retired_commands;
+  SemaphoreHandle_t commands_mutex;
+  // bumped each time `commands` is swapped, so the renderer knows when every
+  // layer has to be drawn again
+  uint32_t commands_generation;
+  uint32_t rendered_generation;
+  // see `command_list_dynamic_layers`
+  uint8_t dynamic_layers;
+  // when the command list was first shown, which tweens are timed from, and
+  // when its animations and effects next move on
+  int64_t shown_at_us;
+  int64_t next_step_us;
+  // When the animation task next ticks, which is the soonest of the next
+  // step, the next frame of each animation with its own time, and the
+  // fast tick. Deadlines are absolute, so the time spent drawing doesn't
+  // add up, and the one-shot `tick_timer` wakes the task through
+  // `tick_semaphore` right on time, instead of on the next FreeRTOS tick.
+  int64_t next_tick_us;
+  esp_timer_handle_t tick_timer;
+  SemaphoreHandle_t tick_semaphore;
+  display_jitter_t jitter;
+  // set when the command list has any tweens, so the display ticks faster
+  bool has_tweens;
+  // when the running transition began, and how long it takes. See
+  // `compositor_transition_begin`.
+  int64_t transition_start_us;
+  uint16_t transition_duration;
+  // kept across command lists, so graphs only need to send new samples.
+  // Created by the first graph command that uses each one.
+  series_handle_t series[COMMAND_GRAPH_SERIES_COUNT];
+  render_frame_t frame;
+  // each band draws through its own view of every layer
+  display_buffer_handle_t views[DISPLAY_RENDER_BANDS][COMPOSITOR_LAYER_COUNT];
+  // What each layer that is drawn more than once looks like after its static
+  // commands, kept until the command list is swapped. Created by the first
+  // command list that needs each one.
+  display_buffer_handle_t caches[COMPOSITOR_LAYER_COUNT];
+  // what each band of each cache covers
+  display_buffer_rect_t cache_bounds[DISPLAY_RENDER_BANDS]
+                                    [COMPOSITOR_LAYER_COUNT];
+  // see `render_frame_t`
+  uint8_t cached_layers;
+  display_frame_cache_t frame_cache;
 } display_t;
 
 typedef display_t *display_handle_t;
@@ -0,0 +1,135 @@
+#include "helper_utils.h"
+
+#include "gfx/color.h"
+
+// The color at each of the 256 steps around the color wheel, at full
+// saturation and value. Red is at `0`, green at about `85` and blue at about
+// `171`.
+static const uint8_t HUE_TABLE[256][3] = {
+    {255, 0, 0}, {255, 6, 0}, {255, 12, 0}, {255, 18, 0}, {255, 24, 0},
+    {255, 30, 0}, {255, 36, 0}, {255, 42, 0}, {255, 48, 0}, {255, 54, 0},
+    {255, 60, 0}, {255, 66, 0}, {255, 72, 0}, {255, 78, 0}, {255, 84, 0},
+    {255, 90, 0}, {255, 96, 0}, {255, 102, 0}, {255, 108, 0}, {255, 114, 0},
+    {255, 120, 0}, {255, 126, 0}, {255, 131, 0}, {255, 137, 0}, {255, 143, 0},
+    {255, 149, 0}, {255, 155, 0}, {255, 161, 0}, {255, 167, 0}, {255, 173, 0},
+    {255, 179, 0}, {255, 185, 0}, {255, 191, 0}, {255, 197, 0}, {255, 203, 0},
+    {255, 209, 0}, {255, 215, 0}, {255, 221, 0}, {255, 227, 0}, {255, 233, 0},
+    {255, 239, 0}, {255, 245, 0}, {255, 251, 0}, {253, 255, 0}, {247, 255, 0},
+    {241, 255, 0}, {235, 255, 0}, {229, 255, 0}, {223, 255, 0}, {217, 255, 0},
+    {211, 255, 0}, {205, 255, 0}, {199, 255, 0}, {193, 255, 0}, {187, 255, 0},
+    {181, 255, 0}, {175, 255, 0}, {169, 255, 0}, {163, 255, 0}, {157, 255, 0},
+    {151, 255, 0}, {145, 255, 0}, {139, 255, 0}, {133, 255, 0}, {128, 255, 0},
+    {122, 255, 0}, {116, 255, 0}, {110, 255, 0}, {104, 255, 0}, {98, 255, 0},
+    {92, 255, 0}, {86, 255, 0}, {80, 255, 0}, {74, 255, 0}, {68, 255, 0},
+    {62, 255, 0}, {56, 255, 0}, {50, 255, 0}, {44, 255, 0}, {38, 255, 0},
+    {32, 255, 0}, {26, 255, 0}, {20, 255, 0}, {14, 255, 0}, {8, 255, 0},
+    {2, 255, 0}, {0, 255, 4}, {0, 255, 10}, {0, 255, 16}, {0, 255, 22},
+    {0, 255, 28}, {0, 255, 34}, {0, 255, 40}, {0, 255, 46}, {0, 255, 52},
+    {0, 255, 58}, {0, 255, 64}, {0, 255, 70}, {0, 255, 76}, {0, 255, 82},
+    {0, 255, 88}, {0, 255, 94}, {0, 255, 100}, {0, 255, 106}, {0, 255, 112},
+    {0, 255, 118}, {0, 255, 124}, {0, 255, 129}, {0, 255, 135}, {0, 255, 141},
+    {0, 255, 147}, {0, 255, 153}, {0, 255, 159}, {0, 255, 165}, {0, 255, 171},
+    {0, 255, 177}, {0, 255, 183}, {0, 255, 189}, {0, 255, 195}, {0, 255, 201},
+    {0, 255, 207}, {0, 255, 213}, {0, 255, 219}, {0, 255, 225}, {0, 255, 231},
+    {0, 255, 237}, {0, 255, 243}, {0, 255, 249}, {0, 255, 255}, {0, 249, 255},
+    {0, 243, 255}, {0, 237, 255}, {0, 231, 255}, {0, 225, 255}, {0, 219, 255},
+    {0, 213, 255}, {0, 207, 255}, {0, 201, 255}, {0, 195, 255}, {0, 189, 255},
+    {0, 183, 255}, {0, 177, 255}, {0, 171, 255}, {0, 165, 255}, {0, 159, 255},
+    {0, 153, 255}, {0, 147, 255}, {0, 141, 255}, {0, 135, 255}, {0, 129, 255},
+    {0, 124, 255}, {0, 118, 255}, {0, 112, 255}, {0, 106, 255}, {0, 100, 255},
+    {0, 94, 255}, {0, 88, 255}, {0, 82, 255}, {0, 76, 255}, {0, 70, 255},
+    {0, 64, 255}, {0, 58, 255}, {0, 52, 255}, {0, 46, 255}, {0, 40, 255},
+    {0, 34, 255}, {0, 28, 255}, {0, 22, 255}, {0, 16, 255}, {0, 10, 255},
+    {0, 4, 255}, {2, 0, 255}, {8, 0, 255}, {14, 0, 255}, {20, 0, 255},
+    {26, 0, 255}, {32, 0, 255}, {38, 0, 255}, {44, 0, 255}, {50, 0, 255},
+    {56, 0, 255}, {62, 0, 255}, {68, 0, 255}, {74, 0, 255}, {80, 0, 255},
+    {86, 0, 255}, {92, 0, 255}, {98, 0, 255}, {104, 0, 255}, {110, 0, 255},
+    {116, 0, 255}, {122, 0, 255}, {128, 0, 255}, {133, 0, 255}, {139, 0, 255},
+    {145, 0, 255}, {151, 0, 255}, {157, 0, 255}, {163, 0, 255}, {169, 0, 255},
+    {175, 0, 255}, {181, 0, 255}, {187, 0, 255}, {193, 0, 255}, {199, 0, 255},
+    {205, 0, 255}, {211, 0, 255}, {217, 0, 255}, {223, 0, 255}, {229, 0, 255},
+    {235, 0, 255}, {241, 0, 255}, {247, 0, 255}, {253, 0, 255}, {255, 0, 251},
+    {255, 0, 245}, {255, 0, 239}, {255, 0, 233}, {255, 0, 227}, {255, 0, 221},
+    {255, 0, 215}, {255, 0, 209}, {255, 0, 203}, {255, 0, 197}, {255, 0, 191},
+    {255, 0, 185}, {255, 0, 179}, {255, 0, 173}, {255, 0, 167}, {255, 0, 161},
+    {255, 0, 155}, {255, 0, 149}, {255, 0, 143}, {255, 0, 137}, {255, 0, 131},
+    {255, 0, 126}, {255, 0, 120}, {255, 0, 114}, {255, 0, 108}, {255, 0, 102},
+    {255, 0, 96}, {255, 0, 90}, {255, 0, 84}, {255, 0, 78}, {255, 0, 72},
+    {255, 0, 66}, {255, 0, 60}, {255, 0, 54}, {255, 0, 48}, {255, 0, 42},
+    {255, 0, 36}, {255, 0, 30}, {255, 0, 24}, {255, 0, 18}, {255, 0, 12},
+    {255, 0, 6},
+};
+
+// `a * b / 255`, rounded
+static inline uint8_t mul8(uint8_t a, uint8_t b) {
+  const uint16_t product = a * b + 128;
+  return (product + (product >> 8)) >> 8;
+}
+
+// Works out an RGB color from a hue, saturation and value, each from `0` to
+// `255`. The hue is looked up in a table, so this only takes a few multiplies.
+void color_from_hsv(uint8_t hue, uint8_t saturation, uint8_t value,
+                    uint8_t *red, uint8_t *green, uint8_t *blue) {
+  const uint8_t *full = HUE_TABLE[hue];
+  *red = mul8(value, 255 - mul8(saturation, 255 - full[0]));
+  *green = mul8(value, 255 - mul8(saturation, 255 - full[1]));
+  *blue = mul8(value, 255 - mul8(saturation, 255 - full[2]));
+}
+
+// Works out an RGB color from a hue, saturation and lightness, each from `0`
+// to `255`, by way of the same color as a value.
+void color_from_hsl(uint8_t hue, uint8_t saturation, uint8_t lightness,
+                    uint8_t *red, uint8_t *green, uint8_t *blue) {
+  const uint8_t value =
+      lightness + mul8(saturation, MIN(lightness, 255 - lightness));
+  uint8_t valueSaturation = 0;
+  if (value > 0) {
+    valueSaturation =
+        MIN((2 * (value - lightness) * 255 + value / 2) / value, 255);
+  }
+  color_from_hsv(hue, valueSaturation, value, red, green, blue);
+}
+
+// the hue, saturation and value of an RGB color, the other way around to
+// `color_from_hsv`
+void color_to_hsv(uint8_t red, uint8_t green, uint8_t blue, uint8_t *hue,
+                  uint8_t *saturation, uint8_t *value) {
+  const uint8_t max = MAX(red, MAX(green, blue));
+  const uint8_t min = MIN(red, MIN(green, blue));
+  const int32_t delta = max - min;
+  *value = max;
+  if (delta == 0) {
+    *hue = 0;
+    *saturation = 0;
+    return;
+  }
+
+  *saturation = (delta * 255 + max / 2) / max;
+  // how far around the wheel the hue is, with 256 steps between each of red,
+  // yellow, green, cyan, blue and magenta
+  int32_t around;
+  if (max == red) {
+    around = (green - blue) * 256 / delta;
+  } else if (max == green) {
+    around = 512 + (blue - red) * 256 / delta;
+  } else {
+    around = 1024 + (red - green) * 256 / delta;
+  }
+  if (around < 0) {
+    around += 1536;
+  }
+  *hue = ((around * 256 + 768) / 1536) & 0xFF;
+}
+
+// turns a color `amount` steps around the color wheel, out of `256`, keeping
+// its saturation and value
+void color_rotate_hue(uint8_t *red, uint8_t *green, uint8_t *blue,
+                      uint8_t amount) {
+  if (amount == 0) {
+    return;
+  }
+
+  uint8_t hue, saturation, value;
+  color_to_hsv(*red, *green, *blue, &hue, &saturation, &value);
+  color_from_hsv(hue + amount, saturation, value, red, green, blue);
+}
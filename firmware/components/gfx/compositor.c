@@ -0,0 +1,403 @@
+#include <memory.h>
+
+#include "esp_log.h"
+
+#include "helper_utils.h"
+
+#include "gfx/compositor.h"
+
+static const char *TAG = "GFX:COMPOSITOR";
+
+// The blend kernels work on 4 pixels of one channel at a time, packed into a
+// 32 bit word. Multiplies are done on the even and odd bytes separately, so
+// each byte has 16 bits to grow into and never carries into its neighbour.
+typedef uint32_t __attribute__((may_alias)) swar_word_t;
+
+#define SWAR_LANES_EVEN 0x00FF00FFU
+#define SWAR_LANES_ODD 0xFF00FF00U
+#define SWAR_LOW_BITS 0x7F7F7F7FU
+#define SWAR_HIGH_BITS 0x80808080U
+
+// `0xFF` in every byte that is not zero
+static inline uint32_t swar_nonzero_mask(uint32_t word) {
+  const uint32_t high =
+      (word | ((word & SWAR_LOW_BITS) + SWAR_LOW_BITS)) & SWAR_HIGH_BITS;
+  return (high >> 7) * 0xFF;
+}
+
+// `(src * alpha + dst * (256 - alpha)) / 256` for each byte
+static inline uint32_t swar_lerp(uint32_t dst, uint32_t src, uint16_t alpha) {
+  const uint16_t inverse = 256 - alpha;
+  const uint32_t even = (((src & SWAR_LANES_EVEN) * alpha) +
+                         ((dst & SWAR_LANES_EVEN) * inverse)) >>
+                        8;
+  const uint32_t odd = (((src >> 8) & SWAR_LANES_EVEN) * alpha) +
+                       (((dst >> 8) & SWAR_LANES_EVEN) * inverse);
+  return (even & SWAR_LANES_EVEN) | (odd & SWAR_LANES_ODD);
+}
+
+// `dst + (src * alpha / 256)` for each byte, saturating at `255`
+static inline uint32_t swar_add(uint32_t dst, uint32_t src, uint16_t alpha) {
+  if (alpha < 256) {
+    src = swar_lerp(0, src, alpha);
+  }
+  const uint32_t sum = (dst & SWAR_LOW_BITS) + (src & SWAR_LOW_BITS);
+  const uint32_t carry = ((dst & src) | (sum & (dst | src))) & SWAR_HIGH_BITS;
+  return (sum ^ ((dst ^ src) & SWAR_HIGH_BITS)) | ((carry >> 7) * 0xFF);
+}
+
+// the same as the word kernels, for the pixels that don't fill a whole word
+static inline uint8_t blend_channel(uint8_t dst, uint8_t src, uint16_t alpha,
+                                    compositor_blend_t blend) {
+  if (blend == COMPOSITOR_BLEND_ADD) {
+    return MIN(dst + ((src * alpha) >> 8), 255);
+  }
+  return ((src * alpha) + (dst * (256 - alpha))) >> 8;
+}
+
+// blends `length` pixels of `src` onto `dst`, starting at `index`. The planes
+// are allocated with `malloc`, so they are word aligned wherever `index` is.
+static void blend_span(display_buffer_handle_t dst, display_buffer_handle_t src,
+                       uint16_t index, uint16_t length, uint16_t alpha,
+                       compositor_blend_t blend) {
+  const uint16_t end = index + length;
+  uint16_t wordEnd;
+  uint32_t srcRed, srcGreen, srcBlue, mask;
+  swar_word_t *dstRed, *dstGreen, *dstBlue;
+
+  while (index < end) {
+    if ((index & 3) != 0 || end - index < 4) {
+      // black pixels are transparent
+      if ((src->buffer_red[index] | src->buffer_green[index] |
+           src->buffer_blue[index]) != 0) {
+        dst->buffer_red[index] = blend_channel(
+            dst->buffer_red[index], src->buffer_red[index], alpha, blend);
+        dst->buffer_green[index] = blend_channel(
+            dst->buffer_green[index], src->buffer_green[index], alpha, blend);
+        dst->buffer_blue[index] = blend_channel(
+            dst->buffer_blue[index], src->buffer_blue[index], alpha, blend);
+      }
+      index++;
+      continue;
+    }
+
+    wordEnd = end & ~3;
+    for (; index < wordEnd; index += 4) {
+      srcRed = *(swar_word_t *)(src->buffer_red + index);
+      srcGreen = *(swar_word_t *)(src->buffer_green + index);
+      srcBlue = *(swar_word_t *)(src->buffer_blue + index);
+      mask = swar_nonzero_mask(srcRed | srcGreen | srcBlue);
+      // all four pixels are black, so there is nothing to do
+      if (mask == 0) {
+        continue;
+      }
+
+      dstRed = (swar_word_t *)(dst->buffer_red + index);
+      dstGreen = (swar_word_t *)(dst->buffer_green + index);
+      dstBlue = (swar_word_t *)(dst->buffer_blue + index);
+      if (blend == COMPOSITOR_BLEND_ADD) {
+        // black adds nothing, so it does not need masking
+        *dstRed = swar_add(*dstRed, srcRed, alpha);
+        *dstGreen = swar_add(*dstGreen, srcGreen, alpha);
+        *dstBlue = swar_add(*dstBlue, srcBlue, alpha);
+      } else {
+        // only the pixels that are not black are replaced
+        *dstRed =
+            (swar_lerp(*dstRed, srcRed, alpha) & mask) | (*dstRed & ~mask);
+        *dstGreen = (swar_lerp(*dstGreen, srcGreen, alpha) & mask) |
+                    (*dstGreen & ~mask);
+        *dstBlue =
+            (swar_lerp(*dstBlue, srcBlue, alpha) & mask) | (*dstBlue & ~mask);
+      }
+    }
+  }
+}
+
+// mixes `length` pixels of `from` and `to` into `dst`, by `alpha` out of `256`.
+// Unlike `blend_span`, black is not transparent.
+static void lerp_span(display_buffer_handle_t dst, display_buffer_handle_t from,
+                      display_buffer_handle_t to, uint16_t length,
+                      uint16_t alpha) {
+  const uint16_t wordEnd = length & ~3;
+  uint16_t index = 0;
+  for (; index < wordEnd; index += 4) {
+    *(swar_word_t *)(dst->buffer_red + index) =
+        swar_lerp(*(swar_word_t *)(from->buffer_red + index),
+                  *(swar_word_t *)(to->buffer_red + index), alpha);
+    *(swar_word_t *)(dst->buffer_green + index) =
+        swar_lerp(*(swar_word_t *)(from->buffer_green + index),
+                  *(swar_word_t *)(to->buffer_green + index), alpha);
+    *(swar_word_t *)(dst->buffer_blue + index) =
+        swar_lerp(*(swar_word_t *)(from->buffer_blue + index),
+                  *(swar_word_t *)(to->buffer_blue + index), alpha);
+  }
+  for (; index < length; index++) {
+    dst->buffer_red[index] = blend_channel(
+        from->buffer_red[index], to->buffer_red[index], alpha,
+        COMPOSITOR_BLEND_NORMAL);
+    dst->buffer_green[index] = blend_channel(
+        from->buffer_green[index], to->buffer_green[index], alpha,
+        COMPOSITOR_BLEND_NORMAL);
+    dst->buffer_blue[index] = blend_channel(
+        from->buffer_blue[index], to->buffer_blue[index], alpha,
+        COMPOSITOR_BLEND_NORMAL);
+  }
+}
+
+// copies `length` pixels of row `srcY` of `src`, from `srcX`, to `dst`
+static inline void copy_run(display_buffer_handle_t dst, uint8_t x, uint8_t y,
+                            display_buffer_handle_t src, uint8_t srcX,
+                            uint8_t srcY, uint8_t length) {
+  const uint16_t index = display_buffer_point_to_index(dst, x, y);
+  const uint16_t srcIndex = display_buffer_point_to_index(src, srcX, srcY);
+  memcpy(dst->buffer_red + index, src->buffer_red + srcIndex, length);
+  memcpy(dst->buffer_green + index, src->buffer_green + srcIndex, length);
+  memcpy(dst->buffer_blue + index, src->buffer_blue + srcIndex, length);
+}
+
+// blends a layer onto `dst` within `rect`. Outside of its bounds the layer is
+// all black, so only where they overlap is touched.
+static void blend_layer(display_buffer_handle_t dst, compositor_layer_t *layer,
+                        const display_buffer_rect_t *rect) {
+  const display_buffer_rect_t *bounds = &layer->db->bounds;
+  const uint8_t x0 = MAX(rect->x0, bounds->x0);
+  const uint8_t x1 = MIN(rect->x1, bounds->x1);
+  const uint8_t y0 = MAX(rect->y0, bounds->y0);
+  const uint8_t y1 = MIN(rect->y1, bounds->y1);
+  // map the opacity to 0-256, so opaque layers are copied exactly
+  const uint16_t alpha = layer->opacity + (layer->opacity >> 7);
+
+  if (alpha == 0 || x1 <= x0 || y1 <= y0) {
+    return;
+  }
+
+  for (uint8_t y = y0; y < y1; y++) {
+    blend_span(dst, layer->db, display_buffer_point_to_index(dst, x0, y),
+               x1 - x0, alpha, layer->blend);
+  }
+}
+
+// adds every rectangle of `other` to `set`
+static inline void add_rect_set(display_buffer_rect_set_t *set,
+                                const display_buffer_rect_set_t *other) {
+  for (uint8_t i = 0; i < other->count; i++) {
+    display_buffer_rect_set_add(set, &other->rects[i]);
+  }
+}
+
+esp_err_t compositor_init(compositor_handle_t *compositor_handle,
+                          uint8_t width, uint8_t height) {
+  compositor_handle_t compositor =
+      (compositor_handle_t)calloc(1, sizeof(compositor_t));
+  if (compositor == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for compositor");
+    *compositor_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  compositor->width = width;
+  compositor->height = height;
+
+  esp_err_t ret = display_buffer_init(&compositor->under, width, height);
+  if (ret == ESP_OK) {
+    ret = display_buffer_init(&compositor->output, width, height);
+  }
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT && ret == ESP_OK;
+       layer++) {
+    compositor->layers[layer].opacity = COMPOSITOR_OPACITY_OPAQUE;
+    compositor->layers[layer].blend = COMPOSITOR_BLEND_NORMAL;
+    ret = display_buffer_init(&compositor->layers[layer].db, width, height);
+  }
+
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to initialize compositor buffers");
+    compositor_end(compositor);
+    *compositor_handle = NULL;
+    return ret;
+  }
+
+  *compositor_handle = compositor;
+
+  return ESP_OK;
+}
+
+void compositor_end(compositor_handle_t compositor) {
+  if (compositor == NULL) {
+    return;
+  }
+
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    if (compositor->layers[layer].db != NULL) {
+      display_buffer_end(compositor->layers[layer].db);
+    }
+  }
+  if (compositor->under != NULL) {
+    display_buffer_end(compositor->under);
+  }
+  if (compositor->output != NULL) {
+    display_buffer_end(compositor->output);
+  }
+  if (compositor->previous != NULL) {
+    display_buffer_end(compositor->previous);
+  }
+  if (compositor->transition != NULL) {
+    display_buffer_end(compositor->transition);
+  }
+  free(compositor);
+}
+
+// clears a layer so it can be drawn again, and returns its buffer. Layers that
+// are not begun keep what they last drew, and only their dirty rectangles are
+// composited again.
+display_buffer_handle_t compositor_layer_begin(compositor_handle_t compositor,
+                                               compositor_layer_id_t layer) {
+  compositor_layer_t *target = &compositor->layers[layer];
+  display_buffer_clear_bounds(target->db);
+  return target->db;
+}
+
+void compositor_layer_set_blend(compositor_handle_t compositor,
+                                compositor_layer_id_t layer, uint8_t opacity,
+                                compositor_blend_t blend) {
+  compositor_layer_t *target = &compositor->layers[layer];
+  if (target->opacity != opacity || target->blend != blend) {
+    target->opacity = opacity;
+    target->blend = blend;
+    // everything the layer has drawn looks different now
+    display_buffer_rect_set_add(&target->db->dirty, &target->db->bounds);
+  }
+}
+
+// Blends the dirty rectangles of every layer into `output`, and fills `damage`
+// with the rectangles of `output` that changed. The layers' dirty sets are
+// cleared.
+void compositor_compose(compositor_handle_t compositor,
+                        display_buffer_rect_set_t *damage) {
+  compositor_layer_t *overlay = &compositor->layers[COMPOSITOR_LAYER_OVERLAY];
+  const display_buffer_rect_t *rect;
+  display_buffer_rect_set_clear(damage);
+
+  // first bring `under` up to date where any of its layers changed
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_OVERLAY; layer++) {
+    add_rect_set(damage, &compositor->layers[layer].db->dirty);
+  }
+  for (uint8_t i = 0; i < damage->count; i++) {
+    rect = &damage->rects[i];
+    for (uint8_t y = rect->y0; y < rect->y1; y++) {
+      const uint16_t index =
+          display_buffer_point_to_index(compositor->under, rect->x0, y);
+      memset(compositor->under->buffer_red + index, 0, rect->x1 - rect->x0);
+      memset(compositor->under->buffer_green + index, 0, rect->x1 - rect->x0);
+      memset(compositor->under->buffer_blue + index, 0, rect->x1 - rect->x0);
+    }
+    for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_OVERLAY; layer++) {
+      blend_layer(compositor->under, &compositor->layers[layer], rect);
+    }
+  }
+
+  // then put the overlay on top of `under`, where either changed
+  add_rect_set(damage, &overlay->db->dirty);
+  for (uint8_t i = 0; i < damage->count; i++) {
+    display_buffer_copy_rect(compositor->output, compositor->under,
+                             &damage->rects[i]);
+    blend_layer(compositor->output, overlay, &damage->rects[i]);
+  }
+
+  for (uint8_t layer = 0; layer < COMPOSITOR_LAYER_COUNT; layer++) {
+    display_buffer_rect_set_clear(&compositor->layers[layer].db->dirty);
+  }
+}
+
+// Starts a transition from what is on the matrix now to `output`. If another
+// transition is running, the new one starts from where that one got to.
+esp_err_t compositor_transition_begin(compositor_handle_t compositor,
+                                      compositor_transition_t type,
+                                      compositor_direction_t direction) {
+  esp_err_t ret = ESP_OK;
+  if (compositor->previous == NULL) {
+    ret = display_buffer_init(&compositor->previous, compositor->width,
+                              compositor->height);
+  }
+  if (ret == ESP_OK && compositor->transition == NULL) {
+    ret = display_buffer_init(&compositor->transition, compositor->width,
+                              compositor->height);
+  }
+  if (ret != ESP_OK) {
+    ESP_LOGW(TAG, "Failed to create transition buffers");
+    compositor->transition_type = COMPOSITOR_TRANSITION_NONE;
+    return ret;
+  }
+
+  const display_buffer_rect_t frame = {
+      .x0 = 0,
+      .y0 = 0,
+      .x1 = compositor->width,
+      .y1 = compositor->height,
+  };
+  display_buffer_copy_rect(compositor->previous,
+                           compositor->transition_type ==
+                                   COMPOSITOR_TRANSITION_NONE
+                               ? compositor->output
+                               : compositor->transition,
+                           &frame);
+  compositor->transition_type = type;
+  compositor->transition_direction = direction;
+
+  return ESP_OK;
+}
+
+// Mixes `previous` and `output` into `transition`, `progress` of the way
+// through the running transition, and returns it. A crossfade blends whole
+// words with the same kernel as the layers, and a wipe or slide only copies
+// runs of pixels, so every step costs about one pass over the frame.
+display_buffer_handle_t
+compositor_transition_step(compositor_handle_t compositor, uint16_t progress) {
+  display_buffer_handle_t from = compositor->previous;
+  display_buffer_handle_t to = compositor->output;
+  display_buffer_handle_t dst = compositor->transition;
+  const uint8_t width = compositor->width;
+  const uint8_t height = compositor->height;
+  progress = MIN(progress, COMPOSITOR_TRANSITION_DONE);
+
+  if (compositor->transition_type == COMPOSITOR_TRANSITION_CROSSFADE) {
+    lerp_span(dst, from, to, width * height, progress);
+    return dst;
+  }
+
+  // Split the frame at `split` along the way it moves. A wipe shows each frame
+  // where it is, and a slide moves both frames along by `moved`.
+  const compositor_direction_t direction = compositor->transition_direction;
+  const bool isVertical = direction == COMPOSITOR_DIRECTION_UP ||
+                          direction == COMPOSITOR_DIRECTION_DOWN;
+  const bool isBackward = direction == COMPOSITOR_DIRECTION_LEFT ||
+                          direction == COMPOSITOR_DIRECTION_UP;
+  const bool isSlide =
+      compositor->transition_type == COMPOSITOR_TRANSITION_SLIDE;
+  const uint8_t extent = isVertical ? height : width;
+  const uint8_t moved = (extent * progress) / COMPOSITOR_TRANSITION_DONE;
+  const uint8_t split = isBackward ? extent - moved : moved;
+  display_buffer_handle_t first = isBackward ? from : to;
+  display_buffer_handle_t second = isBackward ? to : from;
+  const uint8_t firstStart =
+      isSlide ? (isBackward ? moved : extent - moved) : 0;
+  const uint8_t secondStart = isSlide ? 0 : split;
+
+  for (uint8_t y = 0; y < height; y++) {
+    if (!isVertical) {
+      copy_run(dst, 0, y, first, firstStart, y, split);
+      copy_run(dst, split, y, second, secondStart, y, width - split);
+    } else if (y < split) {
+      copy_run(dst, 0, y, first, 0, firstStart + y, width);
+    } else {
+      copy_run(dst, 0, y, second, 0, secondStart + y - split, width);
+    }
+  }
+
+  return dst;
+}
+
+// stops the running transition, so `output` is shown again. The transition
+// buffers are kept for the next one.
+void compositor_transition_end(compositor_handle_t compositor) {
+  compositor->transition_type = COMPOSITOR_TRANSITION_NONE;
+}
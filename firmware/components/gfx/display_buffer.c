@@ -23,8 +23,14 @@ esp_err_t display_buffer_init(display_buffer_handle_t *db_handle, uint8_t width,
 
   display_buffer_set_color(db, 255, 255, 255);
   display_buffer_set_cursor(db, 0, 0);
+  db->palette = NULL;
+  db->text_scale = 1;
+  display_buffer_rect_clear(&db->bounds);
+  display_buffer_rect_clear(&db->measured);
+  display_buffer_rect_set_clear(&db->dirty);
   db->width = width;
   db->height = height;
+  display_buffer_rect_set_full(db, &db->clip);
   db->length = db->width * db->height;
 
   db->buffer_red = (uint8_t *)malloc(sizeof(uint8_t) * db->length);
@@ -58,9 +64,129 @@ esp_err_t display_buffer_init(display_buffer_handle_t *db_handle, uint8_t width,
 
 // resets all values in the buffer to `0`
 void display_buffer_clear(display_buffer_handle_t db) {
+  display_buffer_rect_t full;
+  display_buffer_rect_set_full(db, &full);
   memset(db->buffer_red, 0, sizeof(uint8_t) * db->length);
   memset(db->buffer_green, 0, sizeof(uint8_t) * db->length);
   memset(db->buffer_blue, 0, sizeof(uint8_t) * db->length);
+  display_buffer_rect_clear(&db->bounds);
+  display_buffer_rect_set_add(&db->dirty, &full);
+}
+
+// the same as `display_buffer_clear`, but only clears what has been drawn since
+// the last clear
+void display_buffer_clear_bounds(display_buffer_handle_t db) {
+  display_buffer_clear_rect(db, &db->bounds);
+  display_buffer_rect_clear(&db->bounds);
+}
+
+// resets the pixels within `rect` to `0`. The bounds are left as they are,
+// since whatever is redrawn there will be included again.
+void display_buffer_clear_rect(display_buffer_handle_t db,
+                               const display_buffer_rect_t *rect) {
+  if (display_buffer_rect_is_empty(rect)) {
+    return;
+  }
+
+  const uint8_t width = rect->x1 - rect->x0;
+  uint16_t index;
+  for (uint8_t y = rect->y0; y < rect->y1; y++) {
+    index = display_buffer_point_to_index(db, rect->x0, y);
+    memset(db->buffer_red + index, 0, width);
+    memset(db->buffer_green + index, 0, width);
+    memset(db->buffer_blue + index, 0, width);
+  }
+  display_buffer_rect_set_add(&db->dirty, rect);
+}
+
+// Copies `rect` of one buffer into another of the same size, as one span per
+// row and plane. The bounds, clip and dirty set of neither are touched.
+void display_buffer_copy_rect(display_buffer_handle_t dst,
+                              display_buffer_handle_t src,
+                              const display_buffer_rect_t *rect) {
+  if (display_buffer_rect_is_empty(rect)) {
+    return;
+  }
+
+  const uint8_t width = rect->x1 - rect->x0;
+  uint16_t index;
+  for (uint8_t y = rect->y0; y < rect->y1; y++) {
+    index = display_buffer_point_to_index(dst, rect->x0, y);
+    memcpy(dst->buffer_red + index, src->buffer_red + index, width);
+    memcpy(dst->buffer_green + index, src->buffer_green + index, width);
+    memcpy(dst->buffer_blue + index, src->buffer_blue + index, width);
+  }
+}
+
+static inline uint16_t rect_area(const display_buffer_rect_t *rect) {
+  return (rect->x1 - rect->x0) * (rect->y1 - rect->y0);
+}
+
+// whether two rectangles overlap or share an edge
+static inline bool rect_touches(const display_buffer_rect_t *rect,
+                                const display_buffer_rect_t *other) {
+  return rect->x0 <= other->x1 && other->x0 <= rect->x1 &&
+         rect->y0 <= other->y1 && other->y0 <= rect->y1;
+}
+
+// Adds a rectangle to the set. It is merged with any rectangle it touches, and
+// the merged rectangle is then checked against the rest again, since it may
+// now touch one it did not before. When the set is full, it is merged with
+// whichever rectangle grows the least.
+void display_buffer_rect_set_add(display_buffer_rect_set_t *set,
+                                 const display_buffer_rect_t *rect) {
+  if (display_buffer_rect_is_empty(rect)) {
+    return;
+  }
+
+  display_buffer_rect_t merged = *rect;
+  display_buffer_rect_t grown;
+  uint8_t i = 0;
+  uint8_t best;
+  uint16_t growth;
+  uint16_t bestGrowth;
+
+  while (i < set->count) {
+    if (rect_touches(&set->rects[i], &merged)) {
+      display_buffer_rect_union(&merged, &set->rects[i]);
+      set->rects[i] = set->rects[--set->count];
+      i = 0;
+    } else {
+      i++;
+    }
+  }
+
+  if (set->count == DISPLAY_BUFFER_RECT_SET_MAX) {
+    best = 0;
+    bestGrowth = UINT16_MAX;
+    for (i = 0; i < set->count; i++) {
+      grown = set->rects[i];
+      display_buffer_rect_union(&grown, &merged);
+      growth = rect_area(&grown) - rect_area(&set->rects[i]);
+      if (growth < bestGrowth) {
+        best = i;
+        bestGrowth = growth;
+      }
+    }
+    // the merged rectangle may now touch others, so add it again
+    display_buffer_rect_union(&merged, &set->rects[best]);
+    set->rects[best] = set->rects[--set->count];
+    display_buffer_rect_set_add(set, &merged);
+    return;
+  }
+
+  set->rects[set->count++] = merged;
+}
+
+// puts the cursor, color, font, text scale and palette back to how they are
+// after `display_buffer_init`. Does not change the buffer.
+void display_buffer_reset_state(display_buffer_handle_t db) {
+  display_buffer_set_color(db, 255, 255, 255);
+  display_buffer_set_cursor(db, 0, 0);
+  font_set_size(db->font, FONT_SIZE_MD);
+  db->text_scale = 1;
+  db->palette = NULL;
+  db->fill = NULL;
 }
 
 // cleans up all memory associated with the buffer
@@ -72,78 +198,466 @@ void display_buffer_end(display_buffer_handle_t db) {
   free(db);
 }
 
+// Creates a view of `db`: a buffer that draws into the same pixels, but has its
+// own cursor, font, clip, bounds and dirty set. Views with clips that don't
+// overlap can draw at the same time, from different tasks.
+esp_err_t display_buffer_view_init(display_buffer_handle_t *view_handle,
+                                   display_buffer_handle_t db) {
+  display_buffer_handle_t view =
+      (display_buffer_handle_t)malloc(sizeof(display_buffer_t));
+  if (view == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for display buffer view");
+    *view_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  *view = *db;
+  if (font_init(&view->font) != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to initialize font for display buffer view");
+    free(view);
+    *view_handle = NULL;
+    return ESP_FAIL;
+  }
+  display_buffer_reset_state(view);
+
+  *view_handle = view;
+
+  return ESP_OK;
+}
+
+// cleans up a view, leaving the pixels it shares alone
+void display_buffer_view_end(display_buffer_handle_t view) {
+  if (view == NULL) {
+    return;
+  }
+  font_end(view->font);
+  free(view);
+}
+
+// starts drawing into a view, only within `clip`
+void display_buffer_view_begin(display_buffer_handle_t view,
+                               const display_buffer_rect_t *clip) {
+  view->clip = *clip;
+  display_buffer_rect_clear(&view->bounds);
+  display_buffer_rect_clear(&view->measured);
+  display_buffer_rect_set_clear(&view->dirty);
+}
+
+// adds what a view drew to the bounds and dirty set of the buffer it views
+void display_buffer_view_merge(display_buffer_handle_t db,
+                               display_buffer_handle_t view) {
+  display_buffer_rect_union(&db->bounds, &view->bounds);
+  for (uint8_t i = 0; i < view->dirty.count; i++) {
+    display_buffer_rect_set_add(&db->dirty, &view->dirty.rects[i]);
+  }
+}
+
+// Called by each primitive with the rectangle it is about to draw in. The
+// rectangle is clipped to the buffer and measured, then clipped to the clip and
+// added to the bounds and dirty set. Returns `false` when nothing is left
+// after clipping, so the primitive can skip drawing and just move the cursor.
+static bool include_rect(display_buffer_handle_t db, int16_t x, int16_t y,
+                         int16_t width, int16_t height) {
+  if (x >= db->width || y >= db->height || width <= 0 || height <= 0 ||
+      x + width <= 0 || y + height <= 0) {
+    return false;
+  }
+
+  display_buffer_rect_t rect = {
+      .x0 = MAX(x, 0),
+      .y0 = MAX(y, 0),
+      .x1 = MIN(x + width, db->width),
+      .y1 = MIN(y + height, db->height),
+  };
+  display_buffer_rect_union(&db->measured, &rect);
+
+  display_buffer_rect_intersect(&rect, &db->clip);
+  if (display_buffer_rect_is_empty(&rect)) {
+    return false;
+  }
+  display_buffer_rect_union(&db->bounds, &rect);
+  display_buffer_rect_set_add(&db->dirty, &rect);
+  return true;
+}
+
+// fills a horizontal run of pixels. The caller is responsible for clipping.
+static inline void fill_span(display_buffer_handle_t db, uint16_t index,
+                             uint8_t length, uint8_t red, uint8_t green,
+                             uint8_t blue) {
+  memset(db->buffer_red + index, red, length);
+  memset(db->buffer_green + index, green, length);
+  memset(db->buffer_blue + index, blue, length);
+}
+
+// fills a block of pixels, clipped to the clip. Does not touch the bounds.
+static inline void fill_block(display_buffer_handle_t db, int16_t x, int16_t y,
+                              uint16_t width, uint16_t height, uint8_t red,
+                              uint8_t green, uint8_t blue) {
+  const int16_t x0 = MAX(x, db->clip.x0);
+  const int16_t y0 = MAX(y, db->clip.y0);
+  const int16_t x1 = MIN(x + width, db->clip.x1);
+  const int16_t y1 = MIN(y + height, db->clip.y1);
+  if (x1 <= x0 || y1 <= y0) {
+    return;
+  }
+
+  uint16_t index = display_buffer_point_to_index(db, x0, y0);
+  for (int16_t row = y0; row < y1; row++, index += db->width) {
+    fill_span(db, index, x1 - x0, red, green, blue);
+  }
+}
+
+// the rectangle a fill is stretched over. It may be larger than, or start
+// before, what is actually drawn.
+typedef struct {
+  int16_t x;
+  int16_t y;
+  uint16_t width;
+  uint16_t height;
+} fill_area_t;
+
+// Fills `length` pixels with a gradient, where `position` is how far along the
+// gradient the first pixel is and `step` how much further each pixel is, both
+// in 16.16 fixed point. Between two stops the color changes by the same amount
+// each pixel, so each segment is stepped without any divides.
+static void fill_gradient_span(display_buffer_handle_t db, uint16_t index,
+                               uint8_t length, uint32_t position,
+                               uint32_t step,
+                               const display_buffer_fill_t *fill,
+                               uint8_t shift) {
+  const display_buffer_fill_stop_t *stops = fill->stops;
+  uint8_t stop = 0;
+  uint8_t runLength;
+  uint16_t segment;
+  uint32_t offset;
+  int32_t red, green, blue;
+  int32_t stepRed, stepGreen, stepBlue;
+
+  while (length > 0) {
+    // find the first stop past the current position
+    while (stop < fill->stop_count &&
+           (position >> 16) >= stops[stop].position) {
+      stop++;
+    }
+
+    // before the first stop or after the last, the color doesn't change
+    if (stop == 0 || stop == fill->stop_count) {
+      const display_buffer_fill_stop_t *end =
+          &stops[stop == 0 ? 0 : fill->stop_count - 1];
+      runLength = length;
+      if (stop == 0 && step != 0) {
+        runLength = MIN(
+            (((uint32_t)end->position << 16) - position + step - 1) / step,
+            length);
+      }
+      fill_span(db, index, runLength, end->red >> shift, end->green >> shift,
+                end->blue >> shift);
+      index += runLength;
+      length -= runLength;
+      position += runLength * step;
+      continue;
+    }
+
+    const display_buffer_fill_stop_t *from = &stops[stop - 1];
+    const display_buffer_fill_stop_t *to = &stops[stop];
+    segment = to->position - from->position;
+    offset = position - ((uint32_t)from->position << 16);
+    red = ((int32_t)from->red << 16) +
+          ((to->red - from->red) * (int32_t)(offset / segment)) + (1 << 15);
+    green = ((int32_t)from->green << 16) +
+            ((to->green - from->green) * (int32_t)(offset / segment)) +
+            (1 << 15);
+    blue = ((int32_t)from->blue << 16) +
+           ((to->blue - from->blue) * (int32_t)(offset / segment)) +
+           (1 << 15);
+    stepRed = ((int64_t)(to->red - from->red) * step) / segment;
+    stepGreen = ((int64_t)(to->green - from->green) * step) / segment;
+    stepBlue = ((int64_t)(to->blue - from->blue) * step) / segment;
+
+    // run up to the next stop
+    runLength = length;
+    if (step != 0) {
+      runLength = MIN(
+          (((uint32_t)to->position << 16) - position + step - 1) / step,
+          length);
+    }
+    for (uint8_t i = 0; i < runLength; i++, index++) {
+      db->buffer_red[index] = (red >> 16) >> shift;
+      db->buffer_green[index] = (green >> 16) >> shift;
+      db->buffer_blue[index] = (blue >> 16) >> shift;
+      red += stepRed;
+      green += stepGreen;
+      blue += stepBlue;
+    }
+    length -= runLength;
+    position += runLength * step;
+  }
+}
+
+// Fills `length` pixels with a checker or stripe pattern. `column` and `row`
+// are where the first pixel is in the fill's area. The pattern is drawn as
+// runs of up to `pattern_size` pixels of one color.
+static void fill_pattern_span(display_buffer_handle_t db, uint16_t index,
+                              uint8_t length, int16_t column, int16_t row,
+                              const display_buffer_fill_t *fill,
+                              uint8_t shift) {
+  const int16_t size = fill->pattern_size;
+  const int16_t period = size * 2;
+  // where in the pattern's period the first pixel is, along and across the
+  // direction the pattern changes in
+  int16_t along = column;
+  int16_t across = 0;
+  uint8_t runLength;
+  const display_buffer_fill_stop_t *stop;
+
+  if (fill->type == DISPLAY_BUFFER_FILL_CHECKER) {
+    across = row;
+  } else if (fill->direction == DISPLAY_BUFFER_FILL_VERTICAL) {
+    across = row;
+  } else if (fill->direction == DISPLAY_BUFFER_FILL_DIAGONAL) {
+    along = column + row;
+  }
+  along %= period;
+  along += along < 0 ? period : 0;
+  across %= period;
+  across += across < 0 ? period : 0;
+
+  // vertical stripes are the same color all the way across
+  if (fill->type == DISPLAY_BUFFER_FILL_STRIPES &&
+      fill->direction == DISPLAY_BUFFER_FILL_VERTICAL) {
+    stop = &fill->stops[(across / size) & 1];
+    fill_span(db, index, length, stop->red >> shift, stop->green >> shift,
+              stop->blue >> shift);
+    return;
+  }
+
+  while (length > 0) {
+    stop = &fill->stops[((along / size) + (across / size)) & 1];
+    runLength = MIN(size - (along % size), length);
+    fill_span(db, index, runLength, stop->red >> shift, stop->green >> shift,
+              stop->blue >> shift);
+    index += runLength;
+    length -= runLength;
+    along = (along + runLength) % period;
+  }
+}
+
+// Fills a block of pixels with the current fill stretched over `area`, or the
+// current color when there is no fill. Each color is shifted right by `shift`,
+// for dimmer versions of the same fill. Clipped to the clip, and does not
+// touch the bounds.
+static void fill_block_styled(display_buffer_handle_t db, int16_t x,
+                              int16_t y, uint16_t width, uint16_t height,
+                              const fill_area_t *area, uint8_t shift) {
+  const display_buffer_fill_t *fill = db->fill;
+  if (fill == NULL) {
+    fill_block(db, x, y, width, height, db->color_red >> shift,
+               db->color_green >> shift, db->color_blue >> shift);
+    return;
+  }
+
+  const int16_t x0 = MAX(x, db->clip.x0);
+  const int16_t y0 = MAX(y, db->clip.y0);
+  const int16_t x1 = MIN(x + width, db->clip.x1);
+  const int16_t y1 = MIN(y + height, db->clip.y1);
+  if (x1 <= x0 || y1 <= y0) {
+    return;
+  }
+
+  // How far along the gradient each column and row moves it, in 16.16. These
+  // are rounded up, so pixels that land exactly on a stop aren't a step short.
+  const uint32_t length =
+      fill->direction == DISPLAY_BUFFER_FILL_DIAGONAL ? 255U << 15 : 255U << 16;
+  const uint16_t columns = MAX(area->width - 1, 1);
+  const uint16_t rows = MAX(area->height - 1, 1);
+  uint32_t stepX = 0;
+  uint32_t stepY = 0;
+  if (fill->direction != DISPLAY_BUFFER_FILL_VERTICAL) {
+    stepX = (length + columns - 1) / columns;
+  }
+  if (fill->direction != DISPLAY_BUFFER_FILL_HORIZONTAL) {
+    stepY = (length + rows - 1) / rows;
+  }
+
+  uint16_t index = display_buffer_point_to_index(db, x0, y0);
+  for (int16_t row = y0; row < y1; row++, index += db->width) {
+    if (fill->type != DISPLAY_BUFFER_FILL_GRADIENT) {
+      fill_pattern_span(db, index, x1 - x0, x0 - area->x, row - area->y, fill,
+                        shift);
+      continue;
+    }
+    fill_gradient_span(db, index, x1 - x0,
+                       (MAX(x0 - area->x, 0) * stepX) +
+                           (MAX(row - area->y, 0) * stepY),
+                       stepX, fill, shift);
+  }
+}
+
+// draws a rectangle at the cursor with the current fill or color. Does not
+// move the cursor.
+void display_buffer_draw_rect(display_buffer_handle_t db, uint8_t width,
+                              uint8_t height) {
+  const fill_area_t area = {
+      .x = db->cursor.x,
+      .y = db->cursor.y,
+      .width = width,
+      .height = height,
+  };
+  if (include_rect(db, area.x, area.y, width, height)) {
+    fill_block_styled(db, area.x, area.y, width, height, &area, 0);
+  }
+}
+
+// fills a rectangle with a single color, clipped to the buffer. Does not move
+// the cursor.
+void display_buffer_fill_rect(display_buffer_handle_t db, uint8_t x, uint8_t y,
+                              uint8_t width, uint8_t height, uint8_t red,
+                              uint8_t green, uint8_t blue) {
+  if (include_rect(db, x, y, width, height)) {
+    fill_block(db, x, y, width, height, red, green, blue);
+  }
+}
+
+// columns past the glyph's width are background
+static inline bool glyph_bit_is_set(const font_glyph_t *glyph, uint8_t rowBits,
+                                    uint8_t column) {
+  return column < glyph->width &&
+         (rowBits & (1 << (glyph->width - 1 - column))) != 0;
+}
+
 // This will apply the provided string to the buffer, using the buffer's current
-// cursor and font. The string will be wrapped until it is out of the matrix.
+// cursor, font, and text scale. The string will be wrapped until it is out of
+// the matrix.
+//
+// Each row of a character is split into runs of set/unset pixels, and each run
+// is drawn as a block of `text_scale` rows. This means the cost of a character
+// depends on the number of runs, not the number of pixels, so scaled text is
+// about as cheap as unscaled text.
 void display_buffer_draw_string(display_buffer_handle_t db, char *string) {
-  const size_t stringLength = strlen(string);
-  // the index within the string we are working on
-  uint16_t stringIndex;
-  // the actual ascii character we are working on
-  char ascii_char;
-  // the starting point to draw bits at in the buffer
-  uint16_t bufferStartIdx;
-  // which bit of the font->width we are on working on
-  uint8_t bitmapRowIdx;
-  // the index of the character's bitmap chunk we are working on
-  uint8_t chunkIdx;
-  // the actual chunk value, pulled once to be used multiple
-  uint32_t chunkVal;
-  // the number of the bit we are working on, within the chunk. This is the
-  // _number_, not the zero-based index
-  uint8_t chunkBitN;
+  const uint8_t scale = db->text_scale;
+  // where in the string the next character starts
+  size_t stringIndex = 0;
+  // how many bytes the current UTF-8 character used
+  uint8_t charLength;
+  // the character we are working on, and the one before it for kerning
+  uint32_t codepoint;
+  uint32_t lastCodepoint = 0;
+  // the rows of the current character, resolved once per character
+  font_glyph_t glyph;
+  // which row of the character we are working on
+  uint8_t glyphRow;
+  // the bits of the current row, leftmost pixel in the highest bit
+  uint8_t rowBits;
+  // where the current run of pixels starts, and how long it is
+  uint8_t runStart;
+  uint8_t runLength;
+  bool runIsSet;
+  // where the glyph's first column is drawn
+  int16_t glyphX;
+  uint8_t cellWidth;
+  int16_t kerning;
+  // whether any of the character is inside the clip
+  bool glyphVisible;
+  // the block of buffer pixels for a run, before clipping
+  uint8_t blockX;
+  uint8_t blockY;
+  // a fill is stretched over each line, from where the string starts on it to
+  // the right edge
+  fill_area_t fillArea = {
+      .x = db->cursor.x,
+      .y = db->cursor.y,
+      .width = db->width - db->cursor.x,
+      .height = db->font->height * scale,
+  };
 
   // loop all the characters in the string
-  for (stringIndex = 0; stringIndex < stringLength; stringIndex++) {
-    ascii_char = string[stringIndex];
-    bitmapRowIdx = 0;
-    // convert the buffers cursor to an index, where we start this char
-    bufferStartIdx = display_buffer_cursor_to_index(db);
+  while ((charLength = font_utf8_decode(string + stringIndex, &codepoint)) >
+         0) {
+    stringIndex += charLength;
 
     // If we have moved past the buffer's space, we can go ahead and end
     if (!display_buffer_cursor_is_visible(db)) {
       return;
     }
 
-    // if not a character that we support, change to `?`
-    if (!font_is_valid_ascii(ascii_char)) {
-      ESP_LOGW(TAG, "Unsupported ASCII character \"%d\"", ascii_char);
-      ascii_char = 63;
+    // characters without a glyph are drawn as `FONT_REPLACEMENT_CHAR`
+    font_get_glyph(db->font, codepoint, &glyph);
+
+    // wrapped lines start at the left edge
+    if (db->cursor.y != fillArea.y) {
+      fillArea.x = 0;
+      fillArea.y = db->cursor.y;
+      fillArea.width = db->width;
     }
 
-    for (chunkIdx = 0; chunkIdx < db->font->chunks_per_char; chunkIdx++) {
-      chunkVal = font_get_chunk(db->font, ascii_char, chunkIdx);
+    // pull the pair together (or apart), unless we just wrapped
+    if (db->cursor.x > 0) {
+      kerning = font_get_kerning(db->font, lastCodepoint, codepoint) * scale;
+      db->cursor.x = kerning < 0 && -kerning > db->cursor.x
+                         ? 0
+                         : db->cursor.x + kerning;
+    }
+    lastCodepoint = codepoint;
 
-      for (chunkBitN = 1; chunkBitN <= db->font->bits_per_chunk; chunkBitN++) {
-        // mask the chunk bit, then AND it to the chunk value. Use the result as
-        // a boolean to check if we should set the value to the color or blank
-        if (chunkVal & _BV_1ULL(db->font->bits_per_chunk - chunkBitN)) {
-          display_buffer_safe_set_value(db, bufferStartIdx + bitmapRowIdx,
-                                        db->color_red, db->color_green,
-                                        db->color_blue);
-        } else {
-          display_buffer_safe_set_value(db, bufferStartIdx + bitmapRowIdx, 0, 0,
-                                        0);
+    // a negative offset is clipped at the left edge
+    glyphX = db->cursor.x + (glyph.offset_x * scale);
+    if (glyphX < 0) {
+      glyphX = 0;
+    }
+    // the background is drawn up to the next character, minus any spacing
+    cellWidth = MAX(glyph.width, glyph.advance - db->font->spacing);
+    glyphVisible = include_rect(db, glyphX, db->cursor.y, cellWidth * scale,
+                                db->font->height * scale);
+
+    for (glyphRow = 0; glyphVisible && glyphRow < db->font->height;
+         glyphRow++) {
+      blockY = db->cursor.y + (glyphRow * scale);
+      if (blockY >= db->height) {
+        break;
+      }
+      rowBits = glyph.rows[glyphRow];
+
+      runStart = 0;
+      while (runStart < cellWidth) {
+        runIsSet = glyph_bit_is_set(&glyph, rowBits, runStart);
+        runLength = 1;
+        while (runStart + runLength < cellWidth &&
+               glyph_bit_is_set(&glyph, rowBits, runStart + runLength) ==
+                   runIsSet) {
+          runLength++;
         }
 
-        // increase the rows index. Move down a line if at the end
-        bitmapRowIdx++;
-        if (bitmapRowIdx == db->font->width) {
-          bitmapRowIdx = 0;
-          bufferStartIdx += db->width;
+        blockX = glyphX + (runStart * scale);
+        if (blockX >= db->width) {
+          break;
+        }
+        if (runIsSet) {
+          fill_block_styled(db, blockX, blockY, runLength * scale, scale,
+                            &fillArea, 0);
+        } else {
+          fill_block(db, blockX, blockY, runLength * scale, scale, 0, 0, 0);
         }
+
+        runStart += runLength;
       }
     }
 
     // we're done with this character, move to the next position.
-    display_buffer_next_char_wrap(db);
+    display_buffer_advance_wrap(db, glyph.advance);
   }
 }
 
 void display_buffer_draw_vert_line(display_buffer_handle_t db, uint8_t to) {
+  if (!include_rect(db, db->cursor.x, MIN(db->cursor.y, to), 1,
+                    MAX(db->cursor.y, to) - MIN(db->cursor.y, to) + 1)) {
+    display_buffer_set_cursor(db, db->cursor.x, to);
+    return;
+  }
+
   // faster to write it twice ¯\_(ツ)_/¯
   if (db->cursor.y > to) {
     while (db->cursor.y > to) {
-      if (display_buffer_point_is_visible(db, db->cursor.x, db->cursor.y)) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x, db->cursor.y)) {
         display_buffer_safe_set_value(
             db, display_buffer_point_to_index(db, db->cursor.x, db->cursor.y),
             db->color_red, db->color_green, db->color_blue);
@@ -153,7 +667,7 @@ void display_buffer_draw_vert_line(display_buffer_handle_t db, uint8_t to) {
     }
   } else {
     while (db->cursor.y < to) {
-      if (display_buffer_point_is_visible(db, db->cursor.x, db->cursor.y)) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x, db->cursor.y)) {
         display_buffer_safe_set_value(
             db, display_buffer_point_to_index(db, db->cursor.x, db->cursor.y),
             db->color_red, db->color_green, db->color_blue);
@@ -163,7 +677,7 @@ void display_buffer_draw_vert_line(display_buffer_handle_t db, uint8_t to) {
     }
   }
 
-  if (display_buffer_point_is_visible(db, db->cursor.x, db->cursor.y)) {
+  if (display_buffer_rect_contains(&db->clip, db->cursor.x, db->cursor.y)) {
     display_buffer_safe_set_value(
         db, display_buffer_point_to_index(db, db->cursor.x, db->cursor.y),
         db->color_red, db->color_green, db->color_blue);
@@ -173,10 +687,16 @@ void display_buffer_draw_vert_line(display_buffer_handle_t db, uint8_t to) {
 }
 
 void display_buffer_draw_horiz_line(display_buffer_handle_t db, uint8_t to) {
+  if (!include_rect(db, MIN(db->cursor.x, to), db->cursor.y,
+                    MAX(db->cursor.x, to) - MIN(db->cursor.x, to) + 1, 1)) {
+    display_buffer_set_cursor(db, to, db->cursor.y);
+    return;
+  }
+
   // faster to write it twice ¯\_(ツ)_/¯
   if (db->cursor.x > to) {
     while (db->cursor.x >= to) {
-      if (display_buffer_point_is_visible(db, db->cursor.x, db->cursor.y)) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x, db->cursor.y)) {
         display_buffer_safe_set_value(
             db, display_buffer_point_to_index(db, db->cursor.x, db->cursor.y),
             db->color_red, db->color_green, db->color_blue);
@@ -186,7 +706,7 @@ void display_buffer_draw_horiz_line(display_buffer_handle_t db, uint8_t to) {
     }
   } else {
     while (db->cursor.x <= to) {
-      if (display_buffer_point_is_visible(db, db->cursor.x, db->cursor.y)) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x, db->cursor.y)) {
         display_buffer_safe_set_value(
             db, display_buffer_point_to_index(db, db->cursor.x, db->cursor.y),
             db->color_red, db->color_green, db->color_blue);
@@ -205,11 +725,18 @@ void display_buffer_draw_diag_line(display_buffer_handle_t db, uint8_t to_x,
       ((float)db->cursor.y - (float)to_y) / ((float)db->cursor.x - (float)to_x);
   float unroundedY = (float)db->cursor.y;
 
+  if (!include_rect(db, MIN(db->cursor.x, to_x), MIN(db->cursor.y, to_y),
+                    MAX(db->cursor.x, to_x) - MIN(db->cursor.x, to_x) + 1,
+                    MAX(db->cursor.y, to_y) - MIN(db->cursor.y, to_y) + 1)) {
+    display_buffer_set_cursor(db, to_x, to_y);
+    return;
+  }
+
   // faster to write it twice ¯\_(ツ)_/¯
   if (db->cursor.x <= to_x) {
     while (db->cursor.x <= to_x) {
-      if (display_buffer_point_is_visible(db, db->cursor.x,
-                                          (uint8_t)round(unroundedY))) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x,
+                                       (uint8_t)round(unroundedY))) {
         display_buffer_safe_set_value(
             db,
             display_buffer_point_to_index(db, db->cursor.x,
@@ -222,8 +749,8 @@ void display_buffer_draw_diag_line(display_buffer_handle_t db, uint8_t to_x,
     }
   } else {
     while (db->cursor.x >= to_x) {
-      if (display_buffer_point_is_visible(db, db->cursor.x,
-                                          (uint8_t)round(unroundedY))) {
+      if (display_buffer_rect_contains(&db->clip, db->cursor.x,
+                                       (uint8_t)round(unroundedY))) {
         display_buffer_safe_set_value(
             db,
             display_buffer_point_to_index(db, db->cursor.x,
@@ -256,53 +783,446 @@ void display_buffer_draw_bitmap(display_buffer_handle_t db, uint8_t width,
                                 uint8_t height, uint8_t *buffer_red,
                                 uint8_t *buffer_green, uint8_t *buffer_blue,
                                 bool draw_black) {
+  // pixels past the right edge wrap onto the next row, so then the bounds cover
+  // the full rows they could land in
+  const bool wraps = db->cursor.x + width > db->width;
+  if (!(wraps ? include_rect(db, 0, db->cursor.y, db->width,
+                             height + ((db->cursor.x + width - 1) / db->width))
+              : include_rect(db, db->cursor.x, db->cursor.y, width, height))) {
+    return;
+  }
+
+  // where the current pixel lands, after wrapping
+  uint16_t x;
+  uint16_t y;
+
   for (uint8_t row = 0; row < height; row++) {
-    for (uint8_t col = 0; col < width; col++) {
+    x = db->cursor.x;
+    y = db->cursor.y + row;
+    for (uint8_t col = 0; col < width; col++, x++) {
+      while (x >= db->width) {
+        x -= db->width;
+        y++;
+      }
+
       if (draw_black == false && buffer_red[(row * width) + col] == 0 &&
           buffer_green[(row * width) + col] == 0 &&
           buffer_blue[(row * width) + col] == 0) {
         continue;
       }
+      if (!display_buffer_rect_contains(&db->clip, x, y)) {
+        continue;
+      }
 
       display_buffer_safe_set_value(
-          db,
-          display_buffer_point_to_index(db, db->cursor.x + col,
-                                        db->cursor.y + row),
+          db, display_buffer_point_to_index(db, x, y),
           buffer_red[(row * width) + col], buffer_green[(row * width) + col],
           buffer_blue[(row * width) + col]);
     }
   }
 }
 
-void display_buffer_draw_graph(display_buffer_handle_t db, uint8_t width,
-                               uint8_t height, uint8_t *values,
-                               uint8_t bg_color_red, uint8_t bg_color_green,
-                               uint8_t bg_color_blue) {
-  uint8_t cursorStartX = db->cursor.x;
-  uint8_t cursorStartY = db->cursor.y;
+// Draws a bitmap of packed palette indexes, expanding each index through the
+// palette's color table. Pixels are packed MSB-first and each row starts on a
+// new byte. See `palette_row_stride`. Unlike `display_buffer_draw_bitmap`, the
+// bitmap is clipped to the buffer instead of wrapping onto the next row.
+void display_buffer_draw_indexed_bitmap(display_buffer_handle_t db,
+                                        uint8_t width, uint8_t height,
+                                        uint8_t bpp, uint8_t *data,
+                                        palette_handle_t palette,
+                                        bool draw_black) {
+  if (palette == NULL || !palette_is_valid_bpp(bpp) ||
+      !display_buffer_cursor_is_visible(db)) {
+    return;
+  }
+
+  const uint16_t stride = palette_row_stride(width, bpp);
+  const uint8_t mask = (uint8_t)((1 << bpp) - 1);
+  const uint8_t visibleWidth = MIN(width, db->width - db->cursor.x);
+  const uint8_t visibleHeight = MIN(height, db->height - db->cursor.y);
+  if (!include_rect(db, db->cursor.x, db->cursor.y, visibleWidth,
+                    visibleHeight)) {
+    return;
+  }
+
+  // the packed byte we are pulling indexes out of
+  uint8_t packed;
+  // how many bits of `packed` have not been used yet
+  uint8_t packedBitsLeft;
+  uint8_t paletteIdx;
+  uint16_t bufferIdx;
+  uint8_t *rowData;
+  uint8_t x;
+
+  for (uint8_t row = 0; row < visibleHeight; row++) {
+    if (db->cursor.y + row < db->clip.y0 || db->cursor.y + row >= db->clip.y1) {
+      continue;
+    }
+    rowData = data + (row * stride);
+    bufferIdx = display_buffer_point_to_index(db, db->cursor.x,
+                                              db->cursor.y + row);
+    packed = 0;
+    packedBitsLeft = 0;
+
+    for (uint8_t col = 0; col < visibleWidth; col++, bufferIdx++) {
+      if (packedBitsLeft == 0) {
+        packed = *rowData++;
+        packedBitsLeft = 8;
+      }
+      packedBitsLeft -= bpp;
+      x = db->cursor.x + col;
+      if (x < db->clip.x0 || x >= db->clip.x1) {
+        continue;
+      }
+      paletteIdx = (packed >> packedBitsLeft) & mask;
+
+      // out of range indexes are treated as black
+      if (paletteIdx >= palette->length ||
+          (palette->red[paletteIdx] == 0 && palette->green[paletteIdx] == 0 &&
+           palette->blue[paletteIdx] == 0)) {
+        if (draw_black) {
+          db->buffer_red[bufferIdx] = 0;
+          db->buffer_green[bufferIdx] = 0;
+          db->buffer_blue[bufferIdx] = 0;
+        }
+        continue;
+      }
+
+      db->buffer_red[bufferIdx] = palette->red[paletteIdx];
+      db->buffer_green[bufferIdx] = palette->green[paletteIdx];
+      db->buffer_blue[bufferIdx] = palette->blue[paletteIdx];
+    }
+  }
+}
+
+// pulls a single pixel out of a bitmap source. Returns `false` if the pixel is
+// black, so the caller can skip it.
+static inline bool bitmap_sample(display_buffer_bitmap_t *bitmap, uint8_t x,
+                                 uint8_t y, uint8_t *red, uint8_t *green,
+                                 uint8_t *blue) {
+  if (bitmap->bpp == 0) {
+    const uint16_t idx = (y * bitmap->width) + x;
+    *red = bitmap->data_red[idx];
+    *green = bitmap->data_green[idx];
+    *blue = bitmap->data_blue[idx];
+  } else {
+    const uint16_t bitOffset = x * bitmap->bpp;
+    const uint8_t packed =
+        bitmap->data[(y * palette_row_stride(bitmap->width, bitmap->bpp)) +
+                     (bitOffset >> 3)];
+    const uint8_t paletteIdx =
+        (packed >> (8 - bitmap->bpp - (bitOffset & 7))) &
+        ((1 << bitmap->bpp) - 1);
+    if (paletteIdx >= bitmap->palette->length) {
+      *red = 0;
+      *green = 0;
+      *blue = 0;
+    } else {
+      *red = bitmap->palette->red[paletteIdx];
+      *green = bitmap->palette->green[paletteIdx];
+      *blue = bitmap->palette->blue[paletteIdx];
+    }
+  }
+
+  return *red != 0 || *green != 0 || *blue != 0;
+}
+
+// Draws a bitmap with nearest-neighbour scaling and a 90° rotation step. The
+// only divisions are done once per call to get the source step for each
+// destination pixel. After that each pixel walks the source in 16.16
+// fixed-point, so rotation is just a change in which axis is stepped.
+void display_buffer_draw_bitmap_transformed(
+    display_buffer_handle_t db, display_buffer_bitmap_t *bitmap,
+    display_buffer_transform_t *transform, bool draw_black) {
+  if (display_buffer_transform_is_identity(transform)) {
+    if (bitmap->bpp == 0) {
+      display_buffer_draw_bitmap(db, bitmap->width, bitmap->height,
+                                 bitmap->data_red, bitmap->data_green,
+                                 bitmap->data_blue, draw_black);
+    } else {
+      display_buffer_draw_indexed_bitmap(db, bitmap->width, bitmap->height,
+                                         bitmap->bpp, bitmap->data,
+                                         bitmap->palette, draw_black);
+    }
+    return;
+  }
+
+  if (bitmap->width == 0 || bitmap->height == 0 ||
+      (bitmap->bpp != 0 &&
+       (bitmap->palette == NULL || !palette_is_valid_bpp(bitmap->bpp))) ||
+      !display_buffer_cursor_is_visible(db)) {
+    return;
+  }
+
+  const bool isQuarterTurn =
+      transform->rotation == DISPLAY_BUFFER_ROTATION_90 ||
+      transform->rotation == DISPLAY_BUFFER_ROTATION_270;
+  // the size of the bitmap after rotation, before scaling
+  const int32_t rotatedWidth = isQuarterTurn ? bitmap->height : bitmap->width;
+  const int32_t rotatedHeight = isQuarterTurn ? bitmap->width : bitmap->height;
+  // the size of the bitmap on the buffer. Always at least one pixel.
+  const int32_t destWidth =
+      MAX((rotatedWidth * transform->scale_x) / DISPLAY_BUFFER_SCALE_ONE, 1);
+  const int32_t destHeight =
+      MAX((rotatedHeight * transform->scale_y) / DISPLAY_BUFFER_SCALE_ONE, 1);
+  // how far to move in the rotated bitmap for each destination pixel
+  const int32_t stepU = (rotatedWidth << 16) / destWidth;
+  const int32_t stepV = (rotatedHeight << 16) / destHeight;
+  // source extents, minus one fixed-point unit, for the mirrored axes
+  const int32_t sourceMaxX = ((int32_t)bitmap->width << 16) - 1;
+  const int32_t sourceMaxY = ((int32_t)bitmap->height << 16) - 1;
+
+  const uint8_t visibleWidth = MIN(destWidth, db->width - db->cursor.x);
+  const uint8_t visibleHeight = MIN(destHeight, db->height - db->cursor.y);
+  if (!include_rect(db, db->cursor.x, db->cursor.y, visibleWidth,
+                    visibleHeight)) {
+    return;
+  }
+  // only the columns inside the clip are sampled
+  const uint8_t firstCol = MAX(db->cursor.x, db->clip.x0) - db->cursor.x;
+  const uint8_t lastCol = MIN(db->cursor.x + visibleWidth, db->clip.x1) -
+                          db->cursor.x;
+
+  // per-pixel step through the source for each step along the destination x
+  int32_t stepX = 0;
+  int32_t stepY = 0;
+  switch (transform->rotation) {
+  case DISPLAY_BUFFER_ROTATION_90:
+    stepY = -stepU;
+    break;
+  case DISPLAY_BUFFER_ROTATION_180:
+    stepX = -stepU;
+    break;
+  case DISPLAY_BUFFER_ROTATION_270:
+    stepY = stepU;
+    break;
+  case DISPLAY_BUFFER_ROTATION_0:
+  default:
+    stepX = stepU;
+    break;
+  }
+
+  // sample from the center of each destination pixel
+  const int32_t startU = stepU >> 1;
+  int32_t v = stepV >> 1;
+  int32_t sourceX;
+  int32_t sourceY;
+  uint16_t bufferIdx;
+  uint8_t red, green, blue;
+
+  for (uint8_t row = 0; row < visibleHeight; row++, v += stepV) {
+    if (db->cursor.y + row < db->clip.y0 || db->cursor.y + row >= db->clip.y1) {
+      continue;
+    }
+    switch (transform->rotation) {
+    case DISPLAY_BUFFER_ROTATION_90:
+      sourceX = v;
+      sourceY = sourceMaxY - startU;
+      break;
+    case DISPLAY_BUFFER_ROTATION_180:
+      sourceX = sourceMaxX - startU;
+      sourceY = sourceMaxY - v;
+      break;
+    case DISPLAY_BUFFER_ROTATION_270:
+      sourceX = sourceMaxX - v;
+      sourceY = startU;
+      break;
+    case DISPLAY_BUFFER_ROTATION_0:
+    default:
+      sourceX = startU;
+      sourceY = v;
+      break;
+    }
+
+    sourceX += stepX * firstCol;
+    sourceY += stepY * firstCol;
+    bufferIdx = display_buffer_point_to_index(db, db->cursor.x + firstCol,
+                                              db->cursor.y + row);
+    for (uint8_t col = firstCol; col < lastCol;
+         col++, bufferIdx++, sourceX += stepX, sourceY += stepY) {
+      if (bitmap_sample(bitmap, sourceX >> 16, sourceY >> 16, &red, &green,
+                        &blue) ||
+          draw_black) {
+        db->buffer_red[bufferIdx] = red;
+        db->buffer_green[bufferIdx] = green;
+        db->buffer_blue[bufferIdx] = blue;
+      }
+    }
+  }
+}
+
+// where the columns of a graph come from. Either `values`, which are already
+// scaled to the graph's height, or a series that is scaled here.
+typedef struct {
+  uint8_t *values;
+  series_handle_t series;
+  int16_t scale_min;
+  int32_t scale_range;
+} graph_source_t;
+
+// maps a sample to how many pixels up the graph it is, from `1` to `height`
+static inline uint8_t graph_sample_level(graph_source_t *source,
+                                         uint8_t height, int16_t sample) {
+  // a flat series sits in the middle
+  if (source->scale_range == 0) {
+    return (height + 1) / 2;
+  }
+
+  int32_t offset = MAX((int32_t)sample - source->scale_min, 0);
+  offset = MIN(offset, source->scale_range);
+  return ((offset * (height - 1)) + (source->scale_range / 2)) /
+             source->scale_range +
+         1;
+}
+
+// Finds the lowest and highest level in a column, or `0` if the column is
+// empty. When a series has more samples than the graph has columns, each
+// column covers several samples and shows the full range between them, so
+// peaks are never dropped.
+static inline void graph_column_levels(graph_source_t *source,
+                                       display_buffer_graph_t *graph,
+                                       uint8_t column, uint16_t columns,
+                                       uint8_t *low, uint8_t *high) {
+  if (source->series == NULL) {
+    *low = MIN(source->values[column], graph->height);
+    *high = *low;
+    return;
+  }
 
-  uint8_t prevColorRed = db->color_red;
-  uint8_t prevColorGreen = db->color_green;
-  uint8_t prevColorBlue = db->color_blue;
+  const uint16_t length = source->series->length;
+  int16_t min, max;
+  series_get_range(source->series, (column * length) / columns,
+                   ((column + 1) * length) / columns, &min, &max);
+  *low = graph_sample_level(source, graph->height, min);
+  *high = graph_sample_level(source, graph->height, max);
+}
 
-  // first draw the background
-  display_buffer_set_color(db, bg_color_red, bg_color_green, bg_color_blue);
-  for (uint8_t y = 0; y < height; y++) {
-    display_buffer_set_cursor(db, cursorStartX, cursorStartY + y);
-    display_buffer_draw_horiz_line(db, cursorStartX + width - 1);
+// Draws the background and then each column as a single vertical span, or two
+// for area graphs. Graphs with fewer columns than their width are aligned to
+// the right, so the newest sample is always at the right edge.
+static void draw_graph_columns(display_buffer_handle_t db,
+                               display_buffer_graph_t *graph,
+                               graph_source_t *source, uint16_t columns) {
+  const uint8_t x = db->cursor.x;
+  const uint8_t y = db->cursor.y;
+  const uint16_t bottom = y + graph->height;
+  const uint8_t firstColumn = graph->width - columns;
+  uint8_t low, high;
+  uint8_t lastLow = 0;
+  uint8_t lastHigh = 0;
+  uint8_t spanLow, spanHigh;
+  const fill_area_t area = {
+      .x = x,
+      .y = y,
+      .width = graph->width,
+      .height = graph->height,
+  };
+
+  if (!include_rect(db, x, y, graph->width, graph->height)) {
+    return;
   }
 
-  // reset the color
-  display_buffer_set_color(db, prevColorRed, prevColorGreen, prevColorBlue);
+  fill_block(db, x, y, graph->width, graph->height, graph->bg_color_red,
+             graph->bg_color_green, graph->bg_color_blue);
 
-  // now draw the values
-  for (uint8_t x = 0; x < width; x++) {
-    uint8_t value = MAX(MIN(values[x], height), 0);
-    if (value == 0) {
+  for (uint16_t column = 0; column < columns; column++) {
+    graph_column_levels(source, graph, column, columns, &low, &high);
+    // levels of `0` are left empty
+    if (high == 0) {
+      lastHigh = 0;
       continue;
     }
-    display_buffer_set_cursor(db, cursorStartX + x, cursorStartY + height - 1);
-    display_buffer_draw_vert_line(db, cursorStartY + height - value);
+
+    if (graph->style == DISPLAY_BUFFER_GRAPH_BAR) {
+      fill_block_styled(db, x + firstColumn + column, bottom - high, 1, high,
+                        &area, 0);
+      continue;
+    }
+
+    // stretch the span to meet the last column, so the line has no gaps
+    spanLow = low;
+    spanHigh = high;
+    if (lastHigh != 0 && lastHigh < low) {
+      spanLow = lastHigh + 1;
+    } else if (lastHigh != 0 && lastLow > high) {
+      spanHigh = lastLow - 1;
+    }
+    lastLow = low;
+    lastHigh = high;
+
+    if (graph->style == DISPLAY_BUFFER_GRAPH_AREA && spanLow > 1) {
+      fill_block_styled(db, x + firstColumn + column, bottom - (spanLow - 1),
+                        1, spanLow - 1, &area, 2);
+    }
+    fill_block_styled(db, x + firstColumn + column, bottom - spanHigh, 1,
+                      spanHigh - spanLow + 1, &area, 0);
+  }
+}
+
+// Draws a graph of `values` at the cursor. Each value is already scaled to the
+// height of the graph, and a value of `0` draws nothing. Does not move the
+// cursor.
+void display_buffer_draw_graph(display_buffer_handle_t db,
+                               display_buffer_graph_t *graph, uint8_t *values,
+                               uint16_t value_count) {
+  graph_source_t source = {
+      .values = values,
+      .series = NULL,
+  };
+  draw_graph_columns(db, graph, &source, MIN(value_count, graph->width));
+}
+
+// Draws a graph of a series at the cursor, with one column per sample. When
+// there are more samples than columns, they are decimated into a min/max span
+// per column. Does not move the cursor.
+void display_buffer_draw_series(display_buffer_handle_t db,
+                                display_buffer_graph_t *graph,
+                                series_handle_t series) {
+  int16_t min = graph->scale_min;
+  int16_t max = graph->scale_max;
+  if (graph->autoscale) {
+    series_get_range(series, 0, series->length, &min, &max);
+  }
+
+  graph_source_t source = {
+      .values = NULL,
+      .series = series,
+      .scale_min = min,
+      .scale_range = MAX((int32_t)max - min, 0),
+  };
+  draw_graph_columns(db, graph, &source, MIN(series->length, graph->width));
+}
+
+// Draws a block at the cursor where each pixel is a level, looked up in a ramp
+// of 256 colors. The levels are asked for a row at a time, and only for the
+// part of each row inside the clip. Black levels are drawn too. Does not move
+// the cursor.
+void display_buffer_draw_levels(display_buffer_handle_t db, uint8_t width,
+                                uint8_t height, palette_handle_t ramp,
+                                display_buffer_levels_fn_t levels_fn,
+                                void *context) {
+  const uint8_t x = db->cursor.x;
+  const uint8_t y = db->cursor.y;
+  uint8_t levels[UINT8_MAX];
+  uint8_t level;
+
+  if (!include_rect(db, x, y, width, height)) {
+    return;
+  }
+
+  const uint8_t x0 = MAX(x, db->clip.x0);
+  const uint8_t x1 = MIN(x + width, db->clip.x1);
+  const uint8_t y0 = MAX(y, db->clip.y0);
+  const uint8_t y1 = MIN(y + height, db->clip.y1);
+  uint16_t index = display_buffer_point_to_index(db, x0, y0);
+  for (uint8_t row = y0; row < y1; row++, index += db->width) {
+    levels_fn(context, x0 - x, row - y, x1 - x0, levels);
+    for (uint8_t col = 0; col < x1 - x0; col++) {
+      level = levels[col];
+      db->buffer_red[index + col] = ramp->red[level];
+      db->buffer_green[index + col] = ramp->green[level];
+      db->buffer_blue[index + col] = ramp->blue[level];
+    }
   }
 }
 
@@ -311,7 +1231,9 @@ void display_buffer_add_feedback(display_buffer_handle_t db,
                                  bool invalid_commands,
                                  bool invalid_wifi_state) {
   if (invalid_remote_state) {
-    display_buffer_safe_set_value(db, 0, 255, 0, 0);
+    if (include_rect(db, 0, 0, 1, 1)) {
+      display_buffer_safe_set_value(db, 0, 255, 0, 0);
+    }
   }
 
   if (invalid_wifi_state || invalid_commands) {
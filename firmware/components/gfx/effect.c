@@ -0,0 +1,396 @@
+#include "esp_log.h"
+#include <memory.h>
+
+#include "helper_utils.h"
+
+#include "gfx/effect.h"
+
+static const char *TAG = "GFX:EFFECT";
+
+// one period of a sine wave, from `1` to `255` around `128`
+static const uint8_t SINE_TABLE[256] = {
+    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171,
+    174, 177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211,
+    213, 216, 218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240,
+    241, 243, 244, 245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254,
+    254, 255, 255, 255, 255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251,
+    250, 250, 249, 248, 246, 245, 244, 243, 241, 240, 239, 237, 235, 234, 232,
+    230, 228, 226, 224, 222, 220, 218, 216, 213, 211, 209, 206, 204, 201, 199,
+    196, 193, 191, 188, 185, 182, 179, 177, 174, 171, 168, 165, 162, 159, 156,
+    153, 150, 147, 144, 140, 137, 134, 131, 128, 125, 122, 119, 116, 112, 109,
+    106, 103, 100, 97, 94, 91, 88, 85, 82, 79, 77, 74, 71, 68, 65, 63, 60, 57,
+    55, 52, 50, 47, 45, 43, 40, 38, 36, 34, 32, 30, 28, 26, 24, 22, 21, 19, 17,
+    16, 15, 13, 12, 11, 10, 8, 7, 6, 6, 5, 4, 3, 3, 2, 2, 2, 1, 1, 1, 1, 1, 1,
+    1, 2, 2, 2, 3, 3, 4, 5, 6, 6, 7, 8, 10, 11, 12, 13, 15, 16, 17, 19, 21, 22,
+    24, 26, 28, 30, 32, 34, 36, 38, 40, 43, 45, 47, 50, 52, 55, 57, 60, 63, 65,
+    68, 71, 74, 77, 79, 82, 85, 88, 91, 94, 97, 100, 103, 106, 109, 112, 116,
+    119, 122, 125,
+};
+
+#define sine8(phase) (SINE_TABLE[(uint8_t)(phase)])
+
+// the colors each effect uses until it is given some
+static const display_buffer_fill_stop_t PLASMA_STOPS[] = {
+    {.position = 0, .red = 0, .green = 0, .blue = 96},
+    {.position = 96, .red = 160, .green = 0, .blue = 192},
+    {.position = 176, .red = 255, .green = 96, .blue = 0},
+    {.position = 255, .red = 255, .green = 240, .blue = 96},
+};
+static const display_buffer_fill_stop_t FIRE_STOPS[] = {
+    {.position = 0, .red = 0, .green = 0, .blue = 0},
+    {.position = 96, .red = 160, .green = 0, .blue = 0},
+    {.position = 160, .red = 255, .green = 96, .blue = 0},
+    {.position = 224, .red = 255, .green = 208, .blue = 0},
+    {.position = 255, .red = 255, .green = 255, .blue = 192},
+};
+static const display_buffer_fill_stop_t STARFIELD_STOPS[] = {
+    {.position = 0, .red = 0, .green = 0, .blue = 0},
+    {.position = 255, .red = 255, .green = 255, .blue = 255},
+};
+static const display_buffer_fill_stop_t NOISE_STOPS[] = {
+    {.position = 0, .red = 0, .green = 0, .blue = 32},
+    {.position = 128, .red = 0, .green = 96, .blue = 160},
+    {.position = 255, .red = 160, .green = 255, .blue = 255},
+};
+
+// an xorshift generator, which is plenty for flickering pixels
+static inline uint32_t next_random(effect_handle_t effect) {
+  uint32_t random = effect->random;
+  random ^= random << 13;
+  random ^= random >> 17;
+  random ^= random << 5;
+  effect->random = random;
+  return random;
+}
+
+// eases `0`-`255` in and out, so noise has no creases at the lattice lines
+static inline uint8_t fade8(uint8_t t) {
+  return ((uint32_t)t * t * (768 - (2 * t))) >> 16;
+}
+
+static inline uint8_t lerp8(uint8_t from, uint8_t to, uint8_t t) {
+  return from + ((((int16_t)to - from) * t) >> 8);
+}
+
+// stretches an average of several waves back out, since averaging pulls them
+// towards the middle
+static inline uint8_t stretch8(uint8_t level) {
+  const int16_t stretched = ((((int16_t)level - 128) * 3) / 2) + 128;
+  return MIN(MAX(stretched, 0), 255);
+}
+
+// the random level at a lattice point. Cells wrap every 65536, the same as the
+// 16.16 coordinates they come from.
+static inline uint8_t noise_hash(uint32_t seed, uint32_t x, uint32_t y) {
+  uint32_t hash =
+      ((x & 0xFFFF) * 0x9E3779B1U) ^ ((y & 0xFFFF) * 0x85EBCA77U) ^ seed;
+  hash ^= hash >> 15;
+  hash *= 0x2C1B3C6DU;
+  hash ^= hash >> 12;
+  return hash >> 24;
+}
+
+// Adds one octave of value noise to a row of `sums`, times `weight`. `u` and
+// `v` are where the first pixel is, in 16.16 lattice cells, and `step` is how
+// far each pixel moves along the row. It is never more than a whole cell, so
+// the corners only have to be hashed again when a pixel moves into the next
+// cell.
+static void add_noise_row(uint16_t *sums, uint8_t length, uint32_t u,
+                          uint32_t v, uint32_t step, uint32_t seed,
+                          uint8_t weight) {
+  const uint32_t cellY = v >> 16;
+  const uint8_t fadeY = fade8(v >> 8);
+  uint32_t cellX = u >> 16;
+  uint8_t left = lerp8(noise_hash(seed, cellX, cellY),
+                       noise_hash(seed, cellX, cellY + 1), fadeY);
+  uint8_t right = lerp8(noise_hash(seed, cellX + 1, cellY),
+                        noise_hash(seed, cellX + 1, cellY + 1), fadeY);
+
+  for (uint8_t i = 0; i < length; i++, u += step) {
+    if ((u >> 16) != cellX) {
+      cellX = u >> 16;
+      left = right;
+      right = lerp8(noise_hash(seed, cellX + 1, cellY),
+                    noise_hash(seed, cellX + 1, cellY + 1), fadeY);
+    }
+    sums[i] += lerp8(left, right, fade8(u >> 8)) * weight;
+  }
+}
+
+// two octaves of noise, the finer one drifting the other way
+static void noise_levels(void *context, uint8_t x, uint8_t y, uint8_t length,
+                         uint8_t *levels) {
+  effect_handle_t effect = (effect_handle_t)context;
+  const uint32_t step = 65536U / effect->scale;
+  const uint32_t fineStep = MIN(step * 2, 65536U);
+  const uint32_t drift = effect->time << 4;
+  uint16_t sums[UINT8_MAX];
+
+  memset(sums, 0, length * sizeof(uint16_t));
+  add_noise_row(sums, length, (x * step) + drift, (y * step) + (drift >> 1),
+                step, effect->seed, 3);
+  add_noise_row(sums, length, (x * fineStep) - drift, (y * fineStep) + drift,
+                fineStep, effect->seed ^ 0xA5A5A5A5U, 1);
+  for (uint8_t i = 0; i < length; i++) {
+    levels[i] = stretch8(sums[i] >> 2);
+  }
+}
+
+// Four sine waves: across, down, diagonally, and one across that is pushed
+// sideways by another going down. Phases are in 8.8, so one table entry is
+// `256`, and everything that only depends on the row is looked up once.
+static void plasma_levels(void *context, uint8_t x, uint8_t y, uint8_t length,
+                          uint8_t *levels) {
+  effect_handle_t effect = (effect_handle_t)context;
+  const uint32_t step = 65536U / effect->scale;
+  const uint32_t time = effect->time;
+  const uint32_t rowPhase = y * step;
+  const uint8_t down = sine8((rowPhase + (time >> 1)) >> 8);
+  const uint8_t warp = sine8((rowPhase - time) >> 8);
+  uint32_t phase = x * step;
+
+  for (uint8_t i = 0; i < length; i++, phase += step) {
+    levels[i] = stretch8((sine8((phase + time) >> 8) + down +
+                          sine8((((phase + rowPhase) >> 1) - time) >> 8) +
+                          sine8((phase >> 8) + warp + (time >> 9))) >>
+                         2);
+  }
+}
+
+// for the effects that keep their levels between steps
+static void stored_levels(void *context, uint8_t x, uint8_t y, uint8_t length,
+                          uint8_t *levels) {
+  effect_handle_t effect = (effect_handle_t)context;
+  memcpy(levels, effect->levels + (y * effect->width) + x, length);
+}
+
+// Heat rises one row at a time, drifting a pixel to either side and cooling by
+// a random amount as it goes. The bottom row is kept hot.
+static void step_fire(effect_handle_t effect) {
+  const uint8_t width = effect->width;
+  const uint8_t rise = MIN(MAX(effect->speed, 1), EFFECT_FIRE_RISE_MAX);
+  uint8_t *bottom = effect->levels + ((effect->height - 1) * width);
+  uint8_t *row, *below;
+  int16_t from;
+  uint8_t cooling;
+  uint32_t random;
+
+  for (uint8_t r = 0; r < rise; r++) {
+    for (uint8_t x = 0; x < width; x++) {
+      bottom[x] = 255 - (next_random(effect) & 63);
+    }
+    for (uint8_t y = 0; y + 1 < effect->height; y++) {
+      row = effect->levels + (y * width);
+      below = row + width;
+      for (uint8_t x = 0; x < width; x++) {
+        random = next_random(effect);
+        from = MIN(MAX(x + (int16_t)(random & 3) - 1, 0), width - 1);
+        cooling = (((random >> 8) & 0xFF) * effect->scale) >> 10;
+        row[x] = below[from] > cooling ? below[from] - cooling : 0;
+      }
+    }
+  }
+}
+
+// puts a star back at a random heading. New stars start far away, unless the
+// field is being filled for the first time.
+static void spawn_star(effect_handle_t effect, effect_star_t *star,
+                       bool is_far) {
+  uint32_t random;
+  do {
+    random = next_random(effect);
+    star->x = (int8_t)random;
+    star->y = (int8_t)(random >> 8);
+  } while (star->x == 0 && star->y == 0);
+  star->z = is_far ? 255 : 1 + ((random >> 16) % 255);
+}
+
+// moves each star closer, and plots it brighter the closer it is. Stars that
+// pass the viewer or leave the area start again.
+static void step_starfield(effect_handle_t effect) {
+  const uint8_t count = MIN(MAX(effect->scale, 1), EFFECT_STARS_MAX);
+  const uint8_t speed = MAX(effect->speed, 1);
+  effect_star_t *star;
+  int16_t x, y;
+  uint16_t index;
+
+  memset(effect->levels, 0, effect->width * effect->height);
+  for (uint8_t i = 0; i < count; i++) {
+    star = &effect->stars[i];
+    if (star->z <= speed) {
+      spawn_star(effect, star, true);
+    } else {
+      star->z -= speed;
+    }
+
+    x = (effect->width / 2) + ((star->x * effect->width) / (2 * star->z));
+    y = (effect->height / 2) + ((star->y * effect->height) / (2 * star->z));
+    if (x < 0 || y < 0 || x >= effect->width || y >= effect->height) {
+      spawn_star(effect, star, true);
+      continue;
+    }
+    index = (y * effect->width) + x;
+    effect->levels[index] = MAX(effect->levels[index], 255 - star->z);
+  }
+}
+
+// allocates all memory needed for an effect of `width` by `height`, with the
+// default speed, scale and colors for its type. `effect_reset` has to be
+// called before it is first stepped.
+esp_err_t effect_init(effect_handle_t *effect_handle, effect_type_t type,
+                      uint8_t width, uint8_t height) {
+  if (width == 0 || height == 0) {
+    ESP_LOGE(TAG, "Invalid effect size %ux%u", width, height);
+    *effect_handle = NULL;
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  effect_handle_t effect = (effect_handle_t)calloc(1, sizeof(effect_t));
+  if (effect == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for effect");
+    *effect_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  effect->type = type;
+  effect->width = width;
+  effect->height = height;
+  effect->speed = type == EFFECT_FIRE ? 1 : 4;
+  effect->scale = type == EFFECT_NOISE ? 16 : 32;
+  effect->seed = 1;
+
+  esp_err_t ret = palette_init(&effect->ramp, EFFECT_RAMP_LENGTH);
+  if (ret == ESP_OK && (type == EFFECT_FIRE || type == EFFECT_STARFIELD)) {
+    effect->levels = (uint8_t *)calloc(width * height, sizeof(uint8_t));
+    if (effect->levels == NULL) {
+      ret = ESP_ERR_NO_MEM;
+    }
+  }
+  if (ret == ESP_OK && type == EFFECT_STARFIELD) {
+    effect->stars =
+        (effect_star_t *)malloc(EFFECT_STARS_MAX * sizeof(effect_star_t));
+    if (effect->stars == NULL) {
+      ret = ESP_ERR_NO_MEM;
+    }
+  }
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to allocate memory for effect state");
+    effect_end(effect);
+    *effect_handle = NULL;
+    return ret;
+  }
+
+  switch (type) {
+  case EFFECT_PLASMA:
+    effect_set_ramp(effect, PLASMA_STOPS,
+                    sizeof(PLASMA_STOPS) / sizeof(PLASMA_STOPS[0]));
+    break;
+  case EFFECT_FIRE:
+    effect_set_ramp(effect, FIRE_STOPS,
+                    sizeof(FIRE_STOPS) / sizeof(FIRE_STOPS[0]));
+    break;
+  case EFFECT_STARFIELD:
+    effect_set_ramp(effect, STARFIELD_STOPS,
+                    sizeof(STARFIELD_STOPS) / sizeof(STARFIELD_STOPS[0]));
+    break;
+  case EFFECT_NOISE:
+    effect_set_ramp(effect, NOISE_STOPS,
+                    sizeof(NOISE_STOPS) / sizeof(NOISE_STOPS[0]));
+    break;
+  }
+
+  *effect_handle = effect;
+
+  return ESP_OK;
+}
+
+void effect_end(effect_handle_t effect) {
+  if (effect == NULL) {
+    return;
+  }
+
+  palette_end(effect->ramp);
+  free(effect->levels);
+  free(effect->stars);
+  free(effect);
+}
+
+// Fills the ramp from gradient stops, which must be in order. Levels before the
+// first stop or after the last are the color of that stop.
+void effect_set_ramp(effect_handle_t effect,
+                     const display_buffer_fill_stop_t *stops,
+                     uint8_t stop_count) {
+  const display_buffer_fill_stop_t *from, *to;
+  uint8_t stop = 0;
+  uint8_t along, span;
+
+  for (uint16_t level = 0; level < EFFECT_RAMP_LENGTH; level++) {
+    while (stop + 1 < stop_count && stops[stop + 1].position <= level) {
+      stop++;
+    }
+    from = &stops[stop];
+    to = stop + 1 < stop_count ? &stops[stop + 1] : from;
+    if (level <= from->position || to == from) {
+      effect->ramp->red[level] = from->red;
+      effect->ramp->green[level] = from->green;
+      effect->ramp->blue[level] = from->blue;
+      continue;
+    }
+
+    along = level - from->position;
+    span = to->position - from->position;
+    effect->ramp->red[level] =
+        from->red + ((((int16_t)to->red - from->red) * along) / span);
+    effect->ramp->green[level] =
+        from->green + ((((int16_t)to->green - from->green) * along) / span);
+    effect->ramp->blue[level] =
+        from->blue + ((((int16_t)to->blue - from->blue) * along) / span);
+  }
+}
+
+// starts the effect again from its seed, so the same seed always plays the
+// same way
+void effect_reset(effect_handle_t effect) {
+  // xorshift never leaves `0`, so it can't start there
+  effect->random = effect->seed != 0 ? effect->seed : 1;
+  effect->time = 0;
+  effect->step_us = 0;
+  if (effect->levels != NULL) {
+    memset(effect->levels, 0, effect->width * effect->height);
+  }
+  if (effect->type == EFFECT_STARFIELD) {
+    for (uint8_t i = 0; i < EFFECT_STARS_MAX; i++) {
+      spawn_star(effect, &effect->stars[i], false);
+    }
+  }
+}
+
+// moves the effect on by one step. This has to be done before it is drawn, and
+// not while it is being drawn, since drawing only reads from it.
+void effect_step(effect_handle_t effect) {
+  switch (effect->type) {
+  case EFFECT_PLASMA:
+  case EFFECT_NOISE:
+    effect->time += effect->speed << 6;
+    break;
+  case EFFECT_FIRE:
+    step_fire(effect);
+    break;
+  case EFFECT_STARFIELD:
+    step_starfield(effect);
+    break;
+  }
+}
+
+// draws the effect at the cursor, within the clip. Does not move the cursor.
+void effect_draw(effect_handle_t effect, display_buffer_handle_t db) {
+  display_buffer_levels_fn_t levelsFn = stored_levels;
+  if (effect->type == EFFECT_PLASMA) {
+    levelsFn = plasma_levels;
+  } else if (effect->type == EFFECT_NOISE) {
+    levelsFn = noise_levels;
+  }
+
+  display_buffer_draw_levels(db, effect->width, effect->height, effect->ramp,
+                             levelsFn, effect);
+}
@@ -1,10 +1,85 @@
 #include "esp_log.h"
 #include <memory.h>
 
+#include "helper_utils.h"
+
 #include "gfx/font.h"
 
 static const char *TAG = "GFX:FONT";
 
+// Codepoints above ASCII are looked up in a sparse map instead of each having
+// their own bitmap. Each `ext_map` entry is 16 bits:
+//   bits 15-14: what the value is, `EXT_KIND_*`
+//   bits 13-10: an accent mark composed onto the glyph, `MARK_*`
+//   bits  9-0:  an ASCII character, or an index into the `ext_*` glyph tables
+// So letters that look like ASCII (Cyrillic "А", Greek "Ο", accented Latin)
+// reuse the ASCII glyphs, and only truly new shapes are stored.
+#define EXT_KIND_NONE 0
+#define EXT_KIND_ASCII 1
+#define EXT_KIND_GLYPH 2
+
+#define ext_entry(kind, value, mark)                                           \
+  ((uint16_t)(((kind) << 14) | ((mark) << 10) | (value)))
+#define ext_entry_kind(entry) ((entry) >> 14)
+#define ext_entry_mark(entry) (((entry) >> 10) & 0x0F)
+#define ext_entry_value(entry) ((entry) & 0x03FF)
+
+#define EXT_NONE ext_entry(EXT_KIND_NONE, 0, MARK_NONE)
+#define EXT_ASCII(ascii, mark) ext_entry(EXT_KIND_ASCII, ascii, mark)
+#define EXT_GLYPH(index, mark) ext_entry(EXT_KIND_GLYPH, index, mark)
+
+#define MARK_NONE 0
+#define MARK_GRAVE 1
+#define MARK_ACUTE 2
+#define MARK_CIRCUMFLEX 3
+#define MARK_TILDE 4
+#define MARK_DIAERESIS 5
+#define MARK_RING 6
+#define MARK_CEDILLA 7
+#define MARK_BREVE 8
+#define FONT_MARK_COUNT 9
+
+// An accent drawn over (or under) a glyph. Rows use the same layout as glyph
+// rows.
+typedef struct {
+  uint8_t height;
+  bool below;
+  uint8_t rows[3];
+} font_mark_t;
+
+// A run of codepoints, and where its entries start in `ext_map`
+typedef struct {
+  uint16_t first;
+  uint16_t last;
+  uint16_t offset;
+} font_range_t;
+
+// A glyph of the proportional font. Only the rows with ink are stored, in
+// `prop_rows` starting at index `rows`, and are drawn from row `top` down.
+typedef struct {
+  uint16_t codepoint;
+  uint16_t rows;
+  uint8_t width;
+  uint8_t height;
+  uint8_t top;
+  int8_t offset_x;
+  uint8_t advance;
+} font_prop_glyph_t;
+
+// How much closer (negative) or further apart two glyphs are drawn
+typedef struct {
+  uint16_t left;
+  uint16_t right;
+  int8_t adjust;
+} font_kern_t;
+
+#include "font_prop_data.h"
+
+// glyphs missing from the proportional font fall back to the 6X8 tables
+#if FONT_PROP_HEIGHT != 8
+#error "The proportional font must be 8 pixels tall to fall back to 6X8"
+#endif
+
 // 8X12 ascii font data
 const static uint32_t ascii_8_12[285] = {
     0x00000000, 0x00000000, 0x00000000, //
@@ -302,6 +377,534 @@ const static uint8_t ascii_4_6[285] = {
     0x5A, 0x00, 0x00, // ~
 };
 
+// 8X12 extended glyph data. Indexed by `EXT_GLYPH` entries in `ext_map`
+const static uint32_t ext_8_12[186] = {
+    0x00386C6C, 0x38000000, 0x00000000, // degree
+    0x00000000, 0x00383800, 0x00000000, // middle dot
+    0x000000C6, 0x6C386CC6, 0x00000000, // multiplication
+    0x00001818, 0x00FE0018, 0x18000000, // division
+    0x00303000, 0x30303078, 0x78783000, // inverted exclamation
+    0x00181800, 0x18183060, 0xCC780000, // inverted question
+    0x003C6660, 0x60F86060, 0x60FE0000, // pound
+    0x001E3360, 0xFC60FC60, 0x331E0000, // euro
+    0x0078CCCC, 0xD8CCC6C6, 0xCCD8C000, // sharp s
+    0x00000000, 0x00000000, 0xDBDB0000, // ellipsis
+    0x00001030, 0x60FE6030, 0x10000000, // arrow left
+    0x00183C7E, 0x18181818, 0x18180000, // arrow up
+    0x0000080C, 0x06FE060C, 0x08000000, // arrow right
+    0x00181818, 0x1818187E, 0x3C180000, // arrow down
+    0x00108238, 0x7CFE7C38, 0x82100000, // sun
+    0x00000018, 0x3C7EFFFF, 0x7E000000, // cloud
+    0x00187EFF, 0xFF181818, 0xD8700000, // umbrella
+    0x00105438, 0x92FE9238, 0x54100000, // snowflake
+    0x00060C18, 0x307E0C18, 0x30600000, // lightning
+    0x007ED8D8, 0xD8FCD8D8, 0xD8DE0000, // AE
+    0x00000000, 0x6C1A7ED8, 0xDA6C0000, // ae
+    0x00396ECE, 0xD6D6D6E6, 0x74B80000, // O stroke
+    0x00000000, 0x7CCCDCEC, 0xCCF80000, // o stroke
+    0x00FEFEC0, 0xC0C0C0C0, 0xC0C00000, // Gamma
+    0x00103838, 0x6C6CC6C6, 0xFEFE0000, // Delta
+    0x00386CC6, 0xC6FEC6C6, 0x6C380000, // Theta
+    0x00103838, 0x6C6CC6C6, 0xC6C60000, // Lambda
+    0x00FEFE00, 0x007C0000, 0xFEFE0000, // Xi
+    0x00FEFEC6, 0xC6C6C6C6, 0xC6C60000, // Pi
+    0x00FEC060, 0x30183060, 0xC0FE0000, // Sigma
+    0x00187EDB, 0xDBDBDB7E, 0x18180000, // Phi
+    0x00DBDBDB, 0xDB7E3C18, 0x18180000, // Psi
+    0x00386CC6, 0xC6C6C66C, 0x6CEE0000, // Omega
+    0x00000000, 0x76DCCCCC, 0xDC760000, // alpha
+    0x0078CCCC, 0xD8CCC6C6, 0xCCF8C0C0, // beta
+    0x00000000, 0xC6C66C6C, 0x38381010, // gamma
+    0x007CC060, 0x386CC6C6, 0x6C380000, // delta
+    0x00000000, 0x78C070C0, 0xC0780000, // epsilon
+    0x00386C6C, 0x6C7C6C6C, 0x6C380000, // theta
+    0x00C06030, 0x30386C6C, 0xC6C60000, // lambda
+    0x00000000, 0xCCCCCCCC, 0xCCFAC0C0, // mu
+    0x00000000, 0xFEFE6C6C, 0x6C660000, // pi
+    0x00000000, 0x7ECCC6C6, 0xC67C0000, // sigma
+    0x00000000, 0xFEFE3030, 0x301C0000, // tau
+    0x00000018, 0x7EDBDBDB, 0x7E181818, // phi
+    0x00000000, 0x6CC6D6D6, 0xD66C0000, // omega
+    0x00FEC0C0, 0xC0FCC6C6, 0xC6FC0000, // Be
+    0x003C6C6C, 0x6C6C6C6C, 0xFEC6C600, // De
+    0x00929254, 0x54385454, 0x92920000, // Zhe
+    0x00C6C6CE, 0xCED6E6E6, 0xC6C60000, // Cyrillic I
+    0x003E6666, 0x66666666, 0x66C60000, // El
+    0x00CCCCCC, 0xCCCCCCCC, 0xCCFE0600, // Tse
+    0x00C6C6C6, 0xC67E0606, 0x06060000, // Che
+    0x00D6D6D6, 0xD6D6D6D6, 0xD6FE0000, // Sha
+    0x00D6D6D6, 0xD6D6D6D6, 0xD6FE0200, // Shcha
+    0x00E06060, 0x607C6666, 0x667C0000, // Hard sign
+    0x00C6C6C6, 0xC6F6DEDE, 0xDEF60000, // Yeru
+    0x00C0C0C0, 0xC0FCC6C6, 0xC6FC0000, // Soft sign
+    0x007CC606, 0x063E0606, 0xC67C0000, // Cyrillic E
+    0x00CEDBDB, 0xDBFBDBDB, 0xDBCE0000, // Yu
+    0x007EC6C6, 0xC67E3666, 0xC6C60000, // Ya
+    0x00C6C6C6, 0xC67E0606, 0xCC780000, // Cyrillic U
+};
+
+// 6X8 extended glyph data. Indexed by `EXT_GLYPH` entries in `ext_map`
+const static uint16_t ext_6_8[186] = {
+    0x3124, 0x8C00, 0x0000, // degree
+    0x0000, 0x0C30, 0x0000, // middle dot
+    0x0004, 0x4A10, 0xA440, // multiplication
+    0x0040, 0x1F00, 0x4000, // division
+    0x0040, 0x0410, 0xE384, // inverted exclamation
+    0x1001, 0x0C41, 0x1380, // inverted question
+    0x1892, 0x1E20, 0x87C0, // pound
+    0x1C87, 0x8878, 0x81C0, // euro
+    0x3124, 0x9449, 0x1590, // sharp s
+    0x0000, 0x0000, 0x0540, // ellipsis
+    0x0042, 0x1F20, 0x4000, // arrow left
+    0x10E5, 0x4410, 0x4100, // arrow up
+    0x0040, 0x9F08, 0x4000, // arrow right
+    0x1041, 0x0454, 0xE100, // arrow down
+    0x1113, 0x9F39, 0x1100, // sun
+    0x0003, 0x1EFF, 0xF000, // cloud
+    0x31EF, 0xC411, 0x4200, // umbrella
+    0x1153, 0x8439, 0x5100, // snowflake
+    0x0842, 0x1E10, 0x8400, // lightning
+    0x3D45, 0x1E51, 0x45C0, // AE
+    0x0006, 0x857E, 0x46C0, // ae
+    0x3934, 0xD565, 0x9380, // O stroke
+    0x0003, 0xD355, 0x9F00, // o stroke
+    0x7D04, 0x1041, 0x0400, // Gamma
+    0x1042, 0x8A45, 0x17C0, // Delta
+    0x3914, 0x5F45, 0x1380, // Theta
+    0x10A2, 0x9145, 0x1440, // Lambda
+    0x7C00, 0x0E00, 0x07C0, // Xi
+    0x7D14, 0x5145, 0x1440, // Pi
+    0x7D02, 0x0421, 0x07C0, // Sigma
+    0x10E5, 0x5554, 0xE100, // Phi
+    0x5555, 0x4E10, 0x4100, // Psi
+    0x3914, 0x5128, 0xA6C0, // Omega
+    0x0003, 0x5249, 0x2340, // alpha
+    0x3125, 0x1245, 0x1790, // beta
+    0x0004, 0x5128, 0xA104, // gamma
+    0x3902, 0x0E45, 0x1380, // delta
+    0x0003, 0x9031, 0x0380, // epsilon
+    0x10A2, 0x8E28, 0xA100, // theta
+    0x4081, 0x0C29, 0x2440, // lambda
+    0x0004, 0x9249, 0x2750, // mu
+    0x000F, 0xCA28, 0xA240, // pi
+    0x0003, 0xD245, 0x1380, // sigma
+    0x0007, 0xC410, 0x40C0, // tau
+    0x0043, 0x9554, 0xE104, // phi
+    0x0002, 0x9155, 0x5280, // omega
+    0x7D04, 0x1E45, 0x1780, // Be
+    0x38A2, 0x8A29, 0xF440, // De
+    0x5553, 0x8439, 0x5540, // Zhe
+    0x4514, 0xD565, 0x1440, // Cyrillic I
+    0x3C92, 0x4924, 0x9440, // El
+    0x4924, 0x9249, 0xF040, // Tse
+    0x4514, 0x4F04, 0x1040, // Che
+    0x5555, 0x5555, 0x57C0, // Sha
+    0x5555, 0x5555, 0x57C1, // Shcha
+    0xC082, 0x0E24, 0x9380, // Hard sign
+    0x4514, 0x5D4D, 0x3740, // Yeru
+    0x4104, 0x1E45, 0x1780, // Soft sign
+    0x3910, 0x4F05, 0x1380, // Cyrillic E
+    0x4955, 0x5D55, 0x5480, // Yu
+    0x3D14, 0x4F14, 0x9440, // Ya
+    0x4514, 0x4F05, 0x1380, // Cyrillic U
+};
+
+// 4X6 extended glyph data. Indexed by `EXT_GLYPH` entries in `ext_map`
+const static uint8_t ext_4_6[186] = {
+    0x4A, 0x40, 0x00, // degree
+    0x00, 0x40, 0x00, // middle dot
+    0x0A, 0x4A, 0x00, // multiplication
+    0x40, 0xE0, 0x40, // division
+    0x60, 0x66, 0x60, // inverted exclamation
+    0x40, 0x48, 0x60, // inverted question
+    0x64, 0xE4, 0xF0, // pound
+    0x78, 0xE8, 0x70, // euro
+    0x69, 0xA9, 0xA8, // sharp s
+    0x00, 0x00, 0xA0, // ellipsis
+    0x04, 0xF4, 0x00, // arrow left
+    0x4E, 0x44, 0x40, // arrow up
+    0x02, 0xF2, 0x00, // arrow right
+    0x44, 0x4E, 0x40, // arrow down
+    0xA4, 0xE4, 0xA0, // sun
+    0x06, 0xFF, 0x00, // cloud
+    0x6F, 0x2A, 0x40, // umbrella
+    0x0A, 0x4A, 0x00, // snowflake
+    0x24, 0xF2, 0x40, // lightning
+    0x7A, 0xFA, 0xB0, // AE
+    0x0E, 0x7C, 0xF0, // ae
+    0x6B, 0x9D, 0x60, // O stroke
+    0x07, 0xBD, 0xE0, // o stroke
+    0xF8, 0x88, 0x80, // Gamma
+    0x66, 0x99, 0xF0, // Delta
+    0x69, 0xF9, 0x60, // Theta
+    0x66, 0x99, 0x90, // Lambda
+    0xF0, 0x60, 0xF0, // Xi
+    0xF9, 0x99, 0x90, // Pi
+    0xF4, 0x24, 0xF0, // Sigma
+    0x4E, 0xAE, 0x40, // Phi
+    0xAA, 0xE4, 0x40, // Psi
+    0x69, 0x96, 0xF0, // Omega
+    0x05, 0xAA, 0x50, // alpha
+    0x69, 0xE9, 0xE8, // beta
+    0x09, 0x96, 0x44, // gamma
+    0x68, 0x69, 0x60, // delta
+    0x07, 0xC8, 0x70, // epsilon
+    0x69, 0xF9, 0x60, // theta
+    0x84, 0x69, 0x90, // lambda
+    0x09, 0x99, 0xF8, // mu
+    0x0F, 0x55, 0x50, // pi
+    0x07, 0xAA, 0x40, // sigma
+    0x0F, 0x44, 0x30, // tau
+    0x4E, 0xAE, 0x44, // phi
+    0x09, 0x9F, 0x60, // omega
+    0xF8, 0xE9, 0xE0, // Be
+    0x65, 0x5F, 0x90, // De
+    0xAE, 0x4E, 0xA0, // Zhe
+    0x99, 0xBD, 0x90, // Cyrillic I
+    0x75, 0x55, 0x90, // El
+    0xAA, 0xAF, 0x10, // Tse
+    0x99, 0x71, 0x10, // Che
+    0x99, 0x99, 0xF0, // Sha
+    0x99, 0x9F, 0x10, // Shcha
+    0xC4, 0x65, 0x60, // Hard sign
+    0x99, 0xDB, 0xD0, // Yeru
+    0x88, 0xE9, 0xE0, // Soft sign
+    0xE1, 0x71, 0xE0, // Cyrillic E
+    0xAD, 0xDD, 0xA0, // Yu
+    0x79, 0x75, 0x90, // Ya
+    0x99, 0x71, 0xE0, // Cyrillic U
+};
+
+// 8X12 accent marks, indexed by `MARK_*`
+const static font_mark_t marks_8_12[FONT_MARK_COUNT] = {
+    {0, false, {0}}, // none
+    {2, false, {0x30, 0x18}}, // grave
+    {2, false, {0x0C, 0x18}}, // acute
+    {2, false, {0x18, 0x24}}, // circumflex
+    {2, false, {0x34, 0x58}}, // tilde
+    {1, false, {0x6C}}, // diaeresis
+    {3, false, {0x38, 0x28, 0x38}}, // ring
+    {2, true, {0x18, 0x30}}, // cedilla
+    {2, false, {0x44, 0x38}}, // breve
+};
+
+// 6X8 accent marks, indexed by `MARK_*`
+const static font_mark_t marks_6_8[FONT_MARK_COUNT] = {
+    {0, false, {0}}, // none
+    {2, false, {0x08, 0x04}}, // grave
+    {2, false, {0x02, 0x04}}, // acute
+    {2, false, {0x04, 0x0A}}, // circumflex
+    {2, false, {0x0A, 0x14}}, // tilde
+    {1, false, {0x0A}}, // diaeresis
+    {3, false, {0x04, 0x0A, 0x04}}, // ring
+    {2, true, {0x04, 0x08}}, // cedilla
+    {2, false, {0x11, 0x0E}}, // breve
+};
+
+// 4X6 accent marks, indexed by `MARK_*`
+const static font_mark_t marks_4_6[FONT_MARK_COUNT] = {
+    {0, false, {0}}, // none
+    {2, false, {0x08, 0x04}}, // grave
+    {2, false, {0x02, 0x04}}, // acute
+    {2, false, {0x04, 0x0A}}, // circumflex
+    {2, false, {0x05, 0x0A}}, // tilde
+    {1, false, {0x09}}, // diaeresis
+    {1, false, {0x04}}, // ring
+    {1, true, {0x04}}, // cedilla
+    {2, false, {0x09, 0x06}}, // breve
+};
+
+// sparse ranges of supported codepoints above ASCII, sorted by `first`
+const static font_range_t ext_ranges[9] = {
+    {0x00A0, 0x00FF, 0},
+    {0x0391, 0x03C9, 96},
+    {0x0401, 0x0458, 153},
+    {0x2010, 0x2026, 241},
+    {0x20AC, 0x20AC, 264},
+    {0x2190, 0x2193, 265},
+    {0x2600, 0x2602, 269},
+    {0x26A1, 0x26A1, 272},
+    {0x2744, 0x2744, 273},
+};
+
+// one entry per codepoint covered by `ext_ranges`
+const static uint16_t ext_map[274] = {
+    EXT_ASCII(' ', MARK_NONE), // U+00A0 no-break space
+    EXT_GLYPH(4, MARK_NONE), // U+00A1 inverted exclamation mark
+    EXT_NONE, // U+00A2 cent sign
+    EXT_GLYPH(6, MARK_NONE), // U+00A3 pound sign
+    EXT_NONE, // U+00A4 currency sign
+    EXT_NONE, // U+00A5 yen sign
+    EXT_ASCII('|', MARK_NONE), // U+00A6 broken bar
+    EXT_NONE, // U+00A7 section sign
+    EXT_ASCII(' ', MARK_DIAERESIS), // U+00A8 diaeresis
+    EXT_NONE, // U+00A9 copyright sign
+    EXT_NONE, // U+00AA feminine ordinal indicator
+    EXT_NONE, // U+00AB left-pointing double angle quotation mark
+    EXT_NONE, // U+00AC not sign
+    EXT_ASCII('-', MARK_NONE), // U+00AD soft hyphen
+    EXT_NONE, // U+00AE registered sign
+    EXT_NONE, // U+00AF macron
+    EXT_GLYPH(0, MARK_NONE), // U+00B0 degree sign
+    EXT_NONE, // U+00B1 plus-minus sign
+    EXT_NONE, // U+00B2 superscript two
+    EXT_NONE, // U+00B3 superscript three
+    EXT_ASCII(' ', MARK_ACUTE), // U+00B4 acute accent
+    EXT_GLYPH(40, MARK_NONE), // U+00B5 micro sign
+    EXT_NONE, // U+00B6 pilcrow sign
+    EXT_GLYPH(1, MARK_NONE), // U+00B7 middle dot
+    EXT_ASCII(' ', MARK_CEDILLA), // U+00B8 cedilla
+    EXT_NONE, // U+00B9 superscript one
+    EXT_NONE, // U+00BA masculine ordinal indicator
+    EXT_NONE, // U+00BB right-pointing double angle quotation mark
+    EXT_NONE, // U+00BC vulgar fraction one quarter
+    EXT_NONE, // U+00BD vulgar fraction one half
+    EXT_NONE, // U+00BE vulgar fraction three quarters
+    EXT_GLYPH(5, MARK_NONE), // U+00BF inverted question mark
+    EXT_ASCII('A', MARK_GRAVE), // U+00C0 latin capital letter a with grave
+    EXT_ASCII('A', MARK_ACUTE), // U+00C1 latin capital letter a with acute
+    EXT_ASCII('A', MARK_CIRCUMFLEX), // U+00C2 latin capital letter a with circumflex
+    EXT_ASCII('A', MARK_TILDE), // U+00C3 latin capital letter a with tilde
+    EXT_ASCII('A', MARK_DIAERESIS), // U+00C4 latin capital letter a with diaeresis
+    EXT_ASCII('A', MARK_RING), // U+00C5 latin capital letter a with ring above
+    EXT_GLYPH(19, MARK_NONE), // U+00C6 latin capital letter ae
+    EXT_ASCII('C', MARK_CEDILLA), // U+00C7 latin capital letter c with cedilla
+    EXT_ASCII('E', MARK_GRAVE), // U+00C8 latin capital letter e with grave
+    EXT_ASCII('E', MARK_ACUTE), // U+00C9 latin capital letter e with acute
+    EXT_ASCII('E', MARK_CIRCUMFLEX), // U+00CA latin capital letter e with circumflex
+    EXT_ASCII('E', MARK_DIAERESIS), // U+00CB latin capital letter e with diaeresis
+    EXT_ASCII('I', MARK_GRAVE), // U+00CC latin capital letter i with grave
+    EXT_ASCII('I', MARK_ACUTE), // U+00CD latin capital letter i with acute
+    EXT_ASCII('I', MARK_CIRCUMFLEX), // U+00CE latin capital letter i with circumflex
+    EXT_ASCII('I', MARK_DIAERESIS), // U+00CF latin capital letter i with diaeresis
+    EXT_ASCII('D', MARK_NONE), // U+00D0 latin capital letter eth
+    EXT_ASCII('N', MARK_TILDE), // U+00D1 latin capital letter n with tilde
+    EXT_ASCII('O', MARK_GRAVE), // U+00D2 latin capital letter o with grave
+    EXT_ASCII('O', MARK_ACUTE), // U+00D3 latin capital letter o with acute
+    EXT_ASCII('O', MARK_CIRCUMFLEX), // U+00D4 latin capital letter o with circumflex
+    EXT_ASCII('O', MARK_TILDE), // U+00D5 latin capital letter o with tilde
+    EXT_ASCII('O', MARK_DIAERESIS), // U+00D6 latin capital letter o with diaeresis
+    EXT_GLYPH(2, MARK_NONE), // U+00D7 multiplication sign
+    EXT_GLYPH(21, MARK_NONE), // U+00D8 latin capital letter o with stroke
+    EXT_ASCII('U', MARK_GRAVE), // U+00D9 latin capital letter u with grave
+    EXT_ASCII('U', MARK_ACUTE), // U+00DA latin capital letter u with acute
+    EXT_ASCII('U', MARK_CIRCUMFLEX), // U+00DB latin capital letter u with circumflex
+    EXT_ASCII('U', MARK_DIAERESIS), // U+00DC latin capital letter u with diaeresis
+    EXT_ASCII('Y', MARK_ACUTE), // U+00DD latin capital letter y with acute
+    EXT_NONE, // U+00DE latin capital letter thorn
+    EXT_GLYPH(8, MARK_NONE), // U+00DF latin small letter sharp s
+    EXT_ASCII('a', MARK_GRAVE), // U+00E0 latin small letter a with grave
+    EXT_ASCII('a', MARK_ACUTE), // U+00E1 latin small letter a with acute
+    EXT_ASCII('a', MARK_CIRCUMFLEX), // U+00E2 latin small letter a with circumflex
+    EXT_ASCII('a', MARK_TILDE), // U+00E3 latin small letter a with tilde
+    EXT_ASCII('a', MARK_DIAERESIS), // U+00E4 latin small letter a with diaeresis
+    EXT_ASCII('a', MARK_RING), // U+00E5 latin small letter a with ring above
+    EXT_GLYPH(20, MARK_NONE), // U+00E6 latin small letter ae
+    EXT_ASCII('c', MARK_CEDILLA), // U+00E7 latin small letter c with cedilla
+    EXT_ASCII('e', MARK_GRAVE), // U+00E8 latin small letter e with grave
+    EXT_ASCII('e', MARK_ACUTE), // U+00E9 latin small letter e with acute
+    EXT_ASCII('e', MARK_CIRCUMFLEX), // U+00EA latin small letter e with circumflex
+    EXT_ASCII('e', MARK_DIAERESIS), // U+00EB latin small letter e with diaeresis
+    EXT_ASCII('i', MARK_GRAVE), // U+00EC latin small letter i with grave
+    EXT_ASCII('i', MARK_ACUTE), // U+00ED latin small letter i with acute
+    EXT_ASCII('i', MARK_CIRCUMFLEX), // U+00EE latin small letter i with circumflex
+    EXT_ASCII('i', MARK_DIAERESIS), // U+00EF latin small letter i with diaeresis
+    EXT_NONE, // U+00F0 latin small letter eth
+    EXT_ASCII('n', MARK_TILDE), // U+00F1 latin small letter n with tilde
+    EXT_ASCII('o', MARK_GRAVE), // U+00F2 latin small letter o with grave
+    EXT_ASCII('o', MARK_ACUTE), // U+00F3 latin small letter o with acute
+    EXT_ASCII('o', MARK_CIRCUMFLEX), // U+00F4 latin small letter o with circumflex
+    EXT_ASCII('o', MARK_TILDE), // U+00F5 latin small letter o with tilde
+    EXT_ASCII('o', MARK_DIAERESIS), // U+00F6 latin small letter o with diaeresis
+    EXT_GLYPH(3, MARK_NONE), // U+00F7 division sign
+    EXT_GLYPH(22, MARK_NONE), // U+00F8 latin small letter o with stroke
+    EXT_ASCII('u', MARK_GRAVE), // U+00F9 latin small letter u with grave
+    EXT_ASCII('u', MARK_ACUTE), // U+00FA latin small letter u with acute
+    EXT_ASCII('u', MARK_CIRCUMFLEX), // U+00FB latin small letter u with circumflex
+    EXT_ASCII('u', MARK_DIAERESIS), // U+00FC latin small letter u with diaeresis
+    EXT_ASCII('y', MARK_ACUTE), // U+00FD latin small letter y with acute
+    EXT_NONE, // U+00FE latin small letter thorn
+    EXT_ASCII('y', MARK_DIAERESIS), // U+00FF latin small letter y with diaeresis
+    EXT_ASCII('A', MARK_NONE), // U+0391 greek capital letter alpha
+    EXT_ASCII('B', MARK_NONE), // U+0392 greek capital letter beta
+    EXT_GLYPH(23, MARK_NONE), // U+0393 greek capital letter gamma
+    EXT_GLYPH(24, MARK_NONE), // U+0394 greek capital letter delta
+    EXT_ASCII('E', MARK_NONE), // U+0395 greek capital letter epsilon
+    EXT_ASCII('Z', MARK_NONE), // U+0396 greek capital letter zeta
+    EXT_ASCII('H', MARK_NONE), // U+0397 greek capital letter eta
+    EXT_GLYPH(25, MARK_NONE), // U+0398 greek capital letter theta
+    EXT_ASCII('I', MARK_NONE), // U+0399 greek capital letter iota
+    EXT_ASCII('K', MARK_NONE), // U+039A greek capital letter kappa
+    EXT_GLYPH(26, MARK_NONE), // U+039B greek capital letter lamda
+    EXT_ASCII('M', MARK_NONE), // U+039C greek capital letter mu
+    EXT_ASCII('N', MARK_NONE), // U+039D greek capital letter nu
+    EXT_GLYPH(27, MARK_NONE), // U+039E greek capital letter xi
+    EXT_ASCII('O', MARK_NONE), // U+039F greek capital letter omicron
+    EXT_GLYPH(28, MARK_NONE), // U+03A0 greek capital letter pi
+    EXT_ASCII('P', MARK_NONE), // U+03A1 greek capital letter rho
+    EXT_NONE, // U+03A2 unassigned
+    EXT_GLYPH(29, MARK_NONE), // U+03A3 greek capital letter sigma
+    EXT_ASCII('T', MARK_NONE), // U+03A4 greek capital letter tau
+    EXT_ASCII('Y', MARK_NONE), // U+03A5 greek capital letter upsilon
+    EXT_GLYPH(30, MARK_NONE), // U+03A6 greek capital letter phi
+    EXT_ASCII('X', MARK_NONE), // U+03A7 greek capital letter chi
+    EXT_GLYPH(31, MARK_NONE), // U+03A8 greek capital letter psi
+    EXT_GLYPH(32, MARK_NONE), // U+03A9 greek capital letter omega
+    EXT_NONE, // U+03AA greek capital letter iota with dialytika
+    EXT_NONE, // U+03AB greek capital letter upsilon with dialytika
+    EXT_NONE, // U+03AC greek small letter alpha with tonos
+    EXT_NONE, // U+03AD greek small letter epsilon with tonos
+    EXT_NONE, // U+03AE greek small letter eta with tonos
+    EXT_NONE, // U+03AF greek small letter iota with tonos
+    EXT_NONE, // U+03B0 greek small letter upsilon with dialytika and tonos
+    EXT_GLYPH(33, MARK_NONE), // U+03B1 greek small letter alpha
+    EXT_GLYPH(34, MARK_NONE), // U+03B2 greek small letter beta
+    EXT_GLYPH(35, MARK_NONE), // U+03B3 greek small letter gamma
+    EXT_GLYPH(36, MARK_NONE), // U+03B4 greek small letter delta
+    EXT_GLYPH(37, MARK_NONE), // U+03B5 greek small letter epsilon
+    EXT_NONE, // U+03B6 greek small letter zeta
+    EXT_ASCII('n', MARK_NONE), // U+03B7 greek small letter eta
+    EXT_GLYPH(38, MARK_NONE), // U+03B8 greek small letter theta
+    EXT_ASCII('i', MARK_NONE), // U+03B9 greek small letter iota
+    EXT_ASCII('k', MARK_NONE), // U+03BA greek small letter kappa
+    EXT_GLYPH(39, MARK_NONE), // U+03BB greek small letter lamda
+    EXT_GLYPH(40, MARK_NONE), // U+03BC greek small letter mu
+    EXT_ASCII('v', MARK_NONE), // U+03BD greek small letter nu
+    EXT_NONE, // U+03BE greek small letter xi
+    EXT_ASCII('o', MARK_NONE), // U+03BF greek small letter omicron
+    EXT_GLYPH(41, MARK_NONE), // U+03C0 greek small letter pi
+    EXT_ASCII('p', MARK_NONE), // U+03C1 greek small letter rho
+    EXT_ASCII('c', MARK_NONE), // U+03C2 greek small letter final sigma
+    EXT_GLYPH(42, MARK_NONE), // U+03C3 greek small letter sigma
+    EXT_GLYPH(43, MARK_NONE), // U+03C4 greek small letter tau
+    EXT_ASCII('u', MARK_NONE), // U+03C5 greek small letter upsilon
+    EXT_GLYPH(44, MARK_NONE), // U+03C6 greek small letter phi
+    EXT_ASCII('x', MARK_NONE), // U+03C7 greek small letter chi
+    EXT_GLYPH(31, MARK_NONE), // U+03C8 greek small letter psi
+    EXT_GLYPH(45, MARK_NONE), // U+03C9 greek small letter omega
+    EXT_ASCII('E', MARK_DIAERESIS), // U+0401 cyrillic capital letter io
+    EXT_NONE, // U+0402 cyrillic capital letter dje
+    EXT_NONE, // U+0403 cyrillic capital letter gje
+    EXT_NONE, // U+0404 cyrillic capital letter ukrainian ie
+    EXT_ASCII('S', MARK_NONE), // U+0405 cyrillic capital letter dze
+    EXT_ASCII('I', MARK_NONE), // U+0406 cyrillic capital letter byelorussian-ukrainian i
+    EXT_NONE, // U+0407 cyrillic capital letter yi
+    EXT_ASCII('J', MARK_NONE), // U+0408 cyrillic capital letter je
+    EXT_NONE, // U+0409 cyrillic capital letter lje
+    EXT_NONE, // U+040A cyrillic capital letter nje
+    EXT_NONE, // U+040B cyrillic capital letter tshe
+    EXT_NONE, // U+040C cyrillic capital letter kje
+    EXT_NONE, // U+040D cyrillic capital letter i with grave
+    EXT_NONE, // U+040E cyrillic capital letter short u
+    EXT_NONE, // U+040F cyrillic capital letter dzhe
+    EXT_ASCII('A', MARK_NONE), // U+0410 cyrillic capital letter a
+    EXT_GLYPH(46, MARK_NONE), // U+0411 cyrillic capital letter be
+    EXT_ASCII('B', MARK_NONE), // U+0412 cyrillic capital letter ve
+    EXT_GLYPH(23, MARK_NONE), // U+0413 cyrillic capital letter ghe
+    EXT_GLYPH(47, MARK_NONE), // U+0414 cyrillic capital letter de
+    EXT_ASCII('E', MARK_NONE), // U+0415 cyrillic capital letter ie
+    EXT_GLYPH(48, MARK_NONE), // U+0416 cyrillic capital letter zhe
+    EXT_ASCII('3', MARK_NONE), // U+0417 cyrillic capital letter ze
+    EXT_GLYPH(49, MARK_NONE), // U+0418 cyrillic capital letter i
+    EXT_GLYPH(49, MARK_BREVE), // U+0419 cyrillic capital letter short i
+    EXT_ASCII('K', MARK_NONE), // U+041A cyrillic capital letter ka
+    EXT_GLYPH(50, MARK_NONE), // U+041B cyrillic capital letter el
+    EXT_ASCII('M', MARK_NONE), // U+041C cyrillic capital letter em
+    EXT_ASCII('H', MARK_NONE), // U+041D cyrillic capital letter en
+    EXT_ASCII('O', MARK_NONE), // U+041E cyrillic capital letter o
+    EXT_GLYPH(28, MARK_NONE), // U+041F cyrillic capital letter pe
+    EXT_ASCII('P', MARK_NONE), // U+0420 cyrillic capital letter er
+    EXT_ASCII('C', MARK_NONE), // U+0421 cyrillic capital letter es
+    EXT_ASCII('T', MARK_NONE), // U+0422 cyrillic capital letter te
+    EXT_GLYPH(61, MARK_NONE), // U+0423 cyrillic capital letter u
+    EXT_GLYPH(30, MARK_NONE), // U+0424 cyrillic capital letter ef
+    EXT_ASCII('X', MARK_NONE), // U+0425 cyrillic capital letter ha
+    EXT_GLYPH(51, MARK_NONE), // U+0426 cyrillic capital letter tse
+    EXT_GLYPH(52, MARK_NONE), // U+0427 cyrillic capital letter che
+    EXT_GLYPH(53, MARK_NONE), // U+0428 cyrillic capital letter sha
+    EXT_GLYPH(54, MARK_NONE), // U+0429 cyrillic capital letter shcha
+    EXT_GLYPH(55, MARK_NONE), // U+042A cyrillic capital letter hard sign
+    EXT_GLYPH(56, MARK_NONE), // U+042B cyrillic capital letter yeru
+    EXT_GLYPH(57, MARK_NONE), // U+042C cyrillic capital letter soft sign
+    EXT_GLYPH(58, MARK_NONE), // U+042D cyrillic capital letter e
+    EXT_GLYPH(59, MARK_NONE), // U+042E cyrillic capital letter yu
+    EXT_GLYPH(60, MARK_NONE), // U+042F cyrillic capital letter ya
+    EXT_ASCII('a', MARK_NONE), // U+0430 cyrillic small letter a
+    EXT_GLYPH(46, MARK_NONE), // U+0431 cyrillic small letter be
+    EXT_ASCII('B', MARK_NONE), // U+0432 cyrillic small letter ve
+    EXT_GLYPH(23, MARK_NONE), // U+0433 cyrillic small letter ghe
+    EXT_GLYPH(47, MARK_NONE), // U+0434 cyrillic small letter de
+    EXT_ASCII('e', MARK_NONE), // U+0435 cyrillic small letter ie
+    EXT_GLYPH(48, MARK_NONE), // U+0436 cyrillic small letter zhe
+    EXT_ASCII('3', MARK_NONE), // U+0437 cyrillic small letter ze
+    EXT_GLYPH(49, MARK_NONE), // U+0438 cyrillic small letter i
+    EXT_GLYPH(49, MARK_BREVE), // U+0439 cyrillic small letter short i
+    EXT_ASCII('k', MARK_NONE), // U+043A cyrillic small letter ka
+    EXT_GLYPH(50, MARK_NONE), // U+043B cyrillic small letter el
+    EXT_ASCII('M', MARK_NONE), // U+043C cyrillic small letter em
+    EXT_ASCII('H', MARK_NONE), // U+043D cyrillic small letter en
+    EXT_ASCII('o', MARK_NONE), // U+043E cyrillic small letter o
+    EXT_GLYPH(28, MARK_NONE), // U+043F cyrillic small letter pe
+    EXT_ASCII('p', MARK_NONE), // U+0440 cyrillic small letter er
+    EXT_ASCII('c', MARK_NONE), // U+0441 cyrillic small letter es
+    EXT_ASCII('T', MARK_NONE), // U+0442 cyrillic small letter te
+    EXT_ASCII('y', MARK_NONE), // U+0443 cyrillic small letter u
+    EXT_GLYPH(30, MARK_NONE), // U+0444 cyrillic small letter ef
+    EXT_ASCII('x', MARK_NONE), // U+0445 cyrillic small letter ha
+    EXT_GLYPH(51, MARK_NONE), // U+0446 cyrillic small letter tse
+    EXT_GLYPH(52, MARK_NONE), // U+0447 cyrillic small letter che
+    EXT_GLYPH(53, MARK_NONE), // U+0448 cyrillic small letter sha
+    EXT_GLYPH(54, MARK_NONE), // U+0449 cyrillic small letter shcha
+    EXT_GLYPH(55, MARK_NONE), // U+044A cyrillic small letter hard sign
+    EXT_GLYPH(56, MARK_NONE), // U+044B cyrillic small letter yeru
+    EXT_GLYPH(57, MARK_NONE), // U+044C cyrillic small letter soft sign
+    EXT_GLYPH(58, MARK_NONE), // U+044D cyrillic small letter e
+    EXT_GLYPH(59, MARK_NONE), // U+044E cyrillic small letter yu
+    EXT_GLYPH(60, MARK_NONE), // U+044F cyrillic small letter ya
+    EXT_NONE, // U+0450 cyrillic small letter ie with grave
+    EXT_ASCII('e', MARK_DIAERESIS), // U+0451 cyrillic small letter io
+    EXT_NONE, // U+0452 cyrillic small letter dje
+    EXT_NONE, // U+0453 cyrillic small letter gje
+    EXT_NONE, // U+0454 cyrillic small letter ukrainian ie
+    EXT_ASCII('s', MARK_NONE), // U+0455 cyrillic small letter dze
+    EXT_ASCII('i', MARK_NONE), // U+0456 cyrillic small letter byelorussian-ukrainian i
+    EXT_NONE, // U+0457 cyrillic small letter yi
+    EXT_ASCII('j', MARK_NONE), // U+0458 cyrillic small letter je
+    EXT_ASCII('-', MARK_NONE), // U+2010 hyphen
+    EXT_ASCII('-', MARK_NONE), // U+2011 non-breaking hyphen
+    EXT_ASCII('-', MARK_NONE), // U+2012 figure dash
+    EXT_ASCII('-', MARK_NONE), // U+2013 en dash
+    EXT_ASCII('-', MARK_NONE), // U+2014 em dash
+    EXT_ASCII('-', MARK_NONE), // U+2015 horizontal bar
+    EXT_NONE, // U+2016 double vertical line
+    EXT_NONE, // U+2017 double low line
+    EXT_ASCII('\'', MARK_NONE), // U+2018 left single quotation mark
+    EXT_ASCII('\'', MARK_NONE), // U+2019 right single quotation mark
+    EXT_ASCII(',', MARK_NONE), // U+201A single low-9 quotation mark
+    EXT_ASCII('\'', MARK_NONE), // U+201B single high-reversed-9 quotation mark
+    EXT_ASCII('"', MARK_NONE), // U+201C left double quotation mark
+    EXT_ASCII('"', MARK_NONE), // U+201D right double quotation mark
+    EXT_ASCII('"', MARK_NONE), // U+201E double low-9 quotation mark
+    EXT_ASCII('"', MARK_NONE), // U+201F double high-reversed-9 quotation mark
+    EXT_NONE, // U+2020 dagger
+    EXT_NONE, // U+2021 double dagger
+    EXT_GLYPH(1, MARK_NONE), // U+2022 bullet
+    EXT_NONE, // U+2023 triangular bullet
+    EXT_ASCII('.', MARK_NONE), // U+2024 one dot leader
+    EXT_NONE, // U+2025 two dot leader
+    EXT_GLYPH(9, MARK_NONE), // U+2026 horizontal ellipsis
+    EXT_GLYPH(7, MARK_NONE), // U+20AC euro sign
+    EXT_GLYPH(10, MARK_NONE), // U+2190 leftwards arrow
+    EXT_GLYPH(11, MARK_NONE), // U+2191 upwards arrow
+    EXT_GLYPH(12, MARK_NONE), // U+2192 rightwards arrow
+    EXT_GLYPH(13, MARK_NONE), // U+2193 downwards arrow
+    EXT_GLYPH(14, MARK_NONE), // U+2600 black sun with rays
+    EXT_GLYPH(15, MARK_NONE), // U+2601 cloud
+    EXT_GLYPH(16, MARK_NONE), // U+2602 umbrella
+    EXT_GLYPH(18, MARK_NONE), // U+26A1 high voltage sign
+    EXT_GLYPH(17, MARK_NONE), // U+2744 snowflake
+};
+
 // allocates all memory needed for the font
 esp_err_t font_init(font_handle_t *font_handle) {
   font_handle_t font = (font_handle_t)malloc(sizeof(font_t));
@@ -337,6 +940,15 @@ void font_set_size(font_handle_t font, font_size_t size) {
     font->chunks_per_char = 3;
     font->spacing = 0;
     break;
+  case FONT_SIZE_PROP:
+    // keeps the 6X8 cell so missing glyphs can fall back to the 6X8 tables.
+    // `width` is then the widest a glyph will be.
+    font->width = 6;
+    font->height = FONT_PROP_HEIGHT;
+    font->bits_per_chunk = 16;
+    font->chunks_per_char = 3;
+    font->spacing = 0;
+    break;
   case FONT_SIZE_MD:
   default:
     font->width = 6;
@@ -348,6 +960,46 @@ void font_set_size(font_handle_t font, font_size_t size) {
   }
 
   font->bits_per_char = font->bits_per_chunk * font->chunks_per_char;
+  font->proportional = font->size == FONT_SIZE_PROP;
+}
+
+// reads one chunk of either the ASCII or the extended glyph tables
+static uint32_t read_chunk(font_handle_t font, bool extended, uint16_t index,
+                           uint8_t chunk) {
+  const uint16_t offset = (index * font->chunks_per_char) + chunk;
+
+  switch (font->size) {
+  case FONT_SIZE_SM:
+    return (uint32_t)(extended ? ext_4_6[offset] : ascii_4_6[offset]);
+  case FONT_SIZE_LG:
+    return (uint32_t)(extended ? ext_8_12[offset] : ascii_8_12[offset]);
+  case FONT_SIZE_MD:
+  default:
+    return (uint32_t)(extended ? ext_6_8[offset] : ascii_6_8[offset]);
+  }
+}
+
+// Rows are packed back to back across the chunks, so a row may start in one
+// chunk and end in the next.
+static uint8_t read_row(font_handle_t font, bool extended, uint16_t index,
+                        uint8_t row) {
+  const uint8_t bitOffset = row * font->width;
+  const uint8_t chunk = bitOffset / font->bits_per_chunk;
+  const uint8_t chunkOffset = bitOffset % font->bits_per_chunk;
+  const uint32_t chunkVal = read_chunk(font, extended, index, chunk);
+
+  if (chunkOffset + font->width <= font->bits_per_chunk) {
+    return (uint8_t)((chunkVal >>
+                      (font->bits_per_chunk - chunkOffset - font->width)) &
+                     ((1 << font->width) - 1));
+  }
+
+  // the row continues into the next chunk
+  const uint8_t firstBits = font->bits_per_chunk - chunkOffset;
+  const uint8_t restBits = font->width - firstBits;
+  return (uint8_t)(((chunkVal & ((1 << firstBits) - 1)) << restBits) |
+                   (read_chunk(font, extended, index, chunk + 1) >>
+                    (font->bits_per_chunk - restBits)));
 }
 
 uint32_t font_get_chunk(font_handle_t font, char ascii_char, uint8_t chunk) {
@@ -355,19 +1007,274 @@ uint32_t font_get_chunk(font_handle_t font, char ascii_char, uint8_t chunk) {
     return (uint32_t)0;
   }
 
+  return read_chunk(font, false, font_ascii_to_index(ascii_char), chunk);
+}
+
+// Returns one row of a character's bitmap, with the leftmost pixel in bit
+// `font->width - 1`.
+uint8_t font_get_row(font_handle_t font, char ascii_char, uint8_t row) {
+  if (row >= font->height || !font_is_valid_ascii(ascii_char)) {
+    return 0;
+  }
+
+  return read_row(font, false, font_ascii_to_index(ascii_char), row);
+}
+
+// binary search of the sparse extended ranges
+static uint16_t ext_lookup(uint32_t codepoint) {
+  uint8_t low = 0;
+  uint8_t high = sizeof(ext_ranges) / sizeof(ext_ranges[0]);
+  uint8_t mid;
+
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (codepoint < ext_ranges[mid].first) {
+      high = mid;
+    } else if (codepoint > ext_ranges[mid].last) {
+      low = mid + 1;
+    } else {
+      return ext_map[ext_ranges[mid].offset +
+                     (codepoint - ext_ranges[mid].first)];
+    }
+  }
+
+  return EXT_NONE;
+}
+
+static const font_mark_t *get_mark(font_handle_t font, uint8_t mark) {
   switch (font->size) {
   case FONT_SIZE_SM:
-    return (uint32_t)
-        ascii_4_6[(font_ascii_to_index(ascii_char) * font->chunks_per_char) +
-                  chunk];
+    return &marks_4_6[mark];
   case FONT_SIZE_LG:
-    return (uint32_t)
-        ascii_8_12[(font_ascii_to_index(ascii_char) * font->chunks_per_char) +
-                   chunk];
+    return &marks_8_12[mark];
   case FONT_SIZE_MD:
   default:
-    return (uint32_t)
-        ascii_6_8[(font_ascii_to_index(ascii_char) * font->chunks_per_char) +
-                  chunk];
+    return &marks_6_8[mark];
+  }
+}
+
+// Draws an accent into a resolved glyph. Marks above are given a blank row of
+// space by moving the glyph down, as far as the empty rows under it allow.
+static void compose_mark(font_handle_t font, font_glyph_t *glyph,
+                         uint8_t markIndex) {
+  const font_mark_t *mark = get_mark(font, markIndex);
+  uint8_t firstInk = font->height;
+  uint8_t lastInk = 0;
+  uint8_t row;
+  uint8_t start;
+  uint8_t shift;
+
+  for (row = 0; row < font->height; row++) {
+    if (glyph->rows[row] != 0) {
+      if (firstInk == font->height) {
+        firstInk = row;
+      }
+      lastInk = row;
+    }
+  }
+
+  if (mark->below) {
+    start = firstInk == font->height ? font->height - mark->height
+                                     : lastInk + 1;
+    for (row = 0; row < mark->height && start + row < font->height; row++) {
+      glyph->rows[start + row] |= mark->rows[row];
+    }
+    return;
+  }
+
+  if (firstInk < font->height && firstInk <= mark->height) {
+    shift = MIN(mark->height + 1 - firstInk, font->height - 1 - lastInk);
+    memmove(&glyph->rows[shift], glyph->rows, font->height - shift);
+    memset(glyph->rows, 0, shift);
+  }
+
+  for (row = 0; row < mark->height; row++) {
+    glyph->rows[row] |= mark->rows[row];
+  }
+}
+
+// Resolves a codepoint from the monospaced tables. Codepoints without a glyph
+// resolve to `FONT_REPLACEMENT_CHAR` and return false.
+static bool resolve_mono(font_handle_t font, uint32_t codepoint,
+                         font_glyph_t *glyph) {
+  uint16_t entry;
+  uint16_t index;
+  bool extended;
+  bool found = true;
+  uint8_t row;
+
+  if (codepoint <= FONT_ASCII_MAX) {
+    entry = font_is_valid_ascii(codepoint) ? EXT_ASCII(codepoint, MARK_NONE)
+                                           : EXT_NONE;
+  } else {
+    entry = ext_lookup(codepoint);
+  }
+
+  if (ext_entry_kind(entry) == EXT_KIND_NONE) {
+    entry = EXT_ASCII(FONT_REPLACEMENT_CHAR, MARK_NONE);
+    found = false;
+  }
+
+  extended = ext_entry_kind(entry) == EXT_KIND_GLYPH;
+  index = extended ? ext_entry_value(entry)
+                   : font_ascii_to_index(ext_entry_value(entry));
+  for (row = 0; row < font->height; row++) {
+    glyph->rows[row] = read_row(font, extended, index, row);
+  }
+
+  if (ext_entry_mark(entry) != MARK_NONE) {
+    compose_mark(font, glyph, ext_entry_mark(entry));
+  }
+
+  glyph->width = font->width;
+  glyph->offset_x = 0;
+  glyph->advance = font->width + font->spacing;
+
+  return found;
+}
+
+// binary search of the proportional glyphs
+static bool resolve_prop(font_handle_t font, uint32_t codepoint,
+                         font_glyph_t *glyph) {
+  uint16_t low = 0;
+  uint16_t high = sizeof(prop_glyphs) / sizeof(prop_glyphs[0]);
+  uint16_t mid;
+  const font_prop_glyph_t *prop;
+
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (codepoint < prop_glyphs[mid].codepoint) {
+      high = mid;
+    } else if (codepoint > prop_glyphs[mid].codepoint) {
+      low = mid + 1;
+    } else {
+      prop = &prop_glyphs[mid];
+      memset(glyph->rows, 0, sizeof(glyph->rows));
+      memcpy(&glyph->rows[prop->top], &prop_rows[prop->rows], prop->height);
+      glyph->width = prop->width;
+      glyph->offset_x = prop->offset_x;
+      glyph->advance = prop->advance;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Narrows a monospaced glyph to its ink, so fallbacks in the proportional font
+// are spaced like the rest of it.
+static void trim_glyph(font_handle_t font, font_glyph_t *glyph) {
+  uint8_t ink = 0;
+  uint8_t row;
+  uint8_t right = 0;
+
+  for (row = 0; row < font->height; row++) {
+    ink |= glyph->rows[row];
+  }
+  if (ink == 0) {
+    resolve_prop(font, ' ', glyph);
+    return;
   }
+
+  while (!(ink & (1 << right))) {
+    right++;
+  }
+  for (row = 0; row < font->height; row++) {
+    glyph->rows[row] >>= right;
+  }
+
+  glyph->width = 0;
+  while (ink >> (right + glyph->width)) {
+    glyph->width++;
+  }
+  glyph->advance = glyph->width + 1;
+}
+
+// Resolves any codepoint to its rows and metrics. Codepoints without a glyph
+// resolve to `FONT_REPLACEMENT_CHAR` and return false.
+bool font_get_glyph(font_handle_t font, uint32_t codepoint,
+                    font_glyph_t *glyph) {
+  if (!font->proportional) {
+    return resolve_mono(font, codepoint, glyph);
+  }
+
+  if (resolve_prop(font, codepoint, glyph)) {
+    return true;
+  }
+
+  if (!resolve_mono(font, codepoint, glyph)) {
+    resolve_prop(font, FONT_REPLACEMENT_CHAR, glyph);
+    return false;
+  }
+
+  trim_glyph(font, glyph);
+  return true;
+}
+
+// Returns how many pixels to move the cursor between two glyphs, beyond their
+// advance. Always 0 for monospaced fonts.
+int8_t font_get_kerning(font_handle_t font, uint32_t left, uint32_t right) {
+  uint16_t low = 0;
+  uint16_t high = sizeof(prop_kerning) / sizeof(prop_kerning[0]);
+  uint16_t mid;
+
+  if (!font->proportional) {
+    return 0;
+  }
+
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (left < prop_kerning[mid].left ||
+        (left == prop_kerning[mid].left && right < prop_kerning[mid].right)) {
+      high = mid;
+    } else if (left > prop_kerning[mid].left ||
+               right > prop_kerning[mid].right) {
+      low = mid + 1;
+    } else {
+      return prop_kerning[mid].adjust;
+    }
+  }
+
+  return 0;
+}
+
+// Decodes the UTF-8 sequence at the start of `string`. Returns how many bytes
+// it used, or 0 at the end of the string. Malformed bytes are used one at a
+// time and decode to `FONT_CODEPOINT_INVALID`.
+uint8_t font_utf8_decode(const char *string, uint32_t *codepoint) {
+  const uint8_t *bytes = (const uint8_t *)string;
+  uint8_t length;
+  uint8_t i;
+
+  if (bytes[0] == 0) {
+    return 0;
+  }
+
+  if (bytes[0] < 0x80) {
+    *codepoint = bytes[0];
+    return 1;
+  } else if ((bytes[0] & 0xE0) == 0xC0) {
+    length = 2;
+    *codepoint = bytes[0] & 0x1F;
+  } else if ((bytes[0] & 0xF0) == 0xE0) {
+    length = 3;
+    *codepoint = bytes[0] & 0x0F;
+  } else if ((bytes[0] & 0xF8) == 0xF0) {
+    length = 4;
+    *codepoint = bytes[0] & 0x07;
+  } else {
+    *codepoint = FONT_CODEPOINT_INVALID;
+    return 1;
+  }
+
+  // a continuation byte check also stops at the end of the string
+  for (i = 1; i < length; i++) {
+    if ((bytes[i] & 0xC0) != 0x80) {
+      *codepoint = FONT_CODEPOINT_INVALID;
+      return 1;
+    }
+    *codepoint = (*codepoint << 6) | (bytes[i] & 0x3F);
+  }
+
+  return length;
 }
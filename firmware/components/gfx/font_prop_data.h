@@ -0,0 +1,203 @@
+// Generated by server/src/scripts/compileFont.ts from prop8.bdf.
+// Do not edit, run `npm run font:compile` instead.
+#pragma once
+
+#define FONT_PROP_HEIGHT 8
+#define FONT_PROP_WIDTH_MAX 6
+
+// glyph metrics, sorted by codepoint. See `font_prop_glyph_t`
+const static font_prop_glyph_t prop_glyphs[95] = {
+    {0x0020, 0, 0, 0, 7, 0, 3}, // space
+    {0x0021, 0, 3, 7, 0, 0, 4}, // exclam
+    {0x0022, 7, 5, 3, 0, 0, 6}, // quotedbl
+    {0x0023, 10, 5, 6, 1, 0, 6}, // numbersign
+    {0x0024, 16, 4, 7, 0, 0, 5}, // dollar
+    {0x0025, 23, 5, 7, 0, 0, 6}, // percent
+    {0x0026, 30, 5, 7, 0, 0, 6}, // ampersand
+    {0x0027, 37, 2, 3, 0, 0, 3}, // quotesingle
+    {0x0028, 40, 2, 7, 0, 0, 3}, // parenleft
+    {0x0029, 47, 2, 7, 0, 0, 3}, // parenright
+    {0x002A, 54, 5, 5, 1, 0, 6}, // asterisk
+    {0x002B, 59, 5, 5, 1, 0, 6}, // plus
+    {0x002C, 64, 2, 3, 5, 0, 3}, // comma
+    {0x002D, 67, 5, 1, 3, 0, 6}, // hyphen
+    {0x002E, 68, 2, 2, 5, 0, 3}, // period
+    {0x002F, 70, 5, 5, 1, 0, 6}, // slash
+    {0x0030, 75, 5, 7, 0, 0, 6}, // zero
+    {0x0031, 82, 3, 7, 0, 0, 4}, // one
+    {0x0032, 89, 5, 7, 0, 0, 6}, // two
+    {0x0033, 96, 5, 7, 0, 0, 6}, // three
+    {0x0034, 103, 5, 7, 0, 0, 6}, // four
+    {0x0035, 110, 5, 7, 0, 0, 6}, // five
+    {0x0036, 117, 5, 7, 0, 0, 6}, // six
+    {0x0037, 124, 5, 7, 0, 0, 6}, // seven
+    {0x0038, 131, 5, 7, 0, 0, 6}, // eight
+    {0x0039, 138, 5, 7, 0, 0, 6}, // nine
+    {0x003A, 145, 2, 5, 2, 0, 3}, // colon
+    {0x003B, 150, 2, 6, 2, 0, 3}, // semicolon
+    {0x003C, 156, 4, 7, 0, 0, 5}, // less
+    {0x003D, 163, 5, 4, 2, 0, 6}, // equal
+    {0x003E, 167, 4, 7, 0, 0, 5}, // greater
+    {0x003F, 174, 5, 7, 0, 0, 6}, // question
+    {0x0040, 181, 5, 7, 0, 0, 6}, // at
+    {0x0041, 188, 5, 7, 0, 0, 6}, // A
+    {0x0042, 195, 5, 7, 0, 0, 6}, // B
+    {0x0043, 202, 5, 7, 0, 0, 6}, // C
+    {0x0044, 209, 5, 7, 0, 0, 6}, // D
+    {0x0045, 216, 5, 7, 0, 0, 6}, // E
+    {0x0046, 223, 5, 7, 0, 0, 6}, // F
+    {0x0047, 230, 5, 7, 0, 0, 6}, // G
+    {0x0048, 237, 5, 7, 0, 0, 6}, // H
+    {0x0049, 244, 3, 7, 0, 0, 4}, // I
+    {0x004A, 251, 5, 7, 0, 0, 6}, // J
+    {0x004B, 258, 5, 7, 0, 0, 6}, // K
+    {0x004C, 265, 5, 7, 0, 0, 6}, // L
+    {0x004D, 272, 5, 7, 0, 0, 6}, // M
+    {0x004E, 279, 5, 7, 0, 0, 6}, // N
+    {0x004F, 286, 5, 7, 0, 0, 6}, // O
+    {0x0050, 293, 5, 7, 0, 0, 6}, // P
+    {0x0051, 300, 5, 7, 0, 0, 6}, // Q
+    {0x0052, 307, 5, 7, 0, 0, 6}, // R
+    {0x0053, 314, 5, 7, 0, 0, 6}, // S
+    {0x0054, 321, 5, 7, 0, 0, 6}, // T
+    {0x0055, 328, 5, 7, 0, 0, 6}, // U
+    {0x0056, 335, 5, 7, 0, 0, 6}, // V
+    {0x0057, 342, 5, 7, 0, 0, 6}, // W
+    {0x0058, 349, 5, 7, 0, 0, 6}, // X
+    {0x0059, 356, 5, 7, 0, 0, 6}, // Y
+    {0x005A, 363, 4, 7, 0, 0, 5}, // Z
+    {0x005B, 370, 3, 7, 0, 0, 4}, // bracketleft
+    {0x005C, 377, 5, 5, 1, 0, 6}, // backslash
+    {0x005D, 382, 3, 7, 0, 0, 4}, // bracketright
+    {0x005E, 389, 5, 3, 0, 0, 6}, // asciicircum
+    {0x005F, 392, 6, 1, 7, 0, 7}, // underscore
+    {0x0060, 393, 2, 3, 0, 0, 3}, // grave
+    {0x0061, 396, 5, 5, 2, 0, 6}, // a
+    {0x0062, 401, 5, 7, 0, 0, 6}, // b
+    {0x0063, 408, 5, 5, 2, 0, 6}, // c
+    {0x0064, 413, 5, 7, 0, 0, 6}, // d
+    {0x0065, 420, 5, 5, 2, 0, 6}, // e
+    {0x0066, 425, 4, 7, 0, 0, 5}, // f
+    {0x0067, 432, 5, 6, 2, 0, 6}, // g
+    {0x0068, 438, 4, 7, 0, 0, 5}, // h
+    {0x0069, 445, 2, 7, 0, 0, 3}, // i
+    {0x006A, 452, 4, 8, 0, 0, 5}, // j
+    {0x006B, 460, 4, 7, 0, 0, 5}, // k
+    {0x006C, 467, 2, 7, 0, 0, 3}, // l
+    {0x006D, 474, 5, 5, 2, 0, 6}, // m
+    {0x006E, 479, 4, 5, 2, 0, 5}, // n
+    {0x006F, 484, 5, 5, 2, 0, 6}, // o
+    {0x0070, 489, 5, 6, 2, 0, 6}, // p
+    {0x0071, 495, 5, 6, 2, 0, 6}, // q
+    {0x0072, 501, 5, 5, 2, 0, 6}, // r
+    {0x0073, 506, 5, 5, 2, 0, 6}, // s
+    {0x0074, 511, 4, 6, 1, 0, 5}, // t
+    {0x0075, 517, 4, 5, 2, 0, 5}, // u
+    {0x0076, 522, 5, 5, 2, 0, 6}, // v
+    {0x0077, 527, 5, 5, 2, 0, 6}, // w
+    {0x0078, 532, 4, 5, 2, 0, 5}, // x
+    {0x0079, 537, 4, 6, 2, 0, 5}, // y
+    {0x007A, 543, 4, 5, 2, 0, 5}, // z
+    {0x007B, 548, 4, 7, 0, 0, 5}, // braceleft
+    {0x007C, 555, 1, 7, 0, 0, 2}, // bar
+    {0x007D, 562, 4, 7, 0, 0, 5}, // braceright
+    {0x007E, 569, 4, 2, 0, 0, 5}, // asciitilde
+};
+
+// the rows with ink of every glyph, back to back
+const static uint8_t prop_rows[571] = {
+    0x02, 0x07, 0x07, 0x02, 0x02, 0x00, 0x02, 0x1B, 0x1B, 0x12, 0x0A, 0x1F,
+    0x0A, 0x0A, 0x1F, 0x0A, 0x04, 0x07, 0x08, 0x06, 0x01, 0x0E, 0x02, 0x19,
+    0x19, 0x02, 0x04, 0x08, 0x13, 0x13, 0x08, 0x14, 0x14, 0x08, 0x15, 0x12,
+    0x0D, 0x03, 0x03, 0x02, 0x01, 0x02, 0x02, 0x02, 0x02, 0x02, 0x01, 0x02,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x02, 0x0A, 0x0E, 0x1F, 0x0E, 0x0A, 0x04,
+    0x04, 0x1F, 0x04, 0x04, 0x03, 0x03, 0x02, 0x1F, 0x03, 0x03, 0x01, 0x02,
+    0x04, 0x08, 0x10, 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E, 0x02, 0x06,
+    0x02, 0x02, 0x02, 0x02, 0x07, 0x0E, 0x11, 0x01, 0x06, 0x08, 0x10, 0x1F,
+    0x0E, 0x11, 0x01, 0x0E, 0x01, 0x11, 0x0E, 0x02, 0x06, 0x0A, 0x12, 0x1F,
+    0x02, 0x02, 0x1F, 0x10, 0x10, 0x1E, 0x01, 0x11, 0x0E, 0x06, 0x08, 0x10,
+    0x1E, 0x11, 0x11, 0x0E, 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x0E,
+    0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E, 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02,
+    0x0C, 0x03, 0x03, 0x00, 0x03, 0x03, 0x03, 0x03, 0x00, 0x03, 0x03, 0x02,
+    0x01, 0x02, 0x04, 0x08, 0x04, 0x02, 0x01, 0x1F, 0x00, 0x00, 0x1F, 0x08,
+    0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x0E, 0x11, 0x01, 0x06, 0x04, 0x00,
+    0x04, 0x0E, 0x11, 0x17, 0x15, 0x17, 0x10, 0x0E, 0x0E, 0x11, 0x11, 0x11,
+    0x1F, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x0E, 0x11,
+    0x10, 0x10, 0x10, 0x11, 0x0E, 0x1E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1E,
+    0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x1F, 0x10, 0x10, 0x1E, 0x10,
+    0x10, 0x10, 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F, 0x11, 0x11, 0x11,
+    0x1F, 0x11, 0x11, 0x11, 0x07, 0x02, 0x02, 0x02, 0x02, 0x02, 0x07, 0x01,
+    0x01, 0x01, 0x01, 0x11, 0x11, 0x0E, 0x11, 0x12, 0x14, 0x18, 0x14, 0x12,
+    0x11, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x11, 0x1B, 0x15, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x11, 0x0E, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x0E, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10,
+    0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D, 0x1E, 0x11, 0x11, 0x1E, 0x12,
+    0x11, 0x11, 0x0E, 0x11, 0x10, 0x0E, 0x01, 0x11, 0x0E, 0x1F, 0x04, 0x04,
+    0x04, 0x04, 0x04, 0x04, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x11,
+    0x11, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x11, 0x11, 0x15, 0x15, 0x15, 0x15,
+    0x0A, 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A,
+    0x04, 0x04, 0x04, 0x0F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x0F, 0x07, 0x04,
+    0x04, 0x04, 0x04, 0x04, 0x07, 0x10, 0x08, 0x04, 0x02, 0x01, 0x07, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x07, 0x04, 0x0A, 0x11, 0x3F, 0x03, 0x03, 0x01,
+    0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x10, 0x10, 0x1E, 0x11, 0x11, 0x11, 0x1E,
+    0x0E, 0x11, 0x10, 0x11, 0x0E, 0x01, 0x01, 0x0F, 0x11, 0x11, 0x11, 0x0F,
+    0x0E, 0x11, 0x1E, 0x10, 0x0E, 0x03, 0x04, 0x04, 0x0F, 0x04, 0x04, 0x04,
+    0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E, 0x08, 0x08, 0x0E, 0x09, 0x09, 0x09,
+    0x09, 0x02, 0x00, 0x02, 0x02, 0x02, 0x02, 0x03, 0x01, 0x00, 0x03, 0x01,
+    0x01, 0x01, 0x09, 0x06, 0x08, 0x08, 0x09, 0x0A, 0x0C, 0x0A, 0x09, 0x02,
+    0x02, 0x02, 0x02, 0x02, 0x02, 0x03, 0x1A, 0x15, 0x15, 0x11, 0x11, 0x0E,
+    0x09, 0x09, 0x09, 0x09, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x1E, 0x11, 0x11,
+    0x11, 0x1E, 0x10, 0x0F, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x16, 0x09, 0x08,
+    0x08, 0x1C, 0x0E, 0x10, 0x0E, 0x01, 0x0E, 0x04, 0x0F, 0x04, 0x04, 0x05,
+    0x02, 0x09, 0x09, 0x09, 0x0B, 0x05, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x11,
+    0x11, 0x15, 0x1F, 0x0A, 0x09, 0x09, 0x06, 0x09, 0x09, 0x09, 0x09, 0x09,
+    0x07, 0x02, 0x0C, 0x0F, 0x01, 0x06, 0x08, 0x0F, 0x03, 0x04, 0x04, 0x0C,
+    0x04, 0x04, 0x03, 0x01, 0x01, 0x01, 0x00, 0x01, 0x01, 0x01, 0x0C, 0x02,
+    0x02, 0x03, 0x02, 0x02, 0x0C, 0x05, 0x0A,
+};
+
+// kerning adjustments, sorted by left then right codepoint
+const static font_kern_t prop_kerning[42] = {
+    {0x0041, 0x0054, -1}, // AT
+    {0x0041, 0x0056, -1}, // AV
+    {0x0041, 0x0057, -1}, // AW
+    {0x0041, 0x0059, -1}, // AY
+    {0x0046, 0x0061, -1}, // Fa
+    {0x0046, 0x0065, -1}, // Fe
+    {0x0046, 0x006F, -1}, // Fo
+    {0x004C, 0x0054, -1}, // LT
+    {0x004C, 0x0056, -1}, // LV
+    {0x004C, 0x0059, -1}, // LY
+    {0x0054, 0x0041, -1}, // TA
+    {0x0054, 0x0061, -1}, // Ta
+    {0x0054, 0x0063, -1}, // Tc
+    {0x0054, 0x0065, -1}, // Te
+    {0x0054, 0x0067, -1}, // Tg
+    {0x0054, 0x006D, -1}, // Tm
+    {0x0054, 0x006E, -1}, // Tn
+    {0x0054, 0x006F, -1}, // To
+    {0x0054, 0x0070, -1}, // Tp
+    {0x0054, 0x0071, -1}, // Tq
+    {0x0054, 0x0072, -1}, // Tr
+    {0x0054, 0x0073, -1}, // Ts
+    {0x0054, 0x0075, -1}, // Tu
+    {0x0054, 0x0076, -1}, // Tv
+    {0x0054, 0x0077, -1}, // Tw
+    {0x0054, 0x0078, -1}, // Tx
+    {0x0054, 0x0079, -1}, // Ty
+    {0x0054, 0x007A, -1}, // Tz
+    {0x0056, 0x0041, -1}, // VA
+    {0x0056, 0x0061, -1}, // Va
+    {0x0056, 0x0065, -1}, // Ve
+    {0x0056, 0x006F, -1}, // Vo
+    {0x0057, 0x0041, -1}, // WA
+    {0x0057, 0x0061, -1}, // Wa
+    {0x0057, 0x0065, -1}, // We
+    {0x0057, 0x006F, -1}, // Wo
+    {0x0059, 0x0041, -1}, // YA
+    {0x0059, 0x0061, -1}, // Ya
+    {0x0059, 0x0065, -1}, // Ye
+    {0x0059, 0x006F, -1}, // Yo
+    {0x0072, 0x002C, -1}, // r,
+    {0x0072, 0x002E, -1}, // r.
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <inttypes.h>
+
+// Colors can be given as a hue, saturation and value (or lightness) as well as
+// RGB, each from `0` to `255`. They are turned into RGB once, when they are
+// parsed or change, and never per pixel.
+
+void color_from_hsv(uint8_t hue, uint8_t saturation, uint8_t value,
+                    uint8_t *red, uint8_t *green, uint8_t *blue);
+void color_from_hsl(uint8_t hue, uint8_t saturation, uint8_t lightness,
+                    uint8_t *red, uint8_t *green, uint8_t *blue);
+void color_to_hsv(uint8_t red, uint8_t green, uint8_t blue, uint8_t *hue,
+                  uint8_t *saturation, uint8_t *value);
+void color_rotate_hue(uint8_t *red, uint8_t *green, uint8_t *blue,
+                      uint8_t amount);
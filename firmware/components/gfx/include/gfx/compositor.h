@@ -0,0 +1,104 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "gfx/display_buffer.h"
+
+#define COMPOSITOR_LAYER_COUNT 3
+
+// layers are composited from the bottom up, so the overlay is always on top
+typedef enum {
+  COMPOSITOR_LAYER_BACKGROUND = 0,
+  COMPOSITOR_LAYER_CONTENT = 1,
+  COMPOSITOR_LAYER_OVERLAY = 2,
+} compositor_layer_id_t;
+
+// how a layer's pixels are combined with the layers below it. Black pixels
+// are always transparent, the same as bitmaps drawn without `draw_black`.
+typedef enum {
+  // the layer is mixed over what is below it by its opacity
+  COMPOSITOR_BLEND_NORMAL = 0,
+  // the layer, scaled by its opacity, is added to what is below it
+  COMPOSITOR_BLEND_ADD = 1,
+} compositor_blend_t;
+
+#define COMPOSITOR_OPACITY_OPAQUE 255
+
+// how the frame changes from one command list to the next
+typedef enum {
+  // the new frame is shown straight away
+  COMPOSITOR_TRANSITION_NONE = 0,
+  // the old frame fades into the new one
+  COMPOSITOR_TRANSITION_CROSSFADE = 1,
+  // an edge moves across the old frame, uncovering the new one
+  COMPOSITOR_TRANSITION_WIPE = 2,
+  // the new frame pushes the old one off the edge
+  COMPOSITOR_TRANSITION_SLIDE = 3,
+} compositor_transition_t;
+
+// the way a wipe's edge, or a slide, moves
+typedef enum {
+  COMPOSITOR_DIRECTION_LEFT = 0,
+  COMPOSITOR_DIRECTION_RIGHT = 1,
+  COMPOSITOR_DIRECTION_UP = 2,
+  COMPOSITOR_DIRECTION_DOWN = 3,
+} compositor_direction_t;
+
+// a transition's progress runs from `0` up to this
+#define COMPOSITOR_TRANSITION_DONE 256
+
+#define compositor_is_valid_layer(layer)                                       \
+  ((bool)((layer) >= 0 && (layer) < COMPOSITOR_LAYER_COUNT))
+
+#define compositor_get_layer(compositor, layer)                                \
+  ((compositor)->layers[(layer)].db)
+
+typedef struct {
+  display_buffer_handle_t db;
+  uint8_t opacity;
+  compositor_blend_t blend;
+} compositor_layer_t;
+
+// Each layer is its own display buffer that commands draw into. Composition
+// only touches the rectangles in each layer's dirty set, and the layers below
+// the overlay are kept blended together in `under`. Animating just the overlay
+// therefore costs about as much as the area that actually changed.
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+  compositor_layer_t layers[COMPOSITOR_LAYER_COUNT];
+  // every layer except the overlay, blended together
+  display_buffer_handle_t under;
+  // the final frame
+  display_buffer_handle_t output;
+  // What was shown when the running transition began, and what is shown while
+  // it runs. `output` keeps being composed as usual, and each step mixes it
+  // with `previous`. Created by the first transition.
+  display_buffer_handle_t previous;
+  display_buffer_handle_t transition;
+  // `COMPOSITOR_TRANSITION_NONE` while no transition is running
+  compositor_transition_t transition_type;
+  compositor_direction_t transition_direction;
+} compositor_t;
+
+typedef compositor_t *compositor_handle_t;
+
+esp_err_t compositor_init(compositor_handle_t *compositor_handle,
+                          uint8_t width, uint8_t height);
+void compositor_end(compositor_handle_t compositor);
+display_buffer_handle_t compositor_layer_begin(compositor_handle_t compositor,
+                                               compositor_layer_id_t layer);
+void compositor_layer_set_blend(compositor_handle_t compositor,
+                                compositor_layer_id_t layer, uint8_t opacity,
+                                compositor_blend_t blend);
+void compositor_compose(compositor_handle_t compositor,
+                        display_buffer_rect_set_t *damage);
+esp_err_t compositor_transition_begin(compositor_handle_t compositor,
+                                      compositor_transition_t type,
+                                      compositor_direction_t direction);
+display_buffer_handle_t
+compositor_transition_step(compositor_handle_t compositor, uint16_t progress);
+void compositor_transition_end(compositor_handle_t compositor);
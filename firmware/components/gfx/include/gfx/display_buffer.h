@@ -5,6 +5,8 @@
 #include <stdbool.h>
 
 #include "gfx/font.h"
+#include "gfx/palette.h"
+#include "gfx/series.h"
 
 // validates that setting an index in the buffer is not an overflow
 #define display_buffer_safe_set_value(db, index, red, green, blue)             \
@@ -16,18 +18,24 @@
     }                                                                          \
   })
 
-// moves one character and wraps if needed, but does not check that the new row
-// (y) is within range
-#define display_buffer_next_char_wrap(db)                                      \
+// moves the cursor `advance` font pixels, and wraps if another full width
+// character would not fit. Does not check that the new row (y) is within range
+#define display_buffer_advance_wrap(db, advance)                               \
   ({                                                                           \
-    if (db->cursor.x + (db->font->width * 2) + db->font->spacing <=            \
+    if (db->cursor.x + (((advance) + db->font->width + db->font->spacing) *    \
+                        db->text_scale) <=                                     \
         db->width) {                                                           \
-      db->cursor.x += db->font->width + db->font->spacing;                     \
+      db->cursor.x += (advance) * db->text_scale;                              \
     } else {                                                                   \
       display_buffer_line_feed(db);                                            \
     }                                                                          \
   })
 
+// moves one full width character and wraps if needed, but does not check that
+// the new row (y) is within range
+#define display_buffer_next_char_wrap(db)                                      \
+  display_buffer_advance_wrap(db, db->font->width + db->font->spacing)
+
 #define display_buffer_cursor_to_index(db)                                     \
   display_buffer_point_to_index(db, db->cursor.x, db->cursor.y)
 
@@ -56,9 +64,198 @@
 #define display_buffer_line_feed(db)                                           \
   ({                                                                           \
     db->cursor.x = 0;                                                          \
-    db->cursor.y += db->font->height;                                          \
+    db->cursor.y += db->font->height * db->text_scale;                         \
+  })
+
+#define display_buffer_rect_is_empty(rect)                                     \
+  ((bool)((rect)->x1 <= (rect)->x0 || (rect)->y1 <= (rect)->y0))
+
+#define display_buffer_rect_clear(rect)                                        \
+  ({                                                                           \
+    (rect)->x0 = 0;                                                            \
+    (rect)->y0 = 0;                                                            \
+    (rect)->x1 = 0;                                                            \
+    (rect)->y1 = 0;                                                            \
   })
 
+#define display_buffer_rect_set_full(db, rect)                                 \
+  ({                                                                           \
+    (rect)->x0 = 0;                                                            \
+    (rect)->y0 = 0;                                                            \
+    (rect)->x1 = (db)->width;                                                  \
+    (rect)->y1 = (db)->height;                                                 \
+  })
+
+#define display_buffer_rect_contains(rect, x, y)                               \
+  ((bool)((x) >= (rect)->x0 && (x) < (rect)->x1 && (y) >= (rect)->y0 &&        \
+          (y) < (rect)->y1))
+
+// grows `rect` so it also covers `other`
+#define display_buffer_rect_union(rect, other)                                 \
+  ({                                                                           \
+    if (display_buffer_rect_is_empty(rect)) {                                  \
+      *(rect) = *(other);                                                      \
+    } else if (!display_buffer_rect_is_empty(other)) {                         \
+      (rect)->x0 = (other)->x0 < (rect)->x0 ? (other)->x0 : (rect)->x0;        \
+      (rect)->y0 = (other)->y0 < (rect)->y0 ? (other)->y0 : (rect)->y0;        \
+      (rect)->x1 = (other)->x1 > (rect)->x1 ? (other)->x1 : (rect)->x1;        \
+      (rect)->y1 = (other)->y1 > (rect)->y1 ? (other)->y1 : (rect)->y1;        \
+    }                                                                          \
+  })
+
+// shrinks `rect` to only what is also covered by `other`
+#define display_buffer_rect_intersect(rect, other)                             \
+  ({                                                                           \
+    (rect)->x0 = (other)->x0 > (rect)->x0 ? (other)->x0 : (rect)->x0;          \
+    (rect)->y0 = (other)->y0 > (rect)->y0 ? (other)->y0 : (rect)->y0;          \
+    (rect)->x1 = (other)->x1 < (rect)->x1 ? (other)->x1 : (rect)->x1;          \
+    (rect)->y1 = (other)->y1 < (rect)->y1 ? (other)->y1 : (rect)->y1;          \
+  })
+
+#define display_buffer_rect_equal(rect, other)                                 \
+  ((bool)((rect)->x0 == (other)->x0 && (rect)->y0 == (other)->y0 &&            \
+          (rect)->x1 == (other)->x1 && (rect)->y1 == (other)->y1))
+
+// the most rectangles a dirty set keeps apart before merging them
+#define DISPLAY_BUFFER_RECT_SET_MAX 4
+
+#define display_buffer_rect_set_clear(set) ((set)->count = 0)
+
+// the most color stops a gradient fill can have
+#define DISPLAY_BUFFER_FILL_STOPS_MAX 8
+
+// the largest supported text scale factor
+#define DISPLAY_BUFFER_TEXT_SCALE_MAX 4
+
+// scale factors are fixed-point with 8 fractional bits, so this is `1×`
+#define DISPLAY_BUFFER_SCALE_ONE 256
+// the smallest scale factor supported, `1/16×`
+#define DISPLAY_BUFFER_SCALE_MIN 16
+// the largest scale factor supported, `16×`
+#define DISPLAY_BUFFER_SCALE_MAX 4096
+
+#define display_buffer_transform_is_identity(transform)                        \
+  ((bool)((transform)->scale_x == DISPLAY_BUFFER_SCALE_ONE &&                  \
+          (transform)->scale_y == DISPLAY_BUFFER_SCALE_ONE &&                  \
+          (transform)->rotation == DISPLAY_BUFFER_ROTATION_0))
+
+// clockwise rotations
+typedef enum {
+  DISPLAY_BUFFER_ROTATION_0 = 0,
+  DISPLAY_BUFFER_ROTATION_90 = 1,
+  DISPLAY_BUFFER_ROTATION_180 = 2,
+  DISPLAY_BUFFER_ROTATION_270 = 3,
+} display_buffer_rotation_t;
+
+// how a bitmap should be scaled and rotated when drawn. Scaling is applied
+// after rotation, so `scale_x` is always along the buffer's x axis.
+typedef struct {
+  uint16_t scale_x;
+  uint16_t scale_y;
+  display_buffer_rotation_t rotation;
+} display_buffer_transform_t;
+
+// A rectangle of buffer pixels, from `x0`/`y0` up to but not including
+// `x1`/`y1`. It is empty when either end is not past its start.
+typedef struct {
+  uint8_t x0;
+  uint8_t y0;
+  uint8_t x1;
+  uint8_t y1;
+} display_buffer_rect_t;
+
+// A small set of rectangles. Rectangles that touch are merged as they are
+// added, and once it is full, new ones are merged into whichever grows least.
+typedef struct {
+  display_buffer_rect_t rects[DISPLAY_BUFFER_RECT_SET_MAX];
+  uint8_t count;
+} display_buffer_rect_set_t;
+
+// describes the pixel source of a bitmap, either as separate RGB channels or
+// as packed palette indexes.
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+  // `0` for RGB channels, otherwise the bits per packed palette index
+  uint8_t bpp;
+  uint8_t *data_red;
+  uint8_t *data_green;
+  uint8_t *data_blue;
+  uint8_t *data;
+  palette_handle_t palette;
+} display_buffer_bitmap_t;
+
+typedef enum {
+  // blends between the stops along the direction
+  DISPLAY_BUFFER_FILL_GRADIENT = 0,
+  // squares that alternate between the first two stops
+  DISPLAY_BUFFER_FILL_CHECKER = 1,
+  // stripes that alternate between the first two stops along the direction
+  DISPLAY_BUFFER_FILL_STRIPES = 2,
+} display_buffer_fill_type_t;
+
+// which way the color of a fill changes
+typedef enum {
+  // from left to right
+  DISPLAY_BUFFER_FILL_HORIZONTAL = 0,
+  // from top to bottom
+  DISPLAY_BUFFER_FILL_VERTICAL = 1,
+  // from the top left to the bottom right
+  DISPLAY_BUFFER_FILL_DIAGONAL = 2,
+} display_buffer_fill_direction_t;
+
+typedef struct {
+  // where the stop is along a gradient, from `0` at the start to `255` at the
+  // end. Stops must be in order.
+  uint8_t position;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+} display_buffer_fill_stop_t;
+
+// A color that changes across what is being drawn, used in place of the
+// current color. It is stretched over each rectangle or graph, and over each
+// line of a string.
+typedef struct {
+  display_buffer_fill_type_t type;
+  display_buffer_fill_direction_t direction;
+  // the size of each square or stripe of a pattern, in pixels
+  uint8_t pattern_size;
+  uint8_t stop_count;
+  display_buffer_fill_stop_t stops[DISPLAY_BUFFER_FILL_STOPS_MAX];
+} display_buffer_fill_t;
+
+typedef enum {
+  // a solid column from the bottom up to each value
+  DISPLAY_BUFFER_GRAPH_BAR = 0,
+  // just the values, joined up between columns
+  DISPLAY_BUFFER_GRAPH_LINE = 1,
+  // a line, with the area under it filled in a dimmer color
+  DISPLAY_BUFFER_GRAPH_AREA = 2,
+} display_buffer_graph_style_t;
+
+// describes how a graph is drawn, starting at the cursor
+typedef struct {
+  uint8_t width;
+  uint8_t height;
+  display_buffer_graph_style_t style;
+  // when set, series graphs are scaled to fit the samples they show, and
+  // `scale_min`/`scale_max` are ignored
+  bool autoscale;
+  // the sample values at the bottom and top of a series graph
+  int16_t scale_min;
+  int16_t scale_max;
+  uint8_t bg_color_red;
+  uint8_t bg_color_green;
+  uint8_t bg_color_blue;
+} display_buffer_graph_t;
+
+// Fills `length` levels for one row of a block drawn with
+// `display_buffer_draw_levels`, starting at column `x` of the block. `y` is the
+// row within the block.
+typedef void (*display_buffer_levels_fn_t)(void *context, uint8_t x, uint8_t y,
+                                           uint8_t length, uint8_t *levels);
+
 typedef struct {
   uint8_t *buffer_red;
   uint8_t *buffer_green;
@@ -67,6 +264,8 @@ typedef struct {
   uint8_t height;
   uint16_t length;
   font_handle_t font;
+  // how many pixels each font pixel is drawn as, in both directions
+  uint8_t text_scale;
   // current drawing color red
   uint8_t color_red;
   // current drawing color green
@@ -77,6 +276,22 @@ typedef struct {
     uint8_t x;
     uint8_t y;
   } cursor;
+  // current palette used for indexed bitmaps. `NULL` if none has been set
+  palette_handle_t palette;
+  // when set, rectangles, graphs and text are drawn with this instead of the
+  // current color
+  const display_buffer_fill_t *fill;
+  // covers every pixel drawn since the last clear. Everything outside of it is
+  // black.
+  display_buffer_rect_t bounds;
+  // drawing never changes pixels outside of the clip, but still moves the
+  // cursor. An empty clip can be used to measure commands without drawing.
+  display_buffer_rect_t clip;
+  // covers everything each primitive would have drawn, ignoring the clip.
+  // Callers reset it to measure a group of primitives.
+  display_buffer_rect_t measured;
+  // the areas changed since the set was last cleared
+  display_buffer_rect_set_t dirty;
 } display_buffer_t;
 
 typedef display_buffer_t *display_buffer_handle_t;
@@ -84,7 +299,28 @@ typedef display_buffer_t *display_buffer_handle_t;
 esp_err_t display_buffer_init(display_buffer_handle_t *db_handle, uint8_t width,
                               uint8_t height);
 void display_buffer_end(display_buffer_handle_t db_handle);
+esp_err_t display_buffer_view_init(display_buffer_handle_t *view_handle,
+                                   display_buffer_handle_t db);
+void display_buffer_view_end(display_buffer_handle_t view);
+void display_buffer_view_begin(display_buffer_handle_t view,
+                               const display_buffer_rect_t *clip);
+void display_buffer_view_merge(display_buffer_handle_t db,
+                               display_buffer_handle_t view);
 void display_buffer_clear(display_buffer_handle_t db_handle);
+void display_buffer_clear_bounds(display_buffer_handle_t db);
+void display_buffer_clear_rect(display_buffer_handle_t db,
+                               const display_buffer_rect_t *rect);
+void display_buffer_copy_rect(display_buffer_handle_t dst,
+                              display_buffer_handle_t src,
+                              const display_buffer_rect_t *rect);
+void display_buffer_rect_set_add(display_buffer_rect_set_t *set,
+                                 const display_buffer_rect_t *rect);
+void display_buffer_reset_state(display_buffer_handle_t db);
+void display_buffer_draw_rect(display_buffer_handle_t db, uint8_t width,
+                              uint8_t height);
+void display_buffer_fill_rect(display_buffer_handle_t db, uint8_t x, uint8_t y,
+                              uint8_t width, uint8_t height, uint8_t red,
+                              uint8_t green, uint8_t blue);
 void display_buffer_draw_string(display_buffer_handle_t db, char *string);
 void display_buffer_draw_vert_line(display_buffer_handle_t db, uint8_t to);
 void display_buffer_draw_horiz_line(display_buffer_handle_t db, uint8_t to);
@@ -96,10 +332,24 @@ void display_buffer_draw_bitmap(display_buffer_handle_t db, uint8_t width,
                                 uint8_t height, uint8_t *buffer_red,
                                 uint8_t *buffer_green, uint8_t *buffer_blue,
                                 bool draw_black);
-void display_buffer_draw_graph(display_buffer_handle_t db, uint8_t width,
-                               uint8_t height, uint8_t *values,
-                               uint8_t bg_color_red, uint8_t bg_color_green,
-                               uint8_t bg_color_blue);
+void display_buffer_draw_indexed_bitmap(display_buffer_handle_t db,
+                                        uint8_t width, uint8_t height,
+                                        uint8_t bpp, uint8_t *data,
+                                        palette_handle_t palette,
+                                        bool draw_black);
+void display_buffer_draw_bitmap_transformed(
+    display_buffer_handle_t db, display_buffer_bitmap_t *bitmap,
+    display_buffer_transform_t *transform, bool draw_black);
+void display_buffer_draw_graph(display_buffer_handle_t db,
+                               display_buffer_graph_t *graph, uint8_t *values,
+                               uint16_t value_count);
+void display_buffer_draw_series(display_buffer_handle_t db,
+                                display_buffer_graph_t *graph,
+                                series_handle_t series);
+void display_buffer_draw_levels(display_buffer_handle_t db, uint8_t width,
+                                uint8_t height, palette_handle_t ramp,
+                                display_buffer_levels_fn_t levels_fn,
+                                void *context);
 void display_buffer_add_feedback(display_buffer_handle_t db,
                                  bool invalid_remote_state,
                                  bool invalid_commands,
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "gfx/display_buffer.h"
+#include "gfx/palette.h"
+
+// an effect's ramp has a color for every level
+#define EFFECT_RAMP_LENGTH 256
+// the most stars a starfield moves and plots each step
+#define EFFECT_STARS_MAX 64
+// fire rises at most this many rows each step
+#define EFFECT_FIRE_RISE_MAX 4
+
+typedef enum {
+  // overlapping sine waves, one of them warped by another
+  EFFECT_PLASMA = 0,
+  // heat that rises from the bottom row and cools as it goes
+  EFFECT_FIRE = 1,
+  // stars that fly out from the middle
+  EFFECT_STARFIELD = 2,
+  // smooth value noise drifting across the area
+  EFFECT_NOISE = 3,
+} effect_type_t;
+
+typedef struct {
+  // where the star is heading, from the middle of the area
+  int8_t x;
+  int8_t y;
+  // how far away the star is. It gets closer, and brighter, each step.
+  uint8_t z;
+} effect_star_t;
+
+// An animation that is worked out on the device each step, instead of being
+// sent as frames. Each effect gives every pixel a level from `0` to `255`,
+// using only integer maths and small tables, and the level is looked up in
+// `ramp`. Plasma and noise are worked out as each row is drawn. Fire and the
+// starfield move on in `effect_step`, and keep their levels in `levels`.
+//
+// A step costs at most one pass over the area, and drawing costs a few table
+// lookups per pixel, so an effect never costs more than the area it covers.
+typedef struct {
+  effect_type_t type;
+  uint8_t width;
+  uint8_t height;
+  // how far the effect moves each step. Fire rises this many rows, up to
+  // `EFFECT_FIRE_RISE_MAX`.
+  uint8_t speed;
+  // plasma and noise: how many pixels wide the waves and blobs are.
+  // fire: how quickly the heat cools. starfield: how many stars there are.
+  uint8_t scale;
+  // the same seed always gives the same animation
+  uint32_t seed;
+  // the state of the random number generator
+  uint32_t random;
+  // how far the plasma and noise have moved, in 1/256ths of a table entry
+  uint32_t time;
+  // the level of each pixel, for the effects that keep them
+  uint8_t *levels;
+  effect_star_t *stars;
+  palette_handle_t ramp;
+  // how long the last step took, in microseconds. Set by whoever steps it.
+  uint32_t step_us;
+} effect_t;
+
+typedef effect_t *effect_handle_t;
+
+esp_err_t effect_init(effect_handle_t *effect_handle, effect_type_t type,
+                      uint8_t width, uint8_t height);
+void effect_end(effect_handle_t effect);
+void effect_set_ramp(effect_handle_t effect,
+                     const display_buffer_fill_stop_t *stops,
+                     uint8_t stop_count);
+void effect_reset(effect_handle_t effect);
+void effect_step(effect_handle_t effect);
+void effect_draw(effect_handle_t effect, display_buffer_handle_t db);
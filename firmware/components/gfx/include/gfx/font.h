@@ -1,12 +1,15 @@
 #pragma once
 
 #include <inttypes.h>
+#include <stdbool.h>
 
 #include "esp_err.h"
 
 #define FONT_SIZE_SM 0
 #define FONT_SIZE_MD 1
 #define FONT_SIZE_LG 2
+// proportional font compiled from a BDF. See `font_prop_data.h`
+#define FONT_SIZE_PROP 3
 
 // supported ASCII range min
 #define FONT_ASCII_MIN 32
@@ -18,10 +21,18 @@
   (ascii <= FONT_ASCII_MAX && ascii >= FONT_ASCII_MIN)
 #define font_is_valid_chunk(font, ascii) ((ascii) <= (font)->chunks_per_char)
 
+// the tallest glyph of any font size
+#define FONT_HEIGHT_MAX 12
+// what malformed UTF-8 decodes to
+#define FONT_CODEPOINT_INVALID 0xFFFD
+// drawn in place of any codepoint without a glyph
+#define FONT_REPLACEMENT_CHAR '?'
+
 typedef enum {
   font_size_sm = FONT_SIZE_SM,
   font_size_md = FONT_SIZE_MD,
   font_size_lg = FONT_SIZE_LG,
+  font_size_prop = FONT_SIZE_PROP,
 } font_size_t;
 
 typedef struct {
@@ -32,11 +43,29 @@ typedef struct {
   uint8_t bits_per_chunk;
   uint8_t bits_per_char;
   uint8_t spacing;
+  // glyphs have their own width and advance, see `font_glyph_t`
+  bool proportional;
 } font_t;
 
 typedef font_t *font_handle_t;
 
+// A glyph resolved to one byte per row, with the leftmost pixel in bit
+// `width - 1`. Lives on the stack so drawing needs no allocation.
+typedef struct {
+  uint8_t rows[FONT_HEIGHT_MAX];
+  uint8_t width;
+  // pixels between the cursor and the first column
+  int8_t offset_x;
+  // pixels to move the cursor after drawing, including spacing
+  uint8_t advance;
+} font_glyph_t;
+
 esp_err_t font_init(font_handle_t *font_handle);
 void font_set_size(font_handle_t font, font_size_t size);
 void font_end(font_handle_t font);
 uint32_t font_get_chunk(font_handle_t font, char ascii, uint8_t chunk);
+uint8_t font_get_row(font_handle_t font, char ascii, uint8_t row);
+bool font_get_glyph(font_handle_t font, uint32_t codepoint,
+                    font_glyph_t *glyph);
+int8_t font_get_kerning(font_handle_t font, uint32_t left, uint32_t right);
+uint8_t font_utf8_decode(const char *string, uint32_t *codepoint);
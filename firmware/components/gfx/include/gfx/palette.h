@@ -0,0 +1,35 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+// the most entries a palette can hold. This is enough for 8 bits per pixel.
+#define PALETTE_LENGTH_MAX 256
+
+// indexed bitmaps only support bit depths that evenly divide a byte
+#define palette_is_valid_bpp(bpp)                                              \
+  ((bpp) == 1 || (bpp) == 2 || (bpp) == 4 || (bpp) == 8)
+
+// the number of bytes used by one row of packed pixels. Each row starts on a
+// new byte, so the last byte of a row may be padded.
+#define palette_row_stride(width, bpp)                                         \
+  ((uint16_t)((((uint16_t)(width) * (bpp)) + 7) / 8))
+
+// the number of bytes used by a full packed bitmap
+#define palette_data_length(width, height, bpp)                                \
+  ((uint16_t)(palette_row_stride(width, bpp) * (height)))
+
+// A color lookup table used to expand packed, indexed pixels into RGB.
+typedef struct {
+  uint16_t length;
+  uint8_t *red;
+  uint8_t *green;
+  uint8_t *blue;
+} palette_t;
+
+typedef palette_t *palette_handle_t;
+
+esp_err_t palette_init(palette_handle_t *palette_handle, uint16_t length);
+void palette_end(palette_handle_t palette);
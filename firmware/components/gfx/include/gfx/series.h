@@ -0,0 +1,38 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+// the most samples a series can hold
+#define SERIES_CAPACITY_MAX 1024
+
+// the `index`th oldest sample that the series still holds
+#define series_get(series, index)                                              \
+  ((series)->samples[((series)->head + (index)) % (series)->capacity])
+
+// A ring buffer of samples that is kept on the device between command lists,
+// so a graph can be extended with a few new samples instead of being resent in
+// full. Once it is full, each new sample replaces the oldest one.
+typedef struct {
+  int16_t *samples;
+  uint16_t capacity;
+  // how many samples are held, up to `capacity`
+  uint16_t length;
+  // where the oldest sample is in `samples`
+  uint16_t head;
+  // how many samples have ever been appended. Appends are numbered against
+  // this, so the same samples sent twice are only stored once.
+  uint32_t total;
+} series_t;
+
+typedef series_t *series_handle_t;
+
+esp_err_t series_init(series_handle_t *series_handle, uint16_t capacity);
+void series_end(series_handle_t series);
+void series_clear(series_handle_t series);
+void series_append(series_handle_t series, uint32_t start,
+                   const int16_t *samples, uint16_t count);
+void series_get_range(series_handle_t series, uint16_t from, uint16_t to,
+                      int16_t *min, int16_t *max);
@@ -0,0 +1,50 @@
+#include "esp_log.h"
+#include <memory.h>
+
+#include "gfx/palette.h"
+
+static const char *TAG = "GFX:PALETTE";
+
+// allocates all memory needed for a palette of `length` colors. All colors
+// start as black.
+esp_err_t palette_init(palette_handle_t *palette_handle, uint16_t length) {
+  if (length == 0 || length > PALETTE_LENGTH_MAX) {
+    ESP_LOGE(TAG, "Invalid palette length %u", length);
+    *palette_handle = NULL;
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  palette_handle_t palette = (palette_handle_t)malloc(sizeof(palette_t));
+  if (palette == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for palette");
+    *palette_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  palette->length = length;
+  palette->red = (uint8_t *)calloc(length, sizeof(uint8_t));
+  palette->green = (uint8_t *)calloc(length, sizeof(uint8_t));
+  palette->blue = (uint8_t *)calloc(length, sizeof(uint8_t));
+  if (palette->red == NULL || palette->green == NULL ||
+      palette->blue == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for palette colors");
+    palette_end(palette);
+    *palette_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  *palette_handle = palette;
+
+  return ESP_OK;
+}
+
+void palette_end(palette_handle_t palette) {
+  if (palette == NULL) {
+    return;
+  }
+
+  free(palette->red);
+  free(palette->green);
+  free(palette->blue);
+  free(palette);
+}
@@ -0,0 +1,107 @@
+#include "esp_log.h"
+#include <memory.h>
+
+#include "gfx/series.h"
+
+static const char *TAG = "GFX:SERIES";
+
+// allocates all memory needed for a series of up to `capacity` samples. The
+// series starts empty.
+esp_err_t series_init(series_handle_t *series_handle, uint16_t capacity) {
+  if (capacity == 0 || capacity > SERIES_CAPACITY_MAX) {
+    ESP_LOGE(TAG, "Invalid series capacity %u", capacity);
+    *series_handle = NULL;
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  series_handle_t series = (series_handle_t)malloc(sizeof(series_t));
+  if (series == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for series");
+    *series_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  series->samples = (int16_t *)malloc(capacity * sizeof(int16_t));
+  if (series->samples == NULL) {
+    ESP_LOGE(TAG, "Failed to allocate memory for series samples");
+    free(series);
+    *series_handle = NULL;
+    return ESP_ERR_NO_MEM;
+  }
+
+  series->capacity = capacity;
+  series_clear(series);
+
+  *series_handle = series;
+
+  return ESP_OK;
+}
+
+void series_end(series_handle_t series) {
+  if (series == NULL) {
+    return;
+  }
+
+  free(series->samples);
+  free(series);
+}
+
+// drops every sample, and starts numbering appends from `0` again
+void series_clear(series_handle_t series) {
+  series->length = 0;
+  series->head = 0;
+  series->total = 0;
+}
+
+// Appends `count` samples, where `start` is the number of the first one. Any
+// that the series has already seen are skipped, and a gap just continues from
+// `start`. A `start` from before everything the series holds means the sender
+// has started over, so the series does too.
+void series_append(series_handle_t series, uint32_t start,
+                   const int16_t *samples, uint16_t count) {
+  if (start < series->total - series->length) {
+    series_clear(series);
+  }
+
+  // skip the samples we already have
+  if (start < series->total) {
+    const uint32_t seen = series->total - start;
+    if (seen >= count) {
+      return;
+    }
+    samples += seen;
+    count -= seen;
+    start = series->total;
+  }
+
+  for (uint16_t i = 0; i < count; i++) {
+    if (series->length < series->capacity) {
+      series->samples[(series->head + series->length) % series->capacity] =
+          samples[i];
+      series->length++;
+    } else {
+      // full, so the oldest sample is replaced
+      series->samples[series->head] = samples[i];
+      series->head = (series->head + 1) % series->capacity;
+    }
+  }
+  series->total = start + count;
+}
+
+// finds the smallest and largest of the samples from `from` up to, but not
+// including, `to`. Both are counted from the oldest sample.
+void series_get_range(series_handle_t series, uint16_t from, uint16_t to,
+                      int16_t *min, int16_t *max) {
+  int16_t sample;
+  *min = INT16_MAX;
+  *max = INT16_MIN;
+  for (uint16_t i = from; i < to; i++) {
+    sample = series_get(series, i);
+    if (sample < *min) {
+      *min = sample;
+    }
+    if (sample > *max) {
+      *max = sample;
+    }
+  }
+}
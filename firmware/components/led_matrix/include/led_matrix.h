@@ -120,4 +120,13 @@ esp_err_t led_matrix_start(led_matrix_handle_t matrix);
 esp_err_t led_matrix_stop(led_matrix_handle_t matrix);
 esp_err_t led_matrix_end(led_matrix_handle_t matrix);
 esp_err_t led_matrix_show(led_matrix_handle_t matrix, uint8_t *buffer_red,
-                          uint8_t *buffer_green, uint8_t *buffer_blue);
\ No newline at end of file
+                          uint8_t *buffer_green, uint8_t *buffer_blue);
+esp_err_t led_matrix_show_rect(led_matrix_handle_t matrix, uint8_t *buffer_red,
+                               uint8_t *buffer_green, uint8_t *buffer_blue,
+                               uint8_t x, uint8_t y, uint8_t width,
+                               uint8_t height);
+size_t led_matrix_planes_length(led_matrix_handle_t matrix);
+void led_matrix_save_planes(led_matrix_handle_t matrix, uint8_t *planes);
+esp_err_t led_matrix_show_planes(led_matrix_handle_t matrix,
+                                 const uint8_t *planes, uint8_t x, uint8_t y,
+                                 uint8_t width, uint8_t height);
\ No newline at end of file
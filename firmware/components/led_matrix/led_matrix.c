@@ -351,11 +351,13 @@ esp_err_t led_matrix_end(led_matrix_handle_t matrix) {
   return ret;
 }
 
-// Shows a `buffer` in the `matrix`.
-// this performs the work to convert from 8-bit per channel RGB to the
-// bit-packed format needed for the matrix driver.
-esp_err_t led_matrix_show(led_matrix_handle_t matrix, uint8_t *buffer_red,
-                          uint8_t *buffer_green, uint8_t *buffer_blue) {
+// Converts half-rows `rowStart` to `rowEnd` and columns `colStart` to `colEnd`
+// into the bit-packed format needed for the matrix driver. Each half-row holds
+// a row from the top half of the buffer and its pair from the bottom half.
+static void convert_rows(led_matrix_handle_t matrix, uint8_t *buffer_red,
+                         uint8_t *buffer_green, uint8_t *buffer_blue,
+                         uint8_t rowStart, uint8_t rowEnd, uint8_t colStart,
+                         uint8_t colEnd) {
   uint16_t rowAndBitOffset;
   uint16_t rowOffset;
   uint8_t row;
@@ -366,10 +368,10 @@ esp_err_t led_matrix_show(led_matrix_handle_t matrix, uint8_t *buffer_red,
   // actively drawn to while this is happening, there may be visual glitches.
   // but these glitches should be minimal since this runs fairly quickly.
   for (bitNum = 0; bitNum < LED_MATRIX_BIT_DEPTH; bitNum++) {
-    for (row = 0; row < matrix->halfHeight; row++) {
+    for (row = rowStart; row < rowEnd; row++) {
       rowOffset = (row * matrix->width);
       rowAndBitOffset = rowOffset + (bitNum * matrix->width * matrix->height);
-      for (col = 0; col < matrix->width; col++) {
+      for (col = colStart; col < colEnd; col++) {
         SET_MATRIX_BYTE(
             // put the value into the variable
             matrix->buffer[rowAndBitOffset + col],
@@ -388,6 +390,102 @@ esp_err_t led_matrix_show(led_matrix_handle_t matrix, uint8_t *buffer_red,
       }
     }
   }
+}
+
+// Shows a `buffer` in the `matrix`.
+// this performs the work to convert from 8-bit per channel RGB to the
+// bit-packed format needed for the matrix driver.
+esp_err_t led_matrix_show(led_matrix_handle_t matrix, uint8_t *buffer_red,
+                          uint8_t *buffer_green, uint8_t *buffer_blue) {
+  return led_matrix_show_rect(matrix, buffer_red, buffer_green, buffer_blue, 0,
+                              0, matrix->width, matrix->height);
+}
+
+// The same as `led_matrix_show`, but only converts the part of `buffer` that is
+// within a rectangle. Everything else is left showing what it was before.
+esp_err_t led_matrix_show_rect(led_matrix_handle_t matrix, uint8_t *buffer_red,
+                               uint8_t *buffer_green, uint8_t *buffer_blue,
+                               uint8_t x, uint8_t y, uint8_t width,
+                               uint8_t height) {
+  const uint8_t colEnd = MIN(x + width, matrix->width);
+  const uint8_t rowEnd = MIN(y + height, matrix->height);
+  if (x >= colEnd || y >= rowEnd) {
+    return ESP_OK;
+  }
+
+  // the half-rows that the top and bottom halves of the rectangle land in
+  const uint8_t topStart = MIN(y, matrix->halfHeight);
+  const uint8_t topEnd = MIN(rowEnd, matrix->halfHeight);
+  const uint8_t bottomStart = MAX(y, matrix->halfHeight) - matrix->halfHeight;
+  const uint8_t bottomEnd =
+      MAX(rowEnd, matrix->halfHeight) - matrix->halfHeight;
+
+  if (topStart >= topEnd) {
+    convert_rows(matrix, buffer_red, buffer_green, buffer_blue, bottomStart,
+                 bottomEnd, x, colEnd);
+  } else if (bottomStart >= bottomEnd) {
+    convert_rows(matrix, buffer_red, buffer_green, buffer_blue, topStart,
+                 topEnd, x, colEnd);
+  } else if (bottomStart <= topEnd && topStart <= bottomEnd) {
+    // the halves overlap, so convert them together
+    convert_rows(matrix, buffer_red, buffer_green, buffer_blue,
+                 MIN(topStart, bottomStart), MAX(topEnd, bottomEnd), x,
+                 colEnd);
+  } else {
+    convert_rows(matrix, buffer_red, buffer_green, buffer_blue, topStart,
+                 topEnd, x, colEnd);
+    convert_rows(matrix, buffer_red, buffer_green, buffer_blue, bottomStart,
+                 bottomEnd, x, colEnd);
+  }
+
+  return ESP_OK;
+}
+
+// the size of the bit-packed buffer that the matrix is driven from
+size_t led_matrix_planes_length(led_matrix_handle_t matrix) {
+  return sizeof(uint8_t) * matrix->width * matrix->height *
+         LED_MATRIX_BIT_DEPTH;
+}
+
+// Copies what the matrix is showing, already converted, into `planes`, which
+// is `led_matrix_planes_length` bytes. It can be anywhere, such as in PSRAM.
+void led_matrix_save_planes(led_matrix_handle_t matrix, uint8_t *planes) {
+  memcpy(planes, matrix->buffer, led_matrix_planes_length(matrix));
+}
+
+// Shows planes from `led_matrix_save_planes` again, without converting them.
+// Only the half-rows with a part of the rectangle in them are copied, so the
+// rest has to be showing the same already. The matrix isn't pointed at
+// `planes` instead, since the interrupt handler needs its buffer in IRAM.
+esp_err_t led_matrix_show_planes(led_matrix_handle_t matrix,
+                                 const uint8_t *planes, uint8_t x, uint8_t y,
+                                 uint8_t width, uint8_t height) {
+  const uint8_t colEnd = MIN(x + width, matrix->width);
+  const uint8_t rowEnd = MIN(y + height, matrix->height);
+  if (x >= colEnd || y >= rowEnd) {
+    return ESP_OK;
+  }
+
+  // the half-rows that either half of the rectangle lands in. A rectangle
+  // across the middle covers all of them.
+  uint8_t rowStart = 0;
+  uint8_t halfRowEnd = matrix->halfHeight;
+  if (rowEnd <= matrix->halfHeight) {
+    rowStart = y;
+    halfRowEnd = rowEnd;
+  } else if (y >= matrix->halfHeight) {
+    rowStart = y - matrix->halfHeight;
+    halfRowEnd = rowEnd - matrix->halfHeight;
+  }
+
+  uint32_t offset;
+  for (uint8_t bitNum = 0; bitNum < LED_MATRIX_BIT_DEPTH; bitNum++) {
+    for (uint8_t row = rowStart; row < halfRowEnd; row++) {
+      offset =
+          (row * matrix->width) + (bitNum * matrix->width * matrix->height);
+      memcpy(matrix->buffer + offset + x, planes + offset + x, colEnd - x);
+    }
+  }
 
   return ESP_OK;
-}
\ No newline at end of file
+}
@@ -38,6 +38,14 @@ static esp_err_t event_handler(esp_http_client_event_t *evt) {
     ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
 
     fetch_ctx_handle_t ctx = evt->user_data;
+    if (ctx->on_data != NULL) {
+      // the body of a redirect or an error isn't what the caller is reading
+      if (esp_http_client_get_status_code(evt->client) >= 300) {
+        break;
+      }
+      return ctx->on_data(evt->data, evt->data_len, ctx->on_data_arg);
+    }
+
     if (ctx->response->data == NULL) {
       // if there's no data on the response yet, allocate the buffer
       // don't worry about null terminator here, it will be added on
@@ -145,6 +153,10 @@ esp_err_t fetch_init(fetch_ctx_handle_t *ctx_handle) {
   ctx->response->length = 0;
   ctx->response->etag = NULL;
   ctx->etag = NULL;
+  ctx->accept = NULL;
+  ctx->assets = NULL;
+  ctx->on_data = NULL;
+  ctx->on_data_arg = NULL;
 
   *ctx_handle = ctx;
   return ESP_OK;
@@ -178,6 +190,14 @@ esp_err_t fetch_perform(fetch_ctx_handle_t ctx) {
     esp_http_client_set_header(client, "If-None-Match", ctx->etag);
   }
 
+  if (ctx->accept != NULL) {
+    esp_http_client_set_header(client, "Accept", ctx->accept);
+  }
+
+  if (ctx->assets != NULL && ctx->assets[0] != '\0') {
+    esp_http_client_set_header(client, "X-Assets", ctx->assets);
+  }
+
   esp_http_client_set_header(client, "Authorization",
                              "Bearer: " CONFIG_ENDPOINT_TOKEN);
 
@@ -8,7 +8,8 @@
 typedef struct {
   // the length of the data buffer
   size_t length;
-  // the response data. Likely JSON.
+  // the response data. Likely JSON, or a binary format that was asked for
+  // with `accept`.
   char *data;
   // the HTTP status code
   int status_code;
@@ -17,12 +18,28 @@ typedef struct {
   char *etag;
 } fetch_response_data_t;
 
+// called with each chunk of a response's body as it arrives
+typedef esp_err_t (*fetch_on_data_t)(const char *data, size_t length,
+                                     void *arg);
+
 typedef struct {
   char *url;
   esp_http_client_method_t method;
   fetch_response_data_t *response;
   // optional ETag for conditional requests
   char *etag;
+  // optional `Accept` header, for endpoints that can answer in more than one
+  // format. This is not freed by `fetch_end`.
+  const char *accept;
+  // optional `X-Assets` header, the hashes of the bitmaps the client already
+  // has, which the server can refer to instead of sending them again. This is
+  // not freed by `fetch_end`.
+  const char *assets;
+  // optional. If set, the body of a successful response is handed to it a
+  // chunk at a time instead of being kept in `response->data`, so that it can
+  // be parsed as it arrives.
+  fetch_on_data_t on_data;
+  void *on_data_arg;
 } fetch_ctx_t;
 
 typedef fetch_ctx_t *fetch_ctx_handle_t;
@@ -1,18 +1,38 @@
 import { NextRequest } from "next/server"
 import { main } from "@/main"
+import {
+  assetsHeader,
+  commandWireContentType,
+  encodeCommands,
+  parseAssetsHeader,
+  referAssets,
+} from "@/lib"
 import { createHash } from "node:crypto"
 
 export async function GET(request: NextRequest) {
   const commands = await main()
 
-  // create a ETag of that data
+  // the device asks for the binary format, which is much smaller for bitmaps
+  const isBinary =
+    request.headers.get("Accept")?.includes(commandWireContentType) ?? false
+  // and lists the bitmaps it already has, which only need their hash sent
+  const assets = parseAssetsHeader(request.headers.get(assetsHeader))
+  const encode = (known: Set<string>) =>
+    isBinary
+      ? encodeCommands(commands, known)
+      : JSON.stringify(referAssets(commands, known))
+  const fullBody = encode(new Set())
+
+  // create a ETag of that data. It's of the full commands, so that it doesn't
+  // change with the bitmaps the device has.
   const hash = createHash("md5")
-  hash.update(JSON.stringify(commands))
+  hash.update(fullBody)
   const etag = hash.digest("hex")
 
   const headers = new Headers()
   headers.set("Cache-Control", "no-cache")
   headers.set("ETag", etag)
+  headers.set("Vary", `Accept, ${assetsHeader}`)
 
   // check if the client already has the data
   const incomingEtag = request.headers.get("If-None-Match")
@@ -23,7 +43,12 @@ export async function GET(request: NextRequest) {
     })
   }
 
-  return Response.json(commands, {
+  headers.set(
+    "Content-Type",
+    isBinary ? commandWireContentType : "application/json"
+  )
+  const body = assets.size > 0 ? encode(assets) : fullBody
+  return new Response(body, {
     headers: headers,
   })
 }
@@ -5,9 +5,14 @@ import { BitmapComponent } from "@/components/Bitmap"
 import {
   Bitmap,
   CommandApiResponse,
+  CommandEffect,
+  EffectState,
   createBitmap,
   drawCommands,
   createNewAnimationsState,
+  hasTweens,
+  shortestFrameDuration,
+  tweenTickMs,
 } from "@/lib"
 
 export const AnimatedBitmap = ({ commands, config }: CommandApiResponse) => {
@@ -15,18 +20,43 @@ export const AnimatedBitmap = ({ commands, config }: CommandApiResponse) => {
 
   useEffect(() => {
     const allAnimationStates = createNewAnimationsState(commands)
+    const effects = new Map<CommandEffect, EffectState>()
+    // like the device, tick faster for tweens and animations with their own
+    // time, but only move the rest of the animations and effects on once per
+    // animation delay
+    const isTweening = hasTweens(commands)
+    const tickMs = Math.min(
+      shortestFrameDuration(commands, config.animationDelay),
+      isTweening ? tweenTickMs : config.animationDelay
+    )
+    const isTickingFast = tickMs < config.animationDelay
+    const shownAt = Date.now()
+    let nextStep = shownAt
     const applyBitmap = () => {
+      const now = Date.now()
+      const step = !isTickingFast || now >= nextStep
+      if (step) {
+        nextStep += config.animationDelay
+        if (nextStep <= now) {
+          nextStep = now + config.animationDelay
+        }
+      }
+
       const newBitmap = createBitmap(64, 64)
       const updateBitmap = drawCommands({
         bitmap: newBitmap,
         commands,
         allAnimationStates,
+        effects,
+        elapsed: now - shownAt,
+        step,
+        animationDelay: config.animationDelay,
       })
 
       setBitmap(updateBitmap)
     }
 
-    const intTime = setInterval(applyBitmap, config.animationDelay)
+    const intTime = setInterval(applyBitmap, tickMs)
     applyBitmap()
 
     return () => {
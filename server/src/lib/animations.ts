@@ -15,3 +15,69 @@ export const createNewAnimationsState = (
   })
   return allAnimationsState
 }
+
+// the same limits as the device
+const minFrameDuration = 5
+const maxFrameDuration = 65535
+const maxSkippedFrames = 8
+
+/** How long a frame of an animation is shown for, in milliseconds */
+const frameDuration = (
+  durations: number[],
+  frame: number,
+  delay: number
+): number =>
+  Math.min(
+    Math.max(durations[frame] ?? delay, minFrameDuration),
+    maxFrameDuration
+  )
+
+/**
+ * How many frames an animation with its own time moves on by at `elapsed`
+ * milliseconds, as on the device. Frames that are already over are skipped,
+ * unless it's so far behind that it carries on from `elapsed` instead.
+ */
+export const animationFramesDue = (
+  state: AnimationState,
+  durations: number[],
+  elapsed: number,
+  delay: number
+): number => {
+  let frames = 0
+  let nextFrameAt = state.nextFrameAt ?? elapsed
+  while (elapsed >= nextFrameAt) {
+    frames++
+    const frame = (state.lastShowFrame + frames) % state.frameCount
+    nextFrameAt += frameDuration(durations, frame, delay)
+    if (frames === maxSkippedFrames && elapsed >= nextFrameAt) {
+      nextFrameAt = elapsed + frameDuration(durations, frame, delay)
+    }
+  }
+  state.nextFrameAt = nextFrameAt
+  return frames
+}
+
+/**
+ * The shortest time any frame is shown for, which the preview has to tick at
+ * least as often as
+ */
+export const shortestFrameDuration = (
+  commands: Command[],
+  animationDelay: number
+): number =>
+  commands.reduce(
+    (shortest, command) =>
+      command.type === "animation" && (command.durations || command.delay)
+        ? Math.min(
+            shortest,
+            ...command.frames.map((_, frame) =>
+              frameDuration(
+                command.durations ?? [],
+                frame,
+                command.delay ?? animationDelay
+              )
+            )
+          )
+        : shortest,
+    animationDelay
+  )
@@ -0,0 +1,105 @@
+import { encodeQoi, indexedRowStride } from "./bitmaps"
+import type {
+  Command,
+  CommandApiResponse,
+  CommandBitmap,
+  CommandIndexedBitmap,
+} from "./types"
+
+/** Where the device lists the hashes of the bitmaps it already has */
+export const assetsHeader = "X-Assets"
+
+// 64-bit FNV-1a, the same as the device
+const hashOffset = BigInt("0xcbf29ce484222325")
+const hashPrime = BigInt("0x100000001b3")
+
+/** The hash of some bytes, as the 16 hex digits the device knows it by */
+export const assetHash = (bytes: Uint8Array): string => {
+  let hash = hashOffset
+  for (const byte of bytes) {
+    hash = BigInt.asUintN(64, (hash ^ BigInt(byte)) * hashPrime)
+  }
+  return hash.toString(16).padStart(16, "0")
+}
+
+/**
+ * The bytes the device keeps of a bitmap's data. Each channel of a bitmap is
+ * padded to the full size, and an indexed bitmap is cut to its size.
+ */
+export const assetBytes = (
+  command: CommandBitmap | CommandIndexedBitmap
+): Uint8Array => {
+  const { width, height } = command.size
+  if (command.type === "indexed-bitmap") {
+    const bytes = new Uint8Array(
+      indexedRowStride(width, command.bitsPerPixel) * height
+    )
+    bytes.set(command.data.slice(0, bytes.length))
+    return bytes
+  }
+
+  const bytes = new Uint8Array(3 * width * height)
+  const { red, green, blue } = command.data
+  bytes.set(red.slice(0, width * height))
+  bytes.set(green.slice(0, width * height), width * height)
+  bytes.set(blue.slice(0, width * height), 2 * width * height)
+  return bytes
+}
+
+/** The hashes the device sent, which can be referred to instead of the data */
+export const parseAssetsHeader = (header: string | null): Set<string> =>
+  new Set(
+    (header ?? "")
+      .split(",")
+      .map((hash) => hash.trim().toLowerCase())
+      .filter((hash) => /^[0-9a-f]{16}$/.test(hash))
+  )
+
+const toBase64 = (bytes: Uint8Array): string => {
+  let binary = ""
+  for (const byte of bytes) {
+    binary += String.fromCharCode(byte)
+  }
+  return btoa(binary)
+}
+
+const referCommand = (command: Command, assets: Set<string>): object => {
+  switch (command.type) {
+    case "bitmap":
+    case "indexed-bitmap":
+      const asset = assetHash(assetBytes(command))
+      if (assets.has(asset)) {
+        return { ...command, data: { asset } }
+      }
+      // indexed bitmaps are already packed, and small enough as they are
+      return command.type === "bitmap"
+        ? {
+            ...command,
+            data: { encoding: "qoi", base64: toBase64(encodeQoi(command)) },
+          }
+        : command
+    case "animation":
+      return {
+        ...command,
+        frames: command.frames.map((frame) =>
+          frame.map((frameCommand) => referCommand(frameCommand, assets))
+        ),
+      }
+    default:
+      return command
+  }
+}
+
+/**
+ * Replaces the data of each bitmap that the device already has with its hash,
+ * so the icons that are in every response are only sent once. The rest of the
+ * full color bitmaps are sent as QOI images, which are a fraction of the size
+ * of arrays of numbers.
+ */
+export const referAssets = (
+  response: CommandApiResponse,
+  assets: Set<string>
+): object => ({
+  ...response,
+  commands: response.commands.map((command) => referCommand(command, assets)),
+})
@@ -1,4 +1,13 @@
-import type { Bitmap } from "./types"
+import type {
+  BitmapTransform,
+  BitsPerPixel,
+  Bitmap,
+  BlendMode,
+  ColorRGB,
+  IndexedBitmap,
+  Layer,
+  Size,
+} from "./types"
 
 export const cloneBitmap = (bitmap: Bitmap): Bitmap => ({
   size: { ...bitmap.size },
@@ -81,3 +90,279 @@ export const mergeBitmaps = ({
       }),
     base
   )
+
+const blendChannel = (
+  base: number,
+  value: number,
+  alpha: number,
+  blend: BlendMode
+) =>
+  blend === "add"
+    ? Math.min(base + ((value * alpha) >> 8), 255)
+    : (value * alpha + base * (256 - alpha)) >> 8
+
+/**
+ * Blends layers from the bottom up, the same as the firmware's compositor.
+ * Black pixels are transparent.
+ */
+export const compositeLayers = ({
+  size,
+  layers,
+}: {
+  size: Size
+  layers: Layer[]
+}): Bitmap => {
+  const output = createBitmap(size.width, size.height)
+  for (const { bitmap, opacity, blend } of layers) {
+    // maps 0-255 to 0-256, so opaque layers are copied exactly
+    const alpha = opacity + (opacity >> 7)
+    if (alpha === 0) {
+      continue
+    }
+
+    for (let index = 0; index < size.width * size.height; index++) {
+      const red = bitmap.data.red[index]!
+      const green = bitmap.data.green[index]!
+      const blue = bitmap.data.blue[index]!
+      if (red === 0 && green === 0 && blue === 0) {
+        continue
+      }
+
+      const { data } = output
+      data.red[index] = blendChannel(data.red[index]!, red, alpha, blend)
+      data.green[index] = blendChannel(data.green[index]!, green, alpha, blend)
+      data.blue[index] = blendChannel(data.blue[index]!, blue, alpha, blend)
+    }
+  }
+
+  return output
+}
+
+const bitsPerPixelOptions: BitsPerPixel[] = [1, 2, 4, 8]
+
+/** The number of bytes used by one row of packed pixels */
+export const indexedRowStride = (width: number, bitsPerPixel: BitsPerPixel) =>
+  Math.ceil((width * bitsPerPixel) / 8)
+
+/**
+ * Converts a bitmap into packed palette indexes, using the smallest bit depth
+ * that can hold all of its colors. Black is always palette index `0`.
+ */
+export const indexBitmap = (bitmap: Bitmap): IndexedBitmap => {
+  const palette: ColorRGB[] = [{ red: 0, green: 0, blue: 0 }]
+  const paletteLookup = new Map<string, number>([["0,0,0", 0]])
+  const indexes = bitmap.data.red.map((red, i) => {
+    const green = bitmap.data.green[i]
+    const blue = bitmap.data.blue[i]
+    const key = `${red},${green},${blue}`
+    let index = paletteLookup.get(key)
+    if (index === undefined) {
+      index = palette.length
+      palette.push({ red, green, blue })
+      paletteLookup.set(key, index)
+    }
+    return index
+  })
+
+  const bitsPerPixel = bitsPerPixelOptions.find(
+    (bpp) => palette.length <= 1 << bpp
+  )
+  if (!bitsPerPixel) {
+    throw new Error(`Too many colors to index: ${palette.length}`)
+  }
+
+  const stride = indexedRowStride(bitmap.size.width, bitsPerPixel)
+  const data: number[] = new Array(stride * bitmap.size.height).fill(0)
+  for (let y = 0; y < bitmap.size.height; y++) {
+    for (let x = 0; x < bitmap.size.width; x++) {
+      const bitOffset = x * bitsPerPixel
+      const byteIndex = y * stride + Math.floor(bitOffset / 8)
+      const shift = 8 - bitsPerPixel - (bitOffset % 8)
+      data[byteIndex] |= indexes[y * bitmap.size.width + x] << shift
+    }
+  }
+
+  return {
+    size: { ...bitmap.size },
+    bitsPerPixel,
+    data,
+    palette,
+  }
+}
+
+/**
+ * Expands packed palette indexes back into a full bitmap. Out of range indexes
+ * are treated as black, the same as the firmware.
+ */
+export const expandIndexedBitmap = ({
+  size,
+  bitsPerPixel,
+  data,
+  palette,
+}: {
+  size: Size
+  bitsPerPixel: BitsPerPixel
+  data: number[]
+  palette: ColorRGB[]
+}): Bitmap => {
+  const bitmap = createBitmap(size.width, size.height)
+  const stride = indexedRowStride(size.width, bitsPerPixel)
+  const mask = (1 << bitsPerPixel) - 1
+
+  for (let y = 0; y < size.height; y++) {
+    for (let x = 0; x < size.width; x++) {
+      const bitOffset = x * bitsPerPixel
+      const packed = data[y * stride + Math.floor(bitOffset / 8)] ?? 0
+      const index = (packed >> (8 - bitsPerPixel - (bitOffset % 8))) & mask
+      const color = palette[index]
+      if (!color) {
+        continue
+      }
+
+      bitmap.data.red[y * size.width + x] = color.red
+      bitmap.data.green[y * size.width + x] = color.green
+      bitmap.data.blue[y * size.width + x] = color.blue
+    }
+  }
+
+  return bitmap
+}
+
+/** Scale factors are sent as floats, but the firmware uses 8.8 fixed-point */
+const toFixedScale = (scale: number) =>
+  Math.min(Math.max(Math.round(scale * 256), 16), 4096)
+
+/**
+ * Applies a nearest-neighbour scale and clockwise rotation to a bitmap, using
+ * the same fixed-point stepping as the firmware so previews match exactly.
+ */
+export const transformBitmap = (
+  bitmap: Bitmap,
+  { scale = 1, rotation = 0 }: BitmapTransform
+): Bitmap => {
+  const scaleX = toFixedScale(typeof scale === "number" ? scale : scale.x)
+  const scaleY = toFixedScale(typeof scale === "number" ? scale : scale.y)
+  if (scaleX === 256 && scaleY === 256 && rotation === 0) {
+    return bitmap
+  }
+
+  const { width, height } = bitmap.size
+  const isQuarterTurn = rotation === 90 || rotation === 270
+  const rotatedWidth = isQuarterTurn ? height : width
+  const rotatedHeight = isQuarterTurn ? width : height
+  const destWidth = Math.max(Math.floor((rotatedWidth * scaleX) / 256), 1)
+  const destHeight = Math.max(Math.floor((rotatedHeight * scaleY) / 256), 1)
+  const stepU = Math.floor((rotatedWidth << 16) / destWidth)
+  const stepV = Math.floor((rotatedHeight << 16) / destHeight)
+  const sourceMaxX = (width << 16) - 1
+  const sourceMaxY = (height << 16) - 1
+
+  const result = createBitmap(destWidth, destHeight)
+  for (let y = 0; y < destHeight; y++) {
+    const v = (stepV >> 1) + y * stepV
+    for (let x = 0; x < destWidth; x++) {
+      const u = (stepU >> 1) + x * stepU
+      const [sourceX, sourceY] =
+        rotation === 90
+          ? [v, sourceMaxY - u]
+          : rotation === 180
+            ? [sourceMaxX - u, sourceMaxY - v]
+            : rotation === 270
+              ? [sourceMaxX - v, u]
+              : [u, v]
+      const sourceIndex = (sourceY >> 16) * width + (sourceX >> 16)
+      result.data.red[y * destWidth + x] = bitmap.data.red[sourceIndex]
+      result.data.green[y * destWidth + x] = bitmap.data.green[sourceIndex]
+      result.data.blue[y * destWidth + x] = bitmap.data.blue[sourceIndex]
+    }
+  }
+
+  return result
+}
+
+// the same as `QOI_INDEX_COUNT` and the ops in the firmware's "qoi.c"
+const qoiIndexCount = 64
+const qoiOpIndex = 0x00
+const qoiOpDiff = 0x40
+const qoiOpLuma = 0x80
+const qoiOpRun = 0xc0
+const qoiOpRgb = 0xfe
+const qoiRunMax = 62
+const qoiEnd = [0, 0, 0, 0, 0, 0, 0, 1]
+
+/**
+ * Compresses a bitmap as a QOI image, which the device decodes straight into
+ * the bitmap it draws. Flat areas and gradients shrink the most.
+ */
+export const encodeQoi = (bitmap: Bitmap): Uint8Array => {
+  const { width, height } = bitmap.size
+  const bytes: number[] = [0x71, 0x6f, 0x69, 0x66]
+  for (const value of [width, height]) {
+    bytes.push((value >>> 24) & 0xff, (value >> 16) & 0xff)
+    bytes.push((value >> 8) & 0xff, value & 0xff)
+  }
+  // RGB, in the sRGB colorspace
+  bytes.push(3, 0)
+
+  // pixels are opaque, so alpha is left out of the colors here
+  const index: (number | undefined)[] = new Array(qoiIndexCount)
+  let [red, green, blue] = [0, 0, 0]
+  let run = 0
+  const pixelCount = width * height
+  for (let i = 0; i < pixelCount; i++) {
+    const [nextRed, nextGreen, nextBlue] = [
+      bitmap.data.red[i] ?? 0,
+      bitmap.data.green[i] ?? 0,
+      bitmap.data.blue[i] ?? 0,
+    ]
+    if (nextRed === red && nextGreen === green && nextBlue === blue) {
+      run++
+      if (run === qoiRunMax || i === pixelCount - 1) {
+        bytes.push(qoiOpRun | (run - 1))
+        run = 0
+      }
+      continue
+    }
+    if (run > 0) {
+      bytes.push(qoiOpRun | (run - 1))
+      run = 0
+    }
+
+    const color = (nextRed << 16) | (nextGreen << 8) | nextBlue
+    const hash =
+      (nextRed * 3 + nextGreen * 5 + nextBlue * 7 + 255 * 11) % qoiIndexCount
+    // differences wrap around, as they do when the device adds them
+    const wrap = (value: number) => ((value + 128) & 0xff) - 128
+    const diffRed = wrap(nextRed - red)
+    const diffGreen = wrap(nextGreen - green)
+    const diffBlue = wrap(nextBlue - blue)
+    const lumaRed = diffRed - diffGreen
+    const lumaBlue = diffBlue - diffGreen
+    if (index[hash] === color) {
+      bytes.push(qoiOpIndex | hash)
+    } else if (
+      [diffRed, diffGreen, diffBlue].every((diff) => diff >= -2 && diff <= 1)
+    ) {
+      bytes.push(
+        qoiOpDiff |
+          ((diffRed + 2) << 4) |
+          ((diffGreen + 2) << 2) |
+          (diffBlue + 2)
+      )
+    } else if (
+      diffGreen >= -32 &&
+      diffGreen <= 31 &&
+      [lumaRed, lumaBlue].every((diff) => diff >= -8 && diff <= 7)
+    ) {
+      bytes.push(qoiOpLuma | (diffGreen + 32))
+      bytes.push(((lumaRed + 8) << 4) | (lumaBlue + 8))
+    } else {
+      bytes.push(qoiOpRgb, nextRed, nextGreen, nextBlue)
+    }
+    index[hash] = color
+    ;[red, green, blue] = [nextRed, nextGreen, nextBlue]
+  }
+
+  bytes.push(...qoiEnd)
+  return Uint8Array.from(bytes)
+}
@@ -0,0 +1,103 @@
+import type { Color, ColorHSV, ColorRGB, Fill, FillStop } from "./types"
+
+// the same integer maths as the device, so the preview matches it exactly
+
+/** The color at each of the 256 steps around the color wheel */
+const hueTable: ColorRGB[] = Array.from({ length: 256 }, (_, hue) => {
+  const channel = (offset: number) => {
+    const around = (offset + (hue * 6) / 256) % 6
+    return Math.round(255 - 255 * Math.max(0, Math.min(around, 4 - around, 1)))
+  }
+  return { red: channel(5), green: channel(3), blue: channel(1) }
+})
+
+/** `a * b / 255`, rounded */
+const mul8 = (a: number, b: number) => {
+  const product = a * b + 128
+  return (product + (product >> 8)) >> 8
+}
+
+const fromHSV = ({ hue, saturation, value }: ColorHSV): ColorRGB => {
+  const full = hueTable[hue & 0xff]!
+  const channel = (key: keyof ColorRGB) =>
+    mul8(value & 0xff, 255 - mul8(saturation & 0xff, 255 - full[key]))
+  return {
+    red: channel("red"),
+    green: channel("green"),
+    blue: channel("blue"),
+  }
+}
+
+const toHSV = ({ red, green, blue }: ColorRGB): ColorHSV => {
+  const max = Math.max(red, green, blue)
+  const delta = max - Math.min(red, green, blue)
+  if (delta === 0) {
+    return { hue: 0, saturation: 0, value: max }
+  }
+
+  // how far around the wheel the hue is, with 256 steps between each of red,
+  // yellow, green, cyan, blue and magenta
+  let around: number
+  if (max === red) {
+    around = Math.trunc(((green - blue) * 256) / delta)
+  } else if (max === green) {
+    around = 512 + Math.trunc(((blue - red) * 256) / delta)
+  } else {
+    around = 1024 + Math.trunc(((red - green) * 256) / delta)
+  }
+  if (around < 0) {
+    around += 1536
+  }
+  return {
+    hue: Math.floor((around * 256 + 768) / 1536) & 0xff,
+    saturation: Math.floor((delta * 255 + Math.floor(max / 2)) / max),
+    value: max,
+  }
+}
+
+/** Turns any color into RGB, as the device does when it parses it */
+export const toRGB = (color: Color): ColorRGB => {
+  if ("lightness" in color) {
+    const lightness = color.lightness & 0xff
+    const value =
+      lightness +
+      mul8(color.saturation & 0xff, Math.min(lightness, 255 - lightness))
+    const saturation =
+      value > 0
+        ? Math.min(
+            Math.floor(
+              (2 * (value - lightness) * 255 + Math.floor(value / 2)) / value
+            ),
+            255
+          )
+        : 0
+    return fromHSV({ hue: color.hue, saturation, value })
+  }
+  if ("hue" in color) {
+    return fromHSV(color)
+  }
+  return color
+}
+
+/**
+ * Turns a color `amount` steps around the color wheel, out of 256, keeping its
+ * saturation and value
+ */
+export const rotateHue = (color: ColorRGB, amount: number): ColorRGB => {
+  if ((amount & 0xff) === 0) {
+    return color
+  }
+  const hsv = toHSV(color)
+  return fromHSV({ ...hsv, hue: (hsv.hue + amount) & 0xff })
+}
+
+/** A fill with each of its stops turned into RGB, and then rotated */
+export const resolveFill = (fill: Fill, hueRotate = 0): Fill<ColorRGB> => ({
+  ...fill,
+  stops: fill.stops.map(
+    (stop): FillStop<ColorRGB> => ({
+      ...rotateHue(toRGB(stop), hueRotate),
+      position: stop.position,
+    })
+  ),
+})
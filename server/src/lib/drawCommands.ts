@@ -1,28 +1,70 @@
-import { mergeBitmaps } from "./bitmaps"
-import { fontSizeDetailsMap, fontIsValidAscii, fontGetChunk } from "./font"
+import {
+  compositeLayers,
+  createBitmap,
+  expandIndexedBitmap,
+  mergeBitmaps,
+  transformBitmap,
+} from "./bitmaps"
+import { resolveFill, rotateHue, toRGB } from "./colors"
+import { fontSizeDetailsMap, fontGetGlyph, fontGetKerning } from "./font"
+import { createEffectState, effectRow, stepEffect } from "./effects"
+import { appendSeries, decimateSeries, type SeriesBuffer } from "./graphing"
+import { animationFramesDue } from "./animations"
+import { applyTweens } from "./tweens"
 import type {
   Bitmap,
   Command,
+  CommandAnimation,
   CommandApiResponse,
+  CommandEffect,
+  CommandGraph,
+  EffectState,
   Point,
   DrawingState,
+  Layer,
+  LayerName,
   AnimationState,
   ColorRGB,
+  Fill,
   Size,
 } from "./types"
 
+const createDrawingState = (): DrawingState => ({
+  cursor: { x: 0, y: 0 },
+  color: { red: 255, green: 255, blue: 255 },
+  font: {
+    ...fontSizeDetailsMap.md,
+  },
+  textScale: 1,
+})
+
+const layerOrder: LayerName[] = ["background", "content", "overlay"]
+
+/** How far a command turns its own colors around the color wheel */
+const hueRotateOf = (command: Command): number =>
+  "hueRotate" in command && command.hueRotate ? command.hueRotate : 0
+
 const parseAndSetState = (state: DrawingState, command: Command): void => {
   if ("position" in command && command.position) {
     state.cursor = { ...command.position }
   }
 
   if ("color" in command && command.color) {
-    state.color = command.color
+    state.color = rotateHue(toRGB(command.color), hueRotateOf(command))
+    delete state.fill
+  }
+
+  if ("fill" in command && command.fill) {
+    state.fill = resolveFill(command.fill, hueRotateOf(command))
   }
 
   if ("fontSize" in command && command.fontSize) {
     state.font = { ...fontSizeDetailsMap[command.fontSize] }
   }
+
+  if ("textScale" in command && command.textScale) {
+    state.textScale = command.textScale
+  }
 }
 
 const setMatrixValue = ({
@@ -141,7 +183,76 @@ const drawLine = ({
 
 const lineFeed = (state: DrawingState): void => {
   state.cursor.x = 0
-  state.cursor.y += state.font.height
+  state.cursor.y += state.font.height * state.textScale
+}
+
+type FillArea = Point & Size
+
+/**
+ * The color of a fill at `point`, when it is stretched over `area`. The same
+ * as the firmware, give or take one for rounding.
+ */
+const fillColorAt = ({
+  fill,
+  area,
+  point,
+}: {
+  fill: Fill<ColorRGB>
+  area: FillArea
+  point: Point
+}): ColorRGB => {
+  const dx = point.x - area.x
+  const dy = point.y - area.y
+  const direction = fill.direction ?? "horizontal"
+
+  if (fill.type !== "gradient") {
+    const size = fill.size ?? 1
+    const cell = (offset: number) => Math.floor(offset / size)
+    let parity: number
+    if (fill.type === "checker") {
+      parity = cell(dx) + cell(dy)
+    } else if (direction === "horizontal") {
+      parity = cell(dx)
+    } else if (direction === "vertical") {
+      parity = cell(dy)
+    } else {
+      parity = cell(dx + dy)
+    }
+    return fill.stops[parity & 1]!
+  }
+
+  const stops = fill.stops.map((stop, index) => ({
+    ...stop,
+    position:
+      stop.position ?? Math.floor((index * 255) / (fill.stops.length - 1)),
+  }))
+  const along = (offset: number, length: number) =>
+    (Math.max(offset, 0) * 255) / Math.max(length - 1, 1)
+  const position =
+    direction === "horizontal"
+      ? along(dx, area.width)
+      : direction === "vertical"
+        ? along(dy, area.height)
+        : (along(dx, area.width) + along(dy, area.height)) / 2
+
+  const next = stops.findIndex((stop) => position < stop.position)
+  if (next === -1) {
+    return stops[stops.length - 1]!
+  }
+  if (next === 0) {
+    return stops[0]!
+  }
+
+  const from = stops[next - 1]!
+  const to = stops[next]!
+  const mix = (position - from.position) / (to.position - from.position)
+  const channel = (key: keyof ColorRGB) =>
+    Math.floor(from[key] + (to[key] - from[key]) * mix + 0.5)
+  return {
+    red: channel("red"),
+    green: channel("green"),
+    blue: channel("blue"),
+  }
 }
 
 const drawString = ({
@@ -153,153 +264,336 @@ const drawString = ({
   value: string
   bitmap: Bitmap
 }) => {
-  // the actual ascii character we are working on
-  let asciiChar: number
-  // the starting point to draw bits at in the buffer
-  let bufferStartIdx: number
-  // which bit of the font->width we are on working on
-  let bitmapRowIdx: number
-  // the actual chunk value, pulled once to be used multiple
-  let chunkVal: number
-  // the number of the bit we are working on, within the chunk. This is the
-  // _number_, not the zero-based index
-  let chunkBitN: number
-
-  // loop all the characters in the string
-  for (let stringIndex = 0; stringIndex < value.length; stringIndex++) {
-    asciiChar = value.charCodeAt(stringIndex)
-    bitmapRowIdx = 0
-    // convert the buffers cursor to an index, where we start this char
-    bufferStartIdx = state.cursor.y * bitmap.size.width + state.cursor.x
+  const scale = state.textScale
+  const black = { red: 0, green: 0, blue: 0 }
+
+  const { font } = state
+  let lastCodepoint = 0
+  // a fill is stretched over each line, from where the string starts on it to
+  // the right edge
+  const fillArea = {
+    x: state.cursor.x,
+    y: state.cursor.y,
+    width: bitmap.size.width - state.cursor.x,
+    height: font.height * scale,
+  }
 
+  // loop all the characters (not UTF-16 units) in the string
+  for (const char of value) {
     // If we have moved past the buffer's space, we can go ahead and end
     if (state.cursor.y >= bitmap.size.height) {
       return
     }
 
-    // if not a character that we support, change to `?`
-    if (!fontIsValidAscii(asciiChar)) {
-      console.warn("Unsupported ASCII character", asciiChar)
-      asciiChar = 63
+    // characters without a glyph are drawn as `?`
+    const codepoint = char.codePointAt(0)!
+    const glyph = fontGetGlyph({ size: font.name, codepoint })
+
+    // wrapped lines start at the left edge
+    if (state.cursor.y !== fillArea.y) {
+      fillArea.x = 0
+      fillArea.y = state.cursor.y
+      fillArea.width = bitmap.size.width
     }
 
-    for (let chunkIdx = 0; chunkIdx < state.font.chunksPerChar; chunkIdx++) {
-      chunkVal = fontGetChunk({
-        asciiChar,
-        size: state.font.name,
-        chunk: chunkIdx,
+    // kerning only applies between two glyphs on the same line
+    if (state.cursor.x > 0) {
+      const kerning = fontGetKerning({
+        size: font.name,
+        left: lastCodepoint,
+        right: codepoint,
       })
-
-      for (chunkBitN = 1; chunkBitN <= state.font.bitsPerChunk; chunkBitN++) {
-        // mask the chunk bit, then AND it to the chunk value. Use the result as
-        // a boolean to check if we should set the value to the color or blank
-        const setIndex = bufferStartIdx + bitmapRowIdx
-        const setValue =
-          (chunkVal & (1 << (state.font.bitsPerChunk - chunkBitN))) != 0
-            ? state.color
-            : { red: 0, green: 0, blue: 0 }
-        if (setIndex < bitmap.data.red.length) {
-          bitmap.data.red[setIndex] = setValue.red
-          bitmap.data.green[setIndex] = setValue.green
-          bitmap.data.blue[setIndex] = setValue.blue
-        }
-
-        // increase the rows index. Move down a line if at the end
-        bitmapRowIdx++
-        if (bitmapRowIdx == state.font.width) {
-          bitmapRowIdx = 0
-          bufferStartIdx += bitmap.size.width
+      state.cursor.x = Math.max(0, state.cursor.x + kerning * scale)
+    }
+    lastCodepoint = codepoint
+
+    // the whole cell up to the next glyph is drawn, so the background between
+    // proportional glyphs is cleared too
+    const originX = Math.max(0, state.cursor.x + glyph.offsetX * scale)
+    const cellWidth = Math.max(glyph.width, glyph.advance - font.spacing)
+
+    // each font pixel is drawn as a `scale` × `scale` block, clipped to the
+    // bitmap, the same as the firmware
+    for (let glyphY = 0; glyphY < font.height; glyphY++) {
+      for (let glyphX = 0; glyphX < cellWidth; glyphX++) {
+        const isSet =
+          glyphX < glyph.width &&
+          ((glyph.rows[glyphY]! >> (glyph.width - 1 - glyphX)) & 1) === 1
+
+        for (let blockY = 0; blockY < scale; blockY++) {
+          for (let blockX = 0; blockX < scale; blockX++) {
+            const x = originX + glyphX * scale + blockX
+            const y = state.cursor.y + glyphY * scale + blockY
+            if (x >= bitmap.size.width || y >= bitmap.size.height) {
+              continue
+            }
+
+            const setValue = !isSet
+              ? black
+              : state.fill
+                ? fillColorAt({
+                    fill: state.fill,
+                    area: fillArea,
+                    point: { x, y },
+                  })
+                : state.color
+            const setIndex = y * bitmap.size.width + x
+            bitmap.data.red[setIndex] = setValue.red
+            bitmap.data.green[setIndex] = setValue.green
+            bitmap.data.blue[setIndex] = setValue.blue
+          }
         }
       }
     }
 
     // we're done with this character, move to the next position.
     if (
-      state.cursor.x + state.font.width * 2 + state.font.spacing <=
+      state.cursor.x + (glyph.advance + font.width + font.spacing) * scale <=
       bitmap.size.width
     ) {
-      state.cursor.x += state.font.width + state.font.spacing
+      state.cursor.x += glyph.advance * scale
     } else {
       lineFeed(state)
     }
   }
 }
 
+/**
+ * Fills a rectangle with `color`, or with `fill` stretched over `fillArea`.
+ * Each channel is shifted right by `shift`, for dimmer versions of the fill.
+ */
 const fillRect = ({
   point,
   size,
   color,
+  fill,
+  fillArea = { ...point, ...size },
+  shift = 0,
   bitmap,
 }: {
   point: Point
   size: Size
   color: ColorRGB
+  fill?: Fill<ColorRGB>
+  fillArea?: FillArea
+  shift?: number
   bitmap: Bitmap
 }) => {
   for (let y = 0; y < size.height; y++) {
     for (let x = 0; x < size.width; x++) {
+      const pixel = { x: point.x + x, y: point.y + y }
+      const pixelColor = fill
+        ? fillColorAt({ fill, area: fillArea, point: pixel })
+        : color
       setMatrixValue({
-        point: { x: point.x + x, y: point.y + y },
-        color,
+        point: pixel,
+        color: {
+          red: pixelColor.red >> shift,
+          green: pixelColor.green >> shift,
+          blue: pixelColor.blue >> shift,
+        },
         bitmap,
       })
     }
   }
 }
 
+/** Maps a sample to how many pixels up the graph it is, from 1 to `height` */
+const graphSampleLevel = ({
+  sample,
+  min,
+  range,
+  height,
+}: {
+  sample: number
+  min: number
+  range: number
+  height: number
+}): number => {
+  // a flat series sits in the middle
+  if (range === 0) {
+    return Math.floor((height + 1) / 2)
+  }
+
+  const offset = Math.min(Math.max(sample - min, 0), range)
+  return Math.floor((offset * (height - 1) + Math.floor(range / 2)) / range) + 1
+}
+
 const drawGraph = ({
   state,
-  size,
-  values,
+  command,
   bitmap,
-  backgroundColor,
+  series,
 }: {
   state: DrawingState
-  size: Size
-  values: number[]
+  command: CommandGraph
   bitmap: Bitmap
-  backgroundColor?: ColorRGB
+  series: Map<number, SeriesBuffer>
 }) => {
-  if (values.length < size.width) {
-    throw new Error("Not enough values to fill graph width")
-  }
+  const { size, values, backgroundColor, style = "bar" } = command
+  // the lowest and highest level of each column, with 0 left empty
+  let columns: { low: number; high: number }[]
+
+  if (command.series) {
+    const samples = series.get(command.series.id)?.samples ?? []
+    const min = command.scale?.min ?? Math.min(...samples)
+    const range = (command.scale?.max ?? Math.max(...samples)) - min
+    const columnCount = Math.min(samples.length, size.width)
+    columns = decimateSeries(samples, columnCount).map((column) => ({
+      low: graphSampleLevel({
+        sample: column.min,
+        min,
+        range,
+        height: size.height,
+      }),
+      high: graphSampleLevel({
+        sample: column.max,
+        min,
+        range,
+        height: size.height,
+      }),
+    }))
+  } else {
+    if (!values || values.length < size.width) {
+      throw new Error("Not enough values to fill graph width")
+    }
 
-  const maxValue = Math.max(...values)
-  const minValue = Math.min(...values)
-  if (maxValue > size.height) {
-    throw new Error("Max value exceeds graph height")
-  }
-  if (minValue < 0) {
-    throw new Error("Min value is below zero")
+    const maxValue = Math.max(...values)
+    const minValue = Math.min(...values)
+    if (maxValue > size.height) {
+      throw new Error("Max value exceeds graph height")
+    }
+    if (minValue < 0) {
+      throw new Error("Min value is below zero")
+    }
+
+    columns = values
+      .slice(0, size.width)
+      .map((value) => ({ low: value, high: value }))
   }
 
   if (backgroundColor) {
     fillRect({
       point: state.cursor,
       size,
-      color: backgroundColor,
+      color: toRGB(backgroundColor),
       bitmap,
     })
   }
 
-  values.forEach((value, x) => {
+  // columns are aligned to the right, so the newest sample is at the edge
+  const firstX = state.cursor.x + size.width - columns.length
+  const bottom = state.cursor.y + size.height
+  const fillArea = { ...state.cursor, ...size }
+  let last: { low: number; high: number } | undefined
+
+  columns.forEach(({ low, high }, index) => {
     // don't draw anything for zero values
-    if (value === 0) {
+    if (high === 0) {
+      last = undefined
       return
     }
 
-    drawLine({
-      from: { x: state.cursor.x + x, y: state.cursor.y + size.height - 1 },
-      to: {
-        x: state.cursor.x + x,
-        y: state.cursor.y + size.height - value,
-      },
+    const x = firstX + index
+    if (style === "bar") {
+      fillRect({
+        point: { x, y: bottom - high },
+        size: { width: 1, height: high },
+        color: state.color,
+        fill: state.fill,
+        fillArea,
+        bitmap,
+      })
+      return
+    }
+
+    // stretch the span to meet the last column, so the line has no gaps
+    let spanLow = low
+    let spanHigh = high
+    if (last && last.high < low) {
+      spanLow = last.high + 1
+    } else if (last && last.low > high) {
+      spanHigh = last.low - 1
+    }
+    last = { low, high }
+
+    if (style === "area" && spanLow > 1) {
+      fillRect({
+        point: { x, y: bottom - (spanLow - 1) },
+        size: { width: 1, height: spanLow - 1 },
+        color: state.color,
+        fill: state.fill,
+        fillArea,
+        shift: 2,
+        bitmap,
+      })
+    }
+    fillRect({
+      point: { x, y: bottom - spanHigh },
+      size: { width: 1, height: spanHigh - spanLow + 1 },
       color: state.color,
+      fill: state.fill,
+      fillArea,
       bitmap,
     })
   })
 }
 
+/** Draws an effect's current step at `point`, clipped to the bitmap */
+const drawEffect = ({
+  point,
+  effect,
+  bitmap,
+}: {
+  point: Point
+  effect: EffectState
+  bitmap: Bitmap
+}) => {
+  const height = Math.min(effect.height, bitmap.size.height - point.y)
+  const width = Math.min(effect.width, bitmap.size.width - point.x)
+  for (let y = 0; y < height; y++) {
+    const row = effectRow(effect, y)
+    for (let x = 0; x < width; x++) {
+      setMatrixValue({
+        point: { x: point.x + x, y: point.y + y },
+        color: row[x]!,
+        bitmap,
+      })
+    }
+  }
+}
+
+/**
+ * Draws the frame an animation with a `size` has moved to over the one before,
+ * in its canvas. Going back to the first frame starts from an empty canvas.
+ */
+const drawCanvasFrame = (
+  command: CommandAnimation,
+  animationState: AnimationState,
+  options: Pick<
+    Parameters<typeof drawCommands>[0],
+    "series" | "effects" | "elapsed" | "step"
+  >
+): Bitmap => {
+  let canvas = animationState.canvas
+  if (!canvas || animationState.lastShowFrame === 0) {
+    canvas = createBitmap(command.size?.width ?? 0, command.size?.height ?? 0)
+  }
+  const frameCommands = command.frames[animationState.lastShowFrame]
+  if (!frameCommands) {
+    throw new Error(`Missing frame ${animationState.lastShowFrame}`)
+  }
+  canvas.data = drawCommands({
+    ...options,
+    bitmap: canvas,
+    commands: frameCommands,
+    allAnimationStates: [],
+    isInAnimation: true,
+  }).data
+  animationState.canvas = canvas
+  return canvas
+}
+
 /**
  * This function takes a bitmap and a list of commands, and draws the
  * commands onto the bitmap.
@@ -308,21 +602,56 @@ export const drawCommands = ({
   bitmap,
   commands,
   allAnimationStates,
+  isInAnimation = false,
+  series = new Map(),
+  effects = new Map(),
+  elapsed = 0,
+  step = true,
+  animationDelay = 1000,
 }: {
   bitmap: Bitmap
   allAnimationStates: AnimationState[]
+  isInAnimation?: boolean
+  /**
+   * The series kept between fetches, as on the device. Graph samples are
+   * appended as they are drawn. Defaults to empty, so a preview only shows
+   * the samples in `commands`.
+   */
+  series?: Map<number, SeriesBuffer>
+  /**
+   * Each effect's state between frames, keyed by its command. Effects are
+   * stepped as they are drawn. Defaults to empty, so a preview shows each
+   * effect's first step.
+   */
+  effects?: Map<CommandEffect, EffectState>
+  /**
+   * Milliseconds since the commands were fetched, which tweens are timed
+   * from. Defaults to 0, so a preview shows where each tween starts.
+   */
+  elapsed?: number
+  /**
+   * Whether animations and effects move on. The device ticks faster while
+   * there are tweens, but only moves these on once per animation delay.
+   * Animations with `durations` or a `delay` move on by `elapsed` instead.
+   */
+  step?: boolean
+  /**
+   * How long frames without their own duration are shown for, from the
+   * config. Defaults to the device's default.
+   */
+  animationDelay?: number
 } & Pick<CommandApiResponse, "commands">): Bitmap => {
-  const state: DrawingState = {
-    cursor: { x: 0, y: 0 },
-    color: { red: 255, green: 255, blue: 255 },
-    font: {
-      ...fontSizeDetailsMap.md,
-    },
+  const state = createDrawingState()
+  // commands draw into the content layer until they pick another one
+  const layers: Partial<Record<LayerName, Layer>> = {
+    content: { bitmap, opacity: 255, blend: "normal" },
   }
-  const loopBitmap: Bitmap = bitmap
+  let loopBitmap: Bitmap = bitmap
+  let usedLayers = false
   let animationCount = 0
 
-  for (const command of commands) {
+  for (const untweened of commands) {
+    const command = applyTweens(untweened, elapsed)
     parseAndSetState(state, command)
 
     switch (command.type) {
@@ -335,9 +664,33 @@ export const drawCommands = ({
           throw new Error("Missing animation state")
         }
 
-        animationState.lastShowFrame++
-        if (animationState.lastShowFrame >= animationState.frameCount) {
-          animationState.lastShowFrame = 0
+        // frames with their own durations keep their own time, instead of
+        // moving on each step
+        const moves =
+          command.durations || command.delay
+            ? animationFramesDue(
+                animationState,
+                command.durations ?? [],
+                elapsed,
+                command.delay ?? animationDelay
+              )
+            : Number(step)
+        for (let move = 0; move < moves; move++) {
+          animationState.lastShowFrame++
+          if (animationState.lastShowFrame >= animationState.frameCount) {
+            animationState.lastShowFrame = 0
+          }
+          // each frame that was skipped is still drawn into the canvas, since
+          // the next one only holds what changed
+          if (command.size) {
+            drawCanvasFrame(command, animationState, {
+              series,
+              effects,
+              elapsed,
+              // effects in the frames still only move on once per step
+              step: step && move === 0,
+            })
+          }
         }
 
         const frameCommands = command.frames[animationState.lastShowFrame]
@@ -345,11 +698,36 @@ export const drawCommands = ({
           throw new Error(`Missing frame ${animationState.lastShowFrame}`)
         }
 
+        if (command.size) {
+          // frames are drawn over the last one, and only when they change
+          const canvas =
+            animationState.canvas ??
+            drawCanvasFrame(command, animationState, {
+              series,
+              effects,
+              elapsed,
+              step,
+            })
+          loopBitmap.data = mergeBitmaps({
+            base: loopBitmap,
+            overlays: [canvas],
+            offsetX: state.cursor.x,
+            offsetY: state.cursor.y,
+          }).data
+          animationCount++
+          break
+        }
+
         const withAnimationApplied = drawCommands({
           bitmap: loopBitmap,
           commands: frameCommands,
           // no sub-animations are allowed, so pass in empty state
           allAnimationStates: [],
+          isInAnimation: true,
+          series,
+          effects,
+          elapsed,
+          step,
         })
 
         loopBitmap.data = withAnimationApplied.data
@@ -358,7 +736,50 @@ export const drawCommands = ({
       case "bitmap":
         loopBitmap.data = mergeBitmaps({
           base: loopBitmap,
-          overlays: [command],
+          overlays: [transformBitmap(command, command)],
+          offsetX: state.cursor.x,
+          offsetY: state.cursor.y,
+        }).data
+        break
+      case "palette":
+        state.palette = command.colors.map(toRGB)
+        break
+      case "layer":
+        if (isInAnimation) {
+          console.warn("Animations cannot change layers", command)
+          break
+        }
+
+        const layer = (layers[command.layer] ??= {
+          bitmap: createBitmap(bitmap.size.width, bitmap.size.height),
+          opacity: 255,
+          blend: "normal",
+        })
+        layer.opacity = command.opacity ?? 255
+        layer.blend = command.blend ?? "normal"
+        loopBitmap = layer.bitmap
+        Object.assign(state, createDrawingState())
+        delete state.palette
+        usedLayers = true
+        break
+      case "indexed-bitmap":
+        const palette =
+          command.palette?.map((color) =>
+            rotateHue(toRGB(color), hueRotateOf(command))
+          ) ?? state.palette
+        if (!palette) {
+          console.warn("No palette for indexed bitmap", command)
+          break
+        }
+
+        loopBitmap.data = mergeBitmaps({
+          base: loopBitmap,
+          overlays: [
+            transformBitmap(
+              expandIndexedBitmap({ ...command, palette }),
+              command
+            ),
+          ],
           offsetX: state.cursor.x,
           offsetY: state.cursor.y,
         }).data
@@ -374,6 +795,28 @@ export const drawCommands = ({
       case "line-feed":
         lineFeed(state)
         break
+      case "rect":
+        fillRect({
+          point: state.cursor,
+          size: command.size,
+          color: state.color,
+          fill: state.fill,
+          bitmap: loopBitmap,
+        })
+        break
+      case "effect":
+        // keyed by the command that was sent, since tweens copy it
+        const effectKey = untweened as CommandEffect
+        let effect = effects.get(effectKey)
+        if (!effect) {
+          effect = createEffectState(command)
+          effects.set(effectKey, effect)
+        }
+        if (step) {
+          stepEffect(effect)
+        }
+        drawEffect({ point: state.cursor, effect, bitmap: loopBitmap })
+        break
       case "string":
         drawString({
           state,
@@ -404,12 +847,20 @@ export const drawCommands = ({
         })
         break
       case "graph":
+        if (command.series) {
+          const buffer = series.get(command.series.id)
+          const capacity = command.series.capacity ?? command.size.width
+          if (!buffer || buffer.capacity !== capacity) {
+            series.set(command.series.id, { capacity, samples: [], total: 0 })
+          }
+          appendSeries(series.get(command.series.id)!, command.series)
+        }
+
         drawGraph({
           state,
-          size: command.size,
-          values: command.values,
+          command,
           bitmap: loopBitmap,
-          backgroundColor: command.backgroundColor,
+          series,
         })
         break
       default:
@@ -418,5 +869,13 @@ export const drawCommands = ({
     }
   }
 
-  return loopBitmap
+  // without any `layer` commands, everything was drawn into `bitmap`
+  if (!usedLayers) {
+    return loopBitmap
+  }
+
+  return compositeLayers({
+    size: bitmap.size,
+    layers: layerOrder.flatMap((name) => layers[name] ?? []),
+  })
 }
@@ -0,0 +1,316 @@
+import { toRGB } from "./colors"
+import type {
+  ColorRGB,
+  CommandEffect,
+  EffectName,
+  EffectState,
+  FillStop,
+} from "./types"
+
+// the same integer maths as the device, so the preview matches it exactly
+
+/** The most stars a starfield has */
+const starsMax = 64
+/** Fire rises at most this many rows each tick */
+const fireRiseMax = 4
+
+const sineTable = Array.from({ length: 256 }, (_, i) =>
+  Math.round(128 + 127 * Math.sin((2 * Math.PI * i) / 256))
+)
+
+const sine8 = (phase: number) => sineTable[phase & 0xff]!
+
+const defaultStops: Record<EffectName, FillStop[]> = {
+  plasma: [
+    { position: 0, red: 0, green: 0, blue: 96 },
+    { position: 96, red: 160, green: 0, blue: 192 },
+    { position: 176, red: 255, green: 96, blue: 0 },
+    { position: 255, red: 255, green: 240, blue: 96 },
+  ],
+  fire: [
+    { position: 0, red: 0, green: 0, blue: 0 },
+    { position: 96, red: 160, green: 0, blue: 0 },
+    { position: 160, red: 255, green: 96, blue: 0 },
+    { position: 224, red: 255, green: 208, blue: 0 },
+    { position: 255, red: 255, green: 255, blue: 192 },
+  ],
+  starfield: [
+    { position: 0, red: 0, green: 0, blue: 0 },
+    { position: 255, red: 255, green: 255, blue: 255 },
+  ],
+  noise: [
+    { position: 0, red: 0, green: 0, blue: 32 },
+    { position: 128, red: 0, green: 96, blue: 160 },
+    { position: 255, red: 160, green: 255, blue: 255 },
+  ],
+}
+
+/** Spreads stops without a position evenly, as the device does */
+const resolveStops = (stops: FillStop[]) =>
+  stops.map((stop, index) => ({
+    ...toRGB(stop),
+    position: stop.position ?? Math.floor((index * 255) / (stops.length - 1)),
+  }))
+
+/** A color for every level, from gradient stops that are in order */
+const createRamp = (fillStops: FillStop[]): ColorRGB[] => {
+  const stops = resolveStops(fillStops)
+  const ramp: ColorRGB[] = []
+  let stop = 0
+  for (let level = 0; level < 256; level++) {
+    while (stop + 1 < stops.length && stops[stop + 1]!.position <= level) {
+      stop++
+    }
+    const from = stops[stop]!
+    const to = stops[stop + 1] ?? from
+    if (level <= from.position || to === from) {
+      ramp.push({ red: from.red, green: from.green, blue: from.blue })
+      continue
+    }
+
+    const along = level - from.position
+    const span = to.position - from.position
+    const channel = (key: keyof ColorRGB) =>
+      from[key] + Math.trunc(((to[key] - from[key]) * along) / span)
+    ramp.push({
+      red: channel("red"),
+      green: channel("green"),
+      blue: channel("blue"),
+    })
+  }
+  return ramp
+}
+
+const validColors = (colors: FillStop[] | undefined): colors is FillStop[] => {
+  if (!colors || colors.length < 2 || colors.length > 8) {
+    return false
+  }
+  const stops = resolveStops(colors)
+  return stops.every(
+    (stop, index) => index === 0 || stop.position >= stops[index - 1]!.position
+  )
+}
+
+const nextRandom = (state: EffectState): number => {
+  let random = state.random
+  random = (random ^ (random << 13)) >>> 0
+  random = (random ^ (random >>> 17)) >>> 0
+  random = (random ^ (random << 5)) >>> 0
+  state.random = random
+  return random
+}
+
+const fade8 = (t: number) => (t * t * (768 - 2 * t)) >> 16
+
+const lerp8 = (from: number, to: number, t: number) =>
+  from + (((to - from) * t) >> 8)
+
+/** Stretches an average of waves back out from the middle */
+const stretch8 = (level: number) =>
+  Math.min(Math.max(Math.trunc(((level - 128) * 3) / 2) + 128, 0), 255)
+
+const noiseHash = (seed: number, x: number, y: number) => {
+  let hash =
+    (Math.imul(x & 0xffff, 0x9e3779b1) ^
+      Math.imul(y & 0xffff, 0x85ebca77) ^
+      seed) >>>
+    0
+  hash = (hash ^ (hash >>> 15)) >>> 0
+  hash = Math.imul(hash, 0x2c1b3c6d) >>> 0
+  hash = (hash ^ (hash >>> 12)) >>> 0
+  return hash >>> 24
+}
+
+const addNoiseRow = (
+  sums: number[],
+  u: number,
+  v: number,
+  step: number,
+  seed: number,
+  weight: number
+) => {
+  const cellY = v >>> 16
+  const fadeY = fade8((v >>> 8) & 0xff)
+  const column = (cellX: number) =>
+    lerp8(
+      noiseHash(seed, cellX, cellY),
+      noiseHash(seed, cellX, cellY + 1),
+      fadeY
+    )
+  for (let i = 0; i < sums.length; i++, u = (u + step) >>> 0) {
+    const cellX = u >>> 16
+    sums[i]! +=
+      lerp8(column(cellX), column(cellX + 1), fade8((u >>> 8) & 0xff)) *
+      weight
+  }
+}
+
+const noiseRow = (state: EffectState, y: number, length: number) => {
+  const step = Math.floor(65536 / state.scale)
+  const fineStep = Math.min(step * 2, 65536)
+  const drift = (state.time << 4) >>> 0
+  const sums = new Array<number>(length).fill(0)
+  addNoiseRow(
+    sums,
+    drift,
+    (y * step + (drift >>> 1)) >>> 0,
+    step,
+    state.seed,
+    3
+  )
+  addNoiseRow(
+    sums,
+    (0 - drift) >>> 0,
+    (y * fineStep + drift) >>> 0,
+    fineStep,
+    (state.seed ^ 0xa5a5a5a5) >>> 0,
+    1
+  )
+  return sums.map((sum) => stretch8(sum >> 2))
+}
+
+const plasmaRow = (state: EffectState, y: number, length: number) => {
+  const step = Math.floor(65536 / state.scale)
+  const time = state.time
+  const rowPhase = y * step
+  const down = sine8((rowPhase + (time >>> 1)) >>> 8)
+  const warp = sine8((rowPhase - time) >>> 8)
+  const levels: number[] = []
+  for (let x = 0, phase = 0; x < length; x++, phase += step) {
+    levels.push(
+      stretch8(
+        (sine8((phase + time) >>> 8) +
+          down +
+          sine8((((phase + rowPhase) >>> 1) - time) >>> 8) +
+          sine8((phase >>> 8) + warp + (time >>> 9))) >>
+          2
+      )
+    )
+  }
+  return levels
+}
+
+const stepFire = (state: EffectState) => {
+  const { width, height, levels } = state
+  const rise = Math.min(Math.max(state.speed, 1), fireRiseMax)
+  const bottom = (height - 1) * width
+  for (let r = 0; r < rise; r++) {
+    for (let x = 0; x < width; x++) {
+      levels![bottom + x] = 255 - (nextRandom(state) & 63)
+    }
+    for (let y = 0; y + 1 < height; y++) {
+      for (let x = 0; x < width; x++) {
+        const random = nextRandom(state)
+        const from = Math.min(Math.max(x + (random & 3) - 1, 0), width - 1)
+        const cooling = (((random >>> 8) & 0xff) * state.scale) >> 10
+        const below = levels![(y + 1) * width + from]!
+        levels![y * width + x] = below > cooling ? below - cooling : 0
+      }
+    }
+  }
+}
+
+const spawnStar = (
+  state: EffectState,
+  star: EffectState["stars"][number],
+  isFar: boolean
+) => {
+  let random: number
+  do {
+    random = nextRandom(state)
+    star.x = ((random & 0xff) << 24) >> 24
+    star.y = (((random >>> 8) & 0xff) << 24) >> 24
+  } while (star.x === 0 && star.y === 0)
+  star.z = isFar ? 255 : 1 + ((random >>> 16) % 255)
+}
+
+const stepStarfield = (state: EffectState) => {
+  const { width, height, levels } = state
+  const count = Math.min(Math.max(state.scale, 1), starsMax)
+  const speed = Math.max(state.speed, 1)
+  levels!.fill(0)
+  for (const star of state.stars.slice(0, count)) {
+    if (star.z <= speed) {
+      spawnStar(state, star, true)
+    } else {
+      star.z -= speed
+    }
+
+    const x =
+      Math.floor(width / 2) + Math.trunc((star.x * width) / (2 * star.z))
+    const y =
+      Math.floor(height / 2) + Math.trunc((star.y * height) / (2 * star.z))
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+      spawnStar(state, star, true)
+      continue
+    }
+    levels![y * width + x] = Math.max(levels![y * width + x]!, 255 - star.z)
+  }
+}
+
+/**
+ * Creates the state of an effect command, as the device does when it parses
+ * one. Effects start again whenever the commands are fetched.
+ */
+export const createEffectState = (command: CommandEffect): EffectState => {
+  const { width, height } = command.size
+  const byte = (value: number | undefined, fallback: number) =>
+    value !== undefined && value >= 1 && value <= 255 ? value : fallback
+  const seed = (command.seed ?? 1) >>> 0
+  const state: EffectState = {
+    effect: command.effect,
+    width,
+    height,
+    speed: byte(command.speed, command.effect === "fire" ? 1 : 4),
+    scale: byte(command.scale, command.effect === "noise" ? 16 : 32),
+    seed,
+    random: seed !== 0 ? seed : 1,
+    time: 0,
+    stars: [],
+    ramp: createRamp(
+      validColors(command.colors)
+        ? command.colors
+        : defaultStops[command.effect]
+    ),
+  }
+  if (command.effect === "fire" || command.effect === "starfield") {
+    state.levels = new Uint8Array(width * height)
+  }
+  if (command.effect === "starfield") {
+    for (let i = 0; i < starsMax; i++) {
+      const star = { x: 0, y: 0, z: 0 }
+      spawnStar(state, star, false)
+      state.stars.push(star)
+    }
+  }
+  return state
+}
+
+/** Moves an effect on by one tick */
+export const stepEffect = (state: EffectState): void => {
+  switch (state.effect) {
+    case "plasma":
+    case "noise":
+      state.time = (state.time + (state.speed << 6)) >>> 0
+      break
+    case "fire":
+      stepFire(state)
+      break
+    case "starfield":
+      stepStarfield(state)
+      break
+  }
+}
+
+/** The color of every pixel of one row of an effect */
+export const effectRow = (state: EffectState, y: number): ColorRGB[] => {
+  const levels =
+    state.effect === "plasma"
+      ? plasmaRow(state, y, state.width)
+      : state.effect === "noise"
+        ? noiseRow(state, y, state.width)
+        : Array.from(
+            state.levels!.subarray(y * state.width, (y + 1) * state.width)
+          )
+  return levels.map((level) => state.ramp[level]!)
+}
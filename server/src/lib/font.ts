@@ -1,4 +1,10 @@
-import type { FontSize, FontSizeDetails } from "./types"
+import type { FontGlyph, FontSize, FontSizeDetails } from "./types"
+import {
+  propFontHeight,
+  propGlyphs,
+  propKerning,
+  propRows,
+} from "./fontPropData"
 
 export const FONT_ASCII_MIN = 32
 export const FONT_ASCII_MAX = 126
@@ -7,6 +13,7 @@ export const fontSizeMap = {
   fontSizeSm: "sm",
   fontSizeMd: "md",
   fontSizeLg: "lg",
+  fontSizeProp: "prop",
 } as const
 
 export const fontSizeDetailsMap = {
@@ -16,6 +23,7 @@ export const fontSizeDetailsMap = {
     bitsPerChunk: 8,
     chunksPerChar: 3,
     spacing: 1,
+    proportional: false,
     name: fontSizeMap.fontSizeSm,
   },
   [fontSizeMap.fontSizeLg]: {
@@ -24,6 +32,7 @@ export const fontSizeDetailsMap = {
     bitsPerChunk: 32,
     chunksPerChar: 3,
     spacing: 0,
+    proportional: false,
     name: fontSizeMap.fontSizeLg,
   },
   [fontSizeMap.fontSizeMd]: {
@@ -32,8 +41,20 @@ export const fontSizeDetailsMap = {
     bitsPerChunk: 16,
     chunksPerChar: 3,
     spacing: 0,
+    proportional: false,
     name: fontSizeMap.fontSizeMd,
   },
+  // keeps the 6x8 cell so missing glyphs can fall back to the 6x8 tables.
+  // `width` is then the widest a glyph will be.
+  [fontSizeMap.fontSizeProp]: {
+    width: 6,
+    height: propFontHeight,
+    bitsPerChunk: 16,
+    chunksPerChar: 3,
+    spacing: 0,
+    proportional: true,
+    name: fontSizeMap.fontSizeProp,
+  },
 } satisfies Record<FontSize, FontSizeDetails>
 
 export const fontAsciiToIndex = (ascii: number) => ascii - FONT_ASCII_MIN
@@ -76,6 +97,250 @@ export const fontGetChunk = ({
   }
 }
 
+// Non-ASCII codepoints are looked up in the sparse `extMap`, the same as the
+// firmware. Each entry is 16 bits:
+//   bits 15-14: 1 = ASCII glyph, 2 = extended glyph, 0 = no glyph
+//   bits 13-10: an accent mark from `marks*` composed onto the glyph
+//   bits  9-0:  the ASCII character, or an index into the `ext*` glyph tables
+const EXT_KIND_ASCII = 1
+const EXT_KIND_GLYPH = 2
+export const FONT_REPLACEMENT_CHAR = 63
+
+const extGetChunks = (size: FontSize, index: number): number[] => {
+  const { chunksPerChar } = fontSizeDetailsMap[size]
+  const start = index * chunksPerChar
+  switch (size) {
+    case fontSizeMap.fontSizeSm:
+      return ext4By6.slice(start, start + chunksPerChar)
+    case fontSizeMap.fontSizeLg:
+      return ext8By12.slice(start, start + chunksPerChar)
+    case fontSizeMap.fontSizeMd:
+    default:
+      return ext6By8.slice(start, start + chunksPerChar)
+  }
+}
+
+const extGetMark = (size: FontSize, mark: number) => {
+  switch (size) {
+    case fontSizeMap.fontSizeSm:
+      return marks4By6[mark]
+    case fontSizeMap.fontSizeLg:
+      return marks8By12[mark]
+    case fontSizeMap.fontSizeMd:
+    default:
+      return marks6By8[mark]
+  }
+}
+
+const extLookup = (codepoint: number): number => {
+  let low = 0
+  let high = extRanges.length
+  while (low < high) {
+    const mid = Math.floor((low + high) / 2)
+    const [first, last, offset] = extRanges[mid]!
+    if (codepoint < first) {
+      high = mid
+    } else if (codepoint > last) {
+      low = mid + 1
+    } else {
+      return extMap[offset + codepoint - first]!
+    }
+  }
+  return 0
+}
+
+// Resolves a codepoint from the monospaced tables
+const getMonoGlyph = (size: FontSize, codepoint: number) => {
+  const font = fontSizeDetailsMap[size]
+  let found = true
+  let entry = fontIsValidAscii(codepoint)
+    ? (EXT_KIND_ASCII << 14) | codepoint
+    : extLookup(codepoint)
+  if (entry >> 14 !== EXT_KIND_ASCII && entry >> 14 !== EXT_KIND_GLYPH) {
+    entry = (EXT_KIND_ASCII << 14) | FONT_REPLACEMENT_CHAR
+    found = false
+  }
+
+  const value = entry & 0x3ff
+  const chunks =
+    entry >> 14 === EXT_KIND_GLYPH
+      ? extGetChunks(size, value)
+      : Array.from({ length: font.chunksPerChar }, (_, chunk) =>
+          fontGetChunk({ size, asciiChar: value, chunk })
+        )
+
+  const rows = Array.from({ length: font.height }, (_, row) => {
+    let bits = 0
+    for (let x = 0; x < font.width; x++) {
+      const bitOffset = row * font.width + x
+      const chunk = chunks[Math.floor(bitOffset / font.bitsPerChunk)]!
+      const shift = font.bitsPerChunk - 1 - (bitOffset % font.bitsPerChunk)
+      bits = (bits << 1) | ((chunk >>> shift) & 1)
+    }
+    return bits
+  })
+
+  const mark = extGetMark(size, (entry >> 10) & 0x0f)
+  if (mark && mark.height > 0) {
+    composeMark(rows, mark)
+  }
+
+  const glyph: FontGlyph = {
+    rows,
+    width: font.width,
+    offsetX: 0,
+    advance: font.width + font.spacing,
+  }
+  return { glyph, found }
+}
+
+const getPropGlyph = (codepoint: number): FontGlyph | undefined => {
+  let low = 0
+  let high = propGlyphs.length
+  while (low < high) {
+    const mid = Math.floor((low + high) / 2)
+    const [glyphCodepoint, start, width, height, top, offsetX, advance] =
+      propGlyphs[mid]!
+    if (codepoint < glyphCodepoint) {
+      high = mid
+    } else if (codepoint > glyphCodepoint) {
+      low = mid + 1
+    } else {
+      const rows = new Array<number>(propFontHeight).fill(0)
+      rows.splice(top, height, ...propRows.slice(start, start + height))
+      return { rows, width, offsetX, advance }
+    }
+  }
+  return undefined
+}
+
+// Narrows a monospaced glyph to its ink, so fallbacks in the proportional
+// font are spaced like the rest of it
+const trimGlyph = (glyph: FontGlyph): FontGlyph => {
+  const ink = glyph.rows.reduce((all, row) => all | row, 0)
+  if (ink === 0) {
+    return getPropGlyph(32)!
+  }
+
+  let right = 0
+  while (!(ink & (1 << right))) {
+    right++
+  }
+  const width = 32 - Math.clz32(ink >> right)
+  return {
+    rows: glyph.rows.map((row) => row >> right),
+    width,
+    offsetX: 0,
+    advance: width + 1,
+  }
+}
+
+/**
+ * Returns the rows and metrics of a codepoint's glyph, the same as the
+ * firmware. Codepoints without a glyph use `FONT_REPLACEMENT_CHAR`.
+ */
+export const fontGetGlyph = ({
+  size,
+  codepoint,
+}: {
+  size: FontSize
+  codepoint: number
+}): FontGlyph => {
+  if (!fontSizeDetailsMap[size].proportional) {
+    return getMonoGlyph(size, codepoint).glyph
+  }
+
+  const propGlyph = getPropGlyph(codepoint)
+  if (propGlyph) {
+    return propGlyph
+  }
+
+  const { glyph, found } = getMonoGlyph(size, codepoint)
+  return found ? trimGlyph(glyph) : getPropGlyph(FONT_REPLACEMENT_CHAR)!
+}
+
+/**
+ * Returns how many pixels to move the cursor between two glyphs, beyond their
+ * advance. Always 0 for monospaced fonts.
+ */
+export const fontGetKerning = ({
+  size,
+  left,
+  right,
+}: {
+  size: FontSize
+  left: number
+  right: number
+}): number => {
+  if (!fontSizeDetailsMap[size].proportional) {
+    return 0
+  }
+  const pair = propKerning.find(
+    ([pairLeft, pairRight]) => pairLeft === left && pairRight === right
+  )
+  return pair ? pair[2] : 0
+}
+
+/**
+ * Returns how many pixels wide a single line of text is drawn, for laying out
+ * text the same way the firmware will draw it.
+ */
+export const fontMeasureString = ({
+  size,
+  text,
+  textScale = 1,
+}: {
+  size: FontSize
+  text: string
+  textScale?: number
+}): number => {
+  let width = 0
+  let lastCodepoint = 0
+  for (const char of text) {
+    const codepoint = char.codePointAt(0)!
+    const glyph = fontGetGlyph({ size, codepoint })
+    if (width > 0) {
+      width += fontGetKerning({ size, left: lastCodepoint, right: codepoint })
+    }
+    width += glyph.advance
+    lastCodepoint = codepoint
+  }
+  return width * textScale
+}
+
+// Draws an accent into a glyph's rows. Marks above are given a blank row of
+// space by moving the glyph down, as far as the empty rows under it allow.
+const composeMark = (
+  rows: number[],
+  mark: { height: number; below: boolean; rows: number[] }
+) => {
+  const firstInk = rows.findIndex((row) => row !== 0)
+  const lastInk = rows.findLastIndex((row) => row !== 0)
+
+  if (mark.below) {
+    const start = firstInk === -1 ? rows.length - mark.height : lastInk + 1
+    for (let row = 0; row < mark.height; row++) {
+      if (start + row < rows.length) {
+        rows[start + row]! |= mark.rows[row]!
+      }
+    }
+    return
+  }
+
+  if (firstInk !== -1 && firstInk <= mark.height) {
+    const shift = Math.min(
+      mark.height + 1 - firstInk,
+      rows.length - 1 - lastInk
+    )
+    rows.unshift(...new Array<number>(shift).fill(0))
+    rows.splice(rows.length - shift, shift)
+  }
+
+  for (let row = 0; row < mark.height; row++) {
+    rows[row]! |= mark.rows[row]!
+  }
+}
+
 //disable prettier formatting this array
 // prettier-ignore
 export const ascii8By12 = [
@@ -375,3 +640,531 @@ export const ascii4By6 = [
   0x62, 0x32, 0x60, // }
   0x5A, 0x00, 0x00, // ~
 ];
+
+export const extRanges = [
+  [0x00a0, 0x00ff, 0],
+  [0x0391, 0x03c9, 96],
+  [0x0401, 0x0458, 153],
+  [0x2010, 0x2026, 241],
+  [0x20ac, 0x20ac, 264],
+  [0x2190, 0x2193, 265],
+  [0x2600, 0x2602, 269],
+  [0x26a1, 0x26a1, 272],
+  [0x2744, 0x2744, 273],
+] as const
+
+//disable prettier formatting this array
+// prettier-ignore
+export const extMap = [
+  0x4020, // U+00A0 no-break space
+  0x8004, // U+00A1 inverted exclamation mark
+  0x0000, // U+00A2 cent sign
+  0x8006, // U+00A3 pound sign
+  0x0000, // U+00A4 currency sign
+  0x0000, // U+00A5 yen sign
+  0x407C, // U+00A6 broken bar
+  0x0000, // U+00A7 section sign
+  0x5420, // U+00A8 diaeresis
+  0x0000, // U+00A9 copyright sign
+  0x0000, // U+00AA feminine ordinal indicator
+  0x0000, // U+00AB left-pointing double angle quotation mark
+  0x0000, // U+00AC not sign
+  0x402D, // U+00AD soft hyphen
+  0x0000, // U+00AE registered sign
+  0x0000, // U+00AF macron
+  0x8000, // U+00B0 degree sign
+  0x0000, // U+00B1 plus-minus sign
+  0x0000, // U+00B2 superscript two
+  0x0000, // U+00B3 superscript three
+  0x4820, // U+00B4 acute accent
+  0x8028, // U+00B5 micro sign
+  0x0000, // U+00B6 pilcrow sign
+  0x8001, // U+00B7 middle dot
+  0x5C20, // U+00B8 cedilla
+  0x0000, // U+00B9 superscript one
+  0x0000, // U+00BA masculine ordinal indicator
+  0x0000, // U+00BB right-pointing double angle quotation mark
+  0x0000, // U+00BC vulgar fraction one quarter
+  0x0000, // U+00BD vulgar fraction one half
+  0x0000, // U+00BE vulgar fraction three quarters
+  0x8005, // U+00BF inverted question mark
+  0x4441, // U+00C0 latin capital letter a with grave
+  0x4841, // U+00C1 latin capital letter a with acute
+  0x4C41, // U+00C2 latin capital letter a with circumflex
+  0x5041, // U+00C3 latin capital letter a with tilde
+  0x5441, // U+00C4 latin capital letter a with diaeresis
+  0x5841, // U+00C5 latin capital letter a with ring above
+  0x8013, // U+00C6 latin capital letter ae
+  0x5C43, // U+00C7 latin capital letter c with cedilla
+  0x4445, // U+00C8 latin capital letter e with grave
+  0x4845, // U+00C9 latin capital letter e with acute
+  0x4C45, // U+00CA latin capital letter e with circumflex
+  0x5445, // U+00CB latin capital letter e with diaeresis
+  0x4449, // U+00CC latin capital letter i with grave
+  0x4849, // U+00CD latin capital letter i with acute
+  0x4C49, // U+00CE latin capital letter i with circumflex
+  0x5449, // U+00CF latin capital letter i with diaeresis
+  0x4044, // U+00D0 latin capital letter eth
+  0x504E, // U+00D1 latin capital letter n with tilde
+  0x444F, // U+00D2 latin capital letter o with grave
+  0x484F, // U+00D3 latin capital letter o with acute
+  0x4C4F, // U+00D4 latin capital letter o with circumflex
+  0x504F, // U+00D5 latin capital letter o with tilde
+  0x544F, // U+00D6 latin capital letter o with diaeresis
+  0x8002, // U+00D7 multiplication sign
+  0x8015, // U+00D8 latin capital letter o with stroke
+  0x4455, // U+00D9 latin capital letter u with grave
+  0x4855, // U+00DA latin capital letter u with acute
+  0x4C55, // U+00DB latin capital letter u with circumflex
+  0x5455, // U+00DC latin capital letter u with diaeresis
+  0x4859, // U+00DD latin capital letter y with acute
+  0x0000, // U+00DE latin capital letter thorn
+  0x8008, // U+00DF latin small letter sharp s
+  0x4461, // U+00E0 latin small letter a with grave
+  0x4861, // U+00E1 latin small letter a with acute
+  0x4C61, // U+00E2 latin small letter a with circumflex
+  0x5061, // U+00E3 latin small letter a with tilde
+  0x5461, // U+00E4 latin small letter a with diaeresis
+  0x5861, // U+00E5 latin small letter a with ring above
+  0x8014, // U+00E6 latin small letter ae
+  0x5C63, // U+00E7 latin small letter c with cedilla
+  0x4465, // U+00E8 latin small letter e with grave
+  0x4865, // U+00E9 latin small letter e with acute
+  0x4C65, // U+00EA latin small letter e with circumflex
+  0x5465, // U+00EB latin small letter e with diaeresis
+  0x4469, // U+00EC latin small letter i with grave
+  0x4869, // U+00ED latin small letter i with acute
+  0x4C69, // U+00EE latin small letter i with circumflex
+  0x5469, // U+00EF latin small letter i with diaeresis
+  0x0000, // U+00F0 latin small letter eth
+  0x506E, // U+00F1 latin small letter n with tilde
+  0x446F, // U+00F2 latin small letter o with grave
+  0x486F, // U+00F3 latin small letter o with acute
+  0x4C6F, // U+00F4 latin small letter o with circumflex
+  0x506F, // U+00F5 latin small letter o with tilde
+  0x546F, // U+00F6 latin small letter o with diaeresis
+  0x8003, // U+00F7 division sign
+  0x8016, // U+00F8 latin small letter o with stroke
+  0x4475, // U+00F9 latin small letter u with grave
+  0x4875, // U+00FA latin small letter u with acute
+  0x4C75, // U+00FB latin small letter u with circumflex
+  0x5475, // U+00FC latin small letter u with diaeresis
+  0x4879, // U+00FD latin small letter y with acute
+  0x0000, // U+00FE latin small letter thorn
+  0x5479, // U+00FF latin small letter y with diaeresis
+  0x4041, // U+0391 greek capital letter alpha
+  0x4042, // U+0392 greek capital letter beta
+  0x8017, // U+0393 greek capital letter gamma
+  0x8018, // U+0394 greek capital letter delta
+  0x4045, // U+0395 greek capital letter epsilon
+  0x405A, // U+0396 greek capital letter zeta
+  0x4048, // U+0397 greek capital letter eta
+  0x8019, // U+0398 greek capital letter theta
+  0x4049, // U+0399 greek capital letter iota
+  0x404B, // U+039A greek capital letter kappa
+  0x801A, // U+039B greek capital letter lamda
+  0x404D, // U+039C greek capital letter mu
+  0x404E, // U+039D greek capital letter nu
+  0x801B, // U+039E greek capital letter xi
+  0x404F, // U+039F greek capital letter omicron
+  0x801C, // U+03A0 greek capital letter pi
+  0x4050, // U+03A1 greek capital letter rho
+  0x0000, // U+03A2 unassigned
+  0x801D, // U+03A3 greek capital letter sigma
+  0x4054, // U+03A4 greek capital letter tau
+  0x4059, // U+03A5 greek capital letter upsilon
+  0x801E, // U+03A6 greek capital letter phi
+  0x4058, // U+03A7 greek capital letter chi
+  0x801F, // U+03A8 greek capital letter psi
+  0x8020, // U+03A9 greek capital letter omega
+  0x0000, // U+03AA greek capital letter iota with dialytika
+  0x0000, // U+03AB greek capital letter upsilon with dialytika
+  0x0000, // U+03AC greek small letter alpha with tonos
+  0x0000, // U+03AD greek small letter epsilon with tonos
+  0x0000, // U+03AE greek small letter eta with tonos
+  0x0000, // U+03AF greek small letter iota with tonos
+  0x0000, // U+03B0 greek small letter upsilon with dialytika and tonos
+  0x8021, // U+03B1 greek small letter alpha
+  0x8022, // U+03B2 greek small letter beta
+  0x8023, // U+03B3 greek small letter gamma
+  0x8024, // U+03B4 greek small letter delta
+  0x8025, // U+03B5 greek small letter epsilon
+  0x0000, // U+03B6 greek small letter zeta
+  0x406E, // U+03B7 greek small letter eta
+  0x8026, // U+03B8 greek small letter theta
+  0x4069, // U+03B9 greek small letter iota
+  0x406B, // U+03BA greek small letter kappa
+  0x8027, // U+03BB greek small letter lamda
+  0x8028, // U+03BC greek small letter mu
+  0x4076, // U+03BD greek small letter nu
+  0x0000, // U+03BE greek small letter xi
+  0x406F, // U+03BF greek small letter omicron
+  0x8029, // U+03C0 greek small letter pi
+  0x4070, // U+03C1 greek small letter rho
+  0x4063, // U+03C2 greek small letter final sigma
+  0x802A, // U+03C3 greek small letter sigma
+  0x802B, // U+03C4 greek small letter tau
+  0x4075, // U+03C5 greek small letter upsilon
+  0x802C, // U+03C6 greek small letter phi
+  0x4078, // U+03C7 greek small letter chi
+  0x801F, // U+03C8 greek small letter psi
+  0x802D, // U+03C9 greek small letter omega
+  0x5445, // U+0401 cyrillic capital letter io
+  0x0000, // U+0402 cyrillic capital letter dje
+  0x0000, // U+0403 cyrillic capital letter gje
+  0x0000, // U+0404 cyrillic capital letter ukrainian ie
+  0x4053, // U+0405 cyrillic capital letter dze
+  0x4049, // U+0406 cyrillic capital letter byelorussian-ukrainian i
+  0x0000, // U+0407 cyrillic capital letter yi
+  0x404A, // U+0408 cyrillic capital letter je
+  0x0000, // U+0409 cyrillic capital letter lje
+  0x0000, // U+040A cyrillic capital letter nje
+  0x0000, // U+040B cyrillic capital letter tshe
+  0x0000, // U+040C cyrillic capital letter kje
+  0x0000, // U+040D cyrillic capital letter i with grave
+  0x0000, // U+040E cyrillic capital letter short u
+  0x0000, // U+040F cyrillic capital letter dzhe
+  0x4041, // U+0410 cyrillic capital letter a
+  0x802E, // U+0411 cyrillic capital letter be
+  0x4042, // U+0412 cyrillic capital letter ve
+  0x8017, // U+0413 cyrillic capital letter ghe
+  0x802F, // U+0414 cyrillic capital letter de
+  0x4045, // U+0415 cyrillic capital letter ie
+  0x8030, // U+0416 cyrillic capital letter zhe
+  0x4033, // U+0417 cyrillic capital letter ze
+  0x8031, // U+0418 cyrillic capital letter i
+  0xA031, // U+0419 cyrillic capital letter short i
+  0x404B, // U+041A cyrillic capital letter ka
+  0x8032, // U+041B cyrillic capital letter el
+  0x404D, // U+041C cyrillic capital letter em
+  0x4048, // U+041D cyrillic capital letter en
+  0x404F, // U+041E cyrillic capital letter o
+  0x801C, // U+041F cyrillic capital letter pe
+  0x4050, // U+0420 cyrillic capital letter er
+  0x4043, // U+0421 cyrillic capital letter es
+  0x4054, // U+0422 cyrillic capital letter te
+  0x803D, // U+0423 cyrillic capital letter u
+  0x801E, // U+0424 cyrillic capital letter ef
+  0x4058, // U+0425 cyrillic capital letter ha
+  0x8033, // U+0426 cyrillic capital letter tse
+  0x8034, // U+0427 cyrillic capital letter che
+  0x8035, // U+0428 cyrillic capital letter sha
+  0x8036, // U+0429 cyrillic capital letter shcha
+  0x8037, // U+042A cyrillic capital letter hard sign
+  0x8038, // U+042B cyrillic capital letter yeru
+  0x8039, // U+042C cyrillic capital letter soft sign
+  0x803A, // U+042D cyrillic capital letter e
+  0x803B, // U+042E cyrillic capital letter yu
+  0x803C, // U+042F cyrillic capital letter ya
+  0x4061, // U+0430 cyrillic small letter a
+  0x802E, // U+0431 cyrillic small letter be
+  0x4042, // U+0432 cyrillic small letter ve
+  0x8017, // U+0433 cyrillic small letter ghe
+  0x802F, // U+0434 cyrillic small letter de
+  0x4065, // U+0435 cyrillic small letter ie
+  0x8030, // U+0436 cyrillic small letter zhe
+  0x4033, // U+0437 cyrillic small letter ze
+  0x8031, // U+0438 cyrillic small letter i
+  0xA031, // U+0439 cyrillic small letter short i
+  0x406B, // U+043A cyrillic small letter ka
+  0x8032, // U+043B cyrillic small letter el
+  0x404D, // U+043C cyrillic small letter em
+  0x4048, // U+043D cyrillic small letter en
+  0x406F, // U+043E cyrillic small letter o
+  0x801C, // U+043F cyrillic small letter pe
+  0x4070, // U+0440 cyrillic small letter er
+  0x4063, // U+0441 cyrillic small letter es
+  0x4054, // U+0442 cyrillic small letter te
+  0x4079, // U+0443 cyrillic small letter u
+  0x801E, // U+0444 cyrillic small letter ef
+  0x4078, // U+0445 cyrillic small letter ha
+  0x8033, // U+0446 cyrillic small letter tse
+  0x8034, // U+0447 cyrillic small letter che
+  0x8035, // U+0448 cyrillic small letter sha
+  0x8036, // U+0449 cyrillic small letter shcha
+  0x8037, // U+044A cyrillic small letter hard sign
+  0x8038, // U+044B cyrillic small letter yeru
+  0x8039, // U+044C cyrillic small letter soft sign
+  0x803A, // U+044D cyrillic small letter e
+  0x803B, // U+044E cyrillic small letter yu
+  0x803C, // U+044F cyrillic small letter ya
+  0x0000, // U+0450 cyrillic small letter ie with grave
+  0x5465, // U+0451 cyrillic small letter io
+  0x0000, // U+0452 cyrillic small letter dje
+  0x0000, // U+0453 cyrillic small letter gje
+  0x0000, // U+0454 cyrillic small letter ukrainian ie
+  0x4073, // U+0455 cyrillic small letter dze
+  0x4069, // U+0456 cyrillic small letter byelorussian-ukrainian i
+  0x0000, // U+0457 cyrillic small letter yi
+  0x406A, // U+0458 cyrillic small letter je
+  0x402D, // U+2010 hyphen
+  0x402D, // U+2011 non-breaking hyphen
+  0x402D, // U+2012 figure dash
+  0x402D, // U+2013 en dash
+  0x402D, // U+2014 em dash
+  0x402D, // U+2015 horizontal bar
+  0x0000, // U+2016 double vertical line
+  0x0000, // U+2017 double low line
+  0x4027, // U+2018 left single quotation mark
+  0x4027, // U+2019 right single quotation mark
+  0x402C, // U+201A single low-9 quotation mark
+  0x4027, // U+201B single high-reversed-9 quotation mark
+  0x4022, // U+201C left double quotation mark
+  0x4022, // U+201D right double quotation mark
+  0x4022, // U+201E double low-9 quotation mark
+  0x4022, // U+201F double high-reversed-9 quotation mark
+  0x0000, // U+2020 dagger
+  0x0000, // U+2021 double dagger
+  0x8001, // U+2022 bullet
+  0x0000, // U+2023 triangular bullet
+  0x402E, // U+2024 one dot leader
+  0x0000, // U+2025 two dot leader
+  0x8009, // U+2026 horizontal ellipsis
+  0x8007, // U+20AC euro sign
+  0x800A, // U+2190 leftwards arrow
+  0x800B, // U+2191 upwards arrow
+  0x800C, // U+2192 rightwards arrow
+  0x800D, // U+2193 downwards arrow
+  0x800E, // U+2600 black sun with rays
+  0x800F, // U+2601 cloud
+  0x8010, // U+2602 umbrella
+  0x8012, // U+26A1 high voltage sign
+  0x8011, // U+2744 snowflake
+];
+
+//disable prettier formatting this array
+// prettier-ignore
+export const ext8By12 = [
+  0x00386C6C, 0x38000000, 0x00000000, // degree
+  0x00000000, 0x00383800, 0x00000000, // middle dot
+  0x000000C6, 0x6C386CC6, 0x00000000, // multiplication
+  0x00001818, 0x00FE0018, 0x18000000, // division
+  0x00303000, 0x30303078, 0x78783000, // inverted exclamation
+  0x00181800, 0x18183060, 0xCC780000, // inverted question
+  0x003C6660, 0x60F86060, 0x60FE0000, // pound
+  0x001E3360, 0xFC60FC60, 0x331E0000, // euro
+  0x0078CCCC, 0xD8CCC6C6, 0xCCD8C000, // sharp s
+  0x00000000, 0x00000000, 0xDBDB0000, // ellipsis
+  0x00001030, 0x60FE6030, 0x10000000, // arrow left
+  0x00183C7E, 0x18181818, 0x18180000, // arrow up
+  0x0000080C, 0x06FE060C, 0x08000000, // arrow right
+  0x00181818, 0x1818187E, 0x3C180000, // arrow down
+  0x00108238, 0x7CFE7C38, 0x82100000, // sun
+  0x00000018, 0x3C7EFFFF, 0x7E000000, // cloud
+  0x00187EFF, 0xFF181818, 0xD8700000, // umbrella
+  0x00105438, 0x92FE9238, 0x54100000, // snowflake
+  0x00060C18, 0x307E0C18, 0x30600000, // lightning
+  0x007ED8D8, 0xD8FCD8D8, 0xD8DE0000, // AE
+  0x00000000, 0x6C1A7ED8, 0xDA6C0000, // ae
+  0x00396ECE, 0xD6D6D6E6, 0x74B80000, // O stroke
+  0x00000000, 0x7CCCDCEC, 0xCCF80000, // o stroke
+  0x00FEFEC0, 0xC0C0C0C0, 0xC0C00000, // Gamma
+  0x00103838, 0x6C6CC6C6, 0xFEFE0000, // Delta
+  0x00386CC6, 0xC6FEC6C6, 0x6C380000, // Theta
+  0x00103838, 0x6C6CC6C6, 0xC6C60000, // Lambda
+  0x00FEFE00, 0x007C0000, 0xFEFE0000, // Xi
+  0x00FEFEC6, 0xC6C6C6C6, 0xC6C60000, // Pi
+  0x00FEC060, 0x30183060, 0xC0FE0000, // Sigma
+  0x00187EDB, 0xDBDBDB7E, 0x18180000, // Phi
+  0x00DBDBDB, 0xDB7E3C18, 0x18180000, // Psi
+  0x00386CC6, 0xC6C6C66C, 0x6CEE0000, // Omega
+  0x00000000, 0x76DCCCCC, 0xDC760000, // alpha
+  0x0078CCCC, 0xD8CCC6C6, 0xCCF8C0C0, // beta
+  0x00000000, 0xC6C66C6C, 0x38381010, // gamma
+  0x007CC060, 0x386CC6C6, 0x6C380000, // delta
+  0x00000000, 0x78C070C0, 0xC0780000, // epsilon
+  0x00386C6C, 0x6C7C6C6C, 0x6C380000, // theta
+  0x00C06030, 0x30386C6C, 0xC6C60000, // lambda
+  0x00000000, 0xCCCCCCCC, 0xCCFAC0C0, // mu
+  0x00000000, 0xFEFE6C6C, 0x6C660000, // pi
+  0x00000000, 0x7ECCC6C6, 0xC67C0000, // sigma
+  0x00000000, 0xFEFE3030, 0x301C0000, // tau
+  0x00000018, 0x7EDBDBDB, 0x7E181818, // phi
+  0x00000000, 0x6CC6D6D6, 0xD66C0000, // omega
+  0x00FEC0C0, 0xC0FCC6C6, 0xC6FC0000, // Be
+  0x003C6C6C, 0x6C6C6C6C, 0xFEC6C600, // De
+  0x00929254, 0x54385454, 0x92920000, // Zhe
+  0x00C6C6CE, 0xCED6E6E6, 0xC6C60000, // Cyrillic I
+  0x003E6666, 0x66666666, 0x66C60000, // El
+  0x00CCCCCC, 0xCCCCCCCC, 0xCCFE0600, // Tse
+  0x00C6C6C6, 0xC67E0606, 0x06060000, // Che
+  0x00D6D6D6, 0xD6D6D6D6, 0xD6FE0000, // Sha
+  0x00D6D6D6, 0xD6D6D6D6, 0xD6FE0200, // Shcha
+  0x00E06060, 0x607C6666, 0x667C0000, // Hard sign
+  0x00C6C6C6, 0xC6F6DEDE, 0xDEF60000, // Yeru
+  0x00C0C0C0, 0xC0FCC6C6, 0xC6FC0000, // Soft sign
+  0x007CC606, 0x063E0606, 0xC67C0000, // Cyrillic E
+  0x00CEDBDB, 0xDBFBDBDB, 0xDBCE0000, // Yu
+  0x007EC6C6, 0xC67E3666, 0xC6C60000, // Ya
+  0x00C6C6C6, 0xC67E0606, 0xCC780000, // Cyrillic U
+];
+
+//disable prettier formatting this array
+// prettier-ignore
+export const ext6By8 = [
+  0x3124, 0x8C00, 0x0000, // degree
+  0x0000, 0x0C30, 0x0000, // middle dot
+  0x0004, 0x4A10, 0xA440, // multiplication
+  0x0040, 0x1F00, 0x4000, // division
+  0x0040, 0x0410, 0xE384, // inverted exclamation
+  0x1001, 0x0C41, 0x1380, // inverted question
+  0x1892, 0x1E20, 0x87C0, // pound
+  0x1C87, 0x8878, 0x81C0, // euro
+  0x3124, 0x9449, 0x1590, // sharp s
+  0x0000, 0x0000, 0x0540, // ellipsis
+  0x0042, 0x1F20, 0x4000, // arrow left
+  0x10E5, 0x4410, 0x4100, // arrow up
+  0x0040, 0x9F08, 0x4000, // arrow right
+  0x1041, 0x0454, 0xE100, // arrow down
+  0x1113, 0x9F39, 0x1100, // sun
+  0x0003, 0x1EFF, 0xF000, // cloud
+  0x31EF, 0xC411, 0x4200, // umbrella
+  0x1153, 0x8439, 0x5100, // snowflake
+  0x0842, 0x1E10, 0x8400, // lightning
+  0x3D45, 0x1E51, 0x45C0, // AE
+  0x0006, 0x857E, 0x46C0, // ae
+  0x3934, 0xD565, 0x9380, // O stroke
+  0x0003, 0xD355, 0x9F00, // o stroke
+  0x7D04, 0x1041, 0x0400, // Gamma
+  0x1042, 0x8A45, 0x17C0, // Delta
+  0x3914, 0x5F45, 0x1380, // Theta
+  0x10A2, 0x9145, 0x1440, // Lambda
+  0x7C00, 0x0E00, 0x07C0, // Xi
+  0x7D14, 0x5145, 0x1440, // Pi
+  0x7D02, 0x0421, 0x07C0, // Sigma
+  0x10E5, 0x5554, 0xE100, // Phi
+  0x5555, 0x4E10, 0x4100, // Psi
+  0x3914, 0x5128, 0xA6C0, // Omega
+  0x0003, 0x5249, 0x2340, // alpha
+  0x3125, 0x1245, 0x1790, // beta
+  0x0004, 0x5128, 0xA104, // gamma
+  0x3902, 0x0E45, 0x1380, // delta
+  0x0003, 0x9031, 0x0380, // epsilon
+  0x10A2, 0x8E28, 0xA100, // theta
+  0x4081, 0x0C29, 0x2440, // lambda
+  0x0004, 0x9249, 0x2750, // mu
+  0x000F, 0xCA28, 0xA240, // pi
+  0x0003, 0xD245, 0x1380, // sigma
+  0x0007, 0xC410, 0x40C0, // tau
+  0x0043, 0x9554, 0xE104, // phi
+  0x0002, 0x9155, 0x5280, // omega
+  0x7D04, 0x1E45, 0x1780, // Be
+  0x38A2, 0x8A29, 0xF440, // De
+  0x5553, 0x8439, 0x5540, // Zhe
+  0x4514, 0xD565, 0x1440, // Cyrillic I
+  0x3C92, 0x4924, 0x9440, // El
+  0x4924, 0x9249, 0xF040, // Tse
+  0x4514, 0x4F04, 0x1040, // Che
+  0x5555, 0x5555, 0x57C0, // Sha
+  0x5555, 0x5555, 0x57C1, // Shcha
+  0xC082, 0x0E24, 0x9380, // Hard sign
+  0x4514, 0x5D4D, 0x3740, // Yeru
+  0x4104, 0x1E45, 0x1780, // Soft sign
+  0x3910, 0x4F05, 0x1380, // Cyrillic E
+  0x4955, 0x5D55, 0x5480, // Yu
+  0x3D14, 0x4F14, 0x9440, // Ya
+  0x4514, 0x4F05, 0x1380, // Cyrillic U
+];
+
+//disable prettier formatting this array
+// prettier-ignore
+export const ext4By6 = [
+  0x4A, 0x40, 0x00, // degree
+  0x00, 0x40, 0x00, // middle dot
+  0x0A, 0x4A, 0x00, // multiplication
+  0x40, 0xE0, 0x40, // division
+  0x60, 0x66, 0x60, // inverted exclamation
+  0x40, 0x48, 0x60, // inverted question
+  0x64, 0xE4, 0xF0, // pound
+  0x78, 0xE8, 0x70, // euro
+  0x69, 0xA9, 0xA8, // sharp s
+  0x00, 0x00, 0xA0, // ellipsis
+  0x04, 0xF4, 0x00, // arrow left
+  0x4E, 0x44, 0x40, // arrow up
+  0x02, 0xF2, 0x00, // arrow right
+  0x44, 0x4E, 0x40, // arrow down
+  0xA4, 0xE4, 0xA0, // sun
+  0x06, 0xFF, 0x00, // cloud
+  0x6F, 0x2A, 0x40, // umbrella
+  0x0A, 0x4A, 0x00, // snowflake
+  0x24, 0xF2, 0x40, // lightning
+  0x7A, 0xFA, 0xB0, // AE
+  0x0E, 0x7C, 0xF0, // ae
+  0x6B, 0x9D, 0x60, // O stroke
+  0x07, 0xBD, 0xE0, // o stroke
+  0xF8, 0x88, 0x80, // Gamma
+  0x66, 0x99, 0xF0, // Delta
+  0x69, 0xF9, 0x60, // Theta
+  0x66, 0x99, 0x90, // Lambda
+  0xF0, 0x60, 0xF0, // Xi
+  0xF9, 0x99, 0x90, // Pi
+  0xF4, 0x24, 0xF0, // Sigma
+  0x4E, 0xAE, 0x40, // Phi
+  0xAA, 0xE4, 0x40, // Psi
+  0x69, 0x96, 0xF0, // Omega
+  0x05, 0xAA, 0x50, // alpha
+  0x69, 0xE9, 0xE8, // beta
+  0x09, 0x96, 0x44, // gamma
+  0x68, 0x69, 0x60, // delta
+  0x07, 0xC8, 0x70, // epsilon
+  0x69, 0xF9, 0x60, // theta
+  0x84, 0x69, 0x90, // lambda
+  0x09, 0x99, 0xF8, // mu
+  0x0F, 0x55, 0x50, // pi
+  0x07, 0xAA, 0x40, // sigma
+  0x0F, 0x44, 0x30, // tau
+  0x4E, 0xAE, 0x44, // phi
+  0x09, 0x9F, 0x60, // omega
+  0xF8, 0xE9, 0xE0, // Be
+  0x65, 0x5F, 0x90, // De
+  0xAE, 0x4E, 0xA0, // Zhe
+  0x99, 0xBD, 0x90, // Cyrillic I
+  0x75, 0x55, 0x90, // El
+  0xAA, 0xAF, 0x10, // Tse
+  0x99, 0x71, 0x10, // Che
+  0x99, 0x99, 0xF0, // Sha
+  0x99, 0x9F, 0x10, // Shcha
+  0xC4, 0x65, 0x60, // Hard sign
+  0x99, 0xDB, 0xD0, // Yeru
+  0x88, 0xE9, 0xE0, // Soft sign
+  0xE1, 0x71, 0xE0, // Cyrillic E
+  0xAD, 0xDD, 0xA0, // Yu
+  0x79, 0x75, 0x90, // Ya
+  0x99, 0x71, 0xE0, // Cyrillic U
+];
+
+export const marks8By12 = [
+  { height: 0, below: false, rows: [] },
+  { height: 2, below: false, rows: [0x30, 0x18] }, // grave
+  { height: 2, below: false, rows: [0x0c, 0x18] }, // acute
+  { height: 2, below: false, rows: [0x18, 0x24] }, // circumflex
+  { height: 2, below: false, rows: [0x34, 0x58] }, // tilde
+  { height: 1, below: false, rows: [0x6c] }, // diaeresis
+  { height: 3, below: false, rows: [0x38, 0x28, 0x38] }, // ring
+  { height: 2, below: true, rows: [0x18, 0x30] }, // cedilla
+  { height: 2, below: false, rows: [0x44, 0x38] }, // breve
+]
+
+export const marks6By8 = [
+  { height: 0, below: false, rows: [] },
+  { height: 2, below: false, rows: [0x08, 0x04] }, // grave
+  { height: 2, below: false, rows: [0x02, 0x04] }, // acute
+  { height: 2, below: false, rows: [0x04, 0x0a] }, // circumflex
+  { height: 2, below: false, rows: [0x0a, 0x14] }, // tilde
+  { height: 1, below: false, rows: [0x0a] }, // diaeresis
+  { height: 3, below: false, rows: [0x04, 0x0a, 0x04] }, // ring
+  { height: 2, below: true, rows: [0x04, 0x08] }, // cedilla
+  { height: 2, below: false, rows: [0x11, 0x0e] }, // breve
+]
+
+export const marks4By6 = [
+  { height: 0, below: false, rows: [] },
+  { height: 2, below: false, rows: [0x08, 0x04] }, // grave
+  { height: 2, below: false, rows: [0x02, 0x04] }, // acute
+  { height: 2, below: false, rows: [0x04, 0x0a] }, // circumflex
+  { height: 2, below: false, rows: [0x05, 0x0a] }, // tilde
+  { height: 1, below: false, rows: [0x09] }, // diaeresis
+  { height: 1, below: false, rows: [0x04] }, // ring
+  { height: 1, below: true, rows: [0x04] }, // cedilla
+  { height: 2, below: false, rows: [0x09, 0x06] }, // breve
+]
@@ -1,3 +1,5 @@
+import type { GraphSeries } from "./types"
+
 export type GraphData = {
   data: number[]
   scaleMax: number
@@ -109,3 +111,52 @@ export const smoothGraphValues = (data: number[]): number[] => {
 
   return smoothedData
 }
+
+/** The samples a device keeps for one series. See `appendSeries`. */
+export type SeriesBuffer = {
+  capacity: number
+  samples: number[]
+  /** How many samples have ever been appended */
+  total: number
+}
+
+/**
+ * Appends the samples of a graph's `series` to a buffer, the same way the
+ * device does. Samples the buffer has already seen are skipped, and a `start`
+ * from before everything it holds means the sender started over.
+ */
+export const appendSeries = (buffer: SeriesBuffer, series: GraphSeries) => {
+  let start = series.start ?? buffer.total
+  let samples = series.samples
+  if (start < buffer.total - buffer.samples.length) {
+    buffer.samples = []
+    buffer.total = 0
+  }
+
+  if (start < buffer.total) {
+    samples = samples.slice(buffer.total - start)
+    start = buffer.total
+  }
+  if (samples.length === 0) {
+    return
+  }
+
+  buffer.samples = [...buffer.samples, ...samples].slice(-buffer.capacity)
+  buffer.total = start + samples.length
+}
+
+/**
+ * Splits `samples` into `columns` groups, and returns the smallest and largest
+ * sample of each. Peaks are kept however many samples share a column.
+ */
+export const decimateSeries = (
+  samples: number[],
+  columns: number
+): { min: number; max: number }[] =>
+  Array.from({ length: columns }, (_, column) => {
+    const group = samples.slice(
+      Math.floor((column * samples.length) / columns),
+      Math.floor(((column + 1) * samples.length) / columns)
+    )
+    return { min: Math.min(...group), max: Math.max(...group) }
+  })
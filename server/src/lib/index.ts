@@ -1,6 +1,34 @@
 export * from "./types"
 export { fontSizeDetailsMap, fontSizeMap, fontIsValidAscii } from "./font"
 export { drawCommands } from "./drawCommands"
-export { cloneBitmap, createBitmap, mergeBitmaps } from "./bitmaps"
-export { generateGraphValues } from "./graphing"
-export { createNewAnimationsState } from "./animations"
+export {
+  cloneBitmap,
+  createBitmap,
+  mergeBitmaps,
+  indexBitmap,
+  expandIndexedBitmap,
+  transformBitmap,
+  compositeLayers,
+  encodeQoi,
+} from "./bitmaps"
+export {
+  generateGraphValues,
+  appendSeries,
+  decimateSeries,
+} from "./graphing"
+export type { SeriesBuffer } from "./graphing"
+export {
+  createNewAnimationsState,
+  animationFramesDue,
+  shortestFrameDuration,
+} from "./animations"
+export { createEffectState, stepEffect, effectRow } from "./effects"
+export { applyTweens, hasTweens, tweenTickMs } from "./tweens"
+export { toRGB, rotateHue } from "./colors"
+export { commandWireContentType, encodeCommands } from "./wire"
+export {
+  assetsHeader,
+  assetHash,
+  parseAssetsHeader,
+  referAssets,
+} from "./assets"
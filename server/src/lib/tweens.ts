@@ -0,0 +1,199 @@
+import { toRGB } from "./colors"
+import type {
+  Command,
+  CommandAnimation,
+  CommandLayer,
+  CommandLineFeed,
+  CommandPalette,
+  Tween,
+  TweenEasing,
+} from "./types"
+
+// the same fixed-point maths as the device, so the preview matches it exactly
+
+/** How often the device ticks while there are tweens, in milliseconds */
+export const tweenTickMs = 16
+
+/** The most keyframes a tween can have */
+const keyframesMax = 16
+/** A tween's progress between two keyframes, as a fraction of this */
+const progressOne = 65536
+
+const ease = (easing: TweenEasing | undefined, progress: number) => {
+  switch (easing) {
+    case "ease-in":
+      return Math.floor((progress * progress) / progressOne)
+    case "ease-out":
+      const inverse = progressOne - 1 - progress
+      return progressOne - 1 - Math.floor((inverse * inverse) / progressOne)
+    case "ease-in-out":
+      // smoothstep, 3p^2 - 2p^3
+      const square = Math.floor((progress * progress) / progressOne)
+      return 3 * square - 2 * Math.floor((square * progress) / progressOne)
+    default:
+      return progress
+  }
+}
+
+/** A keyframe's values, in the order the device keeps them */
+const keyframeValues = (tween: Tween, index: number): number[] => {
+  switch (tween.property) {
+    case "position":
+      const point = tween.keyframes[index]!.value
+      return [point.x, point.y, 0]
+    case "color":
+      // colors are tweened as RGB, whichever way the keyframes give them
+      const color = toRGB(tween.keyframes[index]!.value)
+      return [color.red, color.green, color.blue]
+    case "size":
+      const size = tween.keyframes[index]!.value
+      return [size.width, size.height, 0]
+    case "value":
+    case "hue-rotate":
+      return [tween.keyframes[index]!.value, 0, 0]
+  }
+}
+
+/** The commands that have a position and color to tween */
+type CommandWithState = Exclude<
+  Command,
+  CommandAnimation | CommandLayer | CommandLineFeed | CommandPalette
+>
+
+const hasState = (command: Command): command is CommandWithState =>
+  command.type !== "animation" &&
+  command.type !== "layer" &&
+  command.type !== "line-feed" &&
+  command.type !== "palette"
+
+const tweenFits = (command: Command, tween: Tween): boolean => {
+  const { keyframes } = tween
+  if (keyframes.length < 1 || keyframes.length > keyframesMax) {
+    return false
+  }
+  const isInOrder = keyframes.every(
+    (keyframe, index) =>
+      Number.isInteger(keyframe.time) &&
+      keyframe.time >= (index > 0 ? keyframes[index - 1]!.time : 0) &&
+      keyframeValues(tween, index).every(
+        (value) => Number.isInteger(value) && value >= 0 && value <= 255
+      )
+  )
+  if (!isInOrder) {
+    return false
+  }
+
+  switch (tween.property) {
+    case "position":
+    case "color":
+    case "hue-rotate":
+      return hasState(command)
+    case "size":
+      return command.type === "rect" || command.type === "graph"
+    case "value":
+      return (
+        command.type === "graph" &&
+        !command.series &&
+        (command.values?.length ?? 0) > 0
+      )
+  }
+}
+
+/** Where a tween is `elapsed` milliseconds after the commands were fetched */
+const tweenValues = (tween: Tween, elapsed: number): number[] => {
+  const { keyframes } = tween
+  const end = keyframes[keyframes.length - 1]!.time
+  let time = elapsed
+  if (end > 0 && tween.loop === "repeat") {
+    time = elapsed % end
+  } else if (end > 0 && tween.loop === "alternate") {
+    time = elapsed % (2 * end)
+    if (time > end) {
+      time = 2 * end - time
+    }
+  }
+
+  // before the first keyframe and after the last, the values are held
+  let next = 0
+  while (next < keyframes.length && keyframes[next]!.time <= time) {
+    next++
+  }
+  if (next === 0 || next === keyframes.length) {
+    return keyframeValues(tween, next === 0 ? 0 : next - 1)
+  }
+
+  const fromTime = keyframes[next - 1]!.time
+  const from = keyframeValues(tween, next - 1)
+  const to = keyframeValues(tween, next)
+  const progress = Math.floor(
+    ((time - fromTime) * progressOne) / (keyframes[next]!.time - fromTime)
+  )
+  const eased = ease(tween.easing, progress)
+  return from.map(
+    (value, i) => value + (((to[i]! - value) * eased + 0x8000) >> 16)
+  )
+}
+
+/**
+ * Returns a copy of `command` with each of its tweens moved to where they are
+ * `elapsed` milliseconds after the commands were fetched, as the device does
+ * each tick. Commands without tweens are returned as they are.
+ */
+export const applyTweens = <T extends Command>(
+  command: T,
+  elapsed: number
+): T => {
+  if (!hasState(command) || !command.tweens) {
+    return command
+  }
+
+  const tweened: Command = { ...command }
+  for (const tween of command.tweens) {
+    if (!tweenFits(command, tween)) {
+      console.warn("Tween does not fit its command", tween)
+      continue
+    }
+
+    const [a, b, c] = tweenValues(tween, Math.floor(elapsed)) as [
+      number,
+      number,
+      number,
+    ]
+    switch (tween.property) {
+      case "position":
+        if (hasState(tweened)) {
+          tweened.position = { x: a, y: b }
+        }
+        break
+      case "color":
+        if (hasState(tweened)) {
+          tweened.color = { red: a, green: b, blue: c }
+        }
+        break
+      case "size":
+        if (tweened.type === "rect" || tweened.type === "graph") {
+          tweened.size = { width: a, height: b }
+        }
+        break
+      case "value":
+        if (tweened.type === "graph" && tweened.values) {
+          tweened.values = [...tweened.values.slice(0, -1), a]
+        }
+        break
+      case "hue-rotate":
+        if (hasState(tweened)) {
+          tweened.hueRotate = a
+        }
+        break
+    }
+  }
+  return tweened as T
+}
+
+/** Whether any of the commands, or their animation frames, have tweens */
+export const hasTweens = (commands: Command[]): boolean =>
+  commands.some((command) =>
+    command.type === "animation"
+      ? command.frames.some(hasTweens)
+      : hasState(command) && (command.tweens?.length ?? 0) > 0
+  )
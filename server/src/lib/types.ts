@@ -4,7 +4,7 @@ export type RemoteState = {
   fetchInterval: number
 }
 
-export type FontSize = "sm" | "md" | "lg"
+export type FontSize = "sm" | "md" | "lg" | "prop"
 
 export type FontSizeDetails = {
   width: number
@@ -12,22 +12,127 @@ export type FontSizeDetails = {
   bitsPerChunk: number
   chunksPerChar: number
   spacing: number
+  /** Glyphs have their own width and advance, see `FontGlyph` */
+  proportional: boolean
   name: FontSize
 }
 
+export type FontGlyph = {
+  /** One entry per row, with the leftmost pixel in bit `width - 1` */
+  rows: number[]
+  width: number
+  /** Pixels between the cursor and the first column */
+  offsetX: number
+  /** Pixels to move the cursor after drawing, including spacing */
+  advance: number
+}
+
 export type ColorRGB = {
   red: number
   green: number
   blue: number
 }
 
+/**
+ * Each from 0 to 255. A hue of 0 is red, about 85 is green and about 171 is
+ * blue.
+ */
+export type ColorHSV = {
+  hue: number
+  saturation: number
+  value: number
+}
+
+export type ColorHSL = {
+  hue: number
+  saturation: number
+  lightness: number
+}
+
+/** Colors are turned into RGB when they're parsed, never for each pixel */
+export type Color = ColorRGB | ColorHSV | ColorHSL
+
+export type FillType = "gradient" | "checker" | "stripes"
+
+/** Which way the color of a fill changes */
+export type FillDirection = "horizontal" | "vertical" | "diagonal"
+
+export type FillStop<C extends Color = Color> = C & {
+  /** 0 to 255, in order. Stops without one are spread evenly. */
+  position?: number
+}
+
+/**
+ * Used instead of `color` for strings, graphs and rects. It is stretched over
+ * each rect or graph, and over each line of a string. Patterns alternate
+ * between the first two stops.
+ */
+export type Fill<C extends Color = Color> = {
+  type: FillType
+  /** Defaults to "horizontal" */
+  direction?: FillDirection
+  /** The size of each square or stripe of a pattern. Defaults to 1. */
+  size?: number
+  /** 2 to 8 stops */
+  stops: FillStop<C>[]
+}
+
+export type TweenEasing = "linear" | "ease-in" | "ease-out" | "ease-in-out"
+
+/**
+ * What a tween does after its last keyframe. "none" stays there, "repeat"
+ * starts again, and "alternate" goes back and forth.
+ */
+export type TweenLoop = "none" | "repeat" | "alternate"
+
+export type Keyframe<T> = {
+  /** Whole milliseconds since the commands were fetched, in order */
+  time: number
+  value: T
+}
+
+type TweenOf<P extends string, T> = {
+  property: P
+  /** 1 to 16 keyframes, with values from 0 to 255 */
+  keyframes: Keyframe<T>[]
+  /** Defaults to "linear" */
+  easing?: TweenEasing
+  /** Defaults to "none" */
+  loop?: TweenLoop
+}
+
+/**
+ * A property that the device moves between a few keyframes by the time since
+ * the commands were fetched, instead of needing a frame for each step. While
+ * there are any, the device ticks at about 60 fps. "size" is only for rects
+ * and graphs, "value" moves the newest of a graph's `values`, and "hue-rotate"
+ * cycles the colors. Colors are tweened as RGB.
+ */
+export type Tween =
+  | TweenOf<"position", Point>
+  | TweenOf<"color", Color>
+  | TweenOf<"size", Size>
+  | TweenOf<"value", number>
+  | TweenOf<"hue-rotate", number>
+
 export type State = {
-  color?: ColorRGB
+  /** Also clears the fill, unless one is set by the same command */
+  color?: Color
+  fill?: Fill
+  /**
+   * Turns the color, fill and an indexed bitmap's own `palette` around the
+   * color wheel, from 0 to 255. It doesn't carry on to later commands.
+   */
+  hueRotate?: number
   fontSize?: FontSize
+  /** Draws each font pixel as a block of this many pixels. 1 to 4. */
+  textScale?: number
   position?: {
     x: number
     y: number
   }
+  /** Replace the values above as they move. Any that don't fit are skipped. */
+  tweens?: Tween[]
 }
 
 export type Point = {
@@ -50,16 +155,115 @@ export type CommandLine = State & {
   to: Point
 }
 
-export type CommandBitmap = State & {
-  type: "bitmap"
-  data: {
-    red: number[]
-    green: number[]
-    blue: number[]
+export type Rotation = 0 | 90 | 180 | 270
+
+export type BitmapTransform = {
+  /** Nearest-neighbour scale factor, either for both axes or per axis */
+  scale?: number | { x: number; y: number }
+  /** Clockwise rotation, applied before scaling */
+  rotation?: Rotation
+}
+
+export type CommandBitmap = State &
+  BitmapTransform & {
+    type: "bitmap"
+    data: {
+      red: number[]
+      green: number[]
+      blue: number[]
+    }
+    size: Size
   }
+
+export type BitsPerPixel = 1 | 2 | 4 | 8
+
+export type CommandIndexedBitmap = State &
+  BitmapTransform & {
+    type: "indexed-bitmap"
+    bitsPerPixel: BitsPerPixel
+    /** Packed palette indexes, MSB first. Each row starts on a new byte. */
+    data: number[]
+    size: Size
+    /** Optional palette for just this bitmap. Defaults to the last `palette`. */
+    palette?: Color[]
+  }
+
+export type CommandPalette = {
+  type: "palette"
+  colors: Color[]
+}
+
+export type LayerName = "background" | "content" | "overlay"
+
+/** Black pixels are always transparent, whatever the blend mode */
+export type BlendMode = "normal" | "add"
+
+/** A rectangle at the cursor, drawn with the current fill or color */
+export type CommandRect = State & {
+  type: "rect"
   size: Size
 }
 
+export type EffectName = "plasma" | "fire" | "starfield" | "noise"
+
+/**
+ * An animation worked out on the device each tick, at the cursor, instead of
+ * being sent as frames. Each pixel gets a level from 0 to 255, which is looked
+ * up in a ramp made from `colors`. Effects start again whenever the commands
+ * change.
+ */
+export type CommandEffect = State & {
+  type: "effect"
+  effect: EffectName
+  size: Size
+  /**
+   * How far the effect moves each tick, from 1 to 255. Fire rises this many
+   * rows, up to 4.
+   */
+  speed?: number
+  /**
+   * From 1 to 255. Plasma and noise: how many pixels wide the waves and blobs
+   * are. Fire: how quickly the heat cools. Starfield: how many stars, up to
+   * 64.
+   */
+  scale?: number
+  /** The same seed always plays the same way. Defaults to 1. */
+  seed?: number
+  /** 2 to 8 stops, from level 0 to 255. Each effect has its own default. */
+  colors?: FillStop[]
+}
+
+/** What the preview keeps of an effect between frames */
+export type EffectState = {
+  effect: EffectName
+  width: number
+  height: number
+  speed: number
+  scale: number
+  seed: number
+  random: number
+  time: number
+  /** The level of each pixel, for fire and the starfield */
+  levels?: Uint8Array
+  stars: { x: number; y: number; z: number }[]
+  ramp: ColorRGB[]
+}
+
+/**
+ * Picks the layer that the following commands draw into. Each layer starts
+ * with the default drawing state, and layers are composited bottom up:
+ * background, content, then overlay. Commands before the first `layer` draw
+ * into the content layer.
+ */
+export type CommandLayer = {
+  type: "layer"
+  layer: LayerName
+  /** 0 (transparent) to 255 (opaque). Defaults to 255. */
+  opacity?: number
+  /** Defaults to "normal" */
+  blend?: BlendMode
+}
+
 export type CommandSetState = State & {
   type: "set-state"
 }
@@ -71,11 +275,40 @@ export type CommandLineFeed = {
 export type CommandAnimation = {
   type: "animation"
   frames: AnimationFrameCommand[][]
+  /**
+   * Makes each frame only draw what changed since the last one, into a canvas
+   * of this size at the cursor. Black pixels in the canvas are left
+   * transparent, so drawing black erases, and the first frame starts from an
+   * empty canvas. The device only redraws the pixels each frame changes.
+   */
+  size?: Size
+  /**
+   * Milliseconds to show each frame for, from 5 to 65535, instead of the
+   * animation delay. Frames past the end use `delay`. The animation keeps its
+   * own time, so frames that are already over by the time the device gets to
+   * them are skipped.
+   */
+  durations?: number[]
+  /**
+   * Milliseconds to show each frame without a duration for, from 5 to 65535.
+   * Defaults to the animation delay. Like `durations`, the animation keeps its
+   * own time, so an animation with a `size` and a `delay` is a region of the
+   * screen with its own frame rate. The device only redraws a region when its
+   * next frame is due.
+   */
+  delay?: number
 }
 
 export type AnimationState = {
   frameCount: number
   lastShowFrame: number
+  /** the frames drawn so far, for an animation with a `size` */
+  canvas?: Bitmap
+  /**
+   * when the next frame is due, in milliseconds since the commands were
+   * shown, for an animation with `durations` or a `delay`
+   */
+  nextFrameAt?: number
 }
 
 export type CommandTime = State & {
@@ -86,11 +319,38 @@ export type CommandDate = State & {
   type: "date"
 }
 
+export type GraphStyle = "bar" | "line" | "area"
+
+/** Samples to append to one of the series the device keeps between fetches */
+export type GraphSeries = {
+  /** Which series, from 0 to 7 */
+  id: number
+  /** How many samples the device keeps. Defaults to the graph's width. */
+  capacity?: number
+  /**
+   * The number of the first sample, counting every sample ever sent. Samples
+   * the device already has are skipped, so it is safe to resend them. Without
+   * it, every sample is appended.
+   */
+  start?: number
+  samples: number[]
+}
+
 export type CommandGraph = State & {
   type: "graph"
   size: Size
-  values: number[]
-  backgroundColor?: ColorRGB
+  /** Already scaled to the graph's height. Not needed with `series`. */
+  values?: number[]
+  /** Graphs a series kept on the device instead of `values` */
+  series?: GraphSeries
+  /** Defaults to "bar" */
+  style?: GraphStyle
+  /**
+   * The sample values at the bottom and top of a series graph. Without it,
+   * the graph is scaled to fit its samples.
+   */
+  scale?: { min: number; max: number }
+  backgroundColor?: Color
 }
 
 export type Command =
@@ -103,19 +363,57 @@ export type Command =
   | CommandTime
   | CommandDate
   | CommandGraph
+  | CommandIndexedBitmap
+  | CommandPalette
+  | CommandLayer
+  | CommandRect
+  | CommandEffect
 
-export type AnimationFrameCommand = Exclude<Command, CommandAnimation>
+export type AnimationFrameCommand = Exclude<
+  Command,
+  CommandAnimation | CommandLayer
+>
 
 export type Bitmap = Pick<CommandBitmap, "size" | "data">
 
+export type IndexedBitmap = Pick<
+  CommandIndexedBitmap,
+  "size" | "bitsPerPixel" | "data"
+> & {
+  palette: ColorRGB[]
+}
+
+export type Layer = {
+  bitmap: Bitmap
+  opacity: number
+  blend: BlendMode
+}
+
 export type DrawingState = {
   cursor: Point
   color: ColorRGB
+  fill?: Fill<ColorRGB>
   font: FontSizeDetails
+  textScale: number
+  palette?: ColorRGB[]
+}
+
+/**
+ * How the device changes to these commands from the last ones it showed. The
+ * new commands are drawn off-screen, and mixed with the old frame until the
+ * transition is over. Only played on the device.
+ */
+export type Transition = {
+  type: "crossfade" | "wipe" | "slide"
+  /** The way a wipe's edge, or a slide, moves. Defaults to "left". */
+  direction?: "left" | "right" | "up" | "down"
+  /** Milliseconds, from 1 to 65535. Defaults to 500. */
+  duration?: number
 }
 
 type CommandsConfig = {
   animationDelay: number
+  transition?: Transition
 }
 
 export type CommandApiResponse = {
@@ -0,0 +1,116 @@
+import { assetBytes, assetHash } from "./assets"
+import { encodeQoi } from "./bitmaps"
+import type { Command, CommandApiResponse } from "./types"
+
+/** What the device asks for when it can decode the binary format */
+export const commandWireContentType = "application/vnd.illumindex.commands"
+
+// the same layout as `COMMAND_WIRE_MAGIC` in the firmware: "ILX", a version
+// byte, the length of the JSON section, the JSON, and then the blobs
+const magic = [0x49, 0x4c, 0x58]
+const version = 1
+const headerLength = 8
+
+/** Where some bytes are in the blobs, in place of an array in the JSON */
+type BlobRef = {
+  blob: number
+  length: number
+}
+
+/** Identical bytes, such as an icon in each frame, are only added once */
+type AddBlob = (bytes: ArrayLike<number>, hash?: string) => BlobRef
+
+/**
+ * The command with its bitmap data or graph values moved into the blobs. The
+ * device reads them straight from the blobs, instead of parsing an array of
+ * numbers.
+ * Bitmaps the device already has in `assets` are only sent as their hash, and
+ * full color bitmaps are compressed.
+ */
+const encodeCommand = (
+  command: Command,
+  addBlob: AddBlob,
+  assets: Set<string>
+): object => {
+  switch (command.type) {
+    case "bitmap":
+    case "indexed-bitmap":
+      // the same bytes as the device keeps, so it finds them by their hash
+      const bytes = assetBytes(command)
+      const asset = assetHash(bytes)
+      if (assets.has(asset)) {
+        return { ...command, data: { asset } }
+      }
+      // a QOI image when it's smaller, which the device decodes from the blob
+      const qoi = command.type === "bitmap" ? encodeQoi(command) : undefined
+      return {
+        ...command,
+        data:
+          qoi && qoi.length < bytes.length
+            ? { encoding: "qoi", ...addBlob(qoi, `qoi:${asset}`) }
+            : addBlob(bytes, asset),
+      }
+    case "graph":
+      return command.values
+        ? { ...command, values: addBlob(command.values) }
+        : command
+    case "animation":
+      return {
+        ...command,
+        frames: command.frames.map((frame) =>
+          frame.map((frameCommand) =>
+            encodeCommand(frameCommand, addBlob, assets)
+          )
+        ),
+      }
+    default:
+      return command
+  }
+}
+
+/**
+ * Encodes commands into the binary format. The rest of the commands stay as
+ * JSON, which is small next to the bitmaps.
+ */
+export const encodeCommands = (
+  response: CommandApiResponse,
+  assets: Set<string> = new Set()
+): Uint8Array => {
+  const blobs: Uint8Array[] = []
+  const blobsByHash = new Map<string, BlobRef>()
+  let blobsLength = 0
+  const addBlob: AddBlob = (bytes, hash) => {
+    const added = hash !== undefined ? blobsByHash.get(hash) : undefined
+    if (added) {
+      return added
+    }
+    const blob = { blob: blobsLength, length: bytes.length }
+    blobs.push(Uint8Array.from(bytes))
+    blobsLength += bytes.length
+    if (hash !== undefined) {
+      blobsByHash.set(hash, blob)
+    }
+    return blob
+  }
+
+  const json = new TextEncoder().encode(
+    JSON.stringify({
+      ...response,
+      commands: response.commands.map((command) =>
+        encodeCommand(command, addBlob, assets)
+      ),
+    })
+  )
+
+  const body = new Uint8Array(headerLength + json.length + blobsLength)
+  body.set(magic)
+  body[3] = version
+  new DataView(body.buffer).setUint32(4, json.length, true)
+  body.set(json, headerLength)
+  let offset = headerLength + json.length
+  for (const blob of blobs) {
+    body.set(blob, offset)
+    offset += blob.length
+  }
+  return body
+}
@@ -1,6 +1,7 @@
 import {
   AnimationFrameCommand,
   fontSizeDetailsMap,
+  indexBitmap,
   type Command,
   type CommandApiResponse,
 } from "@/lib"
@@ -72,13 +73,15 @@ export const main = async (): Promise<CommandApiResponse> => {
       isDayTime: weather.current.is_day,
     })
 
+    // the weather icons only use a few colors, so send them as palette
+    // indexes instead of full RGB channels
     commands.push({
-      type: "bitmap",
+      type: "indexed-bitmap",
       position: {
         x: SCREEN.width - weatherBitmap.size.width - 2,
         y: dividerLineY + 3,
       },
-      ...weatherBitmap,
+      ...indexBitmap(weatherBitmap),
     })
 
     commands.push({
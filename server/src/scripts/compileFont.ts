@@ -0,0 +1,291 @@
+/**
+ * This script compiles a BDF bitmap font into the packed proportional font
+ * tables used by the firmware (`font_prop_data.h`) and the matching metrics
+ * used by the server preview (`fontPropData.ts`), so both always agree.
+ *
+ * Outline fonts can be rasterised to BDF first (e.g. with `otf2bdf`).
+ * Kerning pairs are read from AFM style comments in the BDF header:
+ *   COMMENT KPX <left glyph name> <right glyph name> <adjust>
+ */
+
+import { readFileSync, writeFileSync } from "node:fs"
+import { basename, resolve } from "node:path"
+
+const cOutPath = resolve(
+  __dirname,
+  "../../../firmware/components/gfx/font_prop_data.h"
+)
+const tsOutPath = resolve(__dirname, "../lib/fontPropData.ts")
+
+// glyph rows are stored as one byte each
+const glyphWidthMax = 8
+// matches `FONT_HEIGHT_MAX` in the firmware
+const fontHeightMax = 12
+
+type BdfGlyph = {
+  name: string
+  codepoint: number
+  advance: number
+  width: number
+  height: number
+  offsetX: number
+  offsetY: number
+  bitmap: number[]
+}
+
+type CompiledGlyph = {
+  name: string
+  codepoint: number
+  rows: number
+  width: number
+  height: number
+  top: number
+  offsetX: number
+  advance: number
+}
+
+type Kerning = { left: number; right: number; adjust: number }
+
+const parseBdf = (source: string) => {
+  const lines = source.split(/\r?\n/)
+  const glyphs: BdfGlyph[] = []
+  const kernNames: { left: string; right: string; adjust: number }[] = []
+  let ascent: number | undefined
+  let descent: number | undefined
+  let glyph: Partial<BdfGlyph> | undefined
+  let inBitmap = false
+
+  for (const line of lines) {
+    const [keyword, ...args] = line.trim().split(/\s+/)
+    if (inBitmap) {
+      if (keyword === "ENDCHAR") {
+        inBitmap = false
+        glyphs.push(glyph as BdfGlyph)
+        glyph = undefined
+      } else {
+        glyph!.bitmap!.push(parseInt(keyword!, 16))
+      }
+      continue
+    }
+
+    switch (keyword) {
+      case "COMMENT":
+        if (args[0] === "KPX" && args.length === 4) {
+          kernNames.push({
+            left: args[1]!,
+            right: args[2]!,
+            adjust: Number(args[3]),
+          })
+        }
+        break
+      case "FONT_ASCENT":
+        ascent = Number(args[0])
+        break
+      case "FONT_DESCENT":
+        descent = Number(args[0])
+        break
+      case "STARTCHAR":
+        glyph = { name: args.join(" "), bitmap: [] }
+        break
+      case "ENCODING":
+        glyph!.codepoint = Number(args[0])
+        break
+      case "DWIDTH":
+        glyph!.advance = Number(args[0])
+        break
+      case "BBX":
+        glyph!.width = Number(args[0])
+        glyph!.height = Number(args[1])
+        glyph!.offsetX = Number(args[2])
+        glyph!.offsetY = Number(args[3])
+        break
+      case "BITMAP":
+        inBitmap = true
+        break
+    }
+  }
+
+  if (ascent === undefined || descent === undefined) {
+    throw new Error("BDF is missing FONT_ASCENT or FONT_DESCENT")
+  }
+
+  return { ascent, descent, glyphs, kernNames }
+}
+
+const compile = (source: string) => {
+  const { ascent, descent, glyphs, kernNames } = parseBdf(source)
+  const height = ascent + descent
+  if (height > fontHeightMax) {
+    throw new Error(
+      `Font is ${height}px tall, the most supported is ${fontHeightMax}px`
+    )
+  }
+
+  const rows: number[] = []
+  const compiled: CompiledGlyph[] = glyphs
+    // unencoded glyphs have an encoding of -1
+    .filter((glyph) => glyph.codepoint >= 0 && glyph.codepoint <= 0xffff)
+    .sort((a, b) => a.codepoint - b.codepoint)
+    .map((glyph) => {
+      if (glyph.width > glyphWidthMax) {
+        throw new Error(
+          `Glyph "${glyph.name}" is wider than ${glyphWidthMax}px`
+        )
+      }
+
+      // BDF rows are padded to whole bytes with the leftmost pixel in the
+      // highest bit. The firmware wants the leftmost pixel in bit `width - 1`.
+      const rowBytes = Math.ceil(glyph.width / 8)
+      const top = Math.max(0, ascent - glyph.offsetY - glyph.height)
+      const glyphRows = glyph.bitmap
+        .slice(0, Math.min(glyph.height, height - top))
+        .map((row) => row >> (rowBytes * 8 - glyph.width))
+
+      const start = rows.length
+      rows.push(...glyphRows)
+      return {
+        name: glyph.name,
+        codepoint: glyph.codepoint,
+        rows: start,
+        width: glyph.width,
+        height: glyphRows.length,
+        top,
+        offsetX: glyph.offsetX,
+        advance: glyph.advance,
+      }
+    })
+
+  const byName = new Map(compiled.map((glyph) => [glyph.name, glyph]))
+  const kerning: Kerning[] = kernNames
+    .map(({ left, right, adjust }) => {
+      const leftGlyph = byName.get(left)
+      const rightGlyph = byName.get(right)
+      if (!leftGlyph || !rightGlyph) {
+        throw new Error(`Kerning pair "${left} ${right}" names a missing glyph`)
+      }
+      return {
+        left: leftGlyph.codepoint,
+        right: rightGlyph.codepoint,
+        adjust,
+      }
+    })
+    .sort((a, b) => a.left - b.left || a.right - b.right)
+
+  const widthMax = Math.max(...compiled.map((glyph) => glyph.width))
+
+  return { height, widthMax, glyphs: compiled, rows, kerning }
+}
+
+const hex = (value: number, digits: number) =>
+  `0x${value.toString(16).toUpperCase().padStart(digits, "0")}`
+
+const writeC = (font: ReturnType<typeof compile>, sourceName: string) => {
+  const lines = [
+    `// Generated by server/src/scripts/compileFont.ts from ${sourceName}.`,
+    "// Do not edit, run `npm run font:compile` instead.",
+    "#pragma once",
+    "",
+    `#define FONT_PROP_HEIGHT ${font.height}`,
+    `#define FONT_PROP_WIDTH_MAX ${font.widthMax}`,
+    "",
+    "// glyph metrics, sorted by codepoint. See `font_prop_glyph_t`",
+    `const static font_prop_glyph_t prop_glyphs[${font.glyphs.length}] = {`,
+    ...font.glyphs.map(
+      (glyph) =>
+        `    {${hex(glyph.codepoint, 4)}, ${glyph.rows}, ${glyph.width}, ${glyph.height}, ${glyph.top}, ${glyph.offsetX}, ${glyph.advance}}, // ${glyph.name}`
+    ),
+    "};",
+    "",
+    "// the rows with ink of every glyph, back to back",
+    `const static uint8_t prop_rows[${font.rows.length}] = {`,
+  ]
+  for (let index = 0; index < font.rows.length; index += 12) {
+    lines.push(
+      `    ${font.rows
+        .slice(index, index + 12)
+        .map((row) => `${hex(row, 2)},`)
+        .join(" ")}`
+    )
+  }
+  lines.push(
+    "};",
+    "",
+    "// kerning adjustments, sorted by left then right codepoint",
+    `const static font_kern_t prop_kerning[${font.kerning.length}] = {`,
+    ...font.kerning.map(
+      ({ left, right, adjust }) =>
+        `    {${hex(left, 4)}, ${hex(right, 4)}, ${adjust}}, // ${String.fromCodePoint(left)}${String.fromCodePoint(right)}`
+    ),
+    "};",
+    ""
+  )
+  writeFileSync(cOutPath, lines.join("\n"))
+}
+
+const writeTs = (font: ReturnType<typeof compile>, sourceName: string) => {
+  const lines = [
+    `// Generated by src/scripts/compileFont.ts from ${sourceName}.`,
+    "// Do not edit, run `npm run font:compile` instead.",
+    "",
+    `export const propFontHeight = ${font.height}`,
+    `export const propFontWidthMax = ${font.widthMax}`,
+    "",
+    "// [codepoint, rows, width, height, top, offsetX, advance], sorted by codepoint",
+    "//disable prettier formatting this array",
+    "// prettier-ignore",
+    "export const propGlyphs: [number, number, number, number, number, number, number][] = [",
+    ...font.glyphs.map(
+      (glyph) =>
+        `  [${hex(glyph.codepoint, 4)}, ${glyph.rows}, ${glyph.width}, ${glyph.height}, ${glyph.top}, ${glyph.offsetX}, ${glyph.advance}], // ${glyph.name}`
+    ),
+    "];",
+    "",
+    "//disable prettier formatting this array",
+    "// prettier-ignore",
+    "export const propRows = [",
+  ]
+  for (let index = 0; index < font.rows.length; index += 12) {
+    lines.push(
+      `  ${font.rows
+        .slice(index, index + 12)
+        .map((row) => `${hex(row, 2)},`)
+        .join(" ")}`
+    )
+  }
+  lines.push(
+    "];",
+    "",
+    "// [left, right, adjust], sorted by left then right codepoint",
+    "//disable prettier formatting this array",
+    "// prettier-ignore",
+    "export const propKerning: [number, number, number][] = [",
+    ...font.kerning.map(
+      ({ left, right, adjust }) =>
+        `  [${hex(left, 4)}, ${hex(right, 4)}, ${adjust}], // ${String.fromCodePoint(left)}${String.fromCodePoint(right)}`
+    ),
+    "];",
+    ""
+  )
+  writeFileSync(tsOutPath, lines.join("\n"))
+}
+
+const main = () => {
+  const inputPath = process.argv[2]
+  if (!inputPath) {
+    console.error("Usage: compileFont.ts <font.bdf>")
+    return
+  }
+
+  const font = compile(readFileSync(inputPath, "utf8"))
+  writeC(font, basename(inputPath))
+  writeTs(font, basename(inputPath))
+  console.log(
+    `Compiled ${font.glyphs.length} glyphs and ${font.kerning.length} kerning pairs`
+  )
+  console.log(cOutPath)
+  console.log(tsOutPath)
+}
+
+if (/node$/.test(process.argv[0]) && /compileFont\.ts$/.test(process.argv[1])) {
+  main()
+}